@@ -37,6 +37,8 @@ AudioSource::~AudioSource()
 {
   if (m_packet)
     m_buffer->freePacket(m_packet);
+  if (m_reserved)
+    delete m_reserved;
   delete m_buffer;
 }
 
@@ -108,3 +110,33 @@ int AudioSource::writeData(const char * data, int len)
   }
   return len;
 }
+
+char * AudioSource::reserveData(int len)
+{
+  if (!m_reserved)
+    m_reserved = m_buffer->newPacket(len);
+  else
+    m_reserved->reserve(len);
+  m_reserved->size = len;
+  return m_reserved->data;
+}
+
+int AudioSource::commitData()
+{
+  if (!m_reserved)
+    return 0;
+  int len = m_reserved->size;
+  if (!m_record)
+    return len; // discarded, the space is kept for the next write
+  // check sink: connected output, otherwise internal buffer for reading
+  IODevice* output = connectedOutput();
+  if (output)
+    len = output->write(m_reserved->data, len); // the space is kept for the next write
+  else
+  {
+    m_buffer->writePacket(m_reserved);
+    m_reserved = nullptr;
+    readyRead();
+  }
+  return len;
+}
@@ -86,10 +86,27 @@ protected:
   int writeData(const char *data, int len) override;
   volatile bool m_mute    = false;
 
+  /**
+   * Reserve the space of the next write, so the data can be filled in place.
+   * When no output is connected, the space is the next packet of the internal
+   * buffer, else it is handed to the output on commit, and then reused.
+   * @param len the size to write
+   * @return the space to fill
+   */
+  char * reserveData(int len);
+
+  /**
+   * Write the data filled in the space reserved, without copying it. The data
+   * is discarded when not recording.
+   * @return the size written
+   */
+  int commitData();
+
 private:
   bool m_record               = false;
   FrameBuffer * m_buffer      = nullptr;
   FramePacket * m_packet      = nullptr;
+  FramePacket * m_reserved    = nullptr;
   int m_consumed              = 0;
 };
 
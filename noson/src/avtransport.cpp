@@ -23,6 +23,8 @@
 #include "private/cppdef.h"
 #include "private/debug.h"
 #include "private/os/threads/timeout.h"
+#include "private/eventsequence.h"
+#include "private/positioncache.h"
 #include "didlparser.h"
 
 using namespace NSROOT;
@@ -32,18 +34,6 @@ const std::string AVTransport::ControlURL("/MediaRenderer/AVTransport/Control");
 const std::string AVTransport::EventURL("/MediaRenderer/AVTransport/Event");
 const std::string AVTransport::SCPDURL("/xml/AVTransport1.xml");
 
-namespace NSROOT
-{
-
-  struct AVTransportLastInfo
-  {
-    AVTransportLastInfo() : expiry(), vars() { }
-    OS::CTimeout expiry;
-    ElementList vars;
-  };
-
-}
-
 AVTransport::AVTransport(const std::string& serviceHost, unsigned servicePort)
 : Service(serviceHost, servicePort)
 , m_subscriptionPool()
@@ -51,8 +41,9 @@ AVTransport::AVTransport(const std::string& serviceHost, unsigned servicePort)
 , m_CBHandle(nullptr)
 , m_eventCB(nullptr)
 , m_msgCount(0)
+, m_sequence(new EventSequence())
 , m_property(AVTProperty())
-, m_lastPositionInfo(new AVTransportLastInfo())
+, m_positionCache(new PositionCache())
 {
 }
 
@@ -63,8 +54,9 @@ AVTransport::AVTransport(const std::string& serviceHost, unsigned servicePort, S
 , m_CBHandle(CBHandle)
 , m_eventCB(eventCB)
 , m_msgCount(0)
+, m_sequence(new EventSequence())
 , m_property(AVTProperty())
-, m_lastPositionInfo(new AVTransportLastInfo())
+, m_positionCache(new PositionCache())
 {
   unsigned subId = m_subscriptionPool->GetEventHandler().CreateSubscription(this);
   m_subscriptionPool->GetEventHandler().SubscribeForEvent(subId, EVENT_UPNP_PROPCHANGE);
@@ -79,7 +71,8 @@ AVTransport::~AVTransport()
     m_subscriptionPool->UnsubscribeEvent(m_subscription);
     m_subscriptionPool->GetEventHandler().RevokeAllSubscriptions(this);
   }
-  delete m_lastPositionInfo.Load();
+  SAFE_DELETE(m_positionCache);
+  SAFE_DELETE(m_sequence);
 }
 
 bool AVTransport::GetTransportInfo(ElementList& vars)
@@ -94,24 +87,33 @@ bool AVTransport::GetTransportInfo(ElementList& vars)
 
 bool AVTransport::GetPositionInfo(ElementList& vars)
 {
-  Locked<AVTransportLastInfo*>::pointer p = m_lastPositionInfo.Get();
-  if ((*p)->expiry.TimeLeft() > 0)
-  {
-    vars = (*p)->vars;
+  if (m_positionCache->Load(vars, OS::gettime_ms()))
     return true;
-  }
   ElementList args;
   args.push_back(ElementPtr(new Element("InstanceID", "0")));
+  // the reply is dropped if the transport changes during the request
+  unsigned generation = m_positionCache->Generation();
+  int64_t start = OS::gettime_ms();
   vars = Request("GetPositionInfo", args);
   if (!vars.empty() && vars[0]->compare("GetPositionInfoResponse") == 0)
   {
-    (*p)->vars = vars;
-    (*p)->expiry.Set(1000); // expire in 1 second
+    bool playing, synced;
+    {
+      Locked<AVTProperty>::pointer prop = m_property.Get();
+      playing = (prop->TransportState == "PLAYING");
+      synced = m_sequence->IsSynced() && !prop->EventSID.empty() && prop->EventSID == m_subscription.GetSID();
+    }
+    m_positionCache->Store(vars, generation, start, OS::gettime_ms(), playing, synced);
     return true;
   }
   return false;
 }
 
+void AVTransport::ResetPositionInfo()
+{
+  m_positionCache->Reset();
+}
+
 bool AVTransport::GetMediaInfo(ElementList& vars)
 {
   ElementList args;
@@ -170,6 +172,7 @@ bool AVTransport::Play()
   args.push_back(ElementPtr(new Element("InstanceID", "0")));
   args.push_back(ElementPtr(new Element("Speed", "1")));
   ElementList vars = Request("Play", args);
+  ResetPositionInfo();
   if (!vars.empty() && vars[0]->compare("PlayResponse") == 0)
     return true;
   return false;
@@ -181,6 +184,7 @@ bool AVTransport::Stop()
   args.push_back(ElementPtr(new Element("InstanceID", "0")));
   args.push_back(ElementPtr(new Element("Speed", "1")));
   ElementList vars = Request("Stop", args);
+  ResetPositionInfo();
   if (!vars.empty() && vars[0]->compare("StopResponse") == 0)
     return true;
   return false;
@@ -192,6 +196,7 @@ bool AVTransport::Pause()
   args.push_back(ElementPtr(new Element("InstanceID", "0")));
   args.push_back(ElementPtr(new Element("Speed", "1")));
   ElementList vars = Request("Pause", args);
+  ResetPositionInfo();
   if (!vars.empty() && vars[0]->compare("PauseResponse") == 0)
     return true;
   return false;
@@ -208,6 +213,7 @@ bool AVTransport::SeekTime(uint16_t reltime)
   args.push_back(ElementPtr(new Element("Unit", "REL_TIME")));
   args.push_back(ElementPtr(new Element("Target", buf)));
   ElementList vars = Request("Seek", args);
+  ResetPositionInfo();
   if (!vars.empty() && vars[0]->compare("SeekResponse") == 0)
     return true;
   return false;
@@ -220,6 +226,7 @@ bool AVTransport::SeekTrack(unsigned tracknr)
   args.push_back(ElementPtr(new Element("Unit", "TRACK_NR")));
   args.push_back(ElementPtr(new Element("Target", std::to_string(tracknr))));
   ElementList vars = Request("Seek", args);
+  ResetPositionInfo();
   if (!vars.empty() && vars[0]->compare("SeekResponse") == 0)
     return true;
   return false;
@@ -231,6 +238,7 @@ bool AVTransport::Next()
   args.push_back(ElementPtr(new Element("InstanceID", "0")));
   args.push_back(ElementPtr(new Element("Speed", "1")));
   ElementList vars = Request("Next", args);
+  ResetPositionInfo();
   if (!vars.empty() && vars[0]->compare("NextResponse") == 0)
     return true;
   return false;
@@ -242,6 +250,7 @@ bool AVTransport::Previous()
   args.push_back(ElementPtr(new Element("InstanceID", "0")));
   args.push_back(ElementPtr(new Element("Speed", "1")));
   ElementList vars = Request("Previous", args);
+  ResetPositionInfo();
   if (!vars.empty() && vars[0]->compare("PreviousResponse") == 0)
     return true;
   return false;
@@ -254,6 +263,7 @@ bool AVTransport::SetCurrentURI(const std::string& uri, const std::string& metad
   args.push_back(ElementPtr(new Element("CurrentURI", uri)));
   args.push_back(ElementPtr(new Element("CurrentURIMetaData", metadata)));
   ElementList vars = Request("SetAVTransportURI", args);
+  ResetPositionInfo();
   if (!vars.empty() && vars[0]->compare("SetAVTransportURIResponse") == 0)
     return true;
   return false;
@@ -291,32 +301,47 @@ unsigned AVTransport::AddURIToQueue(const std::string& uri, const std::string& m
 
 unsigned AVTransport::AddMultipleURIsToQueue(const std::vector<std::string>& uris, const std::vector<std::string>& metadatas)
 {
-  ElementList args;
-  Element* elem;
-  args.push_back(ElementPtr(new Element("InstanceID", "0")));
-  args.push_back(ElementPtr(new Element("UpdateID", "0")));
-  args.push_back(ElementPtr(new Element("NumberOfURIs", std::to_string(uris.size()))));
-  elem = new Element("EnqueuedURIs", "");
+  std::string _uris;
+  std::string _metadatas;
+  size_t len = 0;
+  for (std::vector<std::string>::const_iterator it = metadatas.begin(); it != metadatas.end(); ++it)
+    len += it->size() + 1;
+  _metadatas.reserve(len);
   for (std::vector<std::string>::const_iterator it = uris.begin(); it != uris.end(); ++it)
   {
     if (it != uris.begin())
-      elem->append(" ");
-    elem->append(*it);
+      _uris.append(" ");
+    _uris.append(*it);
   }
-  args.push_back(ElementPtr(elem));
-  elem = new Element("EnqueuedURIsMetaData", "");
   for (std::vector<std::string>::const_iterator it = metadatas.begin(); it != metadatas.end(); ++it)
   {
     if (it != metadatas.begin())
-      elem->append(" ");
-    elem->append(*it);
+      _metadatas.append(" ");
+    _metadatas.append(*it);
   }
-  args.push_back(ElementPtr(elem));
+  return AddMultipleURIsToQueue((unsigned)uris.size(), _uris, _metadatas);
+}
+
+unsigned AVTransport::AddMultipleURIsToQueue(unsigned count, std::string& uris, std::string& metadatas)
+{
+  ElementList args;
+  // swap the buffers in, rather than copying them
+  ElementPtr _uris(new Element("EnqueuedURIs"));
+  ElementPtr _metadatas(new Element("EnqueuedURIsMetaData"));
+  _uris->swap(uris);
+  _metadatas->swap(metadatas);
+  args.push_back(ElementPtr(new Element("InstanceID", "0")));
+  args.push_back(ElementPtr(new Element("UpdateID", "0")));
+  args.push_back(ElementPtr(new Element("NumberOfURIs", std::to_string(count))));
+  args.push_back(_uris);
+  args.push_back(_metadatas);
   args.push_back(ElementPtr(new Element("ContainerURI", "")));
   args.push_back(ElementPtr(new Element("ContainerMetadata", "")));
   args.push_back(ElementPtr(new Element("DesiredFirstTrackNumberEnqueued", "0")));
   args.push_back(ElementPtr(new Element("EnqueueAsNext", "0")));
   ElementList vars = Request("AddMultipleURIsToQueue", args);
+  _uris->swap(uris);
+  _metadatas->swap(metadatas);
   if (!vars.empty() && vars[0]->compare("AddMultipleURIsToQueueResponse") == 0)
   {
     uint32_t num;
@@ -463,6 +488,7 @@ bool AVTransport::SetAVTransportURI(const std::string& currentURI, const std::st
   args.push_back(ElementPtr(new Element("CurrentURI", currentURI)));
   args.push_back(ElementPtr(new Element("CurrentURIMetaData", CurrentURIMetaData)));
   ElementList vars = Request("SetAVTransportURI", args);
+  ResetPositionInfo();
   if (!vars.empty() && vars[0]->compare("SetAVTransportURIResponse") == 0)
     return true;
   return false;
@@ -478,6 +504,15 @@ bool AVTransport::BecomeCoordinatorOfStandaloneGroup()
   return false;
 }
 
+bool AVTransport::GetCachedProperty(AVTProperty& property)
+{
+  Locked<AVTProperty>::pointer prop = m_property.Get();
+  if (!m_sequence->IsSynced() || prop->EventSID.empty() || prop->EventSID != m_subscription.GetSID())
+    return false;
+  property = *prop;
+  return true;
+}
+
 void AVTransport::HandleEventMessage(EventMessagePtr msg)
 {
   if (!msg)
@@ -495,17 +530,11 @@ void AVTransport::HandleEventMessage(EventMessagePtr msg)
         // check for higher sequence
         uint32_t seq = 0;
         string_to_uint32(msg->subject[1].c_str(), &seq);
-        if (msg->subject[0] != prop->EventSID)
-        {
-          prop->EventSID = msg->subject[0];
-        }
-        else if (seq < prop->EventSEQ)
-        {
-          DBG(DBG_DEBUG, "%s: %s SEQ=%u , discarding %u\n", __FUNCTION__, prop->EventSID.c_str(), prop->EventSEQ, seq);
+        if (!m_sequence->Check(prop->EventSID, prop->EventSEQ, msg->subject[0], seq))
           return;
-        }
-        // tracking serial of the event
-        prop->EventSEQ = seq;
+        // resync a stale state, with back-off
+        if (m_sequence->Resubscribe(OS::gettime_ms()))
+          m_subscription.AskResubscribe();
 
         std::vector<std::string>::const_iterator it = msg->subject.begin();
         while (it != msg->subject.end())
@@ -588,6 +617,8 @@ void AVTransport::HandleEventMessage(EventMessagePtr msg)
             prop->r_MuseSessions.assign(*++it);
           else if (*it == "TransportStatus")
             prop->TransportStatus.assign(*++it);
+          else if (*it == "TransportPlaySpeed")
+            prop->TransportPlaySpeed.assign(*++it);
           else if (*it == "r:SleepTimerGeneration")
             prop->r_SleepTimerGeneration.assign(*++it);
           else if (*it == "r:AlarmRunning")
@@ -609,6 +640,8 @@ void AVTransport::HandleEventMessage(EventMessagePtr msg)
         }
         // END CRITICAL SECTION
       }
+      // the transport has changed: anchor the position again
+      ResetPositionInfo();
       // Signal
       ++m_msgCount;
       if (m_eventCB)
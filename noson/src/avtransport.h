@@ -30,10 +30,14 @@
 #include <stdint.h>
 #include <vector>
 
+#define AVTRANSPORT_POSITION_RESYNC   30000 // ms an extrapolated position is trusted
+#define AVTRANSPORT_POSITION_OVERRUN  2     // seconds past the end of the track
+
 namespace NSROOT
 {
   class Subscription;
-  struct AVTransportLastInfo;
+  class EventSequence;
+  class PositionCache;
 
   class AVTransport : public Service, public EventSubscriber
   {
@@ -57,6 +61,11 @@ namespace NSROOT
 
     bool GetTransportInfo(ElementList& vars);
 
+    /**
+     * The reply is cached. While the events are in sync, the elapsed time is
+     * extrapolated from the last reply until the transport changes, or the
+     * next resync.
+     */
     bool GetPositionInfo(ElementList& vars);
 
     bool GetMediaInfo(ElementList& vars);
@@ -118,18 +127,34 @@ namespace NSROOT
 
     bool Empty() const { return m_msgCount == 0; }
 
+    /**
+     * Copy the state maintained by the events. It fails while the state
+     * could be stale: no event received for the current subscription, or a
+     * gap in the sequence of events.
+     */
+    bool GetCachedProperty(AVTProperty& property);
+
     Locked<AVTProperty>& GetAVTProperty() { return m_property; }
 
   private:
+    friend class Player;
+
     SubscriptionPoolPtr m_subscriptionPool;
     Subscription m_subscription;
     void* m_CBHandle;
     EventCB m_eventCB;
     unsigned m_msgCount;
+    EventSequence* m_sequence;      // the events of the subscription
 
     Locked<AVTProperty> m_property;
 
-    Locked<AVTransportLastInfo*> m_lastPositionInfo;
+    PositionCache* m_positionCache;   // the last position info
+    void ResetPositionInfo();
+
+    // The URIs and their metadata already joined, each separated by a space.
+    // The buffers are swapped into the request, then given back unchanged,
+    // so the player reuses them for the next bulk.
+    unsigned AddMultipleURIsToQueue(unsigned count, std::string& uris, std::string& metadatas);
   };
 }
 
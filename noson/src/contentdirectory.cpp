@@ -24,8 +24,13 @@
 #include "private/tokenizer.h"
 #include "private/debug.h"
 #include "private/cppdef.h"
+#include "private/browsecache.h"
+#include "private/os/threads/threadpool.h"
+#include "private/os/threads/timeout.h"
 
 #include <list>
+#include <map>
+#include <set>
 
 using namespace NSROOT;
 
@@ -258,35 +263,253 @@ unsigned ContentChunk::summarize(const ElementList& vars)
   return (unsigned)cnt;
 }
 
+///////////////////////////////////////////////////////////////////////////////
+////
+//// ContentPrefetch
+////
+
+#define PREFETCH_FAST_MS  250   // latency under which the bulk size grows
+#define PREFETCH_SLOW_MS  1000  // latency over which the bulk size shrinks
+
+namespace NSROOT
+{
+  class ContentPrefetch
+  {
+  public:
+    struct Page : public ContentChunk
+    {
+      Page(unsigned index, unsigned count)
+      : startingIndex(index)
+      , requestedCount(count)
+      , done(false)
+      , succeeded(false)
+      , valid(false)
+      , orphan(false) {}
+
+      unsigned startingIndex;
+      unsigned requestedCount;
+      volatile bool done;
+      bool succeeded;
+      bool valid;
+      bool orphan;            // overtaken while running: freed by the worker
+      std::vector<DigitalItemPtr> items;
+    };
+
+    ContentPrefetch(ContentDirectory& service, const std::string& root, unsigned depth, unsigned bulksize);
+    ~ContentPrefetch();
+
+    // request the bulks following index until the pipeline is full
+    void Schedule(unsigned index, unsigned totalCount);
+
+    // wait and return the bulk starting at index, the caller takes ownership
+    Page* Take(unsigned index);
+
+  private:
+    class Worker;
+
+    ContentDirectory& m_service;
+    const std::string m_root;
+    unsigned m_depth;
+    unsigned m_maxCount;
+    unsigned m_pageSize;
+    unsigned m_nextIndex;
+
+    typedef std::map<unsigned, Page*> PageMap;
+    PageMap m_pages;
+    std::set<Page*> m_orphans;
+    OS::CMutex m_mutex;
+    OS::CCondition<volatile bool> m_condition;
+    OS::CThreadPool* m_pool;
+
+    Page* Enqueue(unsigned index, unsigned count);
+    void Fetch(Page* page);
+  };
+
+  class ContentPrefetch::Worker : public OS::CWorker
+  {
+  public:
+    Worker(ContentPrefetch& prefetch, Page* page) : m_prefetch(prefetch), m_page(page) {}
+    void Process() override { m_prefetch.Fetch(m_page); }
+  private:
+    ContentPrefetch& m_prefetch;
+    Page* m_page;
+  };
+}
+
+ContentPrefetch::ContentPrefetch(ContentDirectory& service, const std::string& root, unsigned depth, unsigned bulksize)
+: m_service(service)
+, m_root(root)
+, m_depth(depth)
+, m_maxCount(bulksize)
+, m_pageSize(bulksize)
+, m_nextIndex(0)
+, m_pool(new OS::CThreadPool(depth))
+{
+}
+
+ContentPrefetch::~ContentPrefetch()
+{
+  // discard queued requests, then wait for the running ones
+  m_pool->Reset();
+  SAFE_DELETE(m_pool);
+  for (PageMap::iterator it = m_pages.begin(); it != m_pages.end(); ++it)
+    delete it->second;
+  // the orphans discarded before running
+  for (std::set<Page*>::iterator it = m_orphans.begin(); it != m_orphans.end(); ++it)
+    delete *it;
+}
+
+void ContentPrefetch::Schedule(unsigned index, unsigned totalCount)
+{
+  OS::CLockGuard lock(m_mutex);
+  if (m_nextIndex < index)
+    m_nextIndex = index;
+  while (m_pages.size() < m_depth && m_nextIndex < totalCount)
+  {
+    unsigned count = totalCount - m_nextIndex;
+    if (count > m_pageSize)
+      count = m_pageSize;
+    Enqueue(m_nextIndex, count);
+    m_nextIndex += count;
+  }
+}
+
+ContentPrefetch::Page* ContentPrefetch::Take(unsigned index)
+{
+  OS::CLockGuard lock(m_mutex);
+  Page* page;
+  PageMap::iterator it = m_pages.find(index);
+  if (it == m_pages.end())
+  {
+    // a previous bulk was returned short: fill the hole until the next one
+    unsigned count = m_pageSize;
+    it = m_pages.upper_bound(index);
+    if (it != m_pages.end() && it->first - index < count)
+      count = it->first - index;
+    page = Enqueue(index, count);
+    if (m_nextIndex < index + count)
+      m_nextIndex = index + count;
+  }
+  else
+    page = it->second;
+  m_condition.Wait(m_mutex, page->done);
+  m_pages.erase(index);
+  // drop any bulk overtaken by the iterator, so it no longer holds a place
+  // in the pipeline. The one still running is freed by its worker.
+  while (!m_pages.empty() && m_pages.begin()->first < index)
+  {
+    Page* p = m_pages.begin()->second;
+    m_pages.erase(m_pages.begin());
+    if (p->done)
+      delete p;
+    else
+    {
+      p->orphan = true;
+      m_orphans.insert(p);
+    }
+  }
+  return page;
+}
+
+ContentPrefetch::Page* ContentPrefetch::Enqueue(unsigned index, unsigned count)
+{
+  DBG(DBG_PROTO, "%s: prefetch %u from %u\n", __FUNCTION__, count, index);
+  Page* page = new Page(index, count);
+  m_pages.insert(std::make_pair(index, page));
+  if (!m_pool->Enqueue(new Worker(*this, page)))
+    page->done = true;
+  return page;
+}
+
+void ContentPrefetch::Fetch(Page* page)
+{
+  int64_t start = OS::gettime_ms();
+  ElementList vars;
+  ElementList::const_iterator it;
+  page->succeeded = m_service.Browse(m_root, page->startingIndex, page->requestedCount, vars);
+  if (page->succeeded && (it = vars.FindKey("Result")) != vars.end())
+  {
+    unsigned cnt = page->summarize(vars);
+    // peer could return a valid result on out of range
+    if (page->startingIndex < page->m_totalCount)
+    {
+      DIDLParser didl((*it)->c_str(), cnt);
+      if ((page->valid = didl.IsValid()))
+        page->items.swap(didl.GetItems());
+    }
+  }
+  unsigned elapsed = (unsigned)(OS::gettime_ms() - start);
+
+  OS::CLockGuard lock(m_mutex);
+  // adjust the size of next bulks to the observed latency
+  m_pageSize = ContentList::AdaptBulkSize(m_pageSize, elapsed, m_maxCount);
+  DBG(DBG_PROTO, "%s: count %u in %u ms\n", __FUNCTION__, (unsigned)page->items.size(), elapsed);
+  if (page->orphan)
+  {
+    m_orphans.erase(page);
+    delete page;
+    return;
+  }
+  page->done = true;
+  m_condition.Broadcast();
+}
+
 ///////////////////////////////////////////////////////////////////////////////
 ////
 //// ContentList
 ////
 
-ContentList::ContentList(ContentDirectory& service, const ContentSearch& search, unsigned bulksize)
+unsigned ContentList::AdaptBulkSize(unsigned bulksize, unsigned elapsed, unsigned maxCount)
+{
+  if (elapsed > PREFETCH_SLOW_MS && bulksize > BROWSE_MINCOUNT)
+    return (bulksize / 2 > BROWSE_MINCOUNT ? bulksize / 2 : BROWSE_MINCOUNT);
+  if (elapsed < PREFETCH_FAST_MS && bulksize < maxCount)
+    return (bulksize * 2 < maxCount ? bulksize * 2 : maxCount);
+  return bulksize;
+}
+
+ContentList::ContentList(ContentDirectory& service, const ContentSearch& search, unsigned bulksize, unsigned prefetch)
 : m_succeeded(false)
 , m_service(service)
 , m_bulkSize(BROWSE_COUNT)
 , m_root(search.Root())
 , m_browsedCount(0)
+, m_prefetch(nullptr)
 {
   if (bulksize > 0 && bulksize < BROWSE_COUNT)
     m_bulkSize = bulksize;
   BrowseContent(0, m_bulkSize, m_list.begin());
   m_baseUpdateID = m_lastUpdateID; // save baseline ID for this content
+  if (prefetch > 0 && m_succeeded)
+  {
+    m_prefetch = new ContentPrefetch(m_service, m_root, prefetch, m_bulkSize);
+    m_prefetch->Schedule(m_browsedCount, m_totalCount);
+  }
 }
 
-ContentList::ContentList(ContentDirectory& service, const std::string& objectID, unsigned bulksize)
+ContentList::ContentList(ContentDirectory& service, const std::string& objectID, unsigned bulksize, unsigned prefetch)
 : m_succeeded(false)
 , m_service(service)
 , m_bulkSize(BROWSE_COUNT)
 , m_root(objectID)
 , m_browsedCount(0)
+, m_prefetch(nullptr)
 {
   if (bulksize > 0 && bulksize < BROWSE_COUNT)
     m_bulkSize = bulksize;
   BrowseContent(0, m_bulkSize, m_list.begin());
   m_baseUpdateID = m_lastUpdateID; // save baseline ID for this content
+  if (prefetch > 0 && m_succeeded)
+  {
+    m_prefetch = new ContentPrefetch(m_service, m_root, prefetch, m_bulkSize);
+    m_prefetch->Schedule(m_browsedCount, m_totalCount);
+  }
+}
+
+ContentList::~ContentList()
+{
+  // cancel the pending prefetches
+  SAFE_DELETE(m_prefetch);
 }
 
 bool ContentList::Next(List::iterator& i)
@@ -297,7 +520,7 @@ bool ContentList::Next(List::iterator& i)
     bool r = true;
     List::iterator n = i;
     if (++n == e)
-      r = BrowseContent(m_browsedCount, m_bulkSize, n);
+      r = (m_prefetch ? FetchContent(n) : BrowseContent(m_browsedCount, m_bulkSize, n));
     ++i; // On failure i becomes end
     return r;
   }
@@ -338,6 +561,27 @@ bool ContentList::BrowseContent(unsigned startingIndex, unsigned count, List::it
   return false;
 }
 
+bool ContentList::FetchContent(List::iterator position)
+{
+  if (m_browsedCount >= m_totalCount)
+    return false;
+  bool r = false;
+  ContentPrefetch::Page* page = m_prefetch->Take(m_browsedCount);
+  if ((m_succeeded = page->succeeded) && page->valid)
+  {
+    m_lastUpdateID = page->m_lastUpdateID;
+    m_totalCount = page->m_totalCount;
+    m_list.insert(position, page->items.begin(), page->items.end());
+    m_browsedCount += page->items.size();
+    DBG(DBG_PROTO, "%s: count %u\n", __FUNCTION__, (unsigned)page->items.size());
+    r = true;
+  }
+  delete page;
+  if (r)
+    m_prefetch->Schedule(m_browsedCount, m_totalCount);
+  return r;
+}
+
 ///////////////////////////////////////////////////////////////////////////////
 ////
 //// ContentBrowser
@@ -347,18 +591,45 @@ ContentBrowser::ContentBrowser(ContentDirectory& service, const ContentSearch& s
 : m_service(service)
 , m_root(search.Root())
 , m_startingIndex(0)
+, m_pageSize(BROWSE_COUNT)
+, m_cache(nullptr)
+, m_cacheUpdateID(0)
+, m_validated(0)
 {
-  BrowseContent(m_startingIndex, count, m_table.begin());
+  if (count > 0 && count < BROWSE_COUNT)
+    m_pageSize = count;
+  if (count == 0)
+    count = m_pageSize;
+  m_cache = new BrowseCache(m_pageSize, BROWSE_CACHE_SIZE);
+  if (LoadPages(m_startingIndex, count))
+    FillTable(m_startingIndex, count);
   m_baseUpdateID = m_lastUpdateID; // save baseline ID for this content
+  m_cacheUpdateID = m_lastUpdateID;
 }
 
 ContentBrowser::ContentBrowser(ContentDirectory& service, const std::string& objectID, unsigned count)
 : m_service(service)
 , m_root(objectID)
 , m_startingIndex(0)
+, m_pageSize(BROWSE_COUNT)
+, m_cache(nullptr)
+, m_cacheUpdateID(0)
+, m_validated(0)
 {
-  BrowseContent(m_startingIndex, count, m_table.begin());
+  if (count > 0 && count < BROWSE_COUNT)
+    m_pageSize = count;
+  if (count == 0)
+    count = m_pageSize;
+  m_cache = new BrowseCache(m_pageSize, BROWSE_CACHE_SIZE);
+  if (LoadPages(m_startingIndex, count))
+    FillTable(m_startingIndex, count);
   m_baseUpdateID = m_lastUpdateID; // save baseline ID for this content
+  m_cacheUpdateID = m_lastUpdateID;
+}
+
+ContentBrowser::~ContentBrowser()
+{
+  SAFE_DELETE(m_cache);
 }
 
 bool ContentBrowser::Browse(unsigned index, unsigned count)
@@ -370,36 +641,44 @@ bool ContentBrowser::Browse(unsigned index, unsigned count)
     return false;
   }
 
-  unsigned size = (unsigned) m_table.size();
   if (m_totalCount < index + count)
     count = m_totalCount - index;
 
-  if (index == m_startingIndex)
+  int64_t validated = m_validated;
+  bool r = LoadPages(index, index + count);
+  // nothing requested: the update ID could be obsolete
+  if (r && m_validated == validated && OS::gettime_ms() - m_validated >= BROWSE_CACHE_VALIDITY)
+    r = Revalidate(index);
+  // the content changed: the cached pages are obsolete
+  if (r && m_lastUpdateID != m_cacheUpdateID)
   {
-    if (count == size)
-      return true;
-    if (count < size)
-    {
-      m_table.resize(count);
-    }
-    return BrowseContent(m_startingIndex + size, count - size, m_table.end());
+    DBG(DBG_DEBUG, "%s: update ID changed (%u), clear the cache\n", __FUNCTION__, m_lastUpdateID);
+    ClearCache();
+    m_cacheUpdateID = m_lastUpdateID;
+    if (m_totalCount < index + count)
+      count = (index < m_totalCount ? m_totalCount - index : 0);
+    r = LoadPages(index, index + count);
   }
+  if (r)
+    FillTable(index, count);
+  else
+    m_table.clear();
+  m_startingIndex = index;
+  m_cache->Shrink();
+  return r;
+}
 
-  if (index > m_startingIndex && index + count <= m_startingIndex + size)
-  {
-    Table tmp;
-    tmp.insert(tmp.begin(), m_table.begin() + index - m_startingIndex, m_table.begin() + index - m_startingIndex + count);
-    m_table = tmp;
-    m_startingIndex = index;
-    return true;
-  }
+void ContentBrowser::SetCacheSize(size_t bytes)
+{
+  m_cache->SetMaxSize(bytes);
+}
 
-  m_table.clear();
-  m_startingIndex = index;
-  return BrowseContent(m_startingIndex, count, m_table.begin());
+void ContentBrowser::ClearCache()
+{
+  m_cache->Clear();
 }
 
-bool ContentBrowser::BrowseContent(unsigned startingIndex, unsigned count, Table::iterator position)
+bool ContentBrowser::BrowseContent(unsigned startingIndex, unsigned count, Table& items)
 {
   DBG(DBG_PROTO, "%s: browse %u from %u\n", __FUNCTION__, count, startingIndex);
   ElementList vars;
@@ -407,13 +686,85 @@ bool ContentBrowser::BrowseContent(unsigned startingIndex, unsigned count, Table
   if (m_service.Browse(m_root, startingIndex, count, vars) && (it = vars.FindKey("Result")) != vars.end())
   {
     unsigned cnt = summarize(vars);
+    m_validated = OS::gettime_ms();
     DIDLParser didl((*it)->c_str(), cnt);
     if (didl.IsValid())
     {
-      m_table.insert(position, didl.GetItems().begin(), didl.GetItems().end());
+      items.insert(items.end(), didl.GetItems().begin(), didl.GetItems().end());
       DBG(DBG_PROTO, "%s: count %u\n", __FUNCTION__, didl.GetItems().size());
       return true;
     }
   }
   return false;
 }
+
+bool ContentBrowser::Revalidate(unsigned index)
+{
+  // the smallest browse returns the current update ID and total count
+  DBG(DBG_PROTO, "%s: probe %u\n", __FUNCTION__, index);
+  ElementList vars;
+  if (!m_service.Browse(m_root, index, 1, vars) || vars.FindKey("Result") == vars.end())
+    return false;
+  summarize(vars);
+  m_validated = OS::gettime_ms();
+  return true;
+}
+
+bool ContentBrowser::LoadPages(unsigned startingIndex, unsigned endIndex)
+{
+  unsigned index = startingIndex - (startingIndex % m_pageSize);
+  while (index < endIndex)
+  {
+    if (m_cache->Touch(index))
+    {
+      index += m_pageSize;
+      continue;
+    }
+    // request the run of missing pages at once
+    unsigned runEnd = index + m_pageSize;
+    while (runEnd < endIndex && !m_cache->Find(runEnd))
+      runEnd += m_pageSize;
+    Table items;
+    do
+    {
+      size_t done = items.size();
+      if (!BrowseContent(index + done, runEnd - index - done, items))
+        return false;
+      // the peer could return less than requested, or nothing out of range
+      if (items.size() == done)
+        break;
+    } while (index + items.size() < runEnd && index + items.size() < m_totalCount);
+    // split the run into pages, the last page of the list could be partial
+    for (unsigned p = 0; p < items.size(); p += m_pageSize)
+    {
+      unsigned n = (unsigned) items.size() - p;
+      if (n > m_pageSize)
+        n = m_pageSize;
+      else if (n < m_pageSize && index + p + n < m_totalCount)
+        break;
+      m_cache->Store(index + p, items.begin() + p, items.begin() + p + n);
+    }
+    index = runEnd;
+  }
+  return true;
+}
+
+void ContentBrowser::FillTable(unsigned startingIndex, unsigned count)
+{
+  m_table.clear();
+  m_table.reserve(count);
+  unsigned index = startingIndex;
+  unsigned endIndex = startingIndex + count;
+  while (index < endIndex)
+  {
+    unsigned offset = index % m_pageSize;
+    const Table* page = m_cache->Find(index - offset);
+    if (!page || offset >= page->size())
+      break;
+    unsigned n = (unsigned) page->size() - offset;
+    if (n > endIndex - index)
+      n = endIndex - index;
+    m_table.insert(m_table.end(), page->begin() + offset, page->begin() + offset + n);
+    index += n;
+  }
+}
@@ -29,14 +29,19 @@
 #include "locked.h"
 
 #include <list>
+#include <map>
 #include <vector>
 #include <stdint.h>
 
 #define BROWSE_COUNT  100
+#define BROWSE_MINCOUNT 25
+#define BROWSE_CACHE_SIZE 0x200000  // bytes of items held by a browser
+#define BROWSE_CACHE_VALIDITY 1000  // ms a cached range is served without revalidation
 
 namespace NSROOT
 {
   class Subscription;
+  class BrowseCache;
 
   class ContentDirectory : public Service, public EventSubscriber
   {
@@ -145,14 +150,27 @@ namespace NSROOT
   //// ContentList
   ////
 
+  class ContentPrefetch;
+
   class ContentList : private ContentChunk
   {
     typedef std::list<DigitalItemPtr> List;
 
     friend class iterator;
   public:
-    ContentList(ContentDirectory& service, const ContentSearch& search, unsigned bulksize = BROWSE_COUNT);
-    ContentList(ContentDirectory& service, const std::string& objectID, unsigned bulksize = BROWSE_COUNT);
+    /**
+     * Browse the content of the given object. The first bulk is fetched on
+     * creation, then next ones while iterating.
+     * @param bulksize The number of items requested by browse
+     * @param prefetch The number of bulks to keep requested ahead of the
+     * iterator. They are fetched and parsed by workers, and the size of the
+     * bulks is adjusted to the observed latency. 0 disables the prefetching.
+     */
+    ContentList(ContentDirectory& service, const ContentSearch& search, unsigned bulksize = BROWSE_COUNT, unsigned prefetch = 0);
+    ContentList(ContentDirectory& service, const std::string& objectID, unsigned bulksize = BROWSE_COUNT, unsigned prefetch = 0);
+    ~ContentList();
+    ContentList(const ContentList&) = delete;
+    ContentList& operator=(const ContentList&) = delete;
 
     class iterator
     {
@@ -185,6 +203,13 @@ namespace NSROOT
 
     unsigned GetUpdateID() const { return m_baseUpdateID; }
 
+    /**
+     * The size of the next prefetched bulk: halved down to BROWSE_MINCOUNT
+     * when the last one was slow, doubled up to maxCount when it was fast.
+     * @param elapsed The latency of the last bulk in ms
+     */
+    static unsigned AdaptBulkSize(unsigned bulksize, unsigned elapsed, unsigned maxCount);
+
   private:
     bool m_succeeded;
     ContentDirectory& m_service;
@@ -193,10 +218,12 @@ namespace NSROOT
     unsigned m_browsedCount;
 
     List m_list;
+    ContentPrefetch* m_prefetch;
 
     bool Next(List::iterator& i);
     bool Previous(List::iterator& i);
     bool BrowseContent(unsigned startingIndex, unsigned count, List::iterator position);
+    bool FetchContent(List::iterator position);
   };
 
   /////////////////////////////////////////////////////////////////////////////
@@ -209,8 +236,21 @@ namespace NSROOT
   public:
     typedef std::vector<DigitalItemPtr> Table;
 
+    /**
+     * Browse the content of the given object. The browsed items are kept in a
+     * cache of pages with the given count as page size, so that browsing a
+     * range again does not request the cached pages. The cache is discarded
+     * when the peer reports a new update ID. A range fully cached is
+     * revalidated by probing its first item, when the last update ID read is
+     * older than BROWSE_CACHE_VALIDITY. GetUpdateID keeps returning the ID of
+     * the content first browsed, so the caller can detect the change and
+     * reload.
+     */
     ContentBrowser(ContentDirectory& service, const ContentSearch& search, unsigned count = BROWSE_COUNT);
     ContentBrowser(ContentDirectory& service, const std::string& objectID, unsigned count = BROWSE_COUNT);
+    ~ContentBrowser();
+    ContentBrowser(const ContentBrowser&) = delete;
+    ContentBrowser& operator=(const ContentBrowser&) = delete;
 
     bool Browse(unsigned startingIndex, unsigned count);
 
@@ -224,6 +264,13 @@ namespace NSROOT
 
     unsigned GetUpdateID() const { return m_baseUpdateID; }
 
+    /**
+     * Set the max bytes of items held in the cache. 0 disables the cache.
+     */
+    void SetCacheSize(size_t bytes);
+
+    void ClearCache();
+
   private:
     ContentDirectory& m_service;
     std::string m_root;
@@ -231,7 +278,15 @@ namespace NSROOT
 
     Table m_table;
 
-    bool BrowseContent(unsigned startingIndex, unsigned count, Table::iterator position);
+    unsigned m_pageSize;
+    BrowseCache* m_cache;
+    unsigned m_cacheUpdateID;     // update ID of the cached pages
+    int64_t m_validated;          // time of the last update ID read
+
+    bool BrowseContent(unsigned startingIndex, unsigned count, Table& items);
+    bool Revalidate(unsigned index);
+    bool LoadPages(unsigned startingIndex, unsigned endIndex);
+    void FillTable(unsigned startingIndex, unsigned count);
   };
 
 }
@@ -0,0 +1,324 @@
+/*
+ *      Copyright (C) 2026 Jean-Luc Barriere
+ *
+ *  This file is part of Noson
+ *
+ *  Noson is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  Noson is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#include "contentindex.h"
+#include "didlparser.h"
+#include "private/debug.h"
+#include "private/cppdef.h"
+#include "private/builtin.h"
+#include "private/os/threads/mutex.h"
+
+#include <algorithm>
+#include <iterator>
+#include <map>
+
+using namespace NSROOT;
+
+namespace NSROOT
+{
+  // the indexed properties of an item
+  static const char * IndexedKeys[] = {
+    DIDL_QNAME_DC "title",
+    DIDL_QNAME_DC "creator",
+    DIDL_QNAME_UPNP "album",
+    NULL
+  };
+
+  // sorted words with their lists of item numbers stored contiguously
+  struct ContentIndex::Postings
+  {
+    DigitalItemList items;
+    std::vector<std::string> words;
+    std::vector<uint32_t> offsets;  // size of words + 1
+    std::vector<uint32_t> refs;
+  };
+
+  struct ContentIndex::Root
+  {
+    Root(Search_t _search) : search(_search), indexed(false), updateID(0) {}
+    Search_t search;
+    bool indexed;
+    unsigned updateID;  // the update ID of the root when crawled
+    std::map<std::string, unsigned> containerUpdateIDs;
+    SHARED_PTR<Postings> data;
+  };
+}
+
+ContentIndex::ContentIndex(ContentDirectory& service)
+: m_service(service)
+, m_mutex(new OS::CMutex)
+{
+  m_roots.push_back(new Root(SearchTrack));
+  m_roots.push_back(new Root(SearchAlbum));
+  m_roots.push_back(new Root(SearchContributor));
+}
+
+ContentIndex::~ContentIndex()
+{
+  for (std::vector<Root*>::iterator it = m_roots.begin(); it != m_roots.end(); ++it)
+    delete *it;
+  SAFE_DELETE(m_mutex);
+}
+
+bool ContentIndex::IsIndexed(Search_t search)
+{
+  return (search == SearchTrack || search == SearchAlbum || search == SearchContributor);
+}
+
+bool ContentIndex::Refresh(const ContentProperty& property)
+{
+  if (property.ShareIndexInProgress)
+    return false;
+  bool r = true;
+  for (std::vector<Root*>::iterator it = m_roots.begin(); it != m_roots.end(); ++it)
+  {
+    Root* root = *it;
+    const std::string rootID = ContentSearch::rootenum(root->search).first;
+    // collect the update IDs of containers related to the root
+    std::map<std::string, unsigned> updateIDs;
+    bool stale = false;
+    bool changed = false;
+    unsigned baseUpdateID = 0;
+    unsigned baseCount = 0;
+    {
+      OS::CLockGuard lock(*m_mutex);
+      stale = !root->indexed;
+      std::vector<std::pair<std::string, unsigned> >::const_iterator itc;
+      for (itc = property.ContainerUpdateIDs.begin(); itc != property.ContainerUpdateIDs.end(); ++itc)
+      {
+        bool ancestor = (rootID.compare(0, itc->first.size(), itc->first) == 0);
+        if (!ancestor && itc->first.compare(0, rootID.size(), rootID) != 0)
+          continue;
+        updateIDs.insert(*itc);
+        // the containers below the root do not hold its items
+        std::map<std::string, unsigned>::const_iterator itu = root->containerUpdateIDs.find(itc->first);
+        if (ancestor && (itu == root->containerUpdateIDs.end() || itu->second != itc->second))
+          changed = true;
+      }
+      baseUpdateID = root->updateID;
+      baseCount = (root->data ? (unsigned) root->data->items.size() : 0);
+    }
+    if (!stale && changed)
+    {
+      // an ancestor changed: check the root itself changed before crawling
+      unsigned updateID = 0, count = 0;
+      if (!Probe(rootID, updateID, count) || updateID != baseUpdateID || count != baseCount)
+        stale = true;
+      else
+        DBG(DBG_DEBUG, "%s: %s is unchanged (%u)\n", __FUNCTION__, rootID.c_str(), updateID);
+    }
+    if (stale)
+    {
+      DBG(DBG_DEBUG, "%s: crawling %s\n", __FUNCTION__, rootID.c_str());
+      DigitalItemList items;
+      unsigned updateID = 0;
+      if (!Crawl(root->search, items, updateID))
+      {
+        r = false;
+        continue;
+      }
+      SHARED_PTR<Postings> data = Build(items);
+      OS::CLockGuard lock(*m_mutex);
+      root->data = data;
+      root->updateID = updateID;
+      root->indexed = true;
+    }
+    OS::CLockGuard lock(*m_mutex);
+    for (std::map<std::string, unsigned>::const_iterator itu = updateIDs.begin(); itu != updateIDs.end(); ++itu)
+      root->containerUpdateIDs[itu->first] = itu->second;
+  }
+  return r;
+}
+
+void ContentIndex::Assign(Search_t search, const DigitalItemList& items)
+{
+  SHARED_PTR<Postings> data = Build(items);
+  OS::CLockGuard lock(*m_mutex);
+  Root* root = FindRoot(search);
+  if (root)
+  {
+    root->data = data;
+    root->indexed = true;
+  }
+}
+
+DigitalItemList ContentIndex::Search(Search_t search, const std::string& query, unsigned max) const
+{
+  DigitalItemList list;
+  SHARED_PTR<Postings> data;
+  {
+    OS::CLockGuard lock(*m_mutex);
+    const Root* root = FindRoot(search);
+    if (!root || !root->data)
+      return list;
+    data = root->data;
+  }
+  std::vector<std::string> words;
+  Tokenize(query, words);
+  if (words.empty())
+    return list;
+
+  std::vector<uint32_t> result;
+  std::vector<uint32_t> refs;
+  std::vector<uint32_t> tmp;
+  for (std::vector<std::string>::const_iterator it = words.begin(); it != words.end(); ++it)
+  {
+    // merge the references of all words starting with the query word
+    refs.clear();
+    std::vector<std::string>::const_iterator itw = std::lower_bound(data->words.begin(), data->words.end(), *it);
+    unsigned matches = 0;
+    while (itw != data->words.end() && itw->compare(0, it->size(), *it) == 0)
+    {
+      size_t w = itw - data->words.begin();
+      refs.insert(refs.end(), data->refs.begin() + data->offsets[w], data->refs.begin() + data->offsets[w + 1]);
+      ++matches;
+      ++itw;
+    }
+    if (matches > 1)
+    {
+      std::sort(refs.begin(), refs.end());
+      refs.erase(std::unique(refs.begin(), refs.end()), refs.end());
+    }
+    if (it == words.begin())
+      result.swap(refs);
+    else
+    {
+      tmp.clear();
+      std::set_intersection(result.begin(), result.end(), refs.begin(), refs.end(), std::back_inserter(tmp));
+      result.swap(tmp);
+    }
+    if (result.empty())
+      return list;
+  }
+
+  if (max > 0 && result.size() > max)
+    result.resize(max);
+  list.reserve(result.size());
+  for (std::vector<uint32_t>::const_iterator it = result.begin(); it != result.end(); ++it)
+    list.push_back(data->items[*it]);
+  return list;
+}
+
+unsigned ContentIndex::size() const
+{
+  unsigned n = 0;
+  OS::CLockGuard lock(*m_mutex);
+  for (std::vector<Root*>::const_iterator it = m_roots.begin(); it != m_roots.end(); ++it)
+    if ((*it)->data)
+      n += (unsigned) (*it)->data->items.size();
+  return n;
+}
+
+ContentIndex::Root* ContentIndex::FindRoot(Search_t search) const
+{
+  for (std::vector<Root*>::const_iterator it = m_roots.begin(); it != m_roots.end(); ++it)
+    if ((*it)->search == search)
+      return *it;
+  return nullptr;
+}
+
+bool ContentIndex::Probe(const std::string& rootID, unsigned& updateID, unsigned& count)
+{
+  ElementList vars;
+  if (!m_service.Browse(rootID, 0, 1, vars))
+    return false;
+  uint32_t num = 0;
+  if (string_to_uint32(vars.GetValue("UpdateID").c_str(), &num) != 0)
+    return false;
+  updateID = num;
+  if (string_to_uint32(vars.GetValue("TotalMatches").c_str(), &num) != 0)
+    return false;
+  count = num;
+  return true;
+}
+
+bool ContentIndex::Crawl(Search_t search, DigitalItemList& items, unsigned& updateID)
+{
+  ContentList list(m_service, ContentSearch(search, ""), BROWSE_COUNT, CONTENTINDEX_PREFETCH);
+  items.reserve(list.size());
+  for (ContentList::iterator it = list.begin(); it != list.end(); ++it)
+    items.push_back(*it);
+  if (list.failure())
+  {
+    DBG(DBG_WARN, "%s: crawling failed (%u/%u)\n", __FUNCTION__, (unsigned)items.size(), list.size());
+    return false;
+  }
+  updateID = list.GetUpdateID();
+  return true;
+}
+
+SHARED_PTR<ContentIndex::Postings> ContentIndex::Build(const DigitalItemList& items)
+{
+  SHARED_PTR<Postings> data(new Postings());
+  std::map<std::string, std::vector<uint32_t> > dict;
+  std::vector<std::string> words;
+  std::string value;
+  data->items = items;
+  for (uint32_t ref = 0; ref < (uint32_t) items.size(); ++ref)
+  {
+    for (const char ** key = IndexedKeys; *key; ++key)
+    {
+      // read the value without building the elements of the item
+      if (!items[ref]->FindValue(*key, value))
+        continue;
+      words.clear();
+      Tokenize(value, words);
+      for (std::vector<std::string>::const_iterator itw = words.begin(); itw != words.end(); ++itw)
+      {
+        std::vector<uint32_t>& refs = dict[*itw];
+        if (refs.empty() || refs.back() != ref)
+          refs.push_back(ref);
+      }
+    }
+  }
+  // flatten the dictionary
+  data->words.reserve(dict.size());
+  data->offsets.reserve(dict.size() + 1);
+  for (std::map<std::string, std::vector<uint32_t> >::const_iterator it = dict.begin(); it != dict.end(); ++it)
+  {
+    data->words.push_back(it->first);
+    data->offsets.push_back((uint32_t) data->refs.size());
+    data->refs.insert(data->refs.end(), it->second.begin(), it->second.end());
+  }
+  data->offsets.push_back((uint32_t) data->refs.size());
+  DBG(DBG_DEBUG, "%s: %u items, %u words\n", __FUNCTION__, (unsigned)data->items.size(), (unsigned)data->words.size());
+  return data;
+}
+
+void ContentIndex::Tokenize(const std::string& str, std::vector<std::string>& tokens)
+{
+  std::string token;
+  for (std::string::const_iterator it = str.begin(); it != str.end(); ++it)
+  {
+    unsigned char c = (unsigned char) *it;
+    // bytes of multibyte UTF-8 sequences are kept as is
+    if (c >= 0x80 || (c >= '0' && c <= '9') || (c >= 'a' && c <= 'z'))
+      token.push_back((char) c);
+    else if (c >= 'A' && c <= 'Z')
+      token.push_back((char) (c + ('a' - 'A')));
+    else if (!token.empty())
+    {
+      tokens.push_back(token);
+      token.clear();
+    }
+  }
+  if (!token.empty())
+    tokens.push_back(token);
+}
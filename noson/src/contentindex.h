@@ -0,0 +1,110 @@
+/*
+ *      Copyright (C) 2026 Jean-Luc Barriere
+ *
+ *  This file is part of Noson
+ *
+ *  Noson is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  Noson is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#ifndef CONTENTINDEX_H
+#define	CONTENTINDEX_H
+
+#include "local_config.h"
+#include "contentdirectory.h"
+#include "digitalitem.h"
+#include "sonostypes.h"
+
+#include <string>
+#include <vector>
+
+#define CONTENTINDEX_PREFETCH 2
+
+namespace NSROOT
+{
+  namespace OS
+  {
+    class CMutex;
+  }
+
+  /**
+   * The local index of the music library. It is built by crawling the tracks,
+   * the albums and the contributors, then it resolves the searches by words
+   * without requesting the device.
+   */
+  class ContentIndex
+  {
+  public:
+    ContentIndex(ContentDirectory& service);
+    ~ContentIndex();
+    ContentIndex(const ContentIndex&) = delete;
+    ContentIndex& operator=(const ContentIndex&) = delete;
+
+    /**
+     * Crawl the roots not yet indexed, and those changed according to the
+     * container update IDs of the given property. Nothing is done while the
+     * share index is in progress.
+     * @param property The content property of the service
+     * @return true if the index is up to date
+     */
+    bool Refresh(const ContentProperty& property);
+
+    /**
+     * Search the items matching all the words of the query. A word matches
+     * any word of the title, the creator or the album starting with it. The
+     * case of ASCII letters is ignored.
+     * @param search SearchTrack, SearchAlbum or SearchContributor
+     * @param query The words to search
+     * @param max The max count of items to return, 0 for no limit
+     * @return The matching items in the order of the library
+     */
+    DigitalItemList Search(Search_t search, const std::string& query, unsigned max = 0) const;
+
+    /**
+     * Index the given items for the search type, in place of those crawled.
+     * @param search SearchTrack, SearchAlbum or SearchContributor
+     * @param items The items of the root in the order of the library
+     */
+    void Assign(Search_t search, const DigitalItemList& items);
+
+    /**
+     * Check the search type is handled by the index.
+     */
+    static bool IsIndexed(Search_t search);
+
+    /**
+     * Split the string into lowercase words of ASCII letters and digits. The
+     * bytes of multibyte UTF-8 sequences are kept as is.
+     */
+    static void Tokenize(const std::string& str, std::vector<std::string>& tokens);
+
+    unsigned size() const;
+
+  private:
+    struct Postings;
+    struct Root;
+
+    ContentDirectory& m_service;
+    mutable OS::CMutex* m_mutex;
+    std::vector<Root*> m_roots;
+
+    Root* FindRoot(Search_t search) const;
+    bool Probe(const std::string& rootID, unsigned& updateID, unsigned& count);
+    bool Crawl(Search_t search, DigitalItemList& items, unsigned& updateID);
+
+    static SHARED_PTR<Postings> Build(const DigitalItemList& items);
+  };
+}
+
+#endif	/* CONTENTINDEX_H */
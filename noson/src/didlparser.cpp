@@ -21,9 +21,12 @@
 #include "didlparser.h"
 #include "private/tinyxml2.h"
 #include "private/xmldict.h"
+#include "private/itemarena.h"
 #include "private/debug.h"
 #include "private/cppdef.h"
 
+#include <cstring>
+
 using namespace NSROOT;
 
 namespace NSROOT
@@ -38,6 +41,55 @@ namespace NSROOT
     return dict;
   }
   static XMLDict DIDLDict = __initDIDLDict();
+
+  /**
+   * The keys of the names met in a document. The names of the elements are
+   * translated and interned once, then found by comparing the raw names.
+   */
+  class DIDLNames
+  {
+  public:
+    DIDLNames(ItemArena& arena, const XMLNames& xmlnames)
+    : m_arena(arena), m_xmlnames(xmlnames) {}
+
+    uint16_t ElementKey(const char* qname)
+    {
+      int id = Find(m_elements, qname);
+      if (id < 0)
+      {
+        id = m_arena.Intern(DIDLDict.TranslateQName(m_xmlnames, qname));
+        m_elements.push_back(Name(qname, (uint16_t) id));
+      }
+      return (uint16_t) id;
+    }
+
+    uint16_t AttributeKey(const char* name)
+    {
+      int id = Find(m_attributes, name);
+      if (id < 0)
+      {
+        id = m_arena.Intern(name);
+        m_attributes.push_back(Name(name, (uint16_t) id));
+      }
+      return (uint16_t) id;
+    }
+
+  private:
+    // the raw name points into the parsed document
+    typedef std::pair<const char*, uint16_t> Name;
+    ItemArena& m_arena;
+    const XMLNames& m_xmlnames;
+    std::vector<Name> m_elements;
+    std::vector<Name> m_attributes;
+
+    static int Find(const std::vector<Name>& names, const char* name)
+    {
+      for (std::vector<Name>::const_iterator it = names.begin(); it != names.end(); ++it)
+        if (strcmp(it->first, name) == 0)
+          return it->second;
+      return -1;
+    }
+  };
 }
 
 DIDLParser::DIDLParser(const char* document, unsigned reserve)
@@ -71,6 +123,32 @@ bool DIDLParser::Parse()
     // learn declared namespaces in the element the DIDL-Lite for translations
     XMLNames xmlnames;
     xmlnames.AddXMLNS(elem);
+    // the properties of all items are stored in one arena, sized by a first
+    // pass over the tree so the strings are copied into a single block
+    SHARED_PTR<ItemArena> arena(new ItemArena());
+    DIDLNames names(*arena, xmlnames);
+    size_t count = 0, fields = 0, bytes = 0;
+    for (const tinyxml2::XMLElement* ielem = elem->FirstChildElement(); ielem; ielem = ielem->NextSiblingElement())
+    {
+      ++count;
+      for (const tinyxml2::XMLElement* velem = ielem->FirstChildElement(); velem; velem = velem->NextSiblingElement())
+      {
+        const char* text;
+        if (velem->Name() && (text = velem->GetText()))
+        {
+          ++fields;
+          bytes += strlen(text);
+          for (const tinyxml2::XMLAttribute* vattr = velem->FirstAttribute(); vattr && vattr->Name() && vattr->Value(); vattr = vattr->Next())
+          {
+            ++fields;
+            bytes += strlen(vattr->Value());
+          }
+        }
+      }
+    }
+    arena->Reserve(fields, bytes);
+    if (m_items.capacity() < count)
+      m_items.reserve(count);
     // loop over elements
     elem = elem->FirstChildElement();
     while (elem)
@@ -89,24 +167,24 @@ bool DIDLParser::Parse()
           ref.restricted = true;
         else
           ref.restricted = false;
-        ElementList vars;
+        unsigned first = arena->FieldCount();
         const tinyxml2::XMLElement* velem = elem->FirstChildElement();
         while (velem)
         {
-          if (velem->Name() && velem->GetText())
+          const char* text;
+          if (velem->Name() && (text = velem->GetText()))
           {
-            ElementPtr var(new Element(DIDLDict.TranslateQName(xmlnames, velem->Name()), velem->GetText()));
+            arena->AddElement(names.ElementKey(velem->Name()), text, strlen(text));
             const tinyxml2::XMLAttribute* vattr = velem->FirstAttribute();
             while (vattr && vattr->Name() && vattr->Value())
             {
-              var->SetAttribut(vattr->Name(), vattr->Value());
+              arena->AddAttribute(names.AttributeKey(vattr->Name()), vattr->Value(), strlen(vattr->Value()));
               vattr = vattr->Next();
             }
-            vars.push_back(var);
           }
           velem = velem->NextSiblingElement();
         }
-        m_items.push_back(DigitalItemPtr(new DigitalItem(ref.id, ref.parentID, ref.restricted, vars)));
+        m_items.push_back(DigitalItemPtr(new DigitalItem(ref.id, ref.parentID, ref.restricted, arena, first, arena->FieldCount() - first)));
       }
       elem = elem->NextSiblingElement();
     }
@@ -21,9 +21,11 @@
 #include "digitalitem.h"
 #include "didlparser.h"
 #include "private/builtin.h"
-#include "private/tokenizer.h"
+#include "private/itemarena.h"
+#include "private/cppdef.h"
 
 #include <vector>
+#include <cstring>
 
 using namespace NSROOT;
 
@@ -42,6 +44,8 @@ DigitalItem::DigitalItem()
 , m_restricted(false)
 , m_objectID("")
 , m_parentID("")
+, m_first(0)
+, m_count(0)
 {
   ElementPtr _class(new Element(DIDL_QNAME_UPNP "class"));
   _class->assign("object");
@@ -54,6 +58,8 @@ DigitalItem::DigitalItem(Type_t _type, SubType_t _subType)
 , m_restricted(false)
 , m_objectID("")
 , m_parentID("")
+, m_first(0)
+, m_count(0)
 {
   ElementPtr _class(new Element(DIDL_QNAME_UPNP "class"));
   _class->assign("object");
@@ -73,30 +79,130 @@ DigitalItem::DigitalItem(const std::string& objectID, const std::string& parentI
 , m_objectID(objectID)
 , m_parentID(parentID)
 , m_vars(vars)
+, m_first(0)
+, m_count(0)
 {
   ElementList::const_iterator it;
   if ((it = vars.FindKey(DIDL_QNAME_UPNP "class")) != vars.end())
+    SetClass((*it)->c_str(), (*it)->size());
+}
+
+DigitalItem::DigitalItem(const std::string& objectID, const std::string& parentID, bool restricted, const SHARED_PTR<ItemArena>& arena, unsigned first, unsigned count)
+: m_type(Type_unknown)
+, m_subType(SubType_unknown)
+, m_restricted(restricted)
+, m_objectID(objectID)
+, m_parentID(parentID)
+, m_arena(arena)
+, m_first(first)
+, m_count(count)
+{
+  int i = arena->FindElement(m_first, m_count, arena->FindKey(DIDL_QNAME_UPNP "class"));
+  if (i >= 0)
+    SetClass(arena->GetField(i).value, arena->GetField(i).size);
+}
+
+DigitalItem::~DigitalItem()
+{
+}
+
+void DigitalItem::SetClass(const char* _class, size_t len)
+{
+  // parse "object.<type>[.<subtype>[...]]" without copying the tokens
+  const char* end = _class + len;
+  const char* p = static_cast<const char*>(memchr(_class, '.', len));
+  if (!p || p - _class != 6 || strncmp(_class, "object", 6) != 0)
+    return;
+  const char* token = ++p;
+  while (p < end && *p != '.')
+    ++p;
+  size_t size = p - token;
+  if (size == strlen(TypeTable[Type_container]) && strncmp(token, TypeTable[Type_container], size) == 0)
+    m_type = Type_container;
+  else
+    m_type = Type_item;
+  if (p == end)
+    return;
+  token = ++p;
+  while (p < end && *p != '.')
+    ++p;
+  size = p - token;
+  for (unsigned i = 0; i < SubType_unknown; ++i)
   {
-    std::vector<std::string> tokens;
-    tokenize((*it)->c_str(), ".", tokens);
-    if (tokens.size() >= 2 && tokens[0] == "object")
-    {
-      if (tokens[1] == TypeTable[Type_container])
-        m_type = Type_container;
-      else
-        m_type = Type_item;
-      if (tokens.size() >= 3)
-      {
-        for (unsigned i = 0; i < SubType_unknown; ++i)
-        {
-          if (tokens[2] != SubTypeTable[i])
-            continue;
-          m_subType = (SubType_t)i;
-          break;
-        }
-      }
-    }
+    if (size != strlen(SubTypeTable[i]) || strncmp(token, SubTypeTable[i], size) != 0)
+      continue;
+    m_subType = (SubType_t)i;
+    break;
+  }
+}
+
+const ElementPtr& DigitalItem::Built(const ItemArena& arena, unsigned index) const
+{
+  for (std::vector<std::pair<unsigned, ElementPtr> >::const_iterator it = m_built.begin(); it != m_built.end(); ++it)
+  {
+    if (it->first == index)
+      return it->second;
+  }
+  const ItemArena::Field& field = arena.GetField(index);
+  ElementPtr var(new Element(arena.Key(field.key), std::string(field.value, field.size)));
+  unsigned end = m_first + m_count;
+  unsigned i = index + 1;
+  for (unsigned a = field.attrs; a > 0 && i < end; --a)
+  {
+    const ItemArena::Field& attr = arena.GetField(i++);
+    var->SetAttribut(arena.Key(attr.key), std::string(attr.value, attr.size));
+  }
+  m_built.push_back(std::make_pair(index, var));
+  return m_built.back().second;
+}
+
+void DigitalItem::Expand()
+{
+  if (!m_arena)
+    return;
+  ItemArena& arena = *m_arena;
+  {
+    OS::CLockGuard lock(arena.GetMutex());
+    m_vars.clear();
+    m_vars.reserve(m_count);
+    // the elements already read are kept
+    unsigned end = m_first + m_count;
+    for (unsigned i = m_first; i < end; i += arena.GetField(i).attrs + 1)
+      m_vars.push_back(Built(arena, i));
+    m_built.clear();
+  }
+  // release the arena, it is freed with the last item viewing it
+  m_arena.reset();
+}
+
+const std::string& DigitalItem::GetValue(const std::string& key) const
+{
+  if (!m_arena)
+    return m_vars.GetValue(key);
+  ItemArena& arena = *m_arena;
+  int i = arena.FindElement(m_first, m_count, arena.FindKey(key));
+  if (i < 0)
+    return Element::Nil();
+  OS::CLockGuard lock(arena.GetMutex());
+  return *Built(arena, (unsigned) i);
+}
+
+bool DigitalItem::FindValue(const std::string& key, std::string& value) const
+{
+  if (!m_arena)
+  {
+    ElementList::const_iterator it = m_vars.FindKey(key);
+    if (it == m_vars.end() || !(*it))
+      return false;
+    value.assign(**it);
+    return true;
   }
+  const ItemArena& arena = *m_arena;
+  int i = arena.FindElement(m_first, m_count, arena.FindKey(key));
+  if (i < 0)
+    return false;
+  value.assign(arena.GetField(i).value, arena.GetField(i).size);
+  return true;
 }
 
 void DigitalItem::Clone(DigitalItem& _item) const
@@ -106,12 +212,57 @@ void DigitalItem::Clone(DigitalItem& _item) const
   _item.m_restricted  = this->m_restricted;
   _item.m_objectID    = this->m_objectID;
   _item.m_parentID    = this->m_parentID;
-  this->m_vars.Clone(_item.m_vars);
+  _item.m_built.clear();
+  if (m_arena)
+  {
+    // share the view on the arena, the fields are only read
+    _item.m_vars.clear();
+    _item.m_arena = m_arena;
+    _item.m_first = m_first;
+    _item.m_count = m_count;
+  }
+  else
+  {
+    m_vars.Clone(_item.m_vars);
+    _item.m_arena.reset();
+  }
+}
+
+size_t DigitalItem::Footprint() const
+{
+  size_t bytes = sizeof(DigitalItem) + m_objectID.capacity() + m_parentID.capacity();
+  if (m_arena)
+  {
+    ItemArena& arena = *m_arena;
+    for (unsigned i = m_first; i < m_first + m_count; ++i)
+      bytes += sizeof(ItemArena::Field) + arena.GetField(i).size + 1;
+    OS::CLockGuard lock(arena.GetMutex());
+    for (std::vector<std::pair<unsigned, ElementPtr> >::const_iterator it = m_built.begin(); it != m_built.end(); ++it)
+      bytes += sizeof(*it) + sizeof(Element) + it->second->capacity();
+  }
+  else
+  {
+    for (ElementList::const_iterator it = m_vars.begin(); it != m_vars.end(); ++it)
+    {
+      if (*it)
+        bytes += sizeof(ElementPtr) + sizeof(Element) + (*it)->capacity() + (*it)->GetKey().capacity();
+    }
+  }
+  return bytes;
 }
 
 std::vector<ElementPtr> DigitalItem::GetElements() const
 {
   std::vector<ElementPtr> list;
+  if (m_arena)
+  {
+    ItemArena& arena = *m_arena;
+    OS::CLockGuard lock(arena.GetMutex());
+    unsigned end = m_first + m_count;
+    for (unsigned i = m_first; i < end; i += arena.GetField(i).attrs + 1)
+      list.push_back(Built(arena, i));
+    return list;
+  }
   ElementList::const_iterator it = m_vars.begin();
   if (it != m_vars.end())
   {
@@ -124,6 +275,15 @@ std::vector<ElementPtr> DigitalItem::GetElements() const
 
 ElementPtr DigitalItem::GetProperty(const std::string& key) const
 {
+  if (m_arena)
+  {
+    ItemArena& arena = *m_arena;
+    int i = arena.FindElement(m_first, m_count, arena.FindKey(key));
+    if (i < 0)
+      return ElementPtr(NULL);
+    OS::CLockGuard lock(arena.GetMutex());
+    return Built(arena, (unsigned) i);
+  }
   ElementList::const_iterator it = m_vars.FindKey(key);
   if (it != m_vars.end())
     return *it;
@@ -134,6 +294,21 @@ ElementPtr DigitalItem::GetProperty(const std::string& key) const
 std::vector<ElementPtr> DigitalItem::GetCollection(const std::string& key) const
 {
   std::vector<ElementPtr> list;
+  if (m_arena)
+  {
+    ItemArena& arena = *m_arena;
+    int k = arena.FindKey(key);
+    unsigned end = m_first + m_count;
+    int i = arena.FindElement(m_first, m_count, k);
+    OS::CLockGuard lock(arena.GetMutex());
+    while (i >= 0)
+    {
+      list.push_back(Built(arena, (unsigned) i));
+      unsigned next = i + arena.GetField(i).attrs + 1;
+      i = (next < end ? arena.FindElement(next, end - next, k) : -1);
+    }
+    return list;
+  }
   ElementList::const_iterator it = m_vars.FindKey(key);
   if (it != m_vars.end())
   {
@@ -148,6 +323,7 @@ void DigitalItem::SetProperty(const ElementPtr& var)
 {
   if (var)
   {
+    Expand();
     ElementList::iterator it = m_vars.FindKey(var->GetKey());
     if (it != m_vars.end())
       *it = var;
@@ -158,6 +334,7 @@ void DigitalItem::SetProperty(const ElementPtr& var)
 
 void DigitalItem::RemoveProperty(const std::string& key)
 {
+  Expand();
   ElementList::iterator it = m_vars.FindKey(key);
   if (it != m_vars.end())
     m_vars.erase(it);
@@ -166,23 +343,54 @@ void DigitalItem::RemoveProperty(const std::string& key)
 std::string DigitalItem::DIDL() const
 {
   std::string xml;
-  xml.append("<DIDL-Lite").append(DIDLParser::DIDLNSString()).append(">");
+  DIDL(xml);
+  return xml;
+}
+
+void DigitalItem::DIDL(std::string& out) const
+{
+  out.append("<DIDL-Lite").append(DIDLParser::DIDLNSString()).append(">");
   if (m_type != Type_unknown)
   {
-    xml.append("<").append(TypeTable[m_type]);
+    out.append("<").append(TypeTable[m_type]);
     if (!m_objectID.empty())
     {
-      xml.append(" id=\"").append(m_objectID).append("\" parentID=\"").append(m_parentID).append("\"");
-      xml.append(" restricted=\"").append((m_restricted ? "true" : "false")).append("\"");
+      out.append(" id=\"").append(m_objectID).append("\" parentID=\"").append(m_parentID).append("\"");
+      out.append(" restricted=\"").append((m_restricted ? "true" : "false")).append("\"");
     }
-    xml.append(">");
-    for (ElementList::const_iterator it = m_vars.begin(); it != m_vars.end(); ++it)
+    out.append(">");
+    if (m_arena)
     {
-      if (*it)
-        xml.append((*it)->XML());
+      // write the fields from the arena without building the elements
+      const ItemArena& arena = *m_arena;
+      unsigned end = m_first + m_count;
+      unsigned i = m_first;
+      while (i < end)
+      {
+        const ItemArena::Field& field = arena.GetField(i++);
+        const std::string& key = arena.Key(field.key);
+        out.append("<").append(key);
+        for (unsigned a = field.attrs; a > 0 && i < end; --a)
+        {
+          const ItemArena::Field& attr = arena.GetField(i++);
+          out.append(" ").append(arena.Key(attr.key)).append("=\"");
+          Element::XMLEncode(attr.value, attr.size, out);
+          out.append("\"");
+        }
+        out.append(">");
+        Element::XMLEncode(field.value, field.size, out);
+        out.append("</").append(key).append(">");
+      }
+    }
+    else
+    {
+      for (ElementList::const_iterator it = m_vars.begin(); it != m_vars.end(); ++it)
+      {
+        if (*it)
+          (*it)->XML(out);
+      }
     }
-    xml.append("</").append(TypeTable[m_type]).append(">");
+    out.append("</").append(TypeTable[m_type]).append(">");
   }
-  xml.append("</DIDL-Lite>");
-  return xml;
+  out.append("</DIDL-Lite>");
 }
@@ -25,16 +25,21 @@
 #include "element.h"
 #include "sharedptr.h"
 
+#include <vector>
+
 namespace NSROOT
 {
 
   class DigitalItem;
+  class DIDLParser;
+  class ItemArena;
 
   typedef SHARED_PTR<DigitalItem> DigitalItemPtr;
   typedef std::vector<DigitalItemPtr> DigitalItemList;
 
   class DigitalItem
   {
+    friend class DIDLParser;
   public:
     typedef enum
     {
@@ -70,7 +75,7 @@ namespace NSROOT
     DigitalItem();
     DigitalItem(Type_t _type, SubType_t _subType = SubType_unknown);
     DigitalItem(const std::string& objectID, const std::string& parentID, bool restricted, const ElementList& vars);
-    virtual ~DigitalItem() {}
+    virtual ~DigitalItem();
     DigitalItem(const DigitalItem&) = delete;
     DigitalItem& operator=(const DigitalItem&) = delete;
 
@@ -94,7 +99,18 @@ namespace NSROOT
 
     void SetRestricted(bool val) { m_restricted = val; }
 
-    const std::string& GetValue(const std::string& key) const { return m_vars.GetValue(key); }
+    /**
+     * Return the value of the property. For an item parsed in compact storage
+     * only the element read is built, and it is kept with the item.
+     */
+    const std::string& GetValue(const std::string& key) const;
+
+    /**
+     * Copy the value of the property. Unlike the accessors of elements, it
+     * does not build the elements of an item parsed in compact storage.
+     * @return false if the property is not found
+     */
+    bool FindValue(const std::string& key, std::string& value) const;
 
     ElementPtr GetProperty(const std::string& key) const;
 
@@ -110,10 +126,16 @@ namespace NSROOT
 
     std::string DIDL() const;
 
+    // append the DIDL document of the item into the buffer
+    void DIDL(std::string& out) const;
+
     void Clone(DigitalItem& _item) const;
 
     std::vector<ElementPtr> GetElements() const;
 
+    // the approximate bytes held by the item, with its fields in compact storage
+    size_t Footprint() const;
+
   private:
     Type_t m_type;
     SubType_t m_subType;
@@ -122,6 +144,21 @@ namespace NSROOT
     std::string m_objectID;
     std::string m_parentID;
     ElementList m_vars;
+    // a view on the fields of the item in the arena, when parsed in compact
+    // storage, released once the item is changed
+    SHARED_PTR<ItemArena> m_arena;
+    unsigned m_first;
+    unsigned m_count;
+    // the elements read from the arena, by field index
+    mutable std::vector<std::pair<unsigned, ElementPtr> > m_built;
+
+    DigitalItem(const std::string& objectID, const std::string& parentID, bool restricted, const SHARED_PTR<ItemArena>& arena, unsigned first, unsigned count);
+    void SetClass(const char* _class, size_t len);
+    // the element of the field in the arena, built on first call. The mutex
+    // of the arena must be held.
+    const ElementPtr& Built(const ItemArena& arena, unsigned index) const;
+    // build all the elements and release the arena, before a change
+    void Expand();
 
     static const char* TypeTable[Type_unknown + 1];
     static const char* SubTypeTable[SubType_unknown + 1];
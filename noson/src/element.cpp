@@ -0,0 +1,142 @@
+/*
+ *      Copyright (C) 2026 Jean-Luc Barriere
+ *
+ *  This file is part of Noson
+ *
+ *  Noson is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  Noson is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#include "element.h"
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define ELEMENT_SSE2
+#include <emmintrin.h>
+#elif defined(__ARM_NEON) && defined(__aarch64__)
+#define ELEMENT_NEON
+#include <arm_neon.h>
+#endif
+
+using namespace NSROOT;
+
+namespace NSROOT
+{
+  static inline const char* __xml_escape(char c)
+  {
+    switch (c)
+    {
+    case '&': return "&amp;";
+    case '<': return "&lt;";
+    case '>': return "&gt;";
+    case '"': return "&quot;";
+    default:  return nullptr;
+    }
+  }
+
+  // return the position of the first char to escape, or len
+  static size_t __xml_scan(const char* str, size_t len)
+  {
+    size_t i = 0;
+#if defined(ELEMENT_SSE2)
+    const __m128i amp = _mm_set1_epi8('&');
+    const __m128i lt = _mm_set1_epi8('<');
+    const __m128i gt = _mm_set1_epi8('>');
+    const __m128i quot = _mm_set1_epi8('"');
+    for (; i + 16 <= len; i += 16)
+    {
+      __m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i*>(str + i));
+      __m128i m = _mm_or_si128(_mm_or_si128(_mm_cmpeq_epi8(v, amp), _mm_cmpeq_epi8(v, lt)),
+                               _mm_or_si128(_mm_cmpeq_epi8(v, gt), _mm_cmpeq_epi8(v, quot)));
+      int mask = _mm_movemask_epi8(m);
+      if (mask)
+      {
+#if defined(_MSC_VER)
+        unsigned long bit;
+        _BitScanForward(&bit, (unsigned long) mask);
+        return i + bit;
+#else
+        return i + __builtin_ctz((unsigned) mask);
+#endif
+      }
+    }
+#elif defined(ELEMENT_NEON)
+    const uint8x16_t amp = vdupq_n_u8('&');
+    const uint8x16_t lt = vdupq_n_u8('<');
+    const uint8x16_t gt = vdupq_n_u8('>');
+    const uint8x16_t quot = vdupq_n_u8('"');
+    for (; i + 16 <= len; i += 16)
+    {
+      uint8x16_t v = vld1q_u8(reinterpret_cast<const uint8_t*>(str + i));
+      uint8x16_t m = vorrq_u8(vorrq_u8(vceqq_u8(v, amp), vceqq_u8(v, lt)),
+                              vorrq_u8(vceqq_u8(v, gt), vceqq_u8(v, quot)));
+      if (vmaxvq_u8(m))
+        break; // locate the hit below
+    }
+#endif
+    for (; i < len; ++i)
+    {
+      if (__xml_escape(str[i]))
+        break;
+    }
+    return i;
+  }
+}
+
+void Element::XMLEncode(const char* str, size_t len, std::string& out)
+{
+  while (len > 0)
+  {
+    // copy the clean run in bulk, then escape the hit
+    size_t n = __xml_scan(str, len);
+    out.append(str, n);
+    if (n == len)
+      break;
+    out.append(__xml_escape(str[n]));
+    str += n + 1;
+    len -= n + 1;
+  }
+}
+
+void Element::XML(std::string& out) const
+{
+  out.append("<").append(m_key);
+  for (std::vector<Element>::const_iterator it = m_attrs.begin(); it != m_attrs.end(); ++it)
+  {
+    out.append(" ").append(it->m_key).append("=\"");
+    XMLEncode(it->data(), it->size(), out);
+    out.append("\"");
+  }
+  out.append(">");
+  XMLEncode(data(), size(), out);
+  out.append("</").append(m_key).append(">");
+}
+
+void Element::XML(const std::string& ns, std::string& out) const
+{
+  if (ns.empty())
+  {
+    XML(out);
+    return;
+  }
+  out.append("<").append(ns).append(":").append(m_key);
+  for (std::vector<Element>::const_iterator it = m_attrs.begin(); it != m_attrs.end(); ++it)
+  {
+    out.append(" ").append(it->m_key).append("=\"");
+    XMLEncode(it->data(), it->size(), out);
+    out.append("\"");
+  }
+  out.append(">");
+  XMLEncode(data(), size(), out);
+  out.append("</").append(ns).append(":").append(m_key).append(">");
+}
@@ -49,25 +49,21 @@ namespace NSROOT
     std::string XML() const
     {
       std::string ret;
-      ret.append("<").append(m_key);
-      for (std::vector<Element>::const_iterator it = m_attrs.begin(); it != m_attrs.end(); ++it)
-        ret.append(" ").append(it->m_key).append("=\"").append(it->XMLEncoded()).append("\"");
-      ret.append(">").append(XMLEncoded()).append("</").append(m_key).append(">");
+      XML(ret);
       return ret;
     }
 
     std::string XML(const std::string& ns) const
     {
-      if (ns.empty())
-        return XML();
       std::string ret;
-      ret.append("<").append(ns).append(":").append(m_key);
-      for (std::vector<Element>::const_iterator it = m_attrs.begin(); it != m_attrs.end(); ++it)
-        ret.append(" ").append(it->m_key).append("=\"").append(it->XMLEncoded()).append("\"");
-      ret.append(">").append(XMLEncoded()).append("</").append(ns).append(":").append(m_key).append(">");
+      XML(ns, ret);
       return ret;
     }
 
+    // append the XML of the element into the buffer
+    void XML(std::string& out) const;
+    void XML(const std::string& ns, std::string& out) const;
+
     const std::string& GetKey() const { return m_key; }
 
     void SetAttribut(const Element& var)
@@ -100,22 +96,16 @@ namespace NSROOT
     {
       std::string ret;
       ret.reserve(size());
-      for (std::string::const_iterator it = begin(); it != end(); ++it)
-      {
-        if (*it == '&')
-          ret.append("&amp;");
-        else if (*it == '<')
-          ret.append("&lt;");
-        else if (*it == '>')
-          ret.append("&gt;");
-        else if (*it == '"')
-          ret.append("&quot;");
-        else
-          ret.push_back(*it);
-      }
+      XMLEncode(data(), size(), ret);
       return ret;
     }
 
+    /**
+     * Append the string escaped for XML into the buffer. The clean runs are
+     * copied in bulk.
+     */
+    static void XMLEncode(const char* str, size_t len, std::string& out);
+
   private:
     std::string m_key;
     std::vector<Element> m_attrs;
@@ -0,0 +1,287 @@
+/*
+ *      Copyright (C) 2026 Jean-Luc Barriere
+ *
+ *  This file is part of Noson
+ *
+ *  Noson is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  Noson is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#include "federatedsearch.h"
+#include "sonossystem.h"
+#include "contentdirectory.h"
+#include "smapi.h"
+#include "private/debug.h"
+#include "private/cppdef.h"
+#include "private/federatedstate.h"
+#include "private/os/threads/threadpool.h"
+
+using namespace NSROOT;
+
+FederatedSearchPool::FederatedSearchPool(unsigned threads, unsigned threadsPerSource)
+: m_pool(nullptr)
+, m_threads(threads)
+, m_threadsPerSource(threadsPerSource)
+{
+}
+
+FederatedSearchPool::~FederatedSearchPool()
+{
+  if (m_pool)
+  {
+    m_pool->Reset();
+    delete m_pool;
+  }
+}
+
+bool FederatedSearchPool::Enqueue(OS::CWorker* worker)
+{
+  OS::CLockGuard lock(m_mutex);
+  // the pool is created on first use
+  if (!m_pool)
+    m_pool = new OS::CThreadPool(m_threads);
+  return m_pool->Enqueue(worker);
+}
+
+bool FederatedSearchPool::Acquire(const std::string& sourceId)
+{
+  OS::CLockGuard lock(m_mutex);
+  unsigned& running = m_running[sourceId];
+  if (running >= m_threadsPerSource)
+    return false;
+  ++running;
+  return true;
+}
+
+void FederatedSearchPool::Release(const std::string& sourceId)
+{
+  OS::CLockGuard lock(m_mutex);
+  std::map<std::string, unsigned>::iterator it = m_running.find(sourceId);
+  if (it != m_running.end() && --(it->second) == 0)
+    m_running.erase(it);
+}
+
+namespace NSROOT
+{
+  static FederatedSearchPool SearchPool(FEDERATEDSEARCH_THREADS, FEDERATEDSEARCH_SOURCE_THREADS);
+
+  /**
+   * Search the local library through the ContentDirectory of the device.
+   */
+  class LocalSearchWorker : public OS::CWorker
+  {
+  public:
+    LocalSearchWorker(const SHARED_PTR<FederatedSearch::State>& state, unsigned index,
+                      const std::string& host, unsigned port, const std::string& term,
+                      const std::vector<std::string>& categories, unsigned count)
+    : m_state(state), m_index(index), m_host(host), m_port(port), m_term(term)
+    , m_categories(categories), m_count(count) { }
+
+    void Process() override
+    {
+      if (!m_state->Begin(m_index))
+        return;
+      ContentDirectory service(m_host, m_port);
+      for (std::vector<std::string>::const_iterator it = m_categories.begin(); it != m_categories.end(); ++it)
+      {
+        Search_t search = SearchType(*it);
+        if (search == Search_unknown)
+          continue;
+        if (m_state->IsDone(m_index))
+          break;
+        ContentBrowser browser(service, ContentSearch(search, m_term), m_count);
+        FederatedResult result;
+        result.status = FederatedResult::Succeeded;
+        result.category.assign(*it);
+        result.totalCount = browser.total();
+        result.items.swap(browser.table());
+        m_state->Push(m_index, result);
+      }
+      m_state->Finish(m_index);
+    }
+
+  private:
+    SHARED_PTR<FederatedSearch::State> m_state;
+    unsigned m_index;
+    std::string m_host;
+    unsigned m_port;
+    std::string m_term;
+    std::vector<std::string> m_categories;
+    unsigned m_count;
+
+    static Search_t SearchType(const std::string& category)
+    {
+      if (category == "artists")
+        return SearchArtist;
+      if (category == "albums")
+        return SearchAlbum;
+      if (category == "tracks")
+        return SearchTrack;
+      if (category == "genres")
+        return SearchGenre;
+      if (category == "composers")
+        return SearchComposer;
+      if (category == "playlists")
+        return SearchPlaylist;
+      return Search_unknown;
+    }
+  };
+
+  /**
+   * Search a music service through its SMAPI end-point.
+   */
+  class ServiceSearchWorker : public OS::CWorker
+  {
+  public:
+    ServiceSearchWorker(const SHARED_PTR<FederatedSearch::State>& state, unsigned index,
+                        SMAPI* smapi, const SMServicePtr& service, const std::string& locale,
+                        const std::string& term, const std::vector<std::string>& categories, unsigned count)
+    : m_state(state), m_index(index), m_smapi(smapi), m_service(service), m_locale(locale)
+    , m_term(term), m_categories(categories), m_count(count) { }
+
+    ~ServiceSearchWorker() override
+    {
+      SAFE_DELETE(m_smapi);
+    }
+
+    void Process() override
+    {
+      if (!m_state->Begin(m_index))
+        return;
+      if (!m_smapi->Init(m_service, m_locale))
+      {
+        FederatedResult result;
+        result.status = FederatedResult::Failed;
+        m_state->Push(m_index, result);
+      }
+      else
+      {
+        const ElementList& available = m_smapi->AvailableSearchCategories();
+        for (std::vector<std::string>::const_iterator it = m_categories.begin(); it != m_categories.end(); ++it)
+        {
+          if (available.FindKey(*it) == available.end())
+            continue;
+          if (m_state->IsDone(m_index))
+            break;
+          SMAPIMetadata metadata;
+          FederatedResult result;
+          result.category.assign(*it);
+          if (m_smapi->Search(*it, m_term, 0, m_count, metadata))
+          {
+            result.status = FederatedResult::Succeeded;
+            result.totalCount = metadata.TotalCount();
+            result.serviceItems = metadata.GetItems();
+          }
+          else
+            result.status = FederatedResult::Failed;
+          m_state->Push(m_index, result);
+        }
+      }
+      m_state->Finish(m_index);
+    }
+
+  private:
+    SHARED_PTR<FederatedSearch::State> m_state;
+    unsigned m_index;
+    SMAPI* m_smapi;
+    SMServicePtr m_service;
+    std::string m_locale;
+    std::string m_term;
+    std::vector<std::string> m_categories;
+    unsigned m_count;
+  };
+}
+
+FederatedSearch::FederatedSearch(System& system, const std::string& locale)
+: m_system(system)
+, m_locale(locale)
+, m_deadline(FEDERATEDSEARCH_DEADLINE)
+, m_localEnabled(true)
+{
+}
+
+FederatedSearch::~FederatedSearch()
+{
+  Abort();
+}
+
+void FederatedSearch::SetDeadline(const std::string& serviceId, unsigned millisec)
+{
+  m_deadlines[serviceId] = millisec;
+}
+
+bool FederatedSearch::Start(const std::string& term, const std::vector<std::string>& categories, unsigned count)
+{
+  Abort();
+  if (term.empty() || categories.empty())
+    return false;
+  SHARED_PTR<State> state(new State(SearchPool));
+  std::vector<OS::CWorker*> workers;
+  std::map<std::string, unsigned>::const_iterator itd;
+
+  if (m_localEnabled && m_system.IsConnected())
+  {
+    unsigned deadline = ((itd = m_deadlines.find("")) != m_deadlines.end() ? itd->second : m_deadline);
+    state->AddSource("", SMServicePtr(), deadline);
+    workers.push_back(new LocalSearchWorker(state, (unsigned)workers.size(), m_system.GetHost(),
+                                            m_system.GetPort(), term, categories, count));
+  }
+  SMServiceList services = m_system.GetEnabledServices();
+  for (SMServiceList::const_iterator it = services.begin(); it != services.end(); ++it)
+  {
+    unsigned deadline = ((itd = m_deadlines.find((*it)->GetId())) != m_deadlines.end() ? itd->second : m_deadline);
+    state->AddSource((*it)->GetId(), *it, deadline);
+    workers.push_back(new ServiceSearchWorker(state, (unsigned)workers.size(), new SMAPI(m_system),
+                                              *it, m_locale, term, categories, count));
+  }
+  if (workers.empty())
+    return false;
+
+  DBG(DBG_DEBUG, "%s: searching (%s) in %u sources\n", __FUNCTION__, term.c_str(), (unsigned)workers.size());
+  m_state = state;
+  for (unsigned i = 0; i < workers.size(); ++i)
+  {
+    if (!SearchPool.Enqueue(workers[i]))
+    {
+      delete workers[i];
+      state->Finish(i);
+    }
+  }
+  return true;
+}
+
+bool FederatedSearch::Next(FederatedResult& result, unsigned timeout)
+{
+  SHARED_PTR<State> state(m_state);
+  if (!state)
+    return false;
+  return state->Next(result, timeout);
+}
+
+bool FederatedSearch::IsComplete() const
+{
+  SHARED_PTR<State> state(m_state);
+  if (!state)
+    return true;
+  return state->IsComplete();
+}
+
+void FederatedSearch::Abort()
+{
+  if (m_state)
+  {
+    m_state->Abort();
+    m_state.reset();
+  }
+}
@@ -0,0 +1,142 @@
+/*
+ *      Copyright (C) 2026 Jean-Luc Barriere
+ *
+ *  This file is part of Noson
+ *
+ *  Noson is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  Noson is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#ifndef FEDERATEDSEARCH_H
+#define FEDERATEDSEARCH_H
+
+#include "local_config.h"
+#include "sharedptr.h"
+#include "digitalitem.h"
+#include "musicservices.h"
+#include "smapimetadata.h"
+
+#include <string>
+#include <vector>
+#include <map>
+
+#define FEDERATEDSEARCH_DEADLINE  8000  // default deadline of a source in ms
+#define FEDERATEDSEARCH_COUNT     20    // default count of items per category
+#define FEDERATEDSEARCH_THREADS   8     // max count of sources searched at once
+#define FEDERATEDSEARCH_SOURCE_THREADS 1  // max count of threads held by a source at once
+
+namespace NSROOT
+{
+  class System;
+
+  struct FederatedResult
+  {
+    typedef enum
+    {
+      Succeeded = 0,
+      Failed,
+      TimedOut,
+    } Status_t;
+
+    Status_t status;
+    SMServicePtr service;       ///< The music service, or null for the local library
+    std::string category;       ///< The search category: artists, albums, tracks, ...
+    unsigned totalCount;        ///< The total count of matches reported by the source
+    DigitalItemList items;      ///< The items found in the local library
+    SMAPIItemList serviceItems; ///< The items found in the music service
+
+    FederatedResult() : status(Failed), totalCount(0) { }
+    bool IsLocal() const { return !service; }
+  };
+
+  /**
+   * Search a term everywhere: the local library through the ContentDirectory
+   * of the connected device, and every enabled music service. The sources are
+   * requested at once, and the results are delivered category by category as
+   * soon as a source answers. A source that does not complete before its
+   * deadline is reported as timed out, and its late answers are discarded.
+   * The sources of all searches share a pool of threads: the deadline of a
+   * source starts with the search, including the time its work is queued,
+   * and the work queued for an aborted or expired source is dropped. A
+   * source still running for a previous search holds its threads, then it is
+   * reported as failed rather than holding more threads of the pool.
+   */
+  class FederatedSearch
+  {
+  public:
+    FederatedSearch(System& system, const std::string& locale);
+    ~FederatedSearch();
+    FederatedSearch(const FederatedSearch&) = delete;
+    FederatedSearch& operator=(const FederatedSearch&) = delete;
+
+    /**
+     * Set the deadline of the sources, from the start of the search.
+     * @param millisec The delay
+     */
+    void SetDeadline(unsigned millisec) { m_deadline = millisec; }
+
+    /**
+     * Set the deadline of a source, overriding the default.
+     * @param serviceId The id of the music service, or empty for the local library
+     * @param millisec The delay
+     */
+    void SetDeadline(const std::string& serviceId, unsigned millisec);
+
+    /**
+     * Enable or disable searching the local library.
+     */
+    void SetLocalEnabled(bool enabled) { m_localEnabled = enabled; }
+
+    /**
+     * Start searching. A pending search is aborted.
+     * @param term The term to search
+     * @param categories The categories to search, as artists, albums, tracks
+     * or playlists. A service is requested for the categories it supports.
+     * @param count The max count of items per category
+     * @return false if no source can be searched
+     */
+    bool Start(const std::string& term, const std::vector<std::string>& categories, unsigned count = FEDERATEDSEARCH_COUNT);
+
+    /**
+     * Wait for the next result.
+     * @param result (out) The result
+     * @param timeout The max delay to wait in ms
+     * @return false if no result is available after timeout, or the search is complete
+     */
+    bool Next(FederatedResult& result, unsigned timeout);
+
+    /**
+     * Check all sources have answered or expired, and all results have been
+     * delivered.
+     */
+    bool IsComplete() const;
+
+    /**
+     * Abort the search. The pending answers will be discarded.
+     */
+    void Abort();
+
+    struct State;
+
+  private:
+    System& m_system;
+    std::string m_locale;
+    unsigned m_deadline;
+    bool m_localEnabled;
+    std::map<std::string, unsigned> m_deadlines;
+    SHARED_PTR<State> m_state;
+  };
+}
+
+#endif /* FEDERATEDSEARCH_H */
@@ -20,8 +20,7 @@
 
 #include "filepicreader.h"
 #include "private/debug.h"
-#include "private/tokenizer.h"
-#include "private/urlencoder.h"
+#include "private/urlparams.h"
 #include "private/byteorder.h"
 #include "private/base64.h"
 
@@ -58,9 +57,9 @@ FilePicReader* FilePicReader::Instance()
 StreamReader::STREAM * FilePicReader::OpenStream(const std::string& streamUrl)
 {
   std::vector<std::string> params;
-  readParameters(streamUrl, params);
-  std::string filePath = getParamValue(params, FILEPICREADER_PARAM_PATH);
-  std::string typeString = getParamValue(params, FILEPICREADER_PARAM_TYPE);
+  urlparams(streamUrl, params);
+  std::string filePath = urlparamvalue(params, FILEPICREADER_PARAM_PATH);
+  std::string typeString = urlparamvalue(params, FILEPICREADER_PARAM_TYPE);
   DBG(DBG_DEBUG, "%s: path (%s) type (%s)\n", __FUNCTION__, filePath.c_str(), typeString.c_str());
 
   PictureType picType = PictureType::CoverFront;
@@ -191,24 +190,6 @@ void FilePicReader::CloseStream(STREAM* stream)
   }
 }
 
-void FilePicReader::readParameters(const std::string& streamUrl, std::vector<std::string>& params)
-{
-  size_t s = streamUrl.find('?');
-  if (s != std::string::npos)
-    tokenize(streamUrl.substr(s + 1), "&", params, true);
-}
-
-std::string FilePicReader::getParamValue(const std::vector<std::string>& params, const std::string& name)
-{
-  size_t lval = name.length() + 1;
-  for (const std::string& str : params)
-  {
-    if (str.length() > lval && str.at(name.length()) == '=' && str.compare(0, name.length(), name) == 0)
-      return urldecode(str.substr(lval));
-  }
-  return std::string();
-}
-
 
 /////////////////////////////////////////////////////////////////////////////
 //// Media file FLAC/Vorbis
@@ -77,9 +77,6 @@ public:
   };
 
 private:
-  static void readParameters(const std::string& streamUrl, std::vector<std::string>& params);
-  static std::string getParamValue(const std::vector<std::string>& params, const std::string& name);
-
   static Picture * ExtractFLACPicture(const std::string& filePath, PictureType pictureType, bool& error);
   static void FreeFLACPicture(void * payload);
 
@@ -21,7 +21,7 @@
 #include "data/datareader.h"
 #include "private/debug.h"
 #include "private/urlencoder.h"
-#include "private/tokenizer.h"
+#include "private/urlparams.h"
 
 #include <cstring>
 #include <cstdio>
@@ -87,8 +87,8 @@ bool FileStreamer::HandleRequest(handle * handle)
     if (requrl.compare(0, (*it)->uri.length(), (*it)->uri) == 0)
     {
       std::vector<std::string> params;
-      readParameters(requrl, params);
-      std::string filePath = getParamValue(params, FILESTREAMER_PARAM_PATH);
+      urlparams(requrl, params);
+      std::string filePath = urlparamvalue(params, FILESTREAMER_PARAM_PATH);
       if (probe(filePath, (*it)->contentType))
       {
         // define the transfer type to use
@@ -198,24 +198,6 @@ std::string FileStreamer::MakeFileStreamURI(const std::string& filePath, const s
   return streamUri;
 }
 
-void FileStreamer::readParameters(const std::string& streamUrl, std::vector<std::string>& params)
-{
-  size_t s = streamUrl.find('?');
-  if (s != std::string::npos)
-    tokenize(streamUrl.substr(s + 1), "&", params, true);
-}
-
-std::string FileStreamer::getParamValue(const std::vector<std::string>& params, const std::string& name)
-{
-  size_t lval = name.length() + 1;
-  for (const std::string& str : params)
-  {
-    if (str.length() > lval && str.at(name.length()) == '=' && str.compare(0, name.length(), name) == 0)
-      return urldecode(str.substr(lval));
-  }
-  return std::string();
-}
-
 size_t FileStreamer::getFileLength(FILE * file)
 {
   size_t ret = 0;
@@ -18,7 +18,7 @@
 
 #include "flacencoder.h"
 #include "framebuffer.h"
-#include "private/byteorder.h"
+#include "private/pcmconvert.h"
 #include "private/debug.h"
 
 #define SAMPLES 1024
@@ -26,6 +26,42 @@
 
 using namespace NSROOT;
 
+namespace NSROOT
+{
+  struct FLACProfile
+  {
+    const char * name;
+    bool verify;
+    unsigned level;
+    unsigned blocksize; // 0 for the default of the level
+  };
+
+  // indexed by FLACEncoder::Profile
+  static const FLACProfile __profiles[] = {
+    { "lowlatency", false, 0, 576 },
+    { "balanced",   false, 5, 0 },
+    { "archival",   true,  8, 0 },
+  };
+}
+
+bool FLACEncoder::profileByName(const std::string& name, Profile * profile)
+{
+  for (unsigned i = 0; i < sizeof(__profiles) / sizeof(FLACProfile); ++i)
+  {
+    if (name == __profiles[i].name)
+    {
+      *profile = static_cast<Profile>(i);
+      return true;
+    }
+  }
+  return false;
+}
+
+const char * FLACEncoder::profileName(Profile profile)
+{
+  return __profiles[profile].name;
+}
+
 FLACEncoder::FLACEncoder()
 : FLACEncoder(FRAME_BUFFER_SIZE)
 {
@@ -33,10 +69,12 @@ FLACEncoder::FLACEncoder()
 
 FLACEncoder::FLACEncoder(int buffered)
 : AudioEncoder()
+, m_profile(Balanced)
 , m_ok(false)
 , m_bytesPerFrame(0)
 , m_sampleSize(0)
 , m_pcm(nullptr)
+, m_convert(nullptr)
 , m_buffer(nullptr)
 , m_packet(nullptr)
 , m_consumed(0)
@@ -66,15 +104,18 @@ bool FLACEncoder::open()
     return false;
   }
 
-  DBG(DBG_INFO, "Open FLAC encoder\n");
+  const FLACProfile& profile = __profiles[m_profile];
+  DBG(DBG_INFO, "Open FLAC encoder (%s)\n", profile.name);
 
   // configure the encoder
   if (!(m_ok = m_format.isValid()))
     DBG(DBG_WARN, "ERROR: Invalid format\n");
-  else if (!(m_ok = m_encoder->set_verify(true)))
+  else if (!(m_ok = m_encoder->set_verify(profile.verify)))
     DBG(DBG_WARN, "ERROR: Set verify failed\n");
-  else if (!(m_ok = m_encoder->set_compression_level(5)))
+  else if (!(m_ok = m_encoder->set_compression_level(profile.level)))
     DBG(DBG_WARN, "ERROR: Set compression level failed\n");
+  else if (profile.blocksize && !(m_ok = m_encoder->set_blocksize(profile.blocksize)))
+    DBG(DBG_WARN, "ERROR: Set block size (%u) failed\n", profile.blocksize);
   else if (!(m_ok = m_encoder->set_channels(m_format.channelCount)))
     DBG(DBG_WARN, "ERROR: Set channels (%d) failed\n", m_format.channelCount);
   else if (!(m_ok = m_encoder->set_bits_per_sample(m_format.sampleSize)))
@@ -95,6 +136,9 @@ bool FLACEncoder::open()
 
   m_bytesPerFrame = m_format.bytesPerFrame();
   m_sampleSize = m_format.sampleSize;
+  const char * kernel = "";
+  m_convert = SelectPCMToInt32(m_sampleSize, &kernel);
+  DBG(DBG_DEBUG, "FLAC encoder converts %d bits samples with kernel %s\n", m_sampleSize, kernel);
 
   m_buffer->clear();
   if (m_packet)
@@ -168,30 +212,8 @@ int FLACEncoder::encode(const char * data, int len)
   {
     int need = (samples > SAMPLES ? SAMPLES : static_cast<int>(samples));
     // convert the packed little-endian PCM samples into an interleaved FLAC__int32 buffer for libFLAC
-    for(int i = 0; i < (need * m_format.channelCount); i++)
-    {
-      switch (m_sampleSize)
-      {
-      case 8:
-        m_pcm[i] = (unsigned char)(*data) - 128;
-        data += 1;
-        break;
-      case 16:
-        m_pcm[i] = read16le(data);
-        data += 2;
-        break;
-      case 24:
-        m_pcm[i] = read24le(data);
-        data += 3;
-        break;
-      case 32:
-        m_pcm[i] = read32le(data);
-        data += 4;
-        break;
-      default:
-        m_pcm[i] = 0;
-      }
-    }
+    m_convert(data, m_pcm, need * m_format.channelCount);
+    data += need * m_bytesPerFrame;
     // feed samples to encoder
     ok = m_encoder->process_interleaved(m_pcm, need);
     samples -= need;
@@ -40,6 +40,32 @@ public:
   FLACEncoder(int buffered);
   ~FLACEncoder() override;
 
+  /**
+   * The encoder profiles:
+   * LowLatency: small blocks with the fastest level, without verify.
+   * Balanced: the default level and block size, without verify.
+   * Archival: the best level, every frame is verified.
+   */
+  typedef enum
+  {
+    LowLatency = 0,
+    Balanced,
+    Archival,
+  } Profile;
+
+  /**
+   * Set the profile for the next opening. Default is Balanced.
+   */
+  void setProfile(Profile profile) { m_profile = profile; }
+  Profile profile() const { return m_profile; }
+
+  /**
+   * Find the profile by name: lowlatency, balanced or archival.
+   * @return false if the name is unknown
+   */
+  static bool profileByName(const std::string& name, Profile * profile);
+  static const char * profileName(Profile profile);
+
   std::string mediaType() const override { return "audio/x-flac"; }
 
   bool open() override;
@@ -56,10 +82,12 @@ private:
   int writeEncodedData(const char * data, int len);
 
 private:
+  Profile m_profile;
   bool m_ok;
   int m_bytesPerFrame;
   int m_sampleSize;
   FLAC__int32 * m_pcm;
+  void (*m_convert)(const char * data, int32_t * pcm, int count);
 
   FrameBuffer * m_buffer;
   FramePacket * m_packet;
@@ -18,25 +18,21 @@
 
 #include "framebuffer.h"
 
-#include "private/os/threads/mutex.h"
 #include "private/debug.h"
 
-using namespace NSROOT;
+/* the count of packets preallocated beyond the ring, for the packets held
+ * by the consumer and the packet being written */
+#define FRAMEBUFFER_SPARE 4
 
-namespace NSROOT
-{
-  struct FrameBuffer::Lockable
-  {
-    OS::CMutex mutex;
-  };
-}
+using namespace NSROOT;
 
 FramePacket::FramePacket(int _capacity)
 : id(0)
 , size(0)
-, data(new char [_capacity])
-, capacity(_capacity)
+, data(nullptr)
+, capacity(0)
 {
+  reserve(_capacity);
 }
 
 FramePacket::~FramePacket()
@@ -45,53 +41,53 @@ FramePacket::~FramePacket()
     delete [] data;
 }
 
+void FramePacket::reserve(int _capacity)
+{
+  if (_capacity <= capacity)
+    return;
+  if (data)
+    delete [] data;
+  data = new char [_capacity];
+  capacity = _capacity;
+}
+
 FrameBuffer::FrameBuffer(int capacity)
-: m_ringlock(new Lockable())
-, m_poollock(new Lockable())
-, m_capacity(capacity)
-, m_count(0)
+: m_capacity(capacity)
 , m_unread(0)
-, m_buffer()
-, m_read(nullptr)
-, m_write(nullptr)
+, m_frames(0)
+, m_head(0)
+, m_buffer(capacity)
+, m_write(0)
+, m_read(0)
+, m_tail(0)
+, m_next(nullptr)
 , m_pool()
+, m_returns(capacity + FRAMEBUFFER_SPARE + 1)
+, m_returnHead(0)
+, m_returnTail(0)
+, m_largest(0)
 {
   assert(capacity > 0);
-  m_buffer.resize(capacity);
-  init();
+  for (std::atomic<FramePacket*>& frame : m_buffer)
+    frame.store(nullptr);
+  for (std::atomic<FramePacket*>& frame : m_returns)
+    frame.store(nullptr);
+  // the pool holds all packets in the worst case
+  m_pool.reserve(m_returns.size() + capacity);
+  for (int i = 0; i < capacity + FRAMEBUFFER_SPARE; ++i)
+    m_pool.push_back(new FramePacket(0));
 }
 
 FrameBuffer::~FrameBuffer()
 {
-  m_ringlock->mutex.Lock();
-  for (std::vector<Frame*>::iterator it = m_buffer.begin(); it != m_buffer.end(); ++it)
-    delete *it;
-  m_ringlock->mutex.Unlock();
-  m_poollock->mutex.Lock();
-  while (!m_pool.empty())
-  {
-    delete m_pool.front();
-    m_pool.pop_front();
-  }
-  m_poollock->mutex.Unlock();
-  delete m_poollock;
-  delete m_ringlock;
-}
-
-void FrameBuffer::init()
-{
-  Frame * previous = nullptr;
-  for (std::vector<Frame*>::iterator it = m_buffer.begin(); it != m_buffer.end(); ++it)
-  {
-    *it = new Frame();
-    if (previous)
-      previous->next = *it;
-    previous = *it;
-  }
-  if (m_buffer.begin() != m_buffer.end())
-    previous->next = *(m_buffer.begin());
-  m_write = *(m_buffer.begin());
-  m_read = m_write;
+  if (m_next)
+    delete m_next;
+  for (std::atomic<FramePacket*>& frame : m_buffer)
+    delete frame.load();
+  for (std::atomic<FramePacket*>& frame : m_returns)
+    delete frame.load();
+  for (FramePacket * p : m_pool)
+    delete p;
 }
 
 int FrameBuffer::capacity() const
@@ -99,37 +95,29 @@ int FrameBuffer::capacity() const
   return m_capacity;
 }
 
-int FrameBuffer::bytesAvailable() const
+int FrameBuffer::bytesAvailable()
 {
-  OS::CLockGuard g(m_ringlock->mutex);
-  return (m_unread ? m_read->packet->size : 0);
+  // the consumer takes the next packet in advance
+  if (!m_next)
+    m_next = take();
+  return (m_next ? m_next->size : 0);
 }
 
 unsigned FrameBuffer::bytesUnread() const
 {
-  OS::CLockGuard g(m_ringlock->mutex);
-  return m_unread;
+  return m_unread.load(std::memory_order_acquire);
 }
 
 bool FrameBuffer::full() const
 {
-  OS::CLockGuard g(m_ringlock->mutex);
-  return (m_unread && m_read == m_write);
+  return (m_frames.load(std::memory_order_acquire) >= m_capacity);
 }
 
 void FrameBuffer::clear()
 {
-  OS::CLockGuard g(m_ringlock->mutex);
-  // reset of unread implies the reset of packet size
-  // so clean all frames in the buffer
-  for (std::vector<Frame*>::iterator it = m_buffer.begin(); it != m_buffer.end(); ++it)
-  {
-    if ((*it)->packet)
-      freePacket((*it)->packet);
-    (*it)->packet = nullptr;
-  }
-  m_count = m_unread = 0;
-  m_read = m_write;
+  FramePacket * p;
+  while ((p = read()))
+    freePacket(p);
 }
 
 int FrameBuffer::write(const char * data, int len)
@@ -139,20 +127,7 @@ int FrameBuffer::write(const char * data, int len)
     FramePacket * _packet = needPacket(len);
     _packet->size = len;
     memcpy(_packet->data, data, len);
-    {
-      OS::CLockGuard g(m_ringlock->mutex);
-      if (m_write->packet)
-      {
-        // overwriting a packet implies to update unread because the data will be destroyed,
-        // and no longer available for reading.
-        m_unread -= m_write->packet->size;
-        freePacket(m_write->packet);
-      }
-      m_write->packet = _packet;
-      m_write->packet->id = ++m_count;
-      m_write = m_write->next;
-      m_unread += _packet->size;
-    }
+    writePacket(_packet);
   }
   return len;
 }
@@ -168,67 +143,128 @@ void FrameBuffer::writePacket(FramePacket* packet)
 {
   if (packet)
   {
-    OS::CLockGuard g(m_ringlock->mutex);
-    if (m_write->packet)
+    unsigned seq = m_head.load(std::memory_order_relaxed);
+    packet->id = seq;
+    m_unread.fetch_add(packet->size, std::memory_order_release);
+    m_frames.fetch_add(1, std::memory_order_release);
+    // publish the sequence before the packet, so the consumer finding the
+    // packet also finds its sequence
+    m_head.store(seq + 1, std::memory_order_release);
+    FramePacket * old = m_buffer[m_write].exchange(packet, std::memory_order_acq_rel);
+    if (++m_write >= m_capacity)
+      m_write = 0;
+    if (old)
     {
       // overwriting a packet implies to update unread because the data will be destroyed,
       // and no longer available for reading.
-      m_unread -= m_write->packet->size;
-      freePacket(m_write->packet);
+      m_unread.fetch_sub(old->size, std::memory_order_release);
+      m_frames.fetch_sub(1, std::memory_order_release);
+      m_pool.push_back(old);
     }
-    m_write->packet = packet;
-    m_write->packet->id = ++m_count;
-    m_write = m_write->next;
-    m_unread += packet->size;
   }
 }
 
-FramePacket * FrameBuffer::read()
+FramePacket * FrameBuffer::take()
 {
-  FramePacket * p = nullptr;
+  for (;;)
   {
-    OS::CLockGuard g(m_ringlock->mutex);
-    if (m_unread)
+    unsigned head = m_head.load(std::memory_order_acquire);
+    unsigned lag = head - m_tail;
+    if (lag == 0)
+      return nullptr;
+    if (lag > (unsigned)m_capacity)
+    {
+      // the producer has overwritten the frames behind: skip to the oldest
+      unsigned skip = lag - (unsigned)m_capacity;
+      m_tail += skip;
+      m_read = (int)((m_read + skip % (unsigned)m_capacity) % (unsigned)m_capacity);
+      lag = (unsigned)m_capacity;
+    }
+    FramePacket * p = m_buffer[m_read].exchange(nullptr, std::memory_order_acq_rel);
+    if (!p)
     {
-      p = m_read->packet;
-      m_read->packet = nullptr;
-      m_read = m_read->next;
-      m_unread -= p->size;
+      // the producer is writing the last packet, else the packet expected
+      // has been dropped
+      if (lag == 1)
+        return nullptr;
+      ++m_tail;
+      if (++m_read >= m_capacity)
+        m_read = 0;
+      continue;
     }
+    m_frames.fetch_sub(1, std::memory_order_release);
+    if (p->id == m_tail)
+    {
+      ++m_tail;
+      if (++m_read >= m_capacity)
+        m_read = 0;
+      return p;
+    }
+    // the packet expected has just been overwritten by a newer one, or the
+    // slot still holds a packet skipped before: drop it to keep the order
+    if ((int)(p->id - m_tail) > 0)
+    {
+      ++m_tail;
+      if (++m_read >= m_capacity)
+        m_read = 0;
+    }
+    m_unread.fetch_sub(p->size, std::memory_order_release);
+    freePacket(p);
   }
+}
+
+FramePacket * FrameBuffer::read()
+{
+  FramePacket * p = m_next;
+  m_next = nullptr;
+  if (!p)
+    p = take();
+  if (p)
+    m_unread.fetch_sub(p->size, std::memory_order_release);
   return p;
 }
 
 void FrameBuffer::freePacket(FramePacket * p)
 {
-  m_poollock->mutex.Lock();
-  m_pool.push_back(p);
-  m_poollock->mutex.Unlock();
+  unsigned head = m_returnHead.load(std::memory_order_relaxed);
+  unsigned next = (head + 1) % (unsigned)m_returns.size();
+  if (next == m_returnTail.load(std::memory_order_acquire))
+  {
+    // more packets than the pool can hold
+    delete p;
+    return;
+  }
+  m_returns[head].store(p, std::memory_order_relaxed);
+  m_returnHead.store(next, std::memory_order_release);
 }
 
 FramePacket * FrameBuffer::needPacket(int size)
 {
   FramePacket * p = nullptr;
-  m_poollock->mutex.Lock();
-  if (!m_pool.empty())
+  if (m_pool.empty())
   {
-    p = m_pool.front();
-    m_pool.pop_front();
-    m_poollock->mutex.Unlock();
-    if (p->capacity >= size)
+    // collect the packets freed by the consumer
+    unsigned tail = m_returnTail.load(std::memory_order_relaxed);
+    unsigned head = m_returnHead.load(std::memory_order_acquire);
+    while (tail != head)
     {
-      p->id = 0;
-      return p;
+      m_pool.push_back(m_returns[tail].exchange(nullptr, std::memory_order_relaxed));
+      tail = (tail + 1) % (unsigned)m_returns.size();
     }
-    //DBG(DBG_DEBUG, "%s: freed packet from buffer (%d)\n", __FUNCTION__, p->capacity);
-    delete p;
+    m_returnTail.store(tail, std::memory_order_release);
   }
-  else
+  // the packets grow to the largest size, so they fit any next write
+  if (size > m_largest)
+    m_largest = size;
+  if (!m_pool.empty())
   {
-    m_poollock->mutex.Unlock();
+    p = m_pool.back();
+    m_pool.pop_back();
+    p->id = 0;
+    p->reserve(m_largest);
+    return p;
   }
-  p = new FramePacket(size);
-  //DBG(DBG_DEBUG, "%s: allocated packet to buffer (%d)\n", __FUNCTION__, p->capacity);
+  p = new FramePacket(m_largest);
+  DBG(DBG_DEBUG, "%s: allocated packet to buffer (%d)\n", __FUNCTION__, p->capacity);
   return p;
-
 }
@@ -24,7 +24,7 @@
 #include <cstring>
 #include <cassert>
 #include <vector>
-#include <list>
+#include <atomic>
 
 namespace NSROOT
 {
@@ -38,10 +38,22 @@ public:
   FramePacket& operator=(const FramePacket& other) = delete;
   unsigned id;
   int size;
-  char * const data;
-  const int capacity;
+  char * data;
+  int capacity;
+
+  /**
+   * Grow the storage to the given capacity. The content is lost.
+   */
+  void reserve(int _capacity);
 };
 
+/**
+ * The ring of packets between one producer and one consumer, without lock.
+ * The producer calls write(), newPacket() and writePacket(); the consumer
+ * calls read(), freePacket(), bytesAvailable() and clear(). When the ring is
+ * full, the oldest packet is overwritten. The packets are recycled through
+ * a pool, so the steady state does not allocate.
+ */
 class FrameBuffer
 {
 public:
@@ -52,7 +64,12 @@ public:
 
   int capacity() const;
 
-  int bytesAvailable() const;
+  /**
+   * Called by the consumer, like read(). It takes the next packet out of the
+   * ring in advance, so full() no longer counts it.
+   * @return the size of the next packet to read
+   */
+  int bytesAvailable();
 
   unsigned bytesUnread() const;
 
@@ -76,28 +93,26 @@ public:
   void freePacket(FramePacket * p);
 
 private:
-  struct Lockable;
-  mutable Lockable * m_ringlock;
-  mutable Lockable * m_poollock;
   const int m_capacity;           /// buffer size
-  unsigned m_count;               /// total count of processed frame
-  unsigned m_unread;              /// total size of unread data in the buffer
-
-  struct Frame
-  {
-    Frame() : packet(nullptr), next(nullptr) { }
-    ~Frame() { if (packet) delete packet; }
-    FramePacket * packet;
-    Frame * next;
-  };
-
-  std::vector<Frame*> m_buffer;   /// buffer of frames
-  Frame * m_read;                 /// frame to read
-  Frame * m_write;                /// frame to write
-
-  void init();
-
-  std::list<FramePacket*> m_pool;
+  std::atomic<unsigned> m_unread; /// total size of unread data in the buffer
+  std::atomic<int> m_frames;      /// count of packets in the ring
+  std::atomic<unsigned> m_head;   /// sequence of the next packet to write
+
+  std::vector<std::atomic<FramePacket*> > m_buffer; /// buffer of frames
+  int m_write;                    /// frame to write, owned by the producer
+  int m_read;                     /// frame to read, owned by the consumer
+  unsigned m_tail;                /// sequence of the next packet to read
+  FramePacket * m_next;           /// the packet taken by the consumer, not yet read
+
+  FramePacket * take();
+
+  // the packets freed by the producer
+  std::vector<FramePacket*> m_pool;
+  // the packets freed by the consumer, returned to the producer
+  std::vector<std::atomic<FramePacket*> > m_returns;
+  std::atomic<unsigned> m_returnHead;
+  std::atomic<unsigned> m_returnTail;
+  int m_largest;                  /// the size of the largest write
   FramePacket * needPacket(int size);
 };
 
@@ -0,0 +1,214 @@
+/*
+ *      Copyright (C) 2026 Jean-Luc Barriere
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#include "framering.h"
+
+#include "private/os/threads/mutex.h"
+#include "private/os/threads/condition.h"
+#include "private/os/threads/timeout.h"
+#include "private/debug.h"
+
+#include <cassert>
+#include <cstring>
+
+using namespace NSROOT;
+
+namespace NSROOT
+{
+  struct FrameRing::Lockable
+  {
+    OS::CMutex mutex;
+    OS::CCondition<volatile bool> condition;
+  };
+}
+
+FrameRing::FrameRing(int frames)
+: IODevice()
+, m_lock(new Lockable())
+, m_capacity(frames)
+, m_closed(false)
+, m_started(false)
+, m_next(0)
+, m_bytes(0)
+, m_largest(0)
+, m_header()
+, m_slots()
+{
+  assert(frames > 0);
+  m_slots.resize(frames);
+}
+
+FrameRing::~FrameRing()
+{
+  close();
+  delete m_lock;
+}
+
+int FrameRing::bytesAvailable() const
+{
+  OS::CLockGuard lock(m_lock->mutex);
+  return m_bytes;
+}
+
+bool FrameRing::open(OpenMode mode)
+{
+  OS::CLockGuard lock(m_lock->mutex);
+  m_closed = false;
+  return IODevice::open(mode);
+}
+
+void FrameRing::close()
+{
+  OS::CLockGuard lock(m_lock->mutex);
+  m_closed = true;
+  m_lock->condition.Broadcast();
+  IODevice::close();
+}
+
+void FrameRing::clear()
+{
+  OS::CLockGuard lock(m_lock->mutex);
+  m_header.clear();
+  m_started = false;
+  // keep the sequence running, so the cursors never point a new frame
+  for (Slot& slot : m_slots)
+    slot.data.clear();
+  m_bytes = 0;
+}
+
+void FrameRing::attach(Cursor& cursor) const
+{
+  OS::CLockGuard lock(m_lock->mutex);
+  cursor = Cursor();
+  cursor.frame = m_next;
+}
+
+void FrameRing::attach(Cursor& cursor, unsigned backlog) const
+{
+  int64_t since = OS::gettime_ms() - backlog;
+  OS::CLockGuard lock(m_lock->mutex);
+  cursor = Cursor();
+  cursor.frame = m_next;
+  uint64_t oldest = (m_next > (uint64_t)m_capacity ? m_next - m_capacity : 0);
+  while (cursor.frame > oldest && m_slots[(cursor.frame - 1) % m_capacity].time > since)
+    --cursor.frame;
+}
+
+int FrameRing::read(Cursor& cursor, char * data, int maxlen, unsigned timeout)
+{
+  OS::CTimeout _timeout(timeout);
+  OS::CLockGuard lock(m_lock->mutex);
+  for (;;)
+  {
+    if (m_closed)
+      return -1;
+    // the header first
+    if (m_started && cursor.header < (int)m_header.size())
+    {
+      int r = (int)m_header.size() - cursor.header;
+      if (r > maxlen)
+        r = maxlen;
+      memcpy(data, m_header.data() + cursor.header, r);
+      cursor.header += r;
+      return r;
+    }
+    if (cursor.frame < m_next)
+    {
+      uint64_t oldest = (m_next > (uint64_t)m_capacity ? m_next - m_capacity : 0);
+      if (cursor.frame < oldest)
+      {
+        // the frame in progress has been overwritten: its rest is filled
+        // with zeros, so the next frame starts on its boundary
+        if (cursor.offset > 0 && cursor.offset < cursor.size)
+        {
+          int r = cursor.size - cursor.offset;
+          if (r > maxlen)
+            r = maxlen;
+          memset(data, 0, r);
+          cursor.offset += r;
+          return r;
+        }
+        // the reader is too slow: skip to the oldest frame
+        DBG(DBG_DEBUG, "%s: reader lost %u frames\n", __FUNCTION__, (unsigned)(oldest - cursor.frame));
+        cursor.dropped += (unsigned)(oldest - cursor.frame);
+        cursor.frame = oldest;
+        cursor.offset = 0;
+      }
+      const std::vector<char>& slot = m_slots[cursor.frame % m_capacity].data;
+      cursor.size = (int)slot.size();
+      int r = (int)slot.size() - cursor.offset;
+      if (r > maxlen)
+        r = maxlen;
+      if (r > 0)
+        memcpy(data, slot.data() + cursor.offset, r);
+      cursor.offset += r;
+      if (cursor.offset >= (int)slot.size())
+      {
+        ++cursor.frame;
+        cursor.offset = 0;
+      }
+      if (r > 0)
+        return r;
+      continue;
+    }
+    // each reader checks its own cursor on wake up, as a frame is shared
+    if (_timeout.TimeLeft() == 0)
+      return 0;
+    m_lock->condition.Wait(m_lock->mutex, _timeout);
+  }
+}
+
+bool FrameRing::isHeader(const char * data, int len) const
+{
+  (void)data;
+  (void)len;
+  return false;
+}
+
+int FrameRing::readData(char * data, int maxlen)
+{
+  // use read(Cursor&, ...)
+  (void)data;
+  (void)maxlen;
+  return 0;
+}
+
+int FrameRing::writeData(const char * data, int len)
+{
+  OS::CLockGuard lock(m_lock->mutex);
+  if (!m_started && isHeader(data, len))
+  {
+    m_header.insert(m_header.end(), data, data + len);
+    return len;
+  }
+  m_started = true;
+  Slot& slot = m_slots[m_next % m_capacity];
+  m_bytes -= (int)slot.data.size();
+  // the storage of the slot is reused, and it grows to the largest frame, so
+  // the ring stops allocating once each slot has held it
+  if (len > m_largest)
+    m_largest = len;
+  if ((int)slot.data.capacity() < len)
+    slot.data.reserve(m_largest);
+  slot.data.assign(data, data + len);
+  slot.time = OS::gettime_ms();
+  ++m_next;
+  m_bytes += len;
+  m_lock->condition.Broadcast();
+  return len;
+}
@@ -0,0 +1,127 @@
+/*
+ *      Copyright (C) 2026 Jean-Luc Barriere
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#ifndef FRAMERING_H
+#define FRAMERING_H
+
+#include "local_config.h"
+#include "iodevice.h"
+
+#include <stdint.h>
+#include <vector>
+
+namespace NSROOT
+{
+
+/**
+ * The ring of the encoded frames of a stream, shared by many readers. It is
+ * connected as the output of the encoder, so each write is a frame. The
+ * writes preceding the first frame form the header of the stream, that is
+ * delivered first to each reader. Each reader has its own cursor: the
+ * writer never waits for the readers, and a reader falling behind the ring
+ * skips to the oldest frame available. A reader joining late can start from
+ * the frames of the last seconds.
+ */
+class FrameRing : public IODevice
+{
+public:
+  FrameRing(int frames);
+  ~FrameRing() override;
+
+  struct Cursor
+  {
+    Cursor() : frame(0), offset(0), size(0), header(0), dropped(0) { }
+    uint64_t frame;     /// the frame to read
+    int offset;         /// the bytes of the frame already read
+    int size;           /// the size of the frame in progress
+    int header;         /// the bytes of the header already read
+    unsigned dropped;   /// the count of frames skipped
+  };
+
+  int capacity() const { return m_capacity; }
+
+  bool isSequential() const override { return true; }
+
+  /**
+   * @return the size of the frames in the ring
+   */
+  int bytesAvailable() const override;
+
+  bool open(OpenMode mode) override;
+
+  /**
+   * Stop the writer and wake up the readers.
+   */
+  void close() override;
+
+  /**
+   * Set the cursor on the next frame to come.
+   */
+  void attach(Cursor& cursor) const;
+
+  /**
+   * Set the cursor on the oldest frame written in the last period, so the
+   * reader gets the header and the backlog at once, then continues live.
+   * @param backlog The period in ms
+   */
+  void attach(Cursor& cursor, unsigned backlog) const;
+
+  /**
+   * Copy the data next to the cursor: the rest of the header, else the
+   * rest of the current frame. When the frame in progress is overwritten,
+   * its rest is delivered as zeros before skipping to the oldest frame.
+   * @return the size copied, 0 on timeout, or -1 when closed
+   */
+  int read(Cursor& cursor, char * data, int maxlen, unsigned timeout);
+
+  /**
+   * Drop the frames and the header for a new stream.
+   */
+  void clear();
+
+protected:
+  /**
+   * Check the write is a part of the header, before the first frame.
+   */
+  virtual bool isHeader(const char * data, int len) const;
+
+  int readData(char * data, int maxlen) override;
+  int writeData(const char * data, int len) override;
+
+private:
+  struct Lockable;
+  mutable Lockable * m_lock;
+  const int m_capacity;
+  bool m_closed;
+  bool m_started;                 /// the first frame has been written
+  uint64_t m_next;                /// the sequence of the next frame
+  int m_bytes;                    /// the size of the frames in the ring
+  int m_largest;                  /// the size of the largest frame
+  std::vector<char> m_header;
+
+  struct Slot
+  {
+    std::vector<char> data;
+    int64_t time;       /// when the frame was written
+  };
+  std::vector<Slot> m_slots;
+};
+
+}
+
+#endif /* FRAMERING_H */
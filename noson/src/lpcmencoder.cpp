@@ -0,0 +1,272 @@
+/*
+ *      Copyright (C) 2026 Jean-Luc Barriere
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#include "lpcmencoder.h"
+#include "framebuffer.h"
+#include "private/pcmconvert.h"
+#include "private/byteorder.h"
+#include "private/debug.h"
+
+#include <cstring>
+
+#define BLOCK_SIZE 4096
+#define FRAME_BUFFER_SIZE 256
+#define WAV_HEADER_SIZE 44
+
+using namespace NSROOT;
+
+namespace NSROOT
+{
+  // indexed by LPCMEncoder::Framing
+  static const char * __framings[] = {
+    "wav",
+    "l16",
+  };
+}
+
+bool LPCMEncoder::framingByName(const std::string& name, Framing * framing)
+{
+  for (unsigned i = 0; i < sizeof(__framings) / sizeof(const char*); ++i)
+  {
+    if (name == __framings[i])
+    {
+      *framing = static_cast<Framing>(i);
+      return true;
+    }
+  }
+  return false;
+}
+
+const char * LPCMEncoder::framingName(Framing framing)
+{
+  return __framings[framing];
+}
+
+LPCMEncoder::LPCMEncoder()
+: LPCMEncoder(FRAME_BUFFER_SIZE)
+{
+}
+
+LPCMEncoder::LPCMEncoder(int buffered)
+: AudioEncoder()
+, m_framing(WAV)
+, m_blockSize(BLOCK_SIZE)
+, m_ok(false)
+, m_bytesPerFrame(0)
+, m_sampleBytes(0)
+, m_swap(nullptr)
+, m_block(nullptr)
+, m_blockBytes(0)
+, m_filled(0)
+, m_buffer(nullptr)
+, m_packet(nullptr)
+, m_consumed(0)
+{
+  m_buffer = new FrameBuffer(buffered);
+}
+
+LPCMEncoder::~LPCMEncoder()
+{
+  if (AudioEncoder::isOpen())
+    AudioEncoder::close();
+  if (m_block != nullptr)
+    delete[] m_block;
+  if (m_packet)
+    m_buffer->freePacket(m_packet);
+  delete m_buffer;
+}
+
+std::string LPCMEncoder::mediaType() const
+{
+  return mediaType(m_framing, m_format);
+}
+
+std::string LPCMEncoder::mediaType(Framing framing, const AudioFormat& format)
+{
+  if (framing == WAV)
+    return "audio/wav";
+  std::string type(format.sampleSize == 24 ? "audio/L24" : "audio/L16");
+  type.append(";rate=").append(std::to_string(format.sampleRate))
+      .append(";channels=").append(std::to_string(format.channelCount));
+  return type;
+}
+
+bool LPCMEncoder::open()
+{
+  if (AudioEncoder::writable())
+  {
+    DBG(DBG_WARN, "LPCM Encoder already opened\n");
+    return false;
+  }
+
+  DBG(DBG_INFO, "Open LPCM encoder (%s)\n", framingName(m_framing));
+
+  // WAV holds unsigned 8 bits or signed samples, L16 and L24 hold signed
+  // samples of 16 or 24 bits
+  if (!(m_ok = m_format.isValid()))
+    DBG(DBG_WARN, "ERROR: Invalid format\n");
+  else if (!(m_ok = m_blockSize > 0))
+    DBG(DBG_WARN, "ERROR: Invalid block size (%d)\n", m_blockSize);
+  else if (!(m_ok = (m_format.sampleSize == 8 && m_format.sampleType == AudioFormat::UnSignedInt && m_framing == WAV) ||
+          (m_format.sampleSize == 16 && m_format.sampleType == AudioFormat::SignedInt) ||
+          (m_format.sampleSize == 24 && m_format.sampleType == AudioFormat::SignedInt) ||
+          (m_format.sampleSize == 32 && m_format.sampleType == AudioFormat::SignedInt && m_framing == WAV)
+          ))
+    DBG(DBG_WARN, "ERROR: Audio format not supported: %d%s%s\n", m_format.sampleSize,
+            m_format.sampleType == AudioFormat::SignedInt ? "S" : "U",
+            m_format.sampleSize > 8 ? m_format.byteOrder == AudioFormat::LittleEndian ? "LE" : "BE" : "");
+
+  if (!m_ok)
+    return false;
+
+  m_bytesPerFrame = m_format.bytesPerFrame();
+  m_sampleBytes = (m_format.sampleSize + 7) / 8;
+  // WAV is little-endian, L16 is big-endian
+  bool little = (m_framing == WAV);
+  if (m_sampleBytes > 1 && (m_format.byteOrder == AudioFormat::LittleEndian) != little)
+  {
+    const char * kernel = "";
+    m_swap = SelectPCMByteSwap(m_format.sampleSize, &kernel);
+    DBG(DBG_DEBUG, "LPCM encoder swaps %d bits samples with kernel %s\n", m_format.sampleSize, kernel);
+  }
+  else
+    m_swap = nullptr;
+
+  m_buffer->clear();
+  if (m_packet)
+    m_buffer->freePacket(m_packet);
+  m_packet = nullptr;
+
+  if (m_block == nullptr || m_blockBytes != m_blockSize * m_bytesPerFrame)
+  {
+    if (m_block != nullptr)
+      delete[] m_block;
+    m_blockBytes = m_blockSize * m_bytesPerFrame;
+    m_block = new char [m_blockBytes];
+  }
+  m_filled = 0;
+
+  AudioEncoder::open(ReadWrite);
+  if (m_framing == WAV)
+    writeHeader();
+  return true;
+}
+
+bool LPCMEncoder::overflow() const
+{
+  return m_buffer->full();
+}
+
+int LPCMEncoder::bytesAvailable() const
+{
+  if (m_packet)
+    return (m_packet->size - m_consumed);
+  return m_buffer->bytesAvailable();
+}
+
+void LPCMEncoder::close()
+{
+  if (AudioEncoder::writable())
+  {
+    DBG(DBG_INFO, "Close LPCM encoder\n");
+    if (m_filled > 0)
+      writeEncodedData(m_block, m_filled);
+    m_filled = 0;
+    // allow to read the rest in the buffer
+    AudioEncoder::open(ReadOnly);
+  }
+}
+
+int LPCMEncoder::readData(char * data, int maxlen)
+{
+  if (m_packet == nullptr)
+  {
+    m_packet = m_buffer->read();
+    m_consumed = 0;
+  }
+  if (m_packet)
+  {
+    int s = m_packet->size - m_consumed;
+    int r = (maxlen < s ? maxlen : s);
+    memcpy(data, m_packet->data + m_consumed, r);
+    m_consumed += r;
+    if (m_consumed >= m_packet->size)
+    {
+      m_buffer->freePacket(m_packet);
+      m_packet = nullptr;
+    }
+    return r;
+  }
+  return 0;
+}
+
+int LPCMEncoder::encode(const char * data, int len)
+{
+  // the source delivers whole frames, and the block holds whole frames
+  int rest = len - (len % m_bytesPerFrame);
+  while (rest > 0)
+  {
+    int need = m_blockBytes - m_filled;
+    if (need > rest)
+      need = rest;
+    // convert the samples into the byte order of the output
+    if (m_swap)
+      m_swap(data, m_block + m_filled, need / m_sampleBytes);
+    else
+      memcpy(m_block + m_filled, data, need);
+    data += need;
+    rest -= need;
+    m_filled += need;
+    if (m_filled == m_blockBytes)
+    {
+      writeEncodedData(m_block, m_filled);
+      m_filled = 0;
+    }
+  }
+  return len;
+}
+
+int LPCMEncoder::writeEncodedData(const char * data, int len)
+{
+  // check sink: connected output, otherwise internal buffer for reading
+  IODevice* output = connectedOutput();
+  if (output)
+    len = output->write(data, len);
+  else if ((len = m_buffer->write(data, len)) > 0)
+      readyRead();
+  return len;
+}
+
+void LPCMEncoder::writeHeader()
+{
+  // the sizes of a stream are unknown, so they are set to the max
+  char header[WAV_HEADER_SIZE];
+  memcpy(header, "RIFF", 4);
+  write32le(header + 4, (int32_t)0xffffffff);
+  memcpy(header + 8, "WAVEfmt ", 8);
+  write32le(header + 16, 16);
+  write16le(header + 20, 1); // PCM
+  write16le(header + 22, m_format.channelCount);
+  write32le(header + 24, m_format.sampleRate);
+  write32le(header + 28, m_format.sampleRate * m_bytesPerFrame);
+  write16le(header + 32, m_bytesPerFrame);
+  write16le(header + 34, m_sampleBytes * 8);
+  memcpy(header + 36, "data", 4);
+  write32le(header + 40, (int32_t)0xffffffff);
+  writeEncodedData(header, WAV_HEADER_SIZE);
+}
@@ -0,0 +1,115 @@
+/*
+ *      Copyright (C) 2026 Jean-Luc Barriere
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#ifndef LPCMENCODER_H
+#define LPCMENCODER_H
+
+#include "local_config.h"
+#include "audioencoder.h"
+
+namespace NSROOT
+{
+
+class FrameBuffer;
+class FramePacket;
+
+/**
+ * The encoder of the uncompressed PCM stream. It does not encode, but only
+ * frames the samples as a streaming WAV or as the raw audio/L16 of the
+ * RFC 2586. The samples are converted once into the byte order of the
+ * output, and written by blocks of fixed duration.
+ */
+class LPCMEncoder : public AudioEncoder
+{
+public:
+  LPCMEncoder();
+  LPCMEncoder(int buffered);
+  ~LPCMEncoder() override;
+
+  /**
+   * The framings:
+   * WAV: the RIFF header with unknown sizes, then the little-endian samples.
+   * L16: the big-endian samples without header, as audio/L16 or audio/L24.
+   */
+  typedef enum
+  {
+    WAV = 0,
+    L16,
+  } Framing;
+
+  /**
+   * Set the framing for the next opening. Default is WAV.
+   */
+  void setFraming(Framing framing) { m_framing = framing; }
+  Framing framing() const { return m_framing; }
+
+  /**
+   * Find the framing by name: wav or l16.
+   * @return false if the name is unknown
+   */
+  static bool framingByName(const std::string& name, Framing * framing);
+  static const char * framingName(Framing framing);
+
+  /**
+   * Set the count of frames written at once, for the next opening. Default
+   * is 4096.
+   */
+  void setBlockSize(int frames) { m_blockSize = frames; }
+  int blockSize() const { return m_blockSize; }
+
+  std::string mediaType() const override;
+
+  /**
+   * @return the media type of the stream framed for the format
+   */
+  static std::string mediaType(Framing framing, const AudioFormat& format);
+
+  bool open() override;
+  bool overflow() const;
+  int bytesAvailable() const override;
+
+  void close() override;
+
+protected:
+  int readData(char * data, int maxlen) override;
+
+private:
+  int encode(const char * data, int len) override;
+  int writeEncodedData(const char * data, int len);
+  void writeHeader();
+
+private:
+  Framing m_framing;
+  int m_blockSize;
+  bool m_ok;
+  int m_bytesPerFrame;
+  int m_sampleBytes;
+  void (*m_swap)(const char * data, char * out, int count);
+
+  char * m_block;
+  int m_blockBytes;
+  int m_filled;
+
+  FrameBuffer * m_buffer;
+  FramePacket * m_packet;
+  int m_consumed;
+};
+
+}
+
+#endif // LPCMENCODER_H
@@ -27,11 +27,21 @@
 #include "private/wsrequest.h"
 #include "private/wsresponse.h"
 #include "private/os/threads/mutex.h"
+#include "private/diskcache.h"
+
+#include <cstring>
 
 #define USER_AGENT "Linux UPnP/1.0 Sonos/36.4-41270 (ACR_noson)"
+#define MUSICSERVICES_BUCKET "msvc"
 
 using namespace NSROOT;
 
+namespace NSROOT
+{
+  // serialize the deferred parsing of service descriptors
+  static OS::CMutex SMServiceParseLock;
+}
+
 const std::string MusicServices::Name("MusicServices");
 const std::string MusicServices::ControlURL("/MusicServices/Control");
 const std::string MusicServices::EventURL("/MusicServices/Event");
@@ -39,82 +49,122 @@ const std::string MusicServices::SCPDURL("/xml/MusicServices1.xml");
 
 SMService::SMService(const std::string& agent, const ElementList& vars)
 : m_agent(agent)
+, m_id(vars.GetValue("Id"))
 , m_vars(vars)
+, m_parsed(true)
 {
-  m_type = ServiceType(GetId());
+  m_type = ServiceType(m_id);
   m_account = SMAccountPtr(new SMAccount(m_type));
   m_desc.assign("");
 }
 
 SMService::SMService(const std::string& agent, const ElementList& vars, const std::string& serialNum)
 : m_agent(agent)
+, m_id(vars.GetValue("Id"))
 , m_vars(vars)
+, m_parsed(true)
 {
-  m_type = ServiceType(GetId());
+  m_type = ServiceType(m_id);
   m_account = SMAccountPtr(new SMAccount(m_type, serialNum));
   m_desc.assign("");
 }
 
+SMService::SMService(const std::string& agent, const std::string& id, const std::string& descriptor, const std::string& serialNum)
+: m_agent(agent)
+, m_id(id)
+, m_descriptor(descriptor)
+, m_parsed(false)
+{
+  m_type = ServiceType(m_id);
+  if (serialNum.empty())
+    m_account = SMAccountPtr(new SMAccount(m_type));
+  else
+    m_account = SMAccountPtr(new SMAccount(m_type, serialNum));
+  m_desc.assign("");
+}
+
 SMServicePtr SMService::Clone(const std::string& serialNum) const
 {
+  if (!m_parsed.load())
+    return SMServicePtr(new SMService(m_agent, m_id, m_descriptor, serialNum));
   return SMServicePtr(new SMService(m_agent, m_vars, serialNum));
 }
 
+const ElementList& SMService::Vars() const
+{
+  if (!m_parsed.load())
+  {
+    OS::CLockGuard lock(SMServiceParseLock);
+    if (!m_parsed.load())
+    {
+      tinyxml2::XMLDocument doc;
+      if (doc.Parse(m_descriptor.c_str(), m_descriptor.size()) != tinyxml2::XML_SUCCESS ||
+              !MusicServices::ParseService(doc.RootElement(), m_vars))
+        DBG(DBG_ERROR, "%s: invalid descriptor for service (%s)\n", __FUNCTION__, m_id.c_str());
+      m_parsed.store(true);
+    }
+  }
+  return m_vars;
+}
+
 const std::string& SMService::GetId() const
 {
-  return m_vars.GetValue("Id");
+  return m_id;
 }
 
 const std::string& SMService::GetName() const
 {
-  return m_vars.GetValue("Name");
+  return Vars().GetValue("Name");
 }
 
 const std::string& SMService::GetVersion() const
 {
-  return m_vars.GetValue("Version");
+  return Vars().GetValue("Version");
 }
 
 const std::string& SMService::GetUri() const
 {
-  return m_vars.GetValue("Uri");
+  return Vars().GetValue("Uri");
 }
 
 const std::string& SMService::GetSecureUri() const
 {
-  return m_vars.GetValue("SecureUri");
+  return Vars().GetValue("SecureUri");
 }
 
 const std::string& SMService::GetContainerType() const
 {
-  return m_vars.GetValue("ContainerType");
+  return Vars().GetValue("ContainerType");
 }
 
 const std::string& SMService::GetCapabilities() const
 {
-  return m_vars.GetValue("Capabilities");
+  return Vars().GetValue("Capabilities");
 }
 
 ElementPtr SMService::GetPolicy() const
 {
-  ElementList::const_iterator it = m_vars.FindKey("Policy");
-  if (it != m_vars.end())
+  const ElementList& vars = Vars();
+  ElementList::const_iterator it = vars.FindKey("Policy");
+  if (it != vars.end())
     return (*it);
   return ElementPtr();
 }
 
 ElementPtr SMService::GetStrings() const
 {
-  ElementList::const_iterator it = m_vars.FindKey("Strings");
-  if (it != m_vars.end())
+  const ElementList& vars = Vars();
+  ElementList::const_iterator it = vars.FindKey("Strings");
+  if (it != vars.end())
     return (*it);
   return ElementPtr();
 }
 
 ElementPtr SMService::GetPresentationMap() const
 {
-  ElementList::const_iterator it = m_vars.FindKey("PresentationMap");
-  if (it != m_vars.end())
+  const ElementList& vars = Vars();
+  ElementList::const_iterator it = vars.FindKey("PresentationMap");
+  if (it != vars.end())
     return (*it);
   return ElementPtr();
 }
@@ -173,9 +223,38 @@ const std::string& SMService::GetAgent() const
 MusicServices::MusicServices(const std::string& serviceHost, unsigned servicePort)
 : Service(serviceHost, servicePort)
 , m_version("")
+, m_announcedVersion("")
+, m_subscriptionPool()
+, m_subscription()
+, m_CBHandle(nullptr)
+, m_eventCB(nullptr)
 {
 }
 
+MusicServices::MusicServices(const std::string& serviceHost, unsigned servicePort, SubscriptionPoolPtr& subscriptionPool, void* CBHandle, EventCB eventCB)
+: Service(serviceHost, servicePort)
+, m_version("")
+, m_announcedVersion("")
+, m_subscriptionPool(subscriptionPool)
+, m_subscription()
+, m_CBHandle(CBHandle)
+, m_eventCB(eventCB)
+{
+  unsigned subId = m_subscriptionPool->GetEventHandler().CreateSubscription(this);
+  m_subscriptionPool->GetEventHandler().SubscribeForEvent(subId, EVENT_UPNP_PROPCHANGE);
+  m_subscription = m_subscriptionPool->SubscribeEvent(serviceHost, servicePort, EventURL);
+  m_subscription.Start();
+}
+
+MusicServices::~MusicServices()
+{
+  if (m_subscriptionPool)
+  {
+    m_subscriptionPool->UnsubscribeEvent(m_subscription);
+    m_subscriptionPool->GetEventHandler().RevokeAllSubscriptions(this);
+  }
+}
+
 bool MusicServices::GetSessionId(const std::string& serviceId, const std::string& username, ElementList& vars)
 {
   ElementList args;
@@ -187,34 +266,78 @@ bool MusicServices::GetSessionId(const std::string& serviceId, const std::string
   return false;
 }
 
-SMServiceList MusicServices::GetAvailableServices()
+SMServiceList MusicServices::GetAvailableServices(const std::string& cacheKey)
 {
   // hold version's lock until return
   Locked<std::string>::pointer versionPtr = m_version.Get();
   SMServiceList list;
   // load services
   ElementList vars;
-  std::vector<ElementList> data;
-  if (!ListAvailableServices(vars) || !ParseAvailableServices(vars, data))
+  if (!ListAvailableServices(vars))
     DBG(DBG_ERROR, "%s: query services failed\n", __FUNCTION__);
   else
   {
-    // store new value of version
-    versionPtr->assign(vars.GetValue("AvailableServiceListVersion"));
-    std::string agent;
-    // configure a valid user-agent
-    agent.assign(USER_AGENT);
-
-    // Fill the list of services.
-    for (std::vector<ElementList>::const_iterator it = data.begin(); it != data.end(); ++it)
+    const std::string& xml = vars.GetValue("AvailableServiceDescriptorList");
+    list = MakeServiceList(xml);
+    if (list.empty())
+      DBG(DBG_ERROR, "%s: query services failed\n", __FUNCTION__);
+    else
     {
-        list.push_back(SMServicePtr(new SMService(agent, *it)));
+      // store new value of version
+      versionPtr->assign(vars.GetValue("AvailableServiceListVersion"));
+      if (!cacheKey.empty() && DiskCache::IsEnabled())
+      {
+        DiskCache::Entry entry;
+        entry.key.assign(cacheKey);
+        entry.version.assign(*versionPtr);
+        entry.data.assign(xml);
+        DiskCache::Store(MUSICSERVICES_BUCKET, entry);
+      }
     }
   }
   DBG(DBG_DEBUG, "%s: version (%s)\n", __FUNCTION__, versionPtr->c_str());
   return list;
 }
 
+bool MusicServices::LoadAvailableServices(const std::string& cacheKey, SMServiceList& list)
+{
+  DiskCache::Entry entry;
+  if (cacheKey.empty() || !DiskCache::Load(MUSICSERVICES_BUCKET, cacheKey, entry) || entry.version.empty())
+    return false;
+  // hold version's lock until return
+  Locked<std::string>::pointer versionPtr = m_version.Get();
+  SMServiceList tmp = MakeServiceList(entry.data);
+  if (tmp.empty())
+    return false;
+  list.swap(tmp);
+  versionPtr->assign(entry.version);
+  DBG(DBG_DEBUG, "%s: version (%s)\n", __FUNCTION__, versionPtr->c_str());
+  return true;
+}
+
+void MusicServices::HandleEventMessage(EventMessagePtr msg)
+{
+  if (!msg)
+    return;
+  if (msg->event == EVENT_UPNP_PROPCHANGE)
+  {
+    if (m_subscription.GetSID() == msg->subject[0] && msg->subject[2] == "PROPERTY")
+    {
+      DBG(DBG_DEBUG, "%s: %s SEQ=%s %s\n", __FUNCTION__, msg->subject[0].c_str(), msg->subject[1].c_str(), msg->subject[2].c_str());
+      std::vector<std::string>::const_iterator it = msg->subject.begin();
+      while (it != msg->subject.end())
+      {
+        if (*it == "ServiceListVersion")
+          m_announcedVersion.Store(*++it);
+        ++it;
+      }
+      // Signal
+      if (m_eventCB)
+        m_eventCB(m_CBHandle);
+    }
+  }
+}
+
 bool MusicServices::ListAvailableServices(ElementList& vars)
 {
   ElementList args;
@@ -224,74 +347,163 @@ bool MusicServices::ListAvailableServices(ElementList& vars)
   return false;
 }
 
-bool MusicServices::ParseAvailableServices(const ElementList& vars, std::vector<ElementList>& data) const
+SMServiceList MusicServices::MakeServiceList(const std::string& xml)
 {
-  const std::string& xml = vars.GetValue("AvailableServiceDescriptorList");
-  tinyxml2::XMLDocument rootdoc;
-  // Parse xml content
-  if (rootdoc.Parse(xml.c_str(), xml.size()) != tinyxml2::XML_SUCCESS)
+  SMServiceList list;
+  std::vector<std::pair<std::string, std::string> > data;
+  if (SplitAvailableServices(xml, data))
   {
-    DBG(DBG_ERROR, "%s: parse xml failed\n", __FUNCTION__);
-    return false;
+    std::string agent;
+    // configure a valid user-agent
+    agent.assign(USER_AGENT);
+
+    // Fill the list of services. The descriptors will be parsed on demand.
+    for (std::vector<std::pair<std::string, std::string> >::const_iterator it = data.begin(); it != data.end(); ++it)
+    {
+      list.push_back(SMServicePtr(new SMService(agent, it->first, it->second, "")));
+    }
+  }
+  return list;
+}
+
+namespace NSROOT
+{
+  // return the end of the tag starting at pos, skipping the quoted values
+  static size_t __tag_end(const std::string& xml, size_t pos)
+  {
+    char quote = 0;
+    for (; pos < xml.size(); ++pos)
+    {
+      char c = xml[pos];
+      if (quote)
+      {
+        if (c == quote)
+          quote = 0;
+      }
+      else if (c == '"' || c == '\'')
+        quote = c;
+      else if (c == '>')
+        return pos;
+    }
+    return std::string::npos;
   }
-  const tinyxml2::XMLElement* elem; // an element
-  // Check for response: Services
-  if (!(elem = rootdoc.RootElement()) || strncmp(elem->Name(), "Services", 8) != 0)
+
+  // return the position of the tag of the element, or npos
+  static size_t __find_tag(const std::string& xml, const char* tag, size_t len, size_t pos)
+  {
+    while ((pos = xml.find(tag, pos)) != std::string::npos)
+    {
+      // the name must not be the prefix of another one
+      if (pos + len < xml.size() && strchr(" \t\r\n/>", xml[pos + len]))
+        return pos;
+      pos += len;
+    }
+    return pos;
+  }
+
+  // copy the value of the attribute in the start tag, ending at end. Only the
+  // start tag is parsed, to decode the value as the descriptor will be.
+  static bool __tag_attribute(const std::string& xml, size_t pos, size_t end, const char* name, std::string& value)
+  {
+    std::string tag(xml, pos, end - pos);
+    if (!tag.empty() && tag.back() == '/')
+      tag.pop_back();
+    tag.append("/>");
+    tinyxml2::XMLDocument doc;
+    if (doc.Parse(tag.c_str(), tag.size()) != tinyxml2::XML_SUCCESS)
+      return false;
+    const char* attr = doc.RootElement()->Attribute(name);
+    if (!attr)
+      return false;
+    value.assign(attr);
+    return true;
+  }
+}
+
+bool MusicServices::SplitAvailableServices(const std::string& xml, std::vector<std::pair<std::string, std::string> >& data)
+{
+  data.clear();
+  // The descriptors are the children of the root Services, named Service.
+  // They are split without parsing the document, and each one will be
+  // parsed on demand.
+  size_t pos = __find_tag(xml, "<Services", 9, 0);
+  if (pos == std::string::npos || (pos = __tag_end(xml, pos)) == std::string::npos)
   {
     DBG(DBG_ERROR, "%s: invalid or not supported content\n", __FUNCTION__);
-    tinyxml2::XMLPrinter out;
-    rootdoc.Accept(&out);
-    DBG(DBG_ERROR, "%s\n", out.CStr());
     return false;
   }
-  data.clear();
-  elem = elem->FirstChildElement();
-  while (elem)
+  std::string id;
+  while ((pos = __find_tag(xml, "<Service", 8, pos)) != std::string::npos)
   {
-    unsigned uid = 0; // unique item id
-    const tinyxml2::XMLAttribute* attr = elem->FirstAttribute();
-    ElementList service;
-    while (attr)
+    size_t end = __tag_end(xml, pos);
+    if (end == std::string::npos)
+      break;
+    // the element is empty, or closed by the end tag
+    size_t last = end + 1;
+    if (xml[end - 1] != '/')
     {
-      service.push_back(ElementPtr(new Element(attr->Name(), attr->Value())));
-      attr = attr->Next();
+      last = xml.find("</Service>", end);
+      if (last == std::string::npos)
+        break;
+      last += 10;
     }
-    DBG(DBG_DEBUG, "%s: service '%s' (%s)\n", __FUNCTION__, service.GetValue("Name").c_str(), service.GetValue("Id").c_str());
-    // browse childs
-    const tinyxml2::XMLElement* child = elem->FirstChildElement();
-    while (child)
+    if (__tag_attribute(xml, pos, end, "Id", id) && !id.empty())
     {
-      if (XMLNS::NameEqual(child->Name(), "Policy"))
+      DBG(DBG_PROTO, "%s: service (%s)\n", __FUNCTION__, id.c_str());
+      data.push_back(std::make_pair(id, xml.substr(pos, last - pos)));
+    }
+    pos = last;
+  }
+  if (data.empty())
+    DBG(DBG_ERROR, "%s: parse xml failed\n", __FUNCTION__);
+  return !data.empty();
+}
+
+bool MusicServices::ParseService(const tinyxml2::XMLElement* elem, ElementList& service)
+{
+  if (!elem)
+    return false;
+  unsigned uid = 0; // unique item id
+  const tinyxml2::XMLAttribute* attr = elem->FirstAttribute();
+  service.clear();
+  while (attr)
+  {
+    service.push_back(ElementPtr(new Element(attr->Name(), attr->Value())));
+    attr = attr->Next();
+  }
+  DBG(DBG_DEBUG, "%s: service '%s' (%s)\n", __FUNCTION__, service.GetValue("Name").c_str(), service.GetValue("Id").c_str());
+  // browse childs
+  const tinyxml2::XMLElement* child = elem->FirstChildElement();
+  while (child)
+  {
+    if (XMLNS::NameEqual(child->Name(), "Policy"))
+    {
+      const tinyxml2::XMLAttribute* cattr = child->FirstAttribute();
+      ElementPtr policyPtr(new Element(child->Name(), std::to_string(++uid)));
+      while (cattr)
       {
-        const tinyxml2::XMLAttribute* cattr = child->FirstAttribute();
-        ElementPtr policyPtr(new Element(child->Name(), std::to_string(++uid)));
-        while (cattr)
-        {
-          policyPtr->SetAttribut(cattr->Name(), cattr->Value());
-          cattr = cattr->Next();
-        }
-        service.push_back(policyPtr);
+        policyPtr->SetAttribut(cattr->Name(), cattr->Value());
+        cattr = cattr->Next();
       }
-      if (XMLNS::NameEqual(child->Name(), "Presentation"))
+      service.push_back(policyPtr);
+    }
+    if (XMLNS::NameEqual(child->Name(), "Presentation"))
+    {
+      const tinyxml2::XMLElement* child2 = child->FirstChildElement();
+      while (child2)
       {
-        const tinyxml2::XMLElement* child2 = child->FirstChildElement();
-        while (child2)
+        const tinyxml2::XMLAttribute* cattr = child2->FirstAttribute();
+        ElementPtr mapPtr(new Element(child2->Name(), std::to_string(++uid)));
+        while (cattr)
         {
-          const tinyxml2::XMLAttribute* cattr = child2->FirstAttribute();
-          ElementPtr mapPtr(new Element(child2->Name(), std::to_string(++uid)));
-          while (cattr)
-          {
-            mapPtr->SetAttribut(cattr->Name(), cattr->Value());
-            cattr = cattr->Next();
-          }
-          service.push_back(mapPtr);
-          child2 = child2->NextSiblingElement(nullptr);
+          mapPtr->SetAttribut(cattr->Name(), cattr->Value());
+          cattr = cattr->Next();
         }
+        service.push_back(mapPtr);
+        child2 = child2->NextSiblingElement(nullptr);
       }
-      child = child->NextSiblingElement(nullptr);
     }
-    data.push_back(service);
-    elem = elem->NextSiblingElement(nullptr);
+    child = child->NextSiblingElement(nullptr);
   }
   return true;
 }
@@ -25,9 +25,17 @@
 #include "service.h"
 #include "smaccount.h"
 #include "locked.h"
+#include "eventhandler.h"
+#include "subscriptionpool.h"
 
 #include <list>
 #include <vector>
+#include <atomic>
+
+namespace tinyxml2
+{
+  class XMLElement;
+}
 
 namespace NSROOT
 {
@@ -73,16 +81,23 @@ namespace NSROOT
   private:
     std::string m_agent;    ///< The agent string to announce in API call
     SMAccountPtr m_account; ///< The account relates this service
-    ElementList m_vars;
+    std::string m_id;
+    mutable ElementList m_vars;
     std::string m_type;     ///< The type id to use for this service
     mutable std::string m_desc;     ///< The sonos descriptor to use for this service
+    std::string m_descriptor;       ///< The XML descriptor, parsed on first use
+    mutable std::atomic<bool> m_parsed;
+
+    SMService(const std::string& agent, const std::string& id, const std::string& descriptor, const std::string& serialNum);
+    const ElementList& Vars() const;
   };
 
-  class MusicServices : public Service
+  class MusicServices : public Service, public EventSubscriber
   {
   public:
     MusicServices(const std::string& serviceHost, unsigned servicePort);
-    ~MusicServices() {}
+    MusicServices(const std::string& serviceHost, unsigned servicePort, SubscriptionPoolPtr& subscriptionPool, void* CBHandle = nullptr, EventCB eventCB = nullptr);
+    ~MusicServices() override;
 
     static const std::string Name;
     static const std::string ControlURL;
@@ -108,14 +123,47 @@ namespace NSROOT
 
     /**
      * Returns the list of available services
+     * @param cacheKey The key to store the list in the disk cache, or empty
      * @return The service list
      */
-    SMServiceList GetAvailableServices();
+    SMServiceList GetAvailableServices(const std::string& cacheKey = "");
+
+    /**
+     * Load the list of available services from the disk cache.
+     * @param cacheKey The key of the stored list
+     * @param list (out) The service list
+     * @return false if not found
+     */
+    bool LoadAvailableServices(const std::string& cacheKey, SMServiceList& list);
 
     Locked<std::string>& GetVersion() { return m_version; }
 
+    /**
+     * Returns the version of the list announced by the device, or empty until
+     * the first event has been received.
+     */
+    std::string GetAnnouncedVersion() { return m_announcedVersion.Load(); }
+
+    // Implements EventSubscriber
+    void HandleEventMessage(EventMessagePtr msg) override;
+
+    /**
+     * Split the descriptor list into the descriptors of the services.
+     * @param xml The descriptor list
+     * @param data (out) The pairs of service id and descriptor
+     * @return succeeded
+     */
+    static bool SplitAvailableServices(const std::string& xml, std::vector<std::pair<std::string, std::string> >& data);
+
   private:
+    friend class SMService;
+
     Locked<std::string> m_version;  ///< Current version
+    Locked<std::string> m_announcedVersion; ///< Evented version
+    SubscriptionPoolPtr m_subscriptionPool;
+    Subscription m_subscription;
+    void* m_CBHandle;
+    EventCB m_eventCB;
 
     /**
      * Query service ListAvailableServices
@@ -124,7 +172,9 @@ namespace NSROOT
      */
     bool ListAvailableServices(ElementList& vars);
 
-    bool ParseAvailableServices(const ElementList& vars, std::vector<ElementList>& data) const;
+    static bool ParseService(const tinyxml2::XMLElement* elem, ElementList& service);
+
+    SMServiceList MakeServiceList(const std::string& xml);
 
   };
 
@@ -190,27 +190,26 @@ void* PASourceWorker::Process()
     int bytesPerFrame = m_source->m_format.bytesPerFrame();
     assert(bytesPerFrame >= MIN_FRAME_SIZE && bytesPerFrame <= MAX_FRAME_SIZE);
     int bsize = bytesPerFrame * FRAME_BUFFER;
-    char * buf = new char[bsize];
     while (!OS::CThread::IsStopped())
     {
-      // Record some data
-      if (pa_simple_read(m_source->m_pa, buf, bsize, &m_source->m_pa_error) < 0)
+      // Record some data in place
+      char * data = m_source->reserveData(bsize);
+      if (pa_simple_read(m_source->m_pa, data, bsize, &m_source->m_pa_error) < 0)
       {
         DBG(DBG_ERROR, "pa_simple_read() failed: %s\n", pa_strerror(m_source->m_pa_error));
         break;
       }
       if (m_source->m_mute)
-        memset(buf, 0, bsize);
+        memset(data, 0, bsize);
       // Apply the blank killer
-      m_source->m_blankKiller(buf, channels, BLANK_FRAMES);
+      m_source->m_blankKiller(data, channels, BLANK_FRAMES);
       // And write it to out
-      if (m_source->writeData(buf, bsize) != bsize)
+      if (m_source->commitData() != bsize)
       {
         DBG(DBG_ERROR, "write() failed\n");
         break;
       }
     }
-    delete [] buf;
     m_source->freePA();
   }
   return nullptr;
@@ -0,0 +1,97 @@
+/*
+ *      Copyright (C) 2026 Jean-Luc Barriere
+ *
+ *  This library is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU Lesser General Public License as published
+ *  by the Free Software Foundation; either version 3, or (at your option)
+ *  any later version.
+ *
+ *  This library is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ *  GNU Lesser General Public License for more details.
+ *
+ *  You should have received a copy of the GNU Lesser General Public License
+ *  along with this library; see the file COPYING.  If not, write to
+ *  the Free Software Foundation, 51 Franklin Street, Fifth Floor, Boston,
+ *  MA 02110-1301 USA
+ *  http://www.gnu.org/copyleft/gpl.html
+ *
+ */
+
+#include "browsecache.h"
+
+using namespace NSROOT;
+
+BrowseCache::BrowseCache(unsigned pageSize, size_t maxSize)
+: m_pageSize(pageSize)
+, m_maxSize(maxSize)
+, m_size(0)
+{
+}
+
+void BrowseCache::SetMaxSize(size_t bytes)
+{
+  m_maxSize = bytes;
+  Shrink();
+}
+
+bool BrowseCache::Touch(unsigned index)
+{
+  PageMap::iterator it = m_pages.find(index);
+  if (it == m_pages.end())
+    return false;
+  // hit: move the page on top
+  m_lru.splice(m_lru.begin(), m_lru, it->second.lru);
+  return true;
+}
+
+const BrowseCache::Table* BrowseCache::Find(unsigned index) const
+{
+  PageMap::const_iterator it = m_pages.find(index);
+  if (it == m_pages.end())
+    return nullptr;
+  return &(it->second.items);
+}
+
+void BrowseCache::Store(unsigned index, Table::const_iterator first, Table::const_iterator last)
+{
+  PageMap::iterator it = m_pages.find(index);
+  if (it != m_pages.end())
+  {
+    m_size -= it->second.size;
+    m_lru.erase(it->second.lru);
+  }
+  else
+    it = m_pages.insert(std::make_pair(index, Page())).first;
+  Page& page = it->second;
+  page.items.assign(first, last);
+  page.size = 0;
+  for (Table::const_iterator itt = page.items.begin(); itt != page.items.end(); ++itt)
+  {
+    if (*itt)
+      page.size += (*itt)->Footprint();
+  }
+  m_lru.push_front(index);
+  page.lru = m_lru.begin();
+  m_size += page.size;
+}
+
+void BrowseCache::Shrink()
+{
+  // evict the least recently used pages
+  while (m_size > m_maxSize && !m_lru.empty())
+  {
+    PageMap::iterator it = m_pages.find(m_lru.back());
+    m_size -= it->second.size;
+    m_pages.erase(it);
+    m_lru.pop_back();
+  }
+}
+
+void BrowseCache::Clear()
+{
+  m_pages.clear();
+  m_lru.clear();
+  m_size = 0;
+}
@@ -0,0 +1,96 @@
+/*
+ *      Copyright (C) 2026 Jean-Luc Barriere
+ *
+ *  This library is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU Lesser General Public License as published
+ *  by the Free Software Foundation; either version 3, or (at your option)
+ *  any later version.
+ *
+ *  This library is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ *  GNU Lesser General Public License for more details.
+ *
+ *  You should have received a copy of the GNU Lesser General Public License
+ *  along with this library; see the file COPYING.  If not, write to
+ *  the Free Software Foundation, 51 Franklin Street, Fifth Floor, Boston,
+ *  MA 02110-1301 USA
+ *  http://www.gnu.org/copyleft/gpl.html
+ *
+ */
+
+#ifndef BROWSECACHE_H
+#define BROWSECACHE_H
+
+#include "local_config.h"
+#include "../digitalitem.h"
+
+#include <map>
+#include <list>
+#include <vector>
+#include <cstddef>
+
+namespace NSROOT
+{
+
+  /**
+   * The pages of a browsed container, by starting index. The memory held by
+   * the items is bounded, and the least recently used pages are evicted
+   * first.
+   */
+  class BrowseCache
+  {
+  public:
+    typedef std::vector<DigitalItemPtr> Table;
+
+    BrowseCache(unsigned pageSize, size_t maxSize);
+
+    unsigned PageSize() const { return m_pageSize; }
+
+    // the bytes held by the cached items
+    size_t Size() const { return m_size; }
+
+    unsigned PageCount() const { return (unsigned) m_pages.size(); }
+
+    /**
+     * Set the max bytes held, and evict the pages over. 0 disables the cache.
+     */
+    void SetMaxSize(size_t bytes);
+
+    /**
+     * Mark the page as used.
+     * @return false if the page is not cached
+     */
+    bool Touch(unsigned index);
+
+    // return the page starting at index, or null
+    const Table* Find(unsigned index) const;
+
+    // store the page starting at index, as the most recently used
+    void Store(unsigned index, Table::const_iterator first, Table::const_iterator last);
+
+    // evict the least recently used pages until the size fits the max
+    void Shrink();
+
+    void Clear();
+
+  private:
+    typedef std::list<unsigned> LRU;
+    struct Page
+    {
+      Table items;
+      size_t size;
+      LRU::iterator lru;
+    };
+    typedef std::map<unsigned, Page> PageMap;
+
+    unsigned m_pageSize;
+    size_t m_maxSize;
+    size_t m_size;
+    PageMap m_pages;
+    LRU m_lru; // most recently used first
+  };
+
+}
+
+#endif /* BROWSECACHE_H */
@@ -0,0 +1,242 @@
+/*
+ *      Copyright (C) 2026 Jean-Luc Barriere
+ *
+ *  This file is part of Noson
+ *
+ *  Noson is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  Noson is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#include "coalescer.h"
+#include "os/threads/threadpool.h"
+#include "os/threads/condition.h"
+#include "debug.h"
+
+using namespace NSROOT;
+
+namespace NSROOT
+{
+  /**
+   * Send the value waiting for a key. A newer value is sent by a next worker
+   * queued behind the other keys, so the keys take turns on the pool.
+   */
+  class Coalescer::Worker : public OS::CWorker
+  {
+  public:
+    Worker(Coalescer& coalescer, const std::string& key)
+    : m_coalescer(coalescer), m_key(key) { }
+
+    void Process() override
+    {
+      CommandPtr command;
+      int value;
+      if (m_coalescer.Take(m_key, command, &value))
+      {
+        if (!command->Execute(value))
+          DBG(DBG_WARN, "%s: request (%s) failed\n", __FUNCTION__, m_key.c_str());
+      }
+      m_coalescer.Next(m_key);
+    }
+
+  private:
+    Coalescer& m_coalescer;
+    std::string m_key;
+  };
+
+  /**
+   * Run a command of a batch, and signal the last one done.
+   */
+  class Coalescer::BatchWorker : public OS::CWorker
+  {
+  public:
+    struct State
+    {
+      OS::CMutex mutex;
+      OS::CCondition<bool> condition;
+      unsigned remaining;
+      bool done;
+      bool result;
+    };
+
+    BatchWorker(State& state, const CommandPtr& command, int value)
+    : m_state(state), m_command(command), m_value(value) { }
+
+    void Process() override
+    {
+      bool ret = m_command->Execute(m_value);
+      OS::CLockGuard lock(m_state.mutex);
+      m_state.result = ret && m_state.result;
+      if (--m_state.remaining == 0)
+      {
+        m_state.done = true;
+        m_state.condition.Broadcast();
+      }
+    }
+
+  private:
+    State& m_state;
+    CommandPtr m_command;
+    int m_value;
+  };
+}
+
+Coalescer::Coalescer()
+: m_pool(nullptr)
+{
+}
+
+Coalescer::~Coalescer()
+{
+  OS::CThreadPool* pool;
+  {
+    OS::CLockGuard lock(m_mutex);
+    // drop the waiting values, then wait for the requests in flight
+    for (std::map<std::string, Slot>::iterator it = m_slots.begin(); it != m_slots.end(); ++it)
+      it->second.queued = false;
+    pool = m_pool;
+    m_pool = nullptr;
+  }
+  if (pool)
+  {
+    pool->Reset();
+    delete pool;
+  }
+}
+
+bool Coalescer::Submit(const std::string& key, const CommandPtr& command, int value)
+{
+  OS::CLockGuard lock(m_mutex);
+  m_commands[key] = command;
+  std::map<std::string, Slot>::iterator it = m_slots.find(key);
+  if (it != m_slots.end())
+  {
+    // a request is in flight: replace the waiting value
+    it->second.command = command;
+    it->second.value = value;
+    it->second.queued = true;
+    return true;
+  }
+  Slot& slot = m_slots[key];
+  slot.command = command;
+  slot.value = value;
+  slot.queued = true;
+  Worker* worker = new Worker(*this, key);
+  if (Pool()->Enqueue(worker))
+    return true;
+  delete worker;
+  m_slots.erase(key);
+  return false;
+}
+
+bool Coalescer::Pending(const std::string& key, int* value) const
+{
+  OS::CLockGuard lock(m_mutex);
+  std::map<std::string, Slot>::const_iterator it = m_slots.find(key);
+  if (it == m_slots.end())
+    return false;
+  *value = it->second.value;
+  return true;
+}
+
+Coalescer::CommandPtr Coalescer::LastCommand(const std::string& key) const
+{
+  OS::CLockGuard lock(m_mutex);
+  std::map<std::string, CommandPtr>::const_iterator it = m_commands.find(key);
+  if (it == m_commands.end())
+    return CommandPtr();
+  return it->second;
+}
+
+void Coalescer::ForgetCommand(const std::string& key)
+{
+  CommandPtr command;
+  {
+    OS::CLockGuard lock(m_mutex);
+    std::map<std::string, CommandPtr>::iterator it = m_commands.find(key);
+    if (it == m_commands.end())
+      return;
+    command = it->second;
+    m_commands.erase(it);
+  }
+  // the command is destroyed out of the lock
+}
+
+bool Coalescer::Take(const std::string& key, CommandPtr& command, int* value)
+{
+  OS::CLockGuard lock(m_mutex);
+  std::map<std::string, Slot>::iterator it = m_slots.find(key);
+  if (it == m_slots.end() || !it->second.queued)
+    return false;
+  it->second.queued = false;
+  command = it->second.command;
+  *value = it->second.value;
+  return true;
+}
+
+void Coalescer::Next(const std::string& key)
+{
+  OS::CLockGuard lock(m_mutex);
+  std::map<std::string, Slot>::iterator it = m_slots.find(key);
+  if (it == m_slots.end())
+    return;
+  if (it->second.queued && m_pool)
+  {
+    // a newer value was submitted while in flight
+    Worker* worker = new Worker(*this, key);
+    if (m_pool->Enqueue(worker))
+      return;
+    delete worker;
+  }
+  // the last value has been sent
+  m_slots.erase(it);
+}
+
+OS::CThreadPool* Coalescer::Pool()
+{
+  OS::CLockGuard lock(m_mutex);
+  if (!m_pool)
+    m_pool = new OS::CThreadPool(COALESCER_THREADS);
+  return m_pool;
+}
+
+bool Coalescer::RunAll(const Batch& batch)
+{
+  if (batch.empty())
+    return false;
+  BatchWorker::State state;
+  state.remaining = static_cast<unsigned>(batch.size());
+  state.done = false;
+  state.result = true;
+  {
+    // a pool of the batch size, apart from the coalesced keys, so the
+    // commands are all sent together. The workers are queued while suspended
+    // to start one thread by worker.
+    OS::CThreadPool pool(static_cast<unsigned>(batch.size() - 1));
+    pool.Suspend();
+    for (size_t i = 1; i < batch.size(); ++i)
+    {
+      BatchWorker* worker = new BatchWorker(state, batch[i].first, batch[i].second);
+      if (!pool.Enqueue(worker))
+      {
+        worker->Process();
+        delete worker;
+      }
+    }
+    pool.Resume();
+    BatchWorker(state, batch[0].first, batch[0].second).Process();
+    OS::CLockGuard lock(state.mutex);
+    state.condition.Wait(state.mutex, state.done);
+  }
+  return state.result;
+}
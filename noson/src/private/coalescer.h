@@ -0,0 +1,126 @@
+/*
+ *      Copyright (C) 2026 Jean-Luc Barriere
+ *
+ *  This file is part of Noson
+ *
+ *  Noson is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  Noson is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#ifndef COALESCER_H
+#define COALESCER_H
+
+#include "local_config.h"
+#include "../sharedptr.h"
+#include "os/threads/mutex.h"
+
+#include <string>
+#include <vector>
+#include <map>
+
+#define COALESCER_THREADS 4   // max count of keys sent at once
+
+namespace NSROOT
+{
+
+  namespace OS
+  {
+    class CThreadPool;
+  }
+
+  /**
+   * Coalesce the requests of the same kind. A request is sent in background
+   * as soon as submitted. While it is in flight, only the newest value
+   * submitted for the key is kept, and it is sent once the previous request
+   * has completed, in turn with the other keys. The values in between are
+   * dropped.
+   */
+  class Coalescer
+  {
+  public:
+    class Command
+    {
+    public:
+      virtual ~Command() { }
+      virtual bool Execute(int value) = 0;
+    };
+    typedef SHARED_PTR<Command> CommandPtr;
+
+    Coalescer();
+    ~Coalescer();
+    Coalescer(const Coalescer&) = delete;
+    Coalescer& operator=(const Coalescer&) = delete;
+
+    /**
+     * Submit the value to send for the key.
+     * @param key The kind of request, as action and device
+     * @param command The request to run with the value
+     * @param value The value
+     * @return false if the request cannot be scheduled
+     */
+    bool Submit(const std::string& key, const CommandPtr& command, int value);
+
+    /**
+     * Get the newest value submitted for the key that is not yet completed.
+     * That is the state expected once the pending requests are done.
+     * @return false if no request is pending
+     */
+    bool Pending(const std::string& key, int* value) const;
+
+    /**
+     * Get the command last submitted for the key, so it can be reused.
+     * @return null if none was submitted
+     */
+    CommandPtr LastCommand(const std::string& key) const;
+
+    /**
+     * Drop the command kept for the key, so its target can be released.
+     * A request in flight is still completed.
+     */
+    void ForgetCommand(const std::string& key);
+
+    typedef std::vector<std::pair<CommandPtr, int> > Batch;
+
+    /**
+     * Run the commands of the batch at once, the first one in the calling
+     * thread and the others each in its own thread, so a change is applied
+     * by all the devices together. The commands are not coalesced.
+     * @return true if all succeeded
+     */
+    bool RunAll(const Batch& batch);
+
+    class Worker;
+    class BatchWorker;
+
+  private:
+    struct Slot
+    {
+      CommandPtr command;
+      int value;
+      bool queued;    // a value is waiting to be sent
+    };
+
+    mutable OS::CMutex m_mutex;
+    std::map<std::string, Slot> m_slots;
+    std::map<std::string, CommandPtr> m_commands; // last submitted, by key
+    OS::CThreadPool* m_pool;
+
+    bool Take(const std::string& key, CommandPtr& command, int* value);
+    void Next(const std::string& key);
+    OS::CThreadPool* Pool();
+  };
+
+}
+
+#endif /* COALESCER_H */
@@ -0,0 +1,173 @@
+/*
+ *      Copyright (C) 2026 Jean-Luc Barriere
+ *
+ *  This library is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU Lesser General Public License as published
+ *  by the Free Software Foundation; either version 3, or (at your option)
+ *  any later version.
+ *
+ *  This library is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ *  GNU Lesser General Public License for more details.
+ *
+ *  You should have received a copy of the GNU Lesser General Public License
+ *  along with this library; see the file COPYING.  If not, write to
+ *  the Free Software Foundation, 51 Franklin Street, Fifth Floor, Boston,
+ *  MA 02110-1301 USA
+ *  http://www.gnu.org/copyleft/gpl.html
+ *
+ */
+
+#include "diskcache.h"
+#include "../locked.h"
+#include "debug.h"
+
+#include <cstdio>
+#include <stdint.h>
+#include <atomic>
+#if (defined(_WIN32) || defined(_WIN64))
+#include <process.h>
+#define __getpid _getpid
+#else
+#include <unistd.h>
+#define __getpid getpid
+#endif
+
+#define DISKCACHE_MAGIC "NOSONCACHE 2"
+
+using namespace NSROOT;
+
+namespace NSROOT
+{
+  static Locked<std::string> g_cacheDirectory("");
+  static std::atomic<unsigned> g_tempCount(0);
+
+  static uint64_t __hash_key(const std::string& key)
+  {
+    // FNV-1a
+    uint64_t h = 0xcbf29ce484222325ULL;
+    for (std::string::const_iterator it = key.begin(); it != key.end(); ++it)
+    {
+      h ^= (unsigned char)(*it);
+      h *= 0x100000001b3ULL;
+    }
+    return h;
+  }
+
+  static bool __read_line(FILE* file, std::string& line)
+  {
+    line.clear();
+    int c;
+    while ((c = fgetc(file)) != EOF)
+    {
+      if (c == '\n')
+        return true;
+      line.push_back((char)c);
+    }
+    return false;
+  }
+
+  static bool __valid_field(const std::string& str)
+  {
+    return str.find('\n') == std::string::npos;
+  }
+}
+
+void DiskCache::SetDirectory(const std::string& path)
+{
+  g_cacheDirectory.Store(path);
+}
+
+bool DiskCache::IsEnabled()
+{
+  return !g_cacheDirectory.Load().empty();
+}
+
+std::string DiskCache::FilePath(const std::string& bucket, const std::string& key)
+{
+  std::string path = g_cacheDirectory.Load();
+  if (path.empty())
+    return path;
+  char name[24];
+  snprintf(name, sizeof(name), "%016llx", (unsigned long long)__hash_key(key));
+  if (path[path.size() - 1] != '/' && path[path.size() - 1] != '\\')
+    path.push_back('/');
+  path.append("noson-").append(bucket).append("-").append(name).append(".cache");
+  return path;
+}
+
+bool DiskCache::Load(const std::string& bucket, const std::string& key, Entry& entry)
+{
+  std::string path = FilePath(bucket, key);
+  if (path.empty())
+    return false;
+  FILE* file = fopen(path.c_str(), "rb");
+  if (!file)
+    return false;
+  std::string line;
+  bool ok = (__read_line(file, line) && line == DISKCACHE_MAGIC &&
+             __read_line(file, entry.key) && entry.key == key &&
+             __read_line(file, entry.etag) &&
+             __read_line(file, entry.lastModified) &&
+             __read_line(file, entry.version));
+  if (ok)
+  {
+    entry.data.clear();
+    char buffer[4096];
+    size_t r;
+    while ((r = fread(buffer, 1, sizeof(buffer), file)) > 0)
+      entry.data.append(buffer, r);
+    ok = (ferror(file) == 0);
+  }
+  fclose(file);
+  if (!ok)
+    DBG(DBG_WARN, "%s: invalid entry (%s)\n", __FUNCTION__, path.c_str());
+  return ok;
+}
+
+bool DiskCache::Store(const std::string& bucket, const Entry& entry)
+{
+  std::string path = FilePath(bucket, entry.key);
+  if (path.empty())
+    return false;
+  if (!__valid_field(entry.key) || !__valid_field(entry.etag) || !__valid_field(entry.lastModified) ||
+          !__valid_field(entry.version))
+    return false;
+  // write a temporary file, then replace the entry at once. The name is
+  // unique to the process and the call, as the directory could be shared.
+  char suffix[48];
+  snprintf(suffix, sizeof(suffix), ".%d.%u.tmp", (int)__getpid(), g_tempCount.fetch_add(1));
+  std::string temp(path);
+  temp.append(suffix);
+  FILE* file = fopen(temp.c_str(), "wb");
+  if (!file)
+  {
+    DBG(DBG_WARN, "%s: cannot write file (%s)\n", __FUNCTION__, temp.c_str());
+    return false;
+  }
+  bool ok = (fprintf(file, "%s\n%s\n%s\n%s\n%s\n", DISKCACHE_MAGIC, entry.key.c_str(), entry.etag.c_str(),
+                     entry.lastModified.c_str(), entry.version.c_str()) > 0 &&
+             fwrite(entry.data.data(), 1, entry.data.size(), file) == entry.data.size());
+  ok = (fclose(file) == 0) && ok;
+  if (ok)
+  {
+#if (defined(_WIN32) || defined(_WIN64))
+    remove(path.c_str());
+#endif
+    ok = (rename(temp.c_str(), path.c_str()) == 0);
+  }
+  if (!ok)
+  {
+    DBG(DBG_WARN, "%s: cannot store entry (%s)\n", __FUNCTION__, path.c_str());
+    remove(temp.c_str());
+  }
+  return ok;
+}
+
+void DiskCache::Remove(const std::string& bucket, const std::string& key)
+{
+  std::string path = FilePath(bucket, key);
+  if (!path.empty())
+    remove(path.c_str());
+}
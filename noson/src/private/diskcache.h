@@ -0,0 +1,78 @@
+/*
+ *      Copyright (C) 2026 Jean-Luc Barriere
+ *
+ *  This library is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU Lesser General Public License as published
+ *  by the Free Software Foundation; either version 3, or (at your option)
+ *  any later version.
+ *
+ *  This library is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ *  GNU Lesser General Public License for more details.
+ *
+ *  You should have received a copy of the GNU Lesser General Public License
+ *  along with this library; see the file COPYING.  If not, write to
+ *  the Free Software Foundation, 51 Franklin Street, Fifth Floor, Boston,
+ *  MA 02110-1301 USA
+ *  http://www.gnu.org/copyleft/gpl.html
+ *
+ */
+
+#ifndef DISKCACHE_H
+#define DISKCACHE_H
+
+#include "local_config.h"
+
+#include <string>
+
+namespace NSROOT
+{
+
+  /**
+   * A store of documents in files of a directory, which survives the process.
+   * An entry is found by bucket and key, and it holds the validators given by
+   * the server with the document. The persistence is disabled until the
+   * directory is set.
+   */
+  class DiskCache
+  {
+  public:
+    struct Entry
+    {
+      std::string key;
+      std::string etag;
+      std::string lastModified;
+      std::string version;  // the version announced out of band, e.g. by events
+      std::string data;
+    };
+
+    /**
+     * Set the directory of the cache. The directory must exist.
+     * @param path The path, empty disables the persistence
+     */
+    static void SetDirectory(const std::string& path);
+
+    static bool IsEnabled();
+
+    /**
+     * Load the entry stored for the key.
+     * @return false if not found or unreadable
+     */
+    static bool Load(const std::string& bucket, const std::string& key, Entry& entry);
+
+    /**
+     * Store the entry, replacing the previous one of same key.
+     * @return succeeded
+     */
+    static bool Store(const std::string& bucket, const Entry& entry);
+
+    static void Remove(const std::string& bucket, const std::string& key);
+
+  private:
+    static std::string FilePath(const std::string& bucket, const std::string& key);
+  };
+
+}
+
+#endif /* DISKCACHE_H */
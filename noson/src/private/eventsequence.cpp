@@ -0,0 +1,69 @@
+/*
+ *      Copyright (C) 2026 Jean-Luc Barriere
+ *
+ *  This file is part of Noson
+ *
+ *  Noson is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  Noson is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+#include "eventsequence.h"
+#include "debug.h"
+
+using namespace NSROOT;
+
+EventSequence::EventSequence()
+: m_synced(false)
+, m_next(0)
+, m_delay(EVENTSEQUENCE_RESYNC_DELAY)
+{
+}
+
+bool EventSequence::Check(std::string& eventSID, unsigned& eventSEQ, const std::string& sid, uint32_t seq)
+{
+  if (sid != eventSID)
+  {
+    eventSID = sid;
+    // the first event of a subscription carries the whole state, else it
+    // has been missed
+    m_synced = (seq == 0);
+  }
+  else if (seq < eventSEQ)
+  {
+    DBG(DBG_DEBUG, "%s: %s SEQ=%u , discarding %u\n", __FUNCTION__, eventSID.c_str(), eventSEQ, seq);
+    return false;
+  }
+  else if (seq > eventSEQ + 1)
+  {
+    // changes have been missed: the state is stale until the first event of
+    // a new subscription
+    DBG(DBG_WARN, "%s: %s SEQ=%u , missed %u\n", __FUNCTION__, eventSID.c_str(), seq, seq - eventSEQ - 1);
+    m_synced = false;
+  }
+  eventSEQ = seq;
+  if (m_synced)
+  {
+    m_next = 0;
+    m_delay = EVENTSEQUENCE_RESYNC_DELAY;
+  }
+  return true;
+}
+
+bool EventSequence::Resubscribe(int64_t now)
+{
+  if (m_synced || now < m_next)
+    return false;
+  m_next = now + m_delay;
+  m_delay = (m_delay * 2 > EVENTSEQUENCE_RESYNC_MAX ? EVENTSEQUENCE_RESYNC_MAX : m_delay * 2);
+  return true;
+}
@@ -0,0 +1,78 @@
+/*
+ *      Copyright (C) 2026 Jean-Luc Barriere
+ *
+ *  This file is part of Noson
+ *
+ *  Noson is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  Noson is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+#ifndef EVENTSEQUENCE_H
+#define EVENTSEQUENCE_H
+
+#include "local_config.h"
+
+#include <string>
+#include <stdint.h>
+
+#define EVENTSEQUENCE_RESYNC_DELAY  2000    // ms before asking again to resubscribe
+#define EVENTSEQUENCE_RESYNC_MAX    60000   // ms, the delay doubles on each retry
+
+namespace NSROOT
+{
+
+  /**
+   * Track the sequence of the events of a subscription. The first event of a
+   * subscription carries the whole state, so the state is synced from it.
+   * A gap in the sequence, or a subscription first seen past its first event,
+   * leaves the state stale until a new subscription. The caller must
+   * serialize the calls.
+   */
+  class EventSequence
+  {
+  public:
+    EventSequence();
+
+    /**
+     * Check the event against the sequence tracked, and track it.
+     * @param eventSID The tracked identifier of the subscription, updated
+     * @param eventSEQ The tracked serial, updated
+     * @param sid The identifier of the subscription of the event
+     * @param seq The serial of the event
+     * @return false if the event is outdated and must be discarded
+     */
+    bool Check(std::string& eventSID, unsigned& eventSEQ, const std::string& sid, uint32_t seq);
+
+    /**
+     * No event missed since the first event of the subscription.
+     */
+    bool IsSynced() const { return m_synced; }
+
+    /**
+     * Tell whether a resubscription should be asked to resync the state.
+     * It is granted once per delay while the state is stale, and the delay
+     * doubles on each retry, so a subscription whose first event is lost
+     * doesn't resubscribe in a loop.
+     * @param now The current time in ms
+     */
+    bool Resubscribe(int64_t now);
+
+  private:
+    bool m_synced;
+    int64_t m_next;       // no resubscription before
+    unsigned m_delay;
+  };
+
+}
+
+#endif /* EVENTSEQUENCE_H */
@@ -0,0 +1,251 @@
+/*
+ *      Copyright (C) 2026 Jean-Luc Barriere
+ *
+ *  This library is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU Lesser General Public License as published
+ *  by the Free Software Foundation; either version 3, or (at your option)
+ *  any later version.
+ *
+ *  This library is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ *  GNU Lesser General Public License for more details.
+ *
+ *  You should have received a copy of the GNU Lesser General Public License
+ *  along with this library; see the file COPYING.  If not, write to
+ *  the Free Software Foundation, 51 Franklin Street, Fifth Floor, Boston,
+ *  MA 02110-1301 USA
+ *  http://www.gnu.org/copyleft/gpl.html
+ *
+ */
+
+#ifndef FEDERATEDSTATE_H
+#define FEDERATEDSTATE_H
+
+#include "local_config.h"
+#include "../federatedsearch.h"
+#include "os/threads/mutex.h"
+#include "os/threads/condition.h"
+#include "os/threads/timeout.h"
+#include "debug.h"
+
+#include <string>
+#include <vector>
+#include <list>
+#include <map>
+
+namespace NSROOT
+{
+  namespace OS
+  {
+    class CThreadPool;
+    class CWorker;
+  }
+
+  /**
+   * The pool running the sources of the searches. It bounds the count of
+   * threads running a source at once, so that a source which does not answer
+   * cannot hold the threads of the pool.
+   */
+  class FederatedSearchPool
+  {
+  public:
+    FederatedSearchPool(unsigned threads, unsigned threadsPerSource);
+    ~FederatedSearchPool();
+    FederatedSearchPool(const FederatedSearchPool&) = delete;
+    FederatedSearchPool& operator=(const FederatedSearchPool&) = delete;
+
+    // run the worker in background, the pool takes the ownership
+    bool Enqueue(OS::CWorker* worker);
+
+    // take a thread for the source, return false when all its threads are running
+    bool Acquire(const std::string& sourceId);
+
+    void Release(const std::string& sourceId);
+
+  private:
+    OS::CMutex m_mutex;
+    OS::CThreadPool* m_pool;
+    unsigned m_threads;
+    unsigned m_threadsPerSource;
+    std::map<std::string, unsigned> m_running;
+  };
+
+  /**
+   * The state of a search, shared with the workers of the sources. A worker
+   * can outlive the search, then its answers are discarded. The deadline of
+   * a source starts with the search, so a source still queued at its deadline
+   * times out too.
+   */
+  struct FederatedSearch::State
+  {
+    struct Source
+    {
+      std::string id;     // the id of the service, or empty for the local library
+      SMServicePtr service;
+      int64_t deadline;
+      bool running;       // holds a thread of the pool
+      bool done;
+    };
+
+    FederatedSearchPool& pool;
+    OS::CMutex mutex;
+    OS::CCondition<volatile bool> condition;
+    volatile bool ready;
+    std::vector<Source> sources;
+    std::list<FederatedResult> results;
+    unsigned pending;
+
+    State(FederatedSearchPool& _pool) : pool(_pool), ready(false), pending(0) { }
+
+    void AddSource(const std::string& id, const SMServicePtr& service, unsigned delay)
+    {
+      Source src;
+      src.id = id;
+      src.service = service;
+      src.deadline = OS::gettime_ms() + delay;
+      src.running = false;
+      src.done = false;
+      sources.push_back(src);
+      ++pending;
+    }
+
+    /**
+     * Take a thread of the pool for the source when its work is dequeued.
+     * @return false if the source is closed or busy, then the work is dropped
+     */
+    bool Begin(unsigned index)
+    {
+      OS::CLockGuard lock(mutex);
+      Source& src = sources[index];
+      if (src.done || src.deadline <= OS::gettime_ms())
+        return false;
+      if (!pool.Acquire(src.id))
+      {
+        // the threads of the source are held by previous searches
+        DBG(DBG_WARN, "%s: source (%s) is busy\n", __FUNCTION__, src.id.c_str());
+        results.push_back(FederatedResult());
+        results.back().status = FederatedResult::Failed;
+        results.back().service = src.service;
+        src.done = true;
+        --pending;
+        ready = true;
+        condition.Signal();
+        return false;
+      }
+      src.running = true;
+      return true;
+    }
+
+    bool IsDone(unsigned index)
+    {
+      OS::CLockGuard lock(mutex);
+      return sources[index].done;
+    }
+
+    void Push(unsigned index, FederatedResult& result)
+    {
+      OS::CLockGuard lock(mutex);
+      if (sources[index].done)
+        return;
+      result.service = sources[index].service;
+      results.push_back(FederatedResult());
+      std::swap(results.back(), result);
+      ready = true;
+      condition.Signal();
+    }
+
+    // close the source, and release its thread
+    void Finish(unsigned index)
+    {
+      OS::CLockGuard lock(mutex);
+      Source& src = sources[index];
+      if (src.running)
+      {
+        pool.Release(src.id);
+        src.running = false;
+      }
+      if (src.done)
+        return;
+      src.done = true;
+      --pending;
+      ready = true;
+      condition.Signal();
+    }
+
+    void Abort()
+    {
+      OS::CLockGuard lock(mutex);
+      for (std::vector<Source>::iterator it = sources.begin(); it != sources.end(); ++it)
+        it->done = true;
+      pending = 0;
+      results.clear();
+      ready = true;
+      condition.Broadcast();
+    }
+
+    /**
+     * Close the sources past their deadline, and returns the delay until the
+     * next deadline.
+     */
+    unsigned Expire()
+    {
+      int64_t now = OS::gettime_ms();
+      int64_t next = 0;
+      for (std::vector<Source>::iterator it = sources.begin(); it != sources.end(); ++it)
+      {
+        if (it->done)
+          continue;
+        if (it->deadline <= now)
+        {
+          DBG(DBG_WARN, "%s: source (%s) timed out\n", __FUNCTION__, it->id.c_str());
+          it->done = true;
+          --pending;
+          results.push_back(FederatedResult());
+          results.back().status = FederatedResult::TimedOut;
+          results.back().service = it->service;
+        }
+        else if (next == 0 || it->deadline < next)
+          next = it->deadline;
+      }
+      return (next ? (unsigned)(next - now) : 0);
+    }
+
+    /**
+     * Wait for the next result.
+     * @return false if no result is available after timeout, or all sources are closed
+     */
+    bool Next(FederatedResult& result, unsigned timeout)
+    {
+      OS::CTimeout _timeout(timeout);
+      OS::CLockGuard lock(mutex);
+      for (;;)
+      {
+        unsigned next = Expire();
+        if (!results.empty())
+        {
+          std::swap(result, results.front());
+          results.pop_front();
+          return true;
+        }
+        if (pending == 0)
+          return false;
+        unsigned left = _timeout.TimeLeft();
+        if (left == 0)
+          return false;
+        if (next > 0 && next < left)
+          left = next;
+        ready = false;
+        condition.Wait(mutex, ready, left);
+      }
+    }
+
+    bool IsComplete()
+    {
+      OS::CLockGuard lock(mutex);
+      return (pending == 0 && results.empty());
+    }
+  };
+}
+
+#endif /* FEDERATEDSTATE_H */
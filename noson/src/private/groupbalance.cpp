@@ -0,0 +1,56 @@
+/*
+ *      Copyright (C) 2026 Jean-Luc Barriere
+ *
+ *  This file is part of Noson
+ *
+ *  Noson is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  Noson is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+#include "groupbalance.h"
+
+using namespace NSROOT;
+
+int GroupBalance::ScaleVolume(int volume, int sum, size_t count, int target)
+{
+  if (sum <= 0)
+    return target;
+  int v = (volume * target * (int)count + sum / 2) / sum;
+  return (v > 100 ? 100 : v);
+}
+
+void GroupBalance::Save(const std::vector<std::string>& members, const std::vector<int>& volumes)
+{
+  OS::CLockGuard lock(m_mutex);
+  m_volumes.clear();
+  for (size_t i = 0; i < members.size() && i < volumes.size(); ++i)
+    m_volumes[members[i]] = volumes[i];
+}
+
+int GroupBalance::Load(const std::vector<std::string>& members, std::vector<int>& volumes) const
+{
+  OS::CLockGuard lock(m_mutex);
+  std::vector<int> saved;
+  int sum = 0;
+  for (std::vector<std::string>::const_iterator it = members.begin(); it != members.end(); ++it)
+  {
+    std::map<std::string, int>::const_iterator b = m_volumes.find(*it);
+    if (b == m_volumes.end())
+      return 0; // the group has changed since
+    saved.push_back(b->second);
+    sum += b->second;
+  }
+  if (sum > 0)
+    volumes.swap(saved);
+  return sum;
+}
@@ -0,0 +1,73 @@
+/*
+ *      Copyright (C) 2026 Jean-Luc Barriere
+ *
+ *  This file is part of Noson
+ *
+ *  Noson is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  Noson is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+#ifndef GROUPBALANCE_H
+#define GROUPBALANCE_H
+
+#include "local_config.h"
+#include "os/threads/mutex.h"
+
+#include <string>
+#include <vector>
+#include <map>
+
+namespace NSROOT
+{
+
+  /**
+   * Keep the balance of the volumes of a group. The volumes of the members
+   * are saved when the group is silenced, to be restored from it.
+   */
+  class GroupBalance
+  {
+  public:
+    GroupBalance() { }
+    GroupBalance(const GroupBalance&) = delete;
+    GroupBalance& operator=(const GroupBalance&) = delete;
+
+    /**
+     * Scale the volume of a member to keep the balance of the group. From
+     * silence all members join the same level.
+     * @param volume The volume of the member
+     * @param sum The sum of the volumes of the members
+     * @param count The count of members
+     * @param target The average volume to reach
+     * @return The volume of the member, up to 100
+     */
+    static int ScaleVolume(int volume, int sum, size_t count, int target);
+
+    /**
+     * Save the volumes of the members, by UUID.
+     */
+    void Save(const std::vector<std::string>& members, const std::vector<int>& volumes);
+
+    /**
+     * Load the volumes saved for the same members.
+     * @return the sum of the volumes loaded, else 0 and volumes is unchanged
+     */
+    int Load(const std::vector<std::string>& members, std::vector<int>& volumes) const;
+
+  private:
+    mutable OS::CMutex m_mutex;
+    std::map<std::string, int> m_volumes;
+  };
+
+}
+
+#endif /* GROUPBALANCE_H */
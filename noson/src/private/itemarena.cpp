@@ -0,0 +1,142 @@
+/*
+ *      Copyright (C) 2026 Jean-Luc Barriere
+ *
+ *  This library is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU Lesser General Public License as published
+ *  by the Free Software Foundation; either version 3, or (at your option)
+ *  any later version.
+ *
+ *  This library is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ *  GNU Lesser General Public License for more details.
+ *
+ *  You should have received a copy of the GNU Lesser General Public License
+ *  along with this library; see the file COPYING.  If not, write to
+ *  the Free Software Foundation, 51 Franklin Street, Fifth Floor, Boston,
+ *  MA 02110-1301 USA
+ *  http://www.gnu.org/copyleft/gpl.html
+ *
+ */
+
+#include "itemarena.h"
+
+#include <cstring>
+
+using namespace NSROOT;
+
+ItemArena::ItemArena()
+: m_chunkBytes(0)
+, m_ptr(nullptr)
+, m_left(0)
+, m_lastElement(0)
+{
+}
+
+ItemArena::~ItemArena()
+{
+  for (std::vector<char*>::iterator it = m_chunks.begin(); it != m_chunks.end(); ++it)
+    delete[] *it;
+}
+
+uint16_t ItemArena::Intern(const char* key)
+{
+  int id = FindKey(key);
+  if (id >= 0)
+    return (uint16_t) id;
+  m_keys.push_back(key);
+  return (uint16_t) (m_keys.size() - 1);
+}
+
+int ItemArena::FindKey(const char* key) const
+{
+  // the set of keys is small
+  for (size_t i = 0; i < m_keys.size(); ++i)
+    if (m_keys[i].compare(key) == 0)
+      return (int) i;
+  return -1;
+}
+
+int ItemArena::FindElement(unsigned first, unsigned count, int key) const
+{
+  if (key < 0)
+    return -1;
+  unsigned end = first + count;
+  for (unsigned i = first; i < end; ++i)
+  {
+    const Field& field = m_fields[i];
+    if (field.key == key)
+      return (int) i;
+    i += field.attrs;
+  }
+  return -1;
+}
+
+void ItemArena::Reserve(size_t fields, size_t bytes)
+{
+  m_fields.reserve(m_fields.size() + fields);
+  if (bytes > m_left)
+  {
+    char* chunk = new char[bytes];
+    m_chunks.push_back(chunk);
+    m_chunkBytes += bytes;
+    m_ptr = chunk;
+    m_left = bytes;
+  }
+}
+
+const char* ItemArena::Store(const char* str, size_t len)
+{
+  if (len > m_left)
+  {
+    // large strings get a chunk of their own
+    size_t size = (len > ITEMARENA_CHUNK / 4 ? len : ITEMARENA_CHUNK);
+    char* chunk = new char[size];
+    m_chunks.push_back(chunk);
+    m_chunkBytes += size;
+    if (size == len)
+    {
+      memcpy(chunk, str, len);
+      return chunk;
+    }
+    m_ptr = chunk;
+    m_left = size;
+  }
+  char* p = m_ptr;
+  memcpy(p, str, len);
+  m_ptr += len;
+  m_left -= len;
+  return p;
+}
+
+void ItemArena::AddElement(uint16_t key, const char* value, size_t len)
+{
+  Field field;
+  field.value = Store(value, len);
+  field.size = (uint32_t) len;
+  field.key = key;
+  field.attrs = 0;
+  m_lastElement = m_fields.size();
+  m_fields.push_back(field);
+}
+
+void ItemArena::AddAttribute(uint16_t key, const char* value, size_t len)
+{
+  if (m_fields.empty())
+    return;
+  ++m_fields[m_lastElement].attrs;
+  Field field;
+  field.value = Store(value, len);
+  field.size = (uint32_t) len;
+  field.key = key;
+  field.attrs = 0;
+  m_fields.push_back(field);
+}
+
+size_t ItemArena::Footprint() const
+{
+  size_t size = sizeof(ItemArena) + m_chunkBytes + m_fields.capacity() * sizeof(Field);
+  for (std::vector<std::string>::const_iterator it = m_keys.begin(); it != m_keys.end(); ++it)
+    size += sizeof(std::string) + it->capacity();
+  return size;
+}
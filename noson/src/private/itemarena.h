@@ -0,0 +1,106 @@
+/*
+ *      Copyright (C) 2026 Jean-Luc Barriere
+ *
+ *  This library is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU Lesser General Public License as published
+ *  by the Free Software Foundation; either version 3, or (at your option)
+ *  any later version.
+ *
+ *  This library is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ *  GNU Lesser General Public License for more details.
+ *
+ *  You should have received a copy of the GNU Lesser General Public License
+ *  along with this library; see the file COPYING.  If not, write to
+ *  the Free Software Foundation, 51 Franklin Street, Fifth Floor, Boston,
+ *  MA 02110-1301 USA
+ *  http://www.gnu.org/copyleft/gpl.html
+ *
+ */
+
+#ifndef ITEMARENA_H
+#define ITEMARENA_H
+
+#include "local_config.h"
+#include "os/threads/mutex.h"
+
+#include <string>
+#include <vector>
+#include <cstddef>
+#include <stdint.h>
+
+#define ITEMARENA_CHUNK   16384
+
+namespace NSROOT
+{
+
+  /**
+   * The storage of the properties for a bulk of items. The keys are interned,
+   * the strings are packed into large chunks, and the fields of all items are
+   * stored contiguously. Once filled the arena is only read, and it is shared
+   * by the items it holds.
+   */
+  class ItemArena
+  {
+  public:
+    struct Field
+    {
+      const char* value;
+      uint32_t size;
+      uint16_t key;
+      uint16_t attrs; // count of attribute fields following the element
+    };
+
+    ItemArena();
+    ~ItemArena();
+    ItemArena(const ItemArena&) = delete;
+    ItemArena& operator=(const ItemArena&) = delete;
+
+    uint16_t Intern(const std::string& key) { return Intern(key.c_str()); }
+    uint16_t Intern(const char* key);
+
+    int FindKey(const std::string& key) const { return FindKey(key.c_str()); }
+    int FindKey(const char* key) const;
+
+    const std::string& Key(uint16_t id) const { return m_keys[id]; }
+
+    // make room for the given count of fields and bytes of strings, so that
+    // an arena filled with known sizes allocates its storage once
+    void Reserve(size_t fields, size_t bytes);
+
+    // copy the string into the arena
+    const char* Store(const char* str, size_t len);
+
+    // append a new element with a copy of the value
+    void AddElement(uint16_t key, const char* value, size_t len);
+
+    // append a new attribute for the last element
+    void AddAttribute(uint16_t key, const char* value, size_t len);
+
+    unsigned FieldCount() const { return (unsigned) m_fields.size(); }
+
+    const Field& GetField(unsigned index) const { return m_fields[index]; }
+
+    // return the index of the first element with the key in the range, or -1
+    int FindElement(unsigned first, unsigned count, int key) const;
+
+    // bytes allocated by the arena
+    size_t Footprint() const;
+
+    OS::CMutex& GetMutex() { return m_mutex; }
+
+  private:
+    std::vector<std::string> m_keys;
+    std::vector<Field> m_fields;
+    std::vector<char*> m_chunks;
+    size_t m_chunkBytes;
+    char* m_ptr;
+    size_t m_left;
+    size_t m_lastElement;
+    OS::CMutex m_mutex;
+  };
+
+}
+
+#endif /* ITEMARENA_H */
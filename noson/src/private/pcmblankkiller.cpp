@@ -20,6 +20,20 @@
 #include "byteorder.h"
 
 #include <cinttypes>
+#include <cstring>
+
+#if defined(__SSE2__)
+#define PCMBLANK_SSE2
+#include <emmintrin.h>
+#if defined(__GNUC__) && (__GNUC__ >= 5 || defined(__clang__))
+#define PCMBLANK_AVX2
+#include <immintrin.h>
+#endif
+#endif
+#if defined(__ARM_NEON) || defined(__ARM_NEON__)
+#define PCMBLANK_NEON
+#include <arm_neon.h>
+#endif
 
 #define PCM_KILLER_LEVEL    1
 #define ZEROS   0
@@ -31,6 +45,171 @@
 namespace NSROOT
 {
 
+bool PCMIsBlankScalar(const char * data, int len, const char * pattern)
+{
+  while (len > 0)
+  {
+    int n = (len < PCMBLANK_PATTERN ? len : PCMBLANK_PATTERN);
+    for (int i = 0; i < n; ++i)
+    {
+      if (data[i] != pattern[i])
+        return false;
+    }
+    data += n;
+    len -= n;
+  }
+  return true;
+}
+
+/*
+ * The vector kernels compare a block of 48 or 96 bytes, a multiple of the
+ * period of every pattern, then leave on the first block differing.
+ */
+
+#ifdef PCMBLANK_SSE2
+static bool isBlank_sse2(const char * data, int len, const char * pattern)
+{
+  const __m128i p0 = _mm_loadu_si128((const __m128i*)pattern);
+  const __m128i p1 = _mm_loadu_si128((const __m128i*)(pattern + 16));
+  const __m128i p2 = _mm_loadu_si128((const __m128i*)(pattern + 32));
+  int i = 0;
+  for (; i + 48 <= len; i += 48)
+  {
+    __m128i v = _mm_xor_si128(_mm_loadu_si128((const __m128i*)(data + i)), p0);
+    v = _mm_or_si128(v, _mm_xor_si128(_mm_loadu_si128((const __m128i*)(data + i + 16)), p1));
+    v = _mm_or_si128(v, _mm_xor_si128(_mm_loadu_si128((const __m128i*)(data + i + 32)), p2));
+    if (_mm_movemask_epi8(_mm_cmpeq_epi8(v, _mm_setzero_si128())) != 0xffff)
+      return false;
+  }
+  return PCMIsBlankScalar(data + i, len - i, pattern);
+}
+#endif
+
+#ifdef PCMBLANK_AVX2
+__attribute__((target("avx2")))
+static bool isBlank_avx2(const char * data, int len, const char * pattern)
+{
+  const __m256i p0 = _mm256_loadu_si256((const __m256i*)pattern);
+  const __m256i p1 = _mm256_loadu_si256((const __m256i*)(pattern + 32));
+  const __m256i p2 = _mm256_loadu_si256((const __m256i*)(pattern + 64));
+  int i = 0;
+  for (; i + 96 <= len; i += 96)
+  {
+    __m256i v = _mm256_xor_si256(_mm256_loadu_si256((const __m256i*)(data + i)), p0);
+    v = _mm256_or_si256(v, _mm256_xor_si256(_mm256_loadu_si256((const __m256i*)(data + i + 32)), p1));
+    v = _mm256_or_si256(v, _mm256_xor_si256(_mm256_loadu_si256((const __m256i*)(data + i + 64)), p2));
+    if (!_mm256_testz_si256(v, v))
+      return false;
+  }
+  return PCMIsBlankScalar(data + i, len - i, pattern);
+}
+
+static bool __has_avx2()
+{
+  static const bool avx2 = __builtin_cpu_supports("avx2");
+  return avx2;
+}
+#endif
+
+#ifdef PCMBLANK_NEON
+static bool isBlank_neon(const char * data, int len, const char * pattern)
+{
+  const uint8x16_t p0 = vld1q_u8((const uint8_t*)pattern);
+  const uint8x16_t p1 = vld1q_u8((const uint8_t*)(pattern + 16));
+  const uint8x16_t p2 = vld1q_u8((const uint8_t*)(pattern + 32));
+  int i = 0;
+  for (; i + 48 <= len; i += 48)
+  {
+    const uint8_t * d = (const uint8_t*)(data + i);
+    uint8x16_t v = veorq_u8(vld1q_u8(d), p0);
+    v = vorrq_u8(v, veorq_u8(vld1q_u8(d + 16), p1));
+    v = vorrq_u8(v, veorq_u8(vld1q_u8(d + 32), p2));
+    uint64x2_t w = vreinterpretq_u64_u8(v);
+    if ((vgetq_lane_u64(w, 0) | vgetq_lane_u64(w, 1)) != 0)
+      return false;
+  }
+  return PCMIsBlankScalar(data + i, len - i, pattern);
+}
+#endif
+
+struct PCMBlankKernel
+{
+  const char * name;
+  PCMIsBlank isBlank;
+  bool (*available)();
+};
+
+static bool __always() { return true; }
+
+// by order of preference
+static const PCMBlankKernel __kernels[] = {
+#ifdef PCMBLANK_AVX2
+  { "avx2", isBlank_avx2, __has_avx2 },
+#endif
+#ifdef PCMBLANK_SSE2
+  { "sse2", isBlank_sse2, __always },
+#endif
+#ifdef PCMBLANK_NEON
+  { "neon", isBlank_neon, __always },
+#endif
+  { "scalar", PCMIsBlankScalar, __always },
+};
+
+PCMIsBlank SelectPCMIsBlank(const char ** name)
+{
+  for (const PCMBlankKernel& k : __kernels)
+  {
+    if (k.available())
+    {
+      if (name)
+        *name = k.name;
+      return k.isBlank;
+    }
+  }
+  return nullptr;
+}
+
+PCMIsBlank GetPCMIsBlank(const char * name)
+{
+  for (const PCMBlankKernel& k : __kernels)
+  {
+    if (strcmp(k.name, name) == 0)
+      return (k.available() ? k.isBlank : nullptr);
+  }
+  return nullptr;
+}
+
+static bool isBlank(const char * data, int len, const char * pattern)
+{
+  static const PCMIsBlank kernel = SelectPCMIsBlank();
+  return kernel(data, len, pattern);
+}
+
+/**
+ * The silence of a format repeated over the size of the pattern.
+ */
+struct PCMBlankPattern
+{
+  char bytes[PCMBLANK_PATTERN];
+  PCMBlankPattern(uint32_t zero, int size, bool bigEndian)
+  {
+    for (int i = 0; i < PCMBLANK_PATTERN; ++i)
+    {
+      int b = (bigEndian ? size - 1 - (i % size) : (i % size));
+      bytes[i] = (char)((zero >> (8 * b)) & 0xff);
+    }
+  }
+};
+
+static const PCMBlankPattern __zeros(ZEROS, 1, false);
+static const PCMBlankPattern __u8(ZEROU8, 1, false);
+static const PCMBlankPattern __u16le(ZEROU16, 2, false);
+static const PCMBlankPattern __u16be(ZEROU16, 2, true);
+static const PCMBlankPattern __u24le(ZEROU24, 3, false);
+static const PCMBlankPattern __u24be(ZEROU24, 3, true);
+static const PCMBlankPattern __u32le(ZEROU32, 4, false);
+static const PCMBlankPattern __u32be(ZEROU32, 4, true);
+
 void PCMBlankKillerNull(void * buf, int channels, int frames)
 {
   (void)buf;
@@ -41,12 +220,8 @@ void PCMBlankKillerNull(void * buf, int channels, int frames)
 void PCMBlankKillerU8(void * buf, int channels, int frames)
 {
   uint8_t * p = (uint8_t*)buf;
-  uint8_t * e = p + frames * channels;
-  int v = 0;
-  while (p < e) { v |= ((*p++) - ZEROU8); }
-  if (v == 0)
+  if (isBlank((const char*)buf, frames * channels, __u8.bytes))
   {
-    p = (uint8_t*)buf;
     for (int c = 0; c < channels; ++c)
     {
       write8(p + c, (int8_t)(ZEROU8 + PCM_KILLER_LEVEL));
@@ -60,12 +235,8 @@ void PCMBlankKillerU8(void * buf, int channels, int frames)
 void PCMBlankKillerS16LE(void * buf, int channels, int frames)
 {
   int16_t * p = (int16_t*)buf;
-  int16_t * e = p + frames * channels;
-  int v = 0;
-  while (p < e) { v |= (read16le(p++) - ZEROS); }
-  if (v == 0)
+  if (isBlank((const char*)buf, 2 * frames * channels, __zeros.bytes))
   {
-    p = (int16_t*)buf;
     for (int c = 0; c < channels; ++c)
     {
       write16le(p + c, (ZEROS + (PCM_KILLER_LEVEL << 4)));
@@ -77,12 +248,8 @@ void PCMBlankKillerS16LE(void * buf, int channels, int frames)
 void PCMBlankKillerU16LE(void * buf, int channels, int frames)
 {
   uint16_t * p = (uint16_t*)buf;
-  uint16_t * e = p + frames * channels;
-  int v = 0;
-  while (p < e) { v |= ((uint16_t)read16le(p++) - ZEROU16); }
-  if (v == 0)
+  if (isBlank((const char*)buf, 2 * frames * channels, __u16le.bytes))
   {
-    p = (uint16_t*)buf;
     for (int c = 0; c < channels; ++c)
     {
       write16le(p + c, (int16_t)(ZEROU16 + (PCM_KILLER_LEVEL << 4)));
@@ -94,12 +261,8 @@ void PCMBlankKillerU16LE(void * buf, int channels, int frames)
 void PCMBlankKillerS24LE(void * buf, int channels, int frames)
 {
   int8_t * p = (int8_t*)buf;
-  int8_t * e = p + 3 * frames * channels;
-  int v = 0;
-  while (p < e) { v |= ((read32le(p) >> 8) - ZEROS); p += 3; }
-  if (v == 0)
+  if (isBlank((const char*)buf, 3 * frames * channels, __zeros.bytes))
   {
-    p = (int8_t*)buf;
     for (int c = 0; c < channels; ++c)
       write32le(p + 3 * c, (ZEROS + (PCM_KILLER_LEVEL << 8)));
     for (int c = 0; c < channels; ++c)
@@ -111,12 +274,8 @@ void PCMBlankKillerS24LE(void * buf, int channels, int frames)
 void PCMBlankKillerU24LE(void * buf, int channels, int frames)
 {
   uint8_t * p = (uint8_t*)buf;
-  uint8_t * e = p + 3 * frames * channels;
-  int v = 0;
-  while (p < e) { v |= (((uint32_t)read32le(p) >> 8) - ZEROU24); p += 3; }
-  if (v == 0)
+  if (isBlank((const char*)buf, 3 * frames * channels, __u24le.bytes))
   {
-    p = (uint8_t*)buf;
     for (int c = 0; c < channels; ++c)
       write32le(p + 3 * c, (int32_t)(ZEROU24 + (PCM_KILLER_LEVEL << 8)));
     for (int c = 0; c < channels; ++c)
@@ -128,12 +287,8 @@ void PCMBlankKillerU24LE(void * buf, int channels, int frames)
 void PCMBlankKillerS32LE(void * buf, int channels, int frames)
 {
   int32_t * p = (int32_t*)buf;
-  int32_t * e = p + frames * channels;
-  int v = 0;
-  while (p < e) { v |= (read32le(p++) - ZEROS); }
-  if (v == 0)
+  if (isBlank((const char*)buf, 4 * frames * channels, __zeros.bytes))
   {
-    p = (int32_t*)buf;
     for (int c = 0; c < channels; ++c)
     {
       write32le(p + c, (ZEROS + (PCM_KILLER_LEVEL << 16)));
@@ -145,12 +300,8 @@ void PCMBlankKillerS32LE(void * buf, int channels, int frames)
 void PCMBlankKillerU32LE(void * buf, int channels, int frames)
 {
   uint32_t * p = (uint32_t*)buf;
-  uint32_t * e = p + frames * channels;
-  int v = 0;
-  while (p < e) { v |= ((uint32_t)read32le(p++) - ZEROU32); }
-  if (v == 0)
+  if (isBlank((const char*)buf, 4 * frames * channels, __u32le.bytes))
   {
-    p = (uint32_t*)buf;
     for (int c = 0; c < channels; ++c)
     {
       write32le(p + c, (int32_t)(ZEROU32 + (PCM_KILLER_LEVEL << 16)));
@@ -164,12 +315,8 @@ void PCMBlankKillerU32LE(void * buf, int channels, int frames)
 void PCMBlankKillerS16BE(void * buf, int channels, int frames)
 {
   int16_t * p = (int16_t*)buf;
-  int16_t * e = p + frames * channels;
-  int v = 0;
-  while (p < e) { v |= (read16be(p++) - ZEROS); }
-  if (v == 0)
+  if (isBlank((const char*)buf, 2 * frames * channels, __zeros.bytes))
   {
-    p = (int16_t*)buf;
     for (int c = 0; c < channels; ++c)
     {
       write16be(p + c, (ZEROS + (PCM_KILLER_LEVEL << 4)));
@@ -181,12 +328,8 @@ void PCMBlankKillerS16BE(void * buf, int channels, int frames)
 void PCMBlankKillerU16BE(void * buf, int channels, int frames)
 {
   uint16_t * p = (uint16_t*)buf;
-  uint16_t * e = p + frames * channels;
-  int v = 0;
-  while (p < e) { v |= ((uint16_t)read16be(p++) - ZEROU16); }
-  if (v == 0)
+  if (isBlank((const char*)buf, 2 * frames * channels, __u16be.bytes))
   {
-    p = (uint16_t*)buf;
     for (int c = 0; c < channels; ++c)
     {
       write16be(p + c, (int16_t)(ZEROU16 + (PCM_KILLER_LEVEL << 4)));
@@ -198,12 +341,8 @@ void PCMBlankKillerU16BE(void * buf, int channels, int frames)
 void PCMBlankKillerS24BE(void * buf, int channels, int frames)
 {
   int8_t * p = (int8_t*)buf;
-  int8_t * e = p + 3 * frames * channels;
-  int v = 0;
-  while (p < e) { v |= ((read32be(p) >> 8) - ZEROS); p += 3; }
-  if (v == 0)
+  if (isBlank((const char*)buf, 3 * frames * channels, __zeros.bytes))
   {
-    p = (int8_t*)buf;
     for (int c = 0; c < channels; ++c)
       write32be(p + 3 * c, (ZEROS + (PCM_KILLER_LEVEL << 8)) << 8);
     for (int c = 0; c < channels; ++c)
@@ -215,12 +354,8 @@ void PCMBlankKillerS24BE(void * buf, int channels, int frames)
 void PCMBlankKillerU24BE(void * buf, int channels, int frames)
 {
   uint8_t * p = (uint8_t*)buf;
-  uint8_t * e = p + 3 * frames * channels;
-  int v = 0;
-  while (p < e) { v |= (((uint32_t)read32be(p) >> 8) - ZEROU24); p += 3; }
-  if (v == 0)
+  if (isBlank((const char*)buf, 3 * frames * channels, __u24be.bytes))
   {
-    p = (uint8_t*)buf;
     for (int c = 0; c < channels; ++c)
       write32be(p + 3 * c, (int32_t)(ZEROU24 + (PCM_KILLER_LEVEL << 8)) << 8);
     for (int c = 0; c < channels; ++c)
@@ -232,12 +367,8 @@ void PCMBlankKillerU24BE(void * buf, int channels, int frames)
 void PCMBlankKillerS32BE(void * buf, int channels, int frames)
 {
   int32_t * p = (int32_t*)buf;
-  int32_t * e = p + frames * channels;
-  int v = 0;
-  while (p < e) { v |= (read32be(p++) - ZEROS); }
-  if (v == 0)
+  if (isBlank((const char*)buf, 4 * frames * channels, __zeros.bytes))
   {
-    p = (int32_t*)buf;
     for (int c = 0; c < channels; ++c)
     {
       write32be(p + c, (ZEROS + (PCM_KILLER_LEVEL << 16)));
@@ -249,12 +380,8 @@ void PCMBlankKillerS32BE(void * buf, int channels, int frames)
 void PCMBlankKillerU32BE(void * buf, int channels, int frames)
 {
   uint32_t * p = (uint32_t*)buf;
-  uint32_t * e = p + frames * channels;
-  int v = 0;
-  while (p < e) { v |= ((uint32_t)read32be(p++) - ZEROU32); }
-  if (v == 0)
+  if (isBlank((const char*)buf, 4 * frames * channels, __u32be.bytes))
   {
-    p = (uint32_t*)buf;
     for (int c = 0; c < channels; ++c)
     {
       write32be(p + c, (int32_t)(ZEROU32 + (PCM_KILLER_LEVEL << 16)));
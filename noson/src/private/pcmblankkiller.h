@@ -26,6 +26,35 @@ namespace NSROOT
 
 typedef void(*PCMBlankKiller)(void*, int, int);
 
+/**
+ * Check the samples are the silence. The silence of a format is a pattern
+ * of bytes, repeated over PCMBLANK_PATTERN bytes for the kernels.
+ * @param data The samples
+ * @param len The size in bytes
+ * @param pattern The repeated silence
+ * @return false on the first byte differing
+ */
+typedef bool(*PCMIsBlank)(const char * data, int len, const char * pattern);
+
+#define PCMBLANK_PATTERN 96
+
+/**
+ * The reference kernel, one byte at a time.
+ */
+bool PCMIsBlankScalar(const char * data, int len, const char * pattern);
+
+/**
+ * Select the fastest kernel supported by the CPU.
+ * @param name (out) If not null, the name of the kernel
+ */
+PCMIsBlank SelectPCMIsBlank(const char ** name = nullptr);
+
+/**
+ * Get a kernel by name, for the tests and the benchmark.
+ * @return the kernel or null if not available on this CPU
+ */
+PCMIsBlank GetPCMIsBlank(const char * name);
+
 void PCMBlankKillerNull(void * buf, int channels, int frames);
 
 void PCMBlankKillerU8(void * buf, int channels, int frames);
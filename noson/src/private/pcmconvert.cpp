@@ -0,0 +1,437 @@
+/*
+ *      Copyright (C) 2026 Jean-Luc Barriere
+ *
+ *  This file is part of Noson
+ *
+ *  Noson is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  Noson is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#include "pcmconvert.h"
+
+#include <cstring>
+
+#if defined(__BYTE_ORDER__) && __BYTE_ORDER__ == __ORDER_LITTLE_ENDIAN__
+#if defined(__SSE2__)
+#define PCMCONVERT_SSE2
+#include <emmintrin.h>
+#if defined(__GNUC__) && (__GNUC__ >= 5 || defined(__clang__))
+#define PCMCONVERT_AVX2
+#include <immintrin.h>
+#endif
+#endif
+#if defined(__ARM_NEON) || defined(__ARM_NEON__)
+#define PCMCONVERT_NEON
+#include <arm_neon.h>
+#endif
+#endif
+
+using namespace NSROOT;
+
+namespace NSROOT
+{
+
+#if defined(PCMCONVERT_SSE2) || defined(PCMCONVERT_NEON)
+  // the samples are in host order
+  static void s32le_native(const char * data, int32_t * pcm, int count)
+  {
+    memcpy(pcm, data, count * sizeof(int32_t));
+  }
+#endif
+
+#ifdef PCMCONVERT_SSE2
+  static void u8_sse2(const char * data, int32_t * pcm, int count)
+  {
+    const __m128i zero = _mm_setzero_si128();
+    const __m128i bias = _mm_set1_epi16(128);
+    int i = 0;
+    for (; i + 16 <= count; i += 16)
+    {
+      __m128i v = _mm_loadu_si128((const __m128i*)(data + i));
+      __m128i lo = _mm_sub_epi16(_mm_unpacklo_epi8(v, zero), bias);
+      __m128i hi = _mm_sub_epi16(_mm_unpackhi_epi8(v, zero), bias);
+      // sign extend the words
+      _mm_storeu_si128((__m128i*)(pcm + i), _mm_srai_epi32(_mm_unpacklo_epi16(lo, lo), 16));
+      _mm_storeu_si128((__m128i*)(pcm + i + 4), _mm_srai_epi32(_mm_unpackhi_epi16(lo, lo), 16));
+      _mm_storeu_si128((__m128i*)(pcm + i + 8), _mm_srai_epi32(_mm_unpacklo_epi16(hi, hi), 16));
+      _mm_storeu_si128((__m128i*)(pcm + i + 12), _mm_srai_epi32(_mm_unpackhi_epi16(hi, hi), 16));
+    }
+    PCMToInt32Scalar<8>(data + i, pcm + i, count - i);
+  }
+
+  static void s16le_sse2(const char * data, int32_t * pcm, int count)
+  {
+    int i = 0;
+    for (; i + 8 <= count; i += 8)
+    {
+      __m128i v = _mm_loadu_si128((const __m128i*)(data + 2 * i));
+      _mm_storeu_si128((__m128i*)(pcm + i), _mm_srai_epi32(_mm_unpacklo_epi16(v, v), 16));
+      _mm_storeu_si128((__m128i*)(pcm + i + 4), _mm_srai_epi32(_mm_unpackhi_epi16(v, v), 16));
+    }
+    PCMToInt32Scalar<16>(data + 2 * i, pcm + i, count - i);
+  }
+
+  static void s24le_sse2(const char * data, int32_t * pcm, int count)
+  {
+    // move the 3 bytes of the sample i in the upper bytes of the dword i,
+    // then shift back to sign extend
+    const __m128i m0 = _mm_set_epi32(0, 0, 0, (int)0xffffff00);
+    const __m128i m1 = _mm_set_epi32(0, 0, (int)0xffffff00, 0);
+    const __m128i m2 = _mm_set_epi32(0, (int)0xffffff00, 0, 0);
+    const __m128i m3 = _mm_set_epi32((int)0xffffff00, 0, 0, 0);
+    int i = 0;
+    // a load reads 16 bytes for 4 samples
+    for (; i + 6 <= count; i += 4)
+    {
+      __m128i v = _mm_loadu_si128((const __m128i*)(data + 3 * i));
+      __m128i r = _mm_or_si128(
+              _mm_or_si128(_mm_and_si128(_mm_slli_si128(v, 1), m0), _mm_and_si128(_mm_slli_si128(v, 2), m1)),
+              _mm_or_si128(_mm_and_si128(_mm_slli_si128(v, 3), m2), _mm_and_si128(_mm_slli_si128(v, 4), m3)));
+      _mm_storeu_si128((__m128i*)(pcm + i), _mm_srai_epi32(r, 8));
+    }
+    PCMToInt32Scalar<24>(data + 3 * i, pcm + i, count - i);
+  }
+
+  static void swap16_sse2(const char * data, char * out, int count)
+  {
+    int i = 0;
+    for (; i + 8 <= count; i += 8)
+    {
+      __m128i v = _mm_loadu_si128((const __m128i*)(data + 2 * i));
+      _mm_storeu_si128((__m128i*)(out + 2 * i), _mm_or_si128(_mm_slli_epi16(v, 8), _mm_srli_epi16(v, 8)));
+    }
+    PCMByteSwapScalar<16>(data + 2 * i, out + 2 * i, count - i);
+  }
+
+  static void swap32_sse2(const char * data, char * out, int count)
+  {
+    int i = 0;
+    for (; i + 4 <= count; i += 4)
+    {
+      __m128i v = _mm_loadu_si128((const __m128i*)(data + 4 * i));
+      // swap the words, then the bytes of each word
+      v = _mm_shufflehi_epi16(_mm_shufflelo_epi16(v, 0xb1), 0xb1);
+      _mm_storeu_si128((__m128i*)(out + 4 * i), _mm_or_si128(_mm_slli_epi16(v, 8), _mm_srli_epi16(v, 8)));
+    }
+    PCMByteSwapScalar<32>(data + 4 * i, out + 4 * i, count - i);
+  }
+#endif
+
+#ifdef PCMCONVERT_AVX2
+  __attribute__((target("avx2")))
+  static void u8_avx2(const char * data, int32_t * pcm, int count)
+  {
+    const __m256i bias = _mm256_set1_epi32(128);
+    int i = 0;
+    for (; i + 16 <= count; i += 16)
+    {
+      __m128i v = _mm_loadu_si128((const __m128i*)(data + i));
+      _mm256_storeu_si256((__m256i*)(pcm + i), _mm256_sub_epi32(_mm256_cvtepu8_epi32(v), bias));
+      _mm256_storeu_si256((__m256i*)(pcm + i + 8), _mm256_sub_epi32(_mm256_cvtepu8_epi32(_mm_srli_si128(v, 8)), bias));
+    }
+    PCMToInt32Scalar<8>(data + i, pcm + i, count - i);
+  }
+
+  __attribute__((target("avx2")))
+  static void s16le_avx2(const char * data, int32_t * pcm, int count)
+  {
+    int i = 0;
+    for (; i + 16 <= count; i += 16)
+    {
+      __m128i lo = _mm_loadu_si128((const __m128i*)(data + 2 * i));
+      __m128i hi = _mm_loadu_si128((const __m128i*)(data + 2 * i + 16));
+      _mm256_storeu_si256((__m256i*)(pcm + i), _mm256_cvtepi16_epi32(lo));
+      _mm256_storeu_si256((__m256i*)(pcm + i + 8), _mm256_cvtepi16_epi32(hi));
+    }
+    PCMToInt32Scalar<16>(data + 2 * i, pcm + i, count - i);
+  }
+
+  __attribute__((target("avx2")))
+  static void s24le_avx2(const char * data, int32_t * pcm, int count)
+  {
+    // each lane holds 4 samples: bytes 3k..3k+2 go to the upper bytes of
+    // the dword k
+    const __m256i shuffle = _mm256_setr_epi8(
+            -1, 0, 1, 2, -1, 3, 4, 5, -1, 6, 7, 8, -1, 9, 10, 11,
+            -1, 0, 1, 2, -1, 3, 4, 5, -1, 6, 7, 8, -1, 9, 10, 11);
+    int i = 0;
+    // the loads read 28 bytes for 8 samples
+    for (; i + 10 <= count; i += 8)
+    {
+      const char * p = data + 3 * i;
+      __m256i v = _mm256_inserti128_si256(_mm256_castsi128_si256(_mm_loadu_si128((const __m128i*)p)),
+                                          _mm_loadu_si128((const __m128i*)(p + 12)), 1);
+      _mm256_storeu_si256((__m256i*)(pcm + i), _mm256_srai_epi32(_mm256_shuffle_epi8(v, shuffle), 8));
+    }
+    PCMToInt32Scalar<24>(data + 3 * i, pcm + i, count - i);
+  }
+
+  __attribute__((target("avx2")))
+  static void swap16_avx2(const char * data, char * out, int count)
+  {
+    const __m256i shuffle = _mm256_setr_epi8(
+            1, 0, 3, 2, 5, 4, 7, 6, 9, 8, 11, 10, 13, 12, 15, 14,
+            1, 0, 3, 2, 5, 4, 7, 6, 9, 8, 11, 10, 13, 12, 15, 14);
+    int i = 0;
+    for (; i + 16 <= count; i += 16)
+    {
+      __m256i v = _mm256_loadu_si256((const __m256i*)(data + 2 * i));
+      _mm256_storeu_si256((__m256i*)(out + 2 * i), _mm256_shuffle_epi8(v, shuffle));
+    }
+    PCMByteSwapScalar<16>(data + 2 * i, out + 2 * i, count - i);
+  }
+
+  __attribute__((target("avx2")))
+  static void swap24_avx2(const char * data, char * out, int count)
+  {
+    // a lane holds 5 samples in its 15 first bytes, the last byte is kept
+    const __m256i shuffle = _mm256_setr_epi8(
+            2, 1, 0, 5, 4, 3, 8, 7, 6, 11, 10, 9, 14, 13, 12, 15,
+            2, 1, 0, 5, 4, 3, 8, 7, 6, 11, 10, 9, 14, 13, 12, 15);
+    int i = 0;
+    // the loads read 31 bytes for 10 samples, the stores write as much
+    for (; i + 11 <= count; i += 10)
+    {
+      const char * p = data + 3 * i;
+      __m256i v = _mm256_inserti128_si256(_mm256_castsi128_si256(_mm_loadu_si128((const __m128i*)p)),
+                                          _mm_loadu_si128((const __m128i*)(p + 15)), 1);
+      v = _mm256_shuffle_epi8(v, shuffle);
+      // the second store overwrites the byte kept by the first one
+      _mm_storeu_si128((__m128i*)(out + 3 * i), _mm256_castsi256_si128(v));
+      _mm_storeu_si128((__m128i*)(out + 3 * i + 15), _mm256_extracti128_si256(v, 1));
+    }
+    PCMByteSwapScalar<24>(data + 3 * i, out + 3 * i, count - i);
+  }
+
+  __attribute__((target("avx2")))
+  static void swap32_avx2(const char * data, char * out, int count)
+  {
+    const __m256i shuffle = _mm256_setr_epi8(
+            3, 2, 1, 0, 7, 6, 5, 4, 11, 10, 9, 8, 15, 14, 13, 12,
+            3, 2, 1, 0, 7, 6, 5, 4, 11, 10, 9, 8, 15, 14, 13, 12);
+    int i = 0;
+    for (; i + 8 <= count; i += 8)
+    {
+      __m256i v = _mm256_loadu_si256((const __m256i*)(data + 4 * i));
+      _mm256_storeu_si256((__m256i*)(out + 4 * i), _mm256_shuffle_epi8(v, shuffle));
+    }
+    PCMByteSwapScalar<32>(data + 4 * i, out + 4 * i, count - i);
+  }
+
+  static bool __has_avx2()
+  {
+    static const bool avx2 = __builtin_cpu_supports("avx2");
+    return avx2;
+  }
+#endif
+
+#ifdef PCMCONVERT_NEON
+  static void u8_neon(const char * data, int32_t * pcm, int count)
+  {
+    const int16x8_t bias = vdupq_n_s16(128);
+    int i = 0;
+    for (; i + 16 <= count; i += 16)
+    {
+      uint8x16_t v = vld1q_u8((const uint8_t*)(data + i));
+      int16x8_t lo = vsubq_s16(vreinterpretq_s16_u16(vmovl_u8(vget_low_u8(v))), bias);
+      int16x8_t hi = vsubq_s16(vreinterpretq_s16_u16(vmovl_u8(vget_high_u8(v))), bias);
+      vst1q_s32(pcm + i, vmovl_s16(vget_low_s16(lo)));
+      vst1q_s32(pcm + i + 4, vmovl_s16(vget_high_s16(lo)));
+      vst1q_s32(pcm + i + 8, vmovl_s16(vget_low_s16(hi)));
+      vst1q_s32(pcm + i + 12, vmovl_s16(vget_high_s16(hi)));
+    }
+    PCMToInt32Scalar<8>(data + i, pcm + i, count - i);
+  }
+
+  static void s16le_neon(const char * data, int32_t * pcm, int count)
+  {
+    int i = 0;
+    for (; i + 8 <= count; i += 8)
+    {
+      int16x8_t v = vld1q_s16((const int16_t*)(data + 2 * i));
+      vst1q_s32(pcm + i, vmovl_s16(vget_low_s16(v)));
+      vst1q_s32(pcm + i + 4, vmovl_s16(vget_high_s16(v)));
+    }
+    PCMToInt32Scalar<16>(data + 2 * i, pcm + i, count - i);
+  }
+
+  static void s24le_neon(const char * data, int32_t * pcm, int count)
+  {
+    int i = 0;
+    for (; i + 16 <= count; i += 16)
+    {
+      // deinterleave the low, middle and high bytes of 16 samples
+      uint8x16x3_t v = vld3q_u8((const uint8_t*)(data + 3 * i));
+      uint8x16x2_t lm = vzipq_u8(v.val[0], v.val[1]);
+      int8x16_t h = vreinterpretq_s8_u8(v.val[2]);
+      int16x8_t h0 = vmovl_s8(vget_low_s8(h));
+      int16x8_t h1 = vmovl_s8(vget_high_s8(h));
+      uint16x8_t l0 = vreinterpretq_u16_u8(lm.val[0]);
+      uint16x8_t l1 = vreinterpretq_u16_u8(lm.val[1]);
+      // the high byte sign extended, shifted above the low word
+      vst1q_s32(pcm + i, vorrq_s32(vshlq_n_s32(vmovl_s16(vget_low_s16(h0)), 16), vreinterpretq_s32_u32(vmovl_u16(vget_low_u16(l0)))));
+      vst1q_s32(pcm + i + 4, vorrq_s32(vshlq_n_s32(vmovl_s16(vget_high_s16(h0)), 16), vreinterpretq_s32_u32(vmovl_u16(vget_high_u16(l0)))));
+      vst1q_s32(pcm + i + 8, vorrq_s32(vshlq_n_s32(vmovl_s16(vget_low_s16(h1)), 16), vreinterpretq_s32_u32(vmovl_u16(vget_low_u16(l1)))));
+      vst1q_s32(pcm + i + 12, vorrq_s32(vshlq_n_s32(vmovl_s16(vget_high_s16(h1)), 16), vreinterpretq_s32_u32(vmovl_u16(vget_high_u16(l1)))));
+    }
+    PCMToInt32Scalar<24>(data + 3 * i, pcm + i, count - i);
+  }
+
+  static void swap16_neon(const char * data, char * out, int count)
+  {
+    int i = 0;
+    for (; i + 8 <= count; i += 8)
+      vst1q_u8((uint8_t*)(out + 2 * i), vrev16q_u8(vld1q_u8((const uint8_t*)(data + 2 * i))));
+    PCMByteSwapScalar<16>(data + 2 * i, out + 2 * i, count - i);
+  }
+
+  static void swap24_neon(const char * data, char * out, int count)
+  {
+    int i = 0;
+    for (; i + 16 <= count; i += 16)
+    {
+      // deinterleave the bytes of 16 samples, and interleave them back reversed
+      uint8x16x3_t v = vld3q_u8((const uint8_t*)(data + 3 * i));
+      uint8x16_t t = v.val[0];
+      v.val[0] = v.val[2];
+      v.val[2] = t;
+      vst3q_u8((uint8_t*)(out + 3 * i), v);
+    }
+    PCMByteSwapScalar<24>(data + 3 * i, out + 3 * i, count - i);
+  }
+
+  static void swap32_neon(const char * data, char * out, int count)
+  {
+    int i = 0;
+    for (; i + 4 <= count; i += 4)
+      vst1q_u8((uint8_t*)(out + 4 * i), vrev32q_u8(vld1q_u8((const uint8_t*)(data + 4 * i))));
+    PCMByteSwapScalar<32>(data + 4 * i, out + 4 * i, count - i);
+  }
+#endif
+
+  struct PCMKernel
+  {
+    int sampleSize;
+    const char * name;
+    PCMToInt32 convert;
+    bool (*available)();
+  };
+
+  static bool __always() { return true; }
+
+  // by order of preference
+  static const PCMKernel __kernels[] = {
+#ifdef PCMCONVERT_AVX2
+    { 8, "avx2", u8_avx2, __has_avx2 },
+    { 16, "avx2", s16le_avx2, __has_avx2 },
+    { 24, "avx2", s24le_avx2, __has_avx2 },
+#endif
+#ifdef PCMCONVERT_SSE2
+    { 8, "sse2", u8_sse2, __always },
+    { 16, "sse2", s16le_sse2, __always },
+    { 24, "sse2", s24le_sse2, __always },
+    { 32, "sse2", s32le_native, __always },
+#endif
+#ifdef PCMCONVERT_NEON
+    { 8, "neon", u8_neon, __always },
+    { 16, "neon", s16le_neon, __always },
+    { 24, "neon", s24le_neon, __always },
+    { 32, "neon", s32le_native, __always },
+#endif
+    { 8, "scalar", PCMToInt32Scalar<8>, __always },
+    { 16, "scalar", PCMToInt32Scalar<16>, __always },
+    { 24, "scalar", PCMToInt32Scalar<24>, __always },
+    { 32, "scalar", PCMToInt32Scalar<32>, __always },
+  };
+}
+
+PCMToInt32 NSROOT::SelectPCMToInt32(int sampleSize, const char ** name)
+{
+  for (const PCMKernel& k : __kernels)
+  {
+    if (k.sampleSize == sampleSize && k.available())
+    {
+      if (name)
+        *name = k.name;
+      return k.convert;
+    }
+  }
+  return nullptr;
+}
+
+PCMToInt32 NSROOT::GetPCMToInt32(int sampleSize, const char * name)
+{
+  for (const PCMKernel& k : __kernels)
+  {
+    if (k.sampleSize == sampleSize && strcmp(k.name, name) == 0)
+      return (k.available() ? k.convert : nullptr);
+  }
+  return nullptr;
+}
+
+namespace NSROOT
+{
+  struct PCMSwapKernel
+  {
+    int sampleSize;
+    const char * name;
+    PCMByteSwap swap;
+    bool (*available)();
+  };
+
+  // by order of preference
+  static const PCMSwapKernel __swapKernels[] = {
+#ifdef PCMCONVERT_AVX2
+    { 16, "avx2", swap16_avx2, __has_avx2 },
+    { 24, "avx2", swap24_avx2, __has_avx2 },
+    { 32, "avx2", swap32_avx2, __has_avx2 },
+#endif
+#ifdef PCMCONVERT_SSE2
+    { 16, "sse2", swap16_sse2, __always },
+    { 32, "sse2", swap32_sse2, __always },
+#endif
+#ifdef PCMCONVERT_NEON
+    { 16, "neon", swap16_neon, __always },
+    { 24, "neon", swap24_neon, __always },
+    { 32, "neon", swap32_neon, __always },
+#endif
+    { 16, "scalar", PCMByteSwapScalar<16>, __always },
+    { 24, "scalar", PCMByteSwapScalar<24>, __always },
+    { 32, "scalar", PCMByteSwapScalar<32>, __always },
+  };
+}
+
+PCMByteSwap NSROOT::SelectPCMByteSwap(int sampleSize, const char ** name)
+{
+  for (const PCMSwapKernel& k : __swapKernels)
+  {
+    if (k.sampleSize == sampleSize && k.available())
+    {
+      if (name)
+        *name = k.name;
+      return k.swap;
+    }
+  }
+  return nullptr;
+}
+
+PCMByteSwap NSROOT::GetPCMByteSwap(int sampleSize, const char * name)
+{
+  for (const PCMSwapKernel& k : __swapKernels)
+  {
+    if (k.sampleSize == sampleSize && strcmp(k.name, name) == 0)
+      return (k.available() ? k.swap : nullptr);
+  }
+  return nullptr;
+}
@@ -0,0 +1,122 @@
+/*
+ *      Copyright (C) 2026 Jean-Luc Barriere
+ *
+ *  This file is part of Noson
+ *
+ *  Noson is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  Noson is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#ifndef PCMCONVERT_H
+#define PCMCONVERT_H
+
+#include "local_config.h"
+#include "byteorder.h"
+
+#include <stdint.h>
+
+namespace NSROOT
+{
+
+  /**
+   * Convert packed PCM samples into int32, sign extended.
+   * @param data The packed samples
+   * @param pcm The output
+   * @param count The count of samples, i.e frames x channels
+   */
+  typedef void (*PCMToInt32)(const char * data, int32_t * pcm, int count);
+
+  /**
+   * The reference kernels, one sample at a time.
+   */
+  template <int SIZE> struct PCMSample;
+
+  template <> struct PCMSample<8>
+  {
+    static constexpr int bytes = 1;
+    static int32_t read(const char * p) { return (int32_t)(unsigned char)(*p) - 128; }
+  };
+
+  template <> struct PCMSample<16>
+  {
+    static constexpr int bytes = 2;
+    static int32_t read(const char * p) { return read16le(p); }
+  };
+
+  template <> struct PCMSample<24>
+  {
+    static constexpr int bytes = 3;
+    static int32_t read(const char * p) { return read24le(p); }
+  };
+
+  template <> struct PCMSample<32>
+  {
+    static constexpr int bytes = 4;
+    static int32_t read(const char * p) { return read32le(p); }
+  };
+
+  template <int SIZE>
+  void PCMToInt32Scalar(const char * data, int32_t * pcm, int count)
+  {
+    for (int i = 0; i < count; ++i, data += PCMSample<SIZE>::bytes)
+      pcm[i] = PCMSample<SIZE>::read(data);
+  }
+
+  /**
+   * Select the fastest kernel for the format supported by the CPU.
+   * @param sampleSize 8 for unsigned, 16, 24 or 32 for signed little-endian
+   * @param name (out) If not null, the name of the kernel
+   * @return the kernel or null if the format is not supported
+   */
+  PCMToInt32 SelectPCMToInt32(int sampleSize, const char ** name = nullptr);
+
+  /**
+   * Get a kernel by name, for the tests and the benchmark.
+   * @return the kernel or null if not available on this CPU
+   */
+  PCMToInt32 GetPCMToInt32(int sampleSize, const char * name);
+
+  /**
+   * Reverse the byte order of packed PCM samples.
+   * @param data The packed samples
+   * @param out The output, that cannot overlap the input
+   * @param count The count of samples, i.e frames x channels
+   */
+  typedef void (*PCMByteSwap)(const char * data, char * out, int count);
+
+  template <int SIZE>
+  void PCMByteSwapScalar(const char * data, char * out, int count)
+  {
+    for (int i = 0; i < count; ++i, data += SIZE / 8, out += SIZE / 8)
+      for (int b = 0; b < SIZE / 8; ++b)
+        out[b] = data[SIZE / 8 - 1 - b];
+  }
+
+  /**
+   * Select the fastest byte swap kernel supported by the CPU.
+   * @param sampleSize 16, 24 or 32
+   * @param name (out) If not null, the name of the kernel
+   * @return the kernel or null if the size is not supported
+   */
+  PCMByteSwap SelectPCMByteSwap(int sampleSize, const char ** name = nullptr);
+
+  /**
+   * Get a byte swap kernel by name, for the tests and the benchmark.
+   * @return the kernel or null if not available on this CPU
+   */
+  PCMByteSwap GetPCMByteSwap(int sampleSize, const char * name);
+
+}
+
+#endif /* PCMCONVERT_H */
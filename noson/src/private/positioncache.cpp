@@ -0,0 +1,105 @@
+/*
+ *      Copyright (C) 2026 Jean-Luc Barriere
+ *
+ *  This file is part of Noson
+ *
+ *  Noson is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  Noson is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+#include "positioncache.h"
+#include "../avtransport.h"
+
+#include <cstdio>
+
+using namespace NSROOT;
+
+PositionCache::PositionCache()
+: m_generation(1)
+, m_stored(0)
+, m_expiry(0)
+, m_anchor(0)
+, m_relTime(0)
+, m_duration(0)
+, m_playing(false)
+, m_interpolate(false)
+{
+}
+
+bool PositionCache::Load(ElementList& vars, int64_t now)
+{
+  OS::CLockGuard lock(m_mutex);
+  if (m_stored != m_generation.load() || now >= m_expiry)
+    return false;
+  if (!m_interpolate || !m_playing)
+  {
+    vars = m_vars;
+    return true;
+  }
+  unsigned relTime = m_relTime + (unsigned)((now - m_anchor) / 1000);
+  // past the end the next track should have been signaled: resync
+  if (m_duration > 0 && relTime > m_duration + AVTRANSPORT_POSITION_OVERRUN)
+    return false;
+  if (m_duration > 0 && relTime > m_duration)
+    relTime = m_duration;
+  vars.clear();
+  for (ElementList::const_iterator it = m_vars.begin(); it != m_vars.end(); ++it)
+  {
+    if ((*it)->GetKey() == "RelTime")
+      vars.push_back(ElementPtr(new Element("RelTime", FormatTime(relTime))));
+    else
+      vars.push_back(*it);
+  }
+  return true;
+}
+
+bool PositionCache::Store(const ElementList& vars, unsigned generation, int64_t start, int64_t end, bool playing, bool synced)
+{
+  OS::CLockGuard lock(m_mutex);
+  if (generation != m_generation.load())
+    return false;
+  m_stored = generation;
+  m_vars = vars;
+  // the position was taken halfway the request
+  m_anchor = (start + end) / 2;
+  m_duration = 0;
+  bool anchored = false;
+  for (ElementList::const_iterator it = vars.begin(); it != vars.end(); ++it)
+  {
+    if ((*it)->GetKey() == "RelTime")
+      anchored = ParseTime(**it, &m_relTime);
+    else if ((*it)->GetKey() == "TrackDuration")
+      ParseTime(**it, &m_duration);
+  }
+  m_playing = playing;
+  // extrapolate only while the changes of the transport are signaled
+  m_interpolate = anchored && synced;
+  m_expiry = end + (m_interpolate ? AVTRANSPORT_POSITION_RESYNC : 1000);
+  return true;
+}
+
+bool PositionCache::ParseTime(const std::string& str, unsigned* seconds)
+{
+  unsigned h, m, s;
+  if (sscanf(str.c_str(), "%u:%u:%u", &h, &m, &s) != 3)
+    return false;
+  *seconds = h * 3600 + m * 60 + s;
+  return true;
+}
+
+std::string PositionCache::FormatTime(unsigned seconds)
+{
+  char buf[16];
+  snprintf(buf, sizeof(buf), "%u:%.2u:%.2u", seconds / 3600, (seconds % 3600) / 60, seconds % 60);
+  return std::string(buf);
+}
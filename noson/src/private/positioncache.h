@@ -0,0 +1,97 @@
+/*
+ *      Copyright (C) 2026 Jean-Luc Barriere
+ *
+ *  This file is part of Noson
+ *
+ *  Noson is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  Noson is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+#ifndef POSITIONCACHE_H
+#define POSITIONCACHE_H
+
+#include "local_config.h"
+#include "../element.h"
+#include "os/threads/mutex.h"
+
+#include <string>
+#include <atomic>
+#include <stdint.h>
+
+namespace NSROOT
+{
+
+  /**
+   * The last position info, and the anchor to extrapolate the elapsed time
+   * from it. While the events are in sync, any change of the transport is
+   * signaled, so the reply stays valid until then, or the next resync.
+   * A change bumps the generation, and a reply requested before it is not
+   * stored, so no lock is held across the request.
+   */
+  class PositionCache
+  {
+  public:
+    PositionCache();
+    PositionCache(const PositionCache&) = delete;
+    PositionCache& operator=(const PositionCache&) = delete;
+
+    /**
+     * Invalidate the reply stored. It doesn't lock.
+     */
+    void Reset() { ++m_generation; }
+
+    /**
+     * Get the generation to store a reply with, before requesting it.
+     */
+    unsigned Generation() const { return m_generation.load(); }
+
+    /**
+     * Get the reply stored, with the elapsed time extrapolated to now.
+     * @param now The monotonic time in ms
+     * @return false if none is valid
+     */
+    bool Load(ElementList& vars, int64_t now);
+
+    /**
+     * Store the reply, unless the transport has changed since the request.
+     * @param generation The generation taken before the request
+     * @param start The monotonic time of the request in ms
+     * @param end The monotonic time of the reply in ms
+     * @param playing The transport is playing
+     * @param synced The changes of the transport are signaled
+     * @return false if the reply is outdated
+     */
+    bool Store(const ElementList& vars, unsigned generation, int64_t start, int64_t end, bool playing, bool synced);
+
+    /**
+     * Parse the time as H:MM:SS
+     */
+    static bool ParseTime(const std::string& str, unsigned* seconds);
+    static std::string FormatTime(unsigned seconds);
+
+  private:
+    std::atomic<unsigned> m_generation;
+    OS::CMutex m_mutex;
+    unsigned m_stored;    // the generation of the reply
+    int64_t m_expiry;
+    ElementList m_vars;
+    int64_t m_anchor;     // the monotonic time of the reply in ms
+    unsigned m_relTime;   // the elapsed time in seconds at the anchor
+    unsigned m_duration;  // the duration of the track in seconds or 0
+    bool m_playing;
+    bool m_interpolate;
+  };
+
+}
+
+#endif /* POSITIONCACHE_H */
@@ -0,0 +1,159 @@
+/*
+ *      Copyright (C) 2026 Jean-Luc Barriere
+ *
+ *  This library is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU Lesser General Public License as published
+ *  by the Free Software Foundation; either version 3, or (at your option)
+ *  any later version.
+ *
+ *  This library is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ *  GNU Lesser General Public License for more details.
+ *
+ *  You should have received a copy of the GNU Lesser General Public License
+ *  along with this library; see the file COPYING.  If not, write to
+ *  the Free Software Foundation, 51 Franklin Street, Fifth Floor, Boston,
+ *  MA 02110-1301 USA
+ *  http://www.gnu.org/copyleft/gpl.html
+ *
+ */
+
+#include "smapicache.h"
+#include "os/threads/threadpool.h"
+#include "os/threads/timeout.h"
+#include "debug.h"
+#include "cppdef.h"
+
+#define SMAPICACHE_THREADS  2
+
+using namespace NSROOT;
+
+SMAPICache::SMAPICache()
+: m_pool(nullptr)
+, m_size(0)
+, m_maxSize(SMAPICACHE_SIZE)
+, m_ttl(SMAPICACHE_TTL)
+, m_stale(SMAPICACHE_STALE)
+{
+}
+
+SMAPICache::~SMAPICache()
+{
+  if (m_pool)
+  {
+    m_pool->Reset();
+    delete m_pool;
+  }
+}
+
+SMAPICache::Status SMAPICache::Get(const std::string& partition, unsigned revision, const std::string& key, SMAPIMetadata& metadata, bool& refresh)
+{
+  OS::CLockGuard lock(m_mutex);
+  refresh = false;
+  EntryMap::iterator it = m_entries.find(key);
+  if (it == m_entries.end())
+    return Miss;
+  if (it->second.revision != revision)
+  {
+    // the auth of the account has changed
+    DBG(DBG_DEBUG, "%s: drop partition (%s)\n", __FUNCTION__, partition.c_str());
+    ErasePartition(partition, revision);
+    return Miss;
+  }
+  Entry& entry = it->second;
+  int64_t now = OS::gettime_ms();
+  if (now >= entry.expires + (int64_t)m_stale * 1000)
+  {
+    Erase(it);
+    return Miss;
+  }
+  m_lru.splice(m_lru.begin(), m_lru, entry.lru);
+  metadata = entry.metadata;
+  if (now < entry.expires)
+    return Fresh;
+  if (!entry.refreshing)
+    refresh = entry.refreshing = true;
+  return Stale;
+}
+
+void SMAPICache::Put(const std::string& partition, unsigned revision, const std::string& key, const SMAPIMetadata& metadata, size_t size)
+{
+  OS::CLockGuard lock(m_mutex);
+  if (size > m_maxSize)
+    return;
+  EntryMap::iterator it = m_entries.find(key);
+  if (it != m_entries.end())
+    Erase(it);
+  m_lru.push_front(key);
+  Entry& entry = m_entries[key];
+  entry.partition = partition;
+  entry.revision = revision;
+  entry.metadata = metadata;
+  entry.size = size;
+  entry.expires = OS::gettime_ms() + (int64_t)m_ttl * 1000;
+  entry.refreshing = false;
+  entry.lru = m_lru.begin();
+  m_size += size;
+  // evict the least recently used
+  while (m_size > m_maxSize && !m_lru.empty())
+    Erase(m_entries.find(m_lru.back()));
+}
+
+void SMAPICache::Abort(const std::string& key)
+{
+  OS::CLockGuard lock(m_mutex);
+  EntryMap::iterator it = m_entries.find(key);
+  if (it != m_entries.end())
+    it->second.refreshing = false;
+}
+
+void SMAPICache::Clear()
+{
+  OS::CLockGuard lock(m_mutex);
+  m_entries.clear();
+  m_lru.clear();
+  m_size = 0;
+}
+
+void SMAPICache::SetTTL(unsigned ttl, unsigned stale)
+{
+  OS::CLockGuard lock(m_mutex);
+  m_ttl = ttl;
+  m_stale = stale;
+}
+
+void SMAPICache::SetMaxSize(size_t bytes)
+{
+  OS::CLockGuard lock(m_mutex);
+  m_maxSize = bytes;
+  while (m_size > m_maxSize && !m_lru.empty())
+    Erase(m_entries.find(m_lru.back()));
+}
+
+bool SMAPICache::Enqueue(OS::CWorker* worker)
+{
+  OS::CLockGuard lock(m_mutex);
+  if (!m_pool)
+    m_pool = new OS::CThreadPool(SMAPICACHE_THREADS);
+  return m_pool->Enqueue(worker);
+}
+
+void SMAPICache::Erase(EntryMap::iterator it)
+{
+  m_size -= it->second.size;
+  m_lru.erase(it->second.lru);
+  m_entries.erase(it);
+}
+
+void SMAPICache::ErasePartition(const std::string& partition, unsigned revision)
+{
+  EntryMap::iterator it = m_entries.begin();
+  while (it != m_entries.end())
+  {
+    if (it->second.partition == partition && it->second.revision != revision)
+      Erase(it++);
+    else
+      ++it;
+  }
+}
@@ -0,0 +1,123 @@
+/*
+ *      Copyright (C) 2026 Jean-Luc Barriere
+ *
+ *  This library is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU Lesser General Public License as published
+ *  by the Free Software Foundation; either version 3, or (at your option)
+ *  any later version.
+ *
+ *  This library is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ *  GNU Lesser General Public License for more details.
+ *
+ *  You should have received a copy of the GNU Lesser General Public License
+ *  along with this library; see the file COPYING.  If not, write to
+ *  the Free Software Foundation, 51 Franklin Street, Fifth Floor, Boston,
+ *  MA 02110-1301 USA
+ *  http://www.gnu.org/copyleft/gpl.html
+ *
+ */
+
+#ifndef SMAPICACHE_H
+#define SMAPICACHE_H
+
+#include "local_config.h"
+#include "../smapimetadata.h"
+#include "os/threads/mutex.h"
+
+#include <string>
+#include <map>
+#include <list>
+#include <cstddef>
+#include <stdint.h>
+
+#define SMAPICACHE_TTL    60          // seconds an entry is fresh
+#define SMAPICACHE_STALE  600         // seconds an expired entry is served while revalidated
+#define SMAPICACHE_SIZE   0x400000    // bytes of responses held
+
+namespace NSROOT
+{
+
+  namespace OS
+  {
+    class CThreadPool;
+    class CWorker;
+  }
+
+  /**
+   * The store of the parsed responses of a music service. The entries are
+   * grouped by partition (service, account, language), and the partition is
+   * dropped as soon as the auth revision of the account changes. An entry is
+   * fresh during the TTL, then it can be served stale until revalidated.
+   */
+  class SMAPICache
+  {
+  public:
+    SMAPICache();
+    ~SMAPICache();
+    SMAPICache(const SMAPICache&) = delete;
+    SMAPICache& operator=(const SMAPICache&) = delete;
+
+    typedef enum
+    {
+      Miss,
+      Fresh,
+      Stale,
+    } Status;
+
+    /**
+     * Copy the cached response for the key.
+     * @param refresh (out) true when the caller must revalidate the stale entry
+     * @return the status of the entry
+     */
+    Status Get(const std::string& partition, unsigned revision, const std::string& key, SMAPIMetadata& metadata, bool& refresh);
+
+    /**
+     * Store the response for the key.
+     * @param size The size of the raw response, used to bound the memory
+     */
+    void Put(const std::string& partition, unsigned revision, const std::string& key, const SMAPIMetadata& metadata, size_t size);
+
+    // release the revalidation of the entry after a failure
+    void Abort(const std::string& key);
+
+    void Clear();
+
+    void SetTTL(unsigned ttl, unsigned stale);
+
+    void SetMaxSize(size_t bytes);
+
+    // run the worker in background, the cache takes the ownership
+    bool Enqueue(OS::CWorker* worker);
+
+  private:
+    struct Entry
+    {
+      std::string partition;
+      unsigned revision;
+      SMAPIMetadata metadata;
+      size_t size;
+      int64_t expires;
+      bool refreshing;
+      std::list<std::string>::iterator lru;
+    };
+    typedef std::map<std::string, Entry> EntryMap;
+
+    OS::CMutex m_mutex;
+    OS::CThreadPool* m_pool;
+    EntryMap m_entries;
+    std::list<std::string> m_lru; // most recently used first
+    size_t m_size;
+    size_t m_maxSize;
+    unsigned m_ttl;
+    unsigned m_stale;
+
+    void Erase(EntryMap::iterator it);
+    // erase the entries of the partition stored with another auth revision
+    void ErasePartition(const std::string& partition, unsigned revision);
+  };
+
+}
+
+#endif /* SMAPICACHE_H */
@@ -21,10 +21,15 @@
 
 #include "socket.h"
 #include "debug.h"
+#include "os/threads/mutex.h"
+#include "os/threads/timeout.h"
 
 #include <errno.h>
 #include <cstdio>
 #include <cstring>
+#include <map>
+
+#define SOCKET_ROUTE_TTL  60000 // lifetime of a cached route in ms
 
 #ifdef __WINDOWS__
 #include <WS2tcpip.h>
@@ -483,6 +488,44 @@ const char* TcpSocket::GetMyHostName()
   return my_hostname;
 }
 
+namespace NSROOT
+{
+  struct Route
+  {
+    std::string address;
+    int64_t expiry;
+  };
+  static OS::CMutex RouteLock;
+  static std::map<std::string, Route> RouteCache;
+}
+
+std::string TcpSocket::GetMyHostAddrInfoTo(const std::string& server, unsigned port)
+{
+  std::string key(server);
+  key.append(":").append(std::to_string(port));
+  int64_t now = OS::gettime_ms();
+  {
+    OS::CLockGuard lock(RouteLock);
+    std::map<std::string, Route>::const_iterator it = RouteCache.find(key);
+    if (it != RouteCache.end() && it->second.expiry > now)
+      return it->second.address;
+  }
+  TcpSocket sock;
+  sock.Connect(server.c_str(), port, 0);
+  std::string address = sock.GetHostAddrInfo();
+  sock.Disconnect();
+  OS::CLockGuard lock(RouteLock);
+  if (address.empty())
+    RouteCache.erase(key);
+  else
+  {
+    Route& route = RouteCache[key];
+    route.address = address;
+    route.expiry = now + SOCKET_ROUTE_TTL;
+  }
+  return address;
+}
+
 ///////////////////////////////////////////////////////////////////////////////
 ////
 //// TCP server socket
@@ -140,6 +140,16 @@ namespace NSROOT
      */
     static const char* GetMyHostName();
 
+    /**
+     * Returns the address of this host on the route to the given peer. The
+     * address is kept for a while, so that the next calls for the same peer
+     * do not connect again.
+     * @param server The peer
+     * @param port The port to connect on the peer
+     * @return the address string of this host, or empty on failure
+     */
+    static std::string GetMyHostAddrInfoTo(const std::string& server, unsigned port);
+
   protected:
     net_socket_t m_socket;
     int m_rcvbuf;
@@ -0,0 +1,55 @@
+/*
+ *      Copyright (C) 2026 Jean-Luc Barriere
+ *
+ *  This library is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU Lesser General Public License as published
+ *  by the Free Software Foundation; either version 3, or (at your option)
+ *  any later version.
+ *
+ *  This library is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ *  GNU Lesser General Public License for more details.
+ *
+ *  You should have received a copy of the GNU Lesser General Public License
+ *  along with this library; see the file COPYING.  If not, write to
+ *  the Free Software Foundation, 51 Franklin Street, Fifth Floor, Boston,
+ *  MA 02110-1301 USA
+ *  http://www.gnu.org/copyleft/gpl.html
+ *
+ */
+
+#ifndef URLPARAMS_H
+#define URLPARAMS_H
+
+#include "tokenizer.h"
+#include "urlencoder.h"
+
+#include <string>
+#include <vector>
+
+/**
+ * Split the query of the url into its parameters, as name=value
+ */
+#define urlparams __urlparams
+inline void __urlparams(const std::string& url, std::vector<std::string>& params) {
+  size_t s = url.find('?');
+  if (s != std::string::npos)
+    tokenize(url.substr(s + 1), "&", params, true);
+}
+
+/**
+ * Get the decoded value of the named parameter, or empty
+ */
+#define urlparamvalue __urlparamvalue
+inline std::string __urlparamvalue(const std::vector<std::string>& params, const std::string& name) {
+  size_t lval = name.length() + 1;
+  for (const std::string& str : params)
+  {
+    if (str.length() > lval && str.at(name.length()) == '=' && str.compare(0, name.length(), name) == 0)
+      return urldecode(str.substr(lval));
+  }
+  return std::string();
+}
+
+#endif /* URLPARAMS_H */
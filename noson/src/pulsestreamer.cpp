@@ -21,12 +21,16 @@
 #include "pasource.h"
 #include "audiostream.h"
 #include "flacencoder.h"
+#include "lpcmencoder.h"
+#include "framering.h"
 #include "requestbroker.h"
 #include "imageservice.h"
 #include "data/datareader.h"
 #include "private/debug.h"
 #include "private/socket.h"
 #include "private/os/threads/timeout.h"
+#include "private/os/threads/mutex.h"
+#include "private/urlparams.h"
 
 #include <cstring>
 
@@ -34,20 +38,171 @@
 #define PULSESTREAMER_ICON      "/pulseaudio.png"
 #define PULSESTREAMER_CONTENT   "audio/flac"
 #define PULSESTREAMER_DESC      "Audio stream from %s"
-#define PULSESTREAMER_TIMEOUT   10000
-#define PULSESTREAMER_MAX_PB    3
-#define PULSESTREAMER_CHUNK     16384
+#define PULSESTREAMER_MAX_PB    16      // max count of listeners
+#define PULSESTREAMER_RING      256     // count of encoded frames kept for the listeners
 #define PULSESTREAMER_TM_MUTE   1000
 #define PA_SINK_NAME            "noson"
 #define PA_CLIENT_NAME          PA_SINK_NAME
 
 using namespace NSROOT;
 
+namespace NSROOT
+{
+  struct PulseStreamerProfile
+  {
+    int chunk;          // max bytes sent in a chunk
+    unsigned timeout;   // ms to wait for data before closing the stream
+    unsigned burst;     // ms of the stream sent at once to a late listener
+    int block;          // frames written at once by the PCM stream
+  };
+
+  // indexed by FLACEncoder::Profile
+  static const PulseStreamerProfile __profiles[] = {
+    { 4096,  5000,  500,  576 },    // lowlatency
+    { 16384, 10000, 3000, 4096 },   // balanced
+    { 16384, 10000, 3000, 4096 },   // archival
+  };
+
+  enum
+  {
+    Format_FLAC = 0,
+    Format_WAV,
+    Format_L16,
+  };
+
+  struct PulseStreamerFormat
+  {
+    const char * name;
+    const char * uri;
+    const char * title;
+  };
+
+  // indexed by format
+  static const PulseStreamerFormat __formats[] = {
+    { "flac", PULSESTREAMER_URI,      PULSESTREAMER_CNAME },
+    { "wav",  PULSESTREAMER_URI_WAV,  PULSESTREAMER_CNAME ".wav" },
+    { "l16",  PULSESTREAMER_URI_L16,  PULSESTREAMER_CNAME ".l16" },
+  };
+
+  /**
+   * The writes of the FLAC encoder preceding the first frame are the
+   * metadata, that form the header of the stream.
+   */
+  class FLACFrameRing : public FrameRing
+  {
+  public:
+    FLACFrameRing(int frames) : FrameRing(frames) { }
+  protected:
+    bool isHeader(const char * data, int len) const override
+    {
+      // a frame starts with the sync code 0b11111111111110
+      return !(len >= 2 && (unsigned char)data[0] == 0xff && ((unsigned char)data[1] & 0xfe) == 0xf8);
+    }
+  };
+
+  /**
+   * The WAV encoder writes the RIFF header at once, before the samples.
+   */
+  class WAVFrameRing : public FrameRing
+  {
+  public:
+    WAVFrameRing(int frames) : FrameRing(frames) { }
+  protected:
+    bool isHeader(const char * data, int len) const override
+    {
+      return (len >= 4 && memcmp(data, "RIFF", 4) == 0);
+    }
+  };
+}
+
+/**
+ * The capture and the encoding of the sink, shared by the listeners of a
+ * format and a profile. The PCM formats are not encoded, but only framed.
+ */
+struct PulseStreamer::Pipeline
+{
+  Pipeline(const std::string& deviceName, int _format, FLACEncoder::Profile _profile)
+  : format(_format)
+  , profile(_profile)
+  , src(PA_CLIENT_NAME, deviceName)
+  , enc(nullptr)
+  , ring(nullptr)
+  , stream(nullptr)
+  , muted(PULSESTREAMER_TM_MUTE)
+  , listeners(0)
+  {
+    if (format == Format_FLAC)
+    {
+      FLACEncoder * flac = new FLACEncoder();
+      flac->setProfile(profile);
+      enc = flac;
+      ring = new FLACFrameRing(PULSESTREAMER_RING);
+    }
+    else
+    {
+      LPCMEncoder * lpcm = new LPCMEncoder();
+      lpcm->setFraming(format == Format_WAV ? LPCMEncoder::WAV : LPCMEncoder::L16);
+      lpcm->setBlockSize(__profiles[profile].block);
+      enc = lpcm;
+      if (format == Format_WAV)
+        ring = new WAVFrameRing(PULSESTREAMER_RING);
+      else
+        ring = new FrameRing(PULSESTREAMER_RING);
+    }
+    stream = new AudioStream(src, *enc);
+  }
+
+  ~Pipeline()
+  {
+    delete stream;
+    delete ring;
+    delete enc;
+  }
+
+  bool start()
+  {
+    ring->open(IODevice::WriteOnly);
+    enc->connectOutput(ring);
+    // the source is muted for a short time to limit output rate on startup
+    src.mute(true);
+    if (stream->start())
+      return true;
+    ring->close();
+    return false;
+  }
+
+  void stop()
+  {
+    stream->stop();
+    enc->connectOutput(nullptr);
+    ring->close();
+  }
+
+  // disable source mute after delay
+  void unmute()
+  {
+    OS::CLockGuard lock(mutex);
+    if (src.muted() && !muted.TimeLeft())
+      src.mute(false);
+  }
+
+  const int format;
+  const FLACEncoder::Profile profile;
+  PASource src;
+  AudioEncoder * enc;
+  FrameRing * ring;
+  AudioStream * stream;
+  OS::CTimeout muted;
+  OS::CMutex mutex;
+  int listeners;
+};
+
 PulseStreamer::PulseStreamer(RequestBroker * imageService /*= nullptr*/)
 : RequestBroker()
 , m_resources()
 , m_sinkIndex(0)
 , m_playbackCount(0)
+, m_pipelines(PipelineMap())
 {
   // delegate image download to imageService
   ResourcePtr img(nullptr);
@@ -57,15 +212,18 @@ PulseStreamer::PulseStreamer(RequestBroker * imageService /*= nullptr*/)
                                          PULSESTREAMER_ICON,
                                          DataReader::Instance());
 
-  // declare the static resource
-  ResourcePtr ptr = ResourcePtr(new Resource());
-  ptr->uri = PULSESTREAMER_URI;
-  ptr->title = PULSESTREAMER_CNAME;
-  ptr->description = PULSESTREAMER_DESC;
-  ptr->contentType = PULSESTREAMER_CONTENT;
-  if (img)
-    ptr->iconUri.assign(img->uri).append("?id=" LIBVERSION);
-  m_resources.push_back(ptr);
+  // declare the static resources, one by format
+  for (unsigned i = 0; i < sizeof(__formats) / sizeof(PulseStreamerFormat); ++i)
+  {
+    ResourcePtr ptr = ResourcePtr(new Resource());
+    ptr->uri = __formats[i].uri;
+    ptr->title = __formats[i].title;
+    ptr->description = PULSESTREAMER_DESC;
+    ptr->contentType = contentType(i);
+    if (img)
+      ptr->iconUri.assign(img->uri).append("?id=" LIBVERSION);
+    m_resources.push_back(ptr);
+  }
 }
 
 bool PulseStreamer::Initialize()
@@ -79,19 +237,21 @@ bool PulseStreamer::HandleRequest(handle * handle)
 {
   if (!IsAborted())
   {
-    const std::string& requrl = RequestBroker::GetRequestURI(handle);
-    if (requrl.compare(0, strlen(PULSESTREAMER_URI), PULSESTREAMER_URI) == 0)
+    // the format is requested by the stream URL
+    int format;
+    if (formatByURI(RequestBroker::GetRequestURI(handle), &format))
     {
       switch (RequestBroker::GetRequestMethod(handle))
       {
       case RequestBroker::Method_GET:
-        streamSink(handle);
+        streamSink(handle, format);
         return true;
       case RequestBroker::Method_HEAD:
       {
+        // probe the content type of the format
         std::string resp;
         resp.assign(RequestBroker::MakeResponseHeader(RequestBroker::Status_OK))
-            .append("Content-Type: audio/flac\r\n")
+            .append("Content-Type: ").append(contentType(format)).append("\r\n")
             .append("\r\n");
         RequestBroker::Reply(handle, resp.c_str(), resp.length());
         return true;
@@ -106,8 +266,12 @@ bool PulseStreamer::HandleRequest(handle * handle)
 
 RequestBroker::ResourcePtr PulseStreamer::GetResource(const std::string& title)
 {
-  (void)title;
-  return m_resources.front();
+  for (ResourceList::iterator it = m_resources.begin(); it != m_resources.end(); ++it)
+  {
+    if ((*it)->title == title)
+      return (*it);
+  }
+  return ResourcePtr();
 }
 
 RequestBroker::ResourceList PulseStreamer::GetResourceList()
@@ -200,7 +364,7 @@ void PulseStreamer::FreePASink()
   }
 }
 
-void PulseStreamer::streamSink(handle * handle)
+void PulseStreamer::streamSink(handle * handle, int format)
 {
   m_playbackCount.Add(1);
 
@@ -215,50 +379,119 @@ void PulseStreamer::streamSink(handle * handle)
     Reply429(handle);
   else
   {
-    AudioSource * src = new PASource(PA_CLIENT_NAME, deviceName);
-    AudioEncoder * enc = new FLACEncoder();
-    AudioStream ai(*src, *enc);
-    // the source is muted for a short time to limit output rate on startup
-    OS::CTimeout muted(PULSESTREAMER_TM_MUTE);
-    src->mute(true);
-    ai.start();
+    // the encoder profile is requested by the stream URL
+    FLACEncoder::Profile profile = FLACEncoder::Balanced;
+    std::vector<std::string> params;
+    urlparams(RequestBroker::GetRequestURI(handle), params);
+    std::string profileName = urlparamvalue(params, PULSESTREAMER_PARAM_PROFILE);
+    if (!profileName.empty() && !FLACEncoder::profileByName(profileName, &profile))
+      DBG(DBG_WARN, "%s: unknown profile (%s)\n", __FUNCTION__, profileName.c_str());
+    const PulseStreamerProfile& settings = __profiles[profile];
 
-    std::string resp;
-    resp.assign(RequestBroker::MakeResponseHeader(RequestBroker::Status_OK))
-        .append("Content-Type: audio/flac\r\n")
-        .append("Transfer-Encoding: chunked\r\n")
-        .append("\r\n");
-
-    if (RequestBroker::Reply(handle, resp.c_str(), resp.length()))
+    Pipeline * pipeline = attachPipeline(format, profile, deviceName);
+    if (!pipeline)
+      Reply503(handle);
+    else
     {
-      char * buf = new char [PULSESTREAMER_CHUNK + 16];
-      int r = 0;
-      while (!IsAborted() && (r = ai.read(buf + 7, PULSESTREAMER_CHUNK, PULSESTREAMER_TIMEOUT)) > 0)
+      // a late listener starts with the last frames, so the player can fill
+      // its buffer at once
+      FrameRing::Cursor cursor;
+      pipeline->ring->attach(cursor, settings.burst);
+
+      std::string resp;
+      resp.assign(RequestBroker::MakeResponseHeader(RequestBroker::Status_OK))
+          .append("Content-Type: ").append(contentType(format)).append("\r\n")
+          .append("Transfer-Encoding: chunked\r\n")
+          .append("\r\n");
+
+      if (RequestBroker::Reply(handle, resp.c_str(), resp.length()))
       {
-        char str[8];
-        snprintf(str, sizeof(str), "%05x\r\n", (unsigned)r & 0xfffff);
-        memcpy(buf, str, 7);
-        memcpy(buf + r + 7, "\r\n", 2);
-        if (!RequestBroker::Reply(handle, buf, r + 7 + 2))
-          break;
-        // disable source mute after delay
-        if (src->muted() && !muted.TimeLeft())
-          src->mute(false);
+        char * buf = new char [settings.chunk + 16];
+        int r = 0;
+        while (!IsAborted() && (r = pipeline->ring->read(cursor, buf + 7, settings.chunk, settings.timeout)) > 0)
+        {
+          char str[8];
+          snprintf(str, sizeof(str), "%05x\r\n", (unsigned)r & 0xfffff);
+          memcpy(buf, str, 7);
+          memcpy(buf + r + 7, "\r\n", 2);
+          if (!RequestBroker::Reply(handle, buf, r + 7 + 2))
+            break;
+          pipeline->unmute();
+        }
+        delete [] buf;
+        if (r == 0)
+          RequestBroker::Reply(handle, "0\r\n\r\n", 5);
       }
-      delete [] buf;
-      if (r == 0)
-        RequestBroker::Reply(handle, "0\r\n\r\n", 5);
-    }
 
-    ai.stop();
-    delete enc;
-    delete src;
+      if (cursor.dropped)
+        DBG(DBG_WARN, "%s: slow listener lost %u frames\n", __FUNCTION__, cursor.dropped);
+      detachPipeline(pipeline);
+    }
   }
 
   FreePASink();
   m_playbackCount.Sub(1);
 }
 
+PulseStreamer::Pipeline * PulseStreamer::attachPipeline(int format, int profile, const std::string& deviceName)
+{
+  Locked<PipelineMap>::pointer pipelines = m_pipelines.Get();
+  PipelineMap::iterator it = pipelines->find(std::make_pair(format, profile));
+  if (it == pipelines->end())
+  {
+    Pipeline * pipeline = new Pipeline(deviceName, format, static_cast<FLACEncoder::Profile>(profile));
+    if (!pipeline->start())
+    {
+      DBG(DBG_ERROR, "%s: failed to start the stream (%s)\n", __FUNCTION__, deviceName.c_str());
+      delete pipeline;
+      return nullptr;
+    }
+    DBG(DBG_DEBUG, "%s: start the stream (%s %s)\n", __FUNCTION__, __formats[format].name, FLACEncoder::profileName(pipeline->profile));
+    it = pipelines->insert(std::make_pair(std::make_pair(format, profile), pipeline)).first;
+  }
+  ++(it->second->listeners);
+  return it->second;
+}
+
+void PulseStreamer::detachPipeline(Pipeline * pipeline)
+{
+  Locked<PipelineMap>::pointer pipelines = m_pipelines.Get();
+  if (--(pipeline->listeners) > 0)
+    return;
+  DBG(DBG_DEBUG, "%s: stop the stream (%s %s)\n", __FUNCTION__, __formats[pipeline->format].name, FLACEncoder::profileName(pipeline->profile));
+  pipelines->erase(std::make_pair(pipeline->format, (int)pipeline->profile));
+  pipeline->stop();
+  delete pipeline;
+}
+
+bool PulseStreamer::formatByURI(const std::string& uri, int * format)
+{
+  std::string path = uri.substr(0, uri.find('?'));
+  for (unsigned i = 0; i < sizeof(__formats) / sizeof(PulseStreamerFormat); ++i)
+  {
+    if (path == __formats[i].uri)
+    {
+      *format = i;
+      return true;
+    }
+  }
+  return false;
+}
+
+std::string PulseStreamer::contentType(int format)
+{
+  // the source captures the sink in the default format
+  switch (format)
+  {
+  case Format_WAV:
+    return LPCMEncoder::mediaType(LPCMEncoder::WAV, AudioFormat::CDLPCM());
+  case Format_L16:
+    return LPCMEncoder::mediaType(LPCMEncoder::L16, AudioFormat::CDLPCM());
+  default:
+    return PULSESTREAMER_CONTENT;
+  }
+}
+
 void PulseStreamer::Reply503(handle * handle)
 {
   std::string resp;
@@ -22,8 +22,15 @@
 #include "requestbroker.h"
 #include "locked.h"
 
+#include <string>
+#include <vector>
+#include <map>
+
 #define PULSESTREAMER_CNAME   "pulse"
 #define PULSESTREAMER_URI     "/music/pulse.flac"
+#define PULSESTREAMER_URI_WAV "/music/pulse.wav"
+#define PULSESTREAMER_URI_L16 "/music/pulse.l16"
+#define PULSESTREAMER_PARAM_PROFILE "profile"  // lowlatency, balanced or archival
 
 namespace NSROOT
 {
@@ -53,9 +60,19 @@ private:
   // count current running playback
   LockedNumber<int> m_playbackCount;
 
+  // the running pipelines by format and profile
+  struct Pipeline;
+  typedef std::map<std::pair<int, int>, Pipeline*> PipelineMap;
+  Locked<PipelineMap> m_pipelines;
+  Pipeline * attachPipeline(int format, int profile, const std::string& deviceName);
+  void detachPipeline(Pipeline * pipeline);
+
+  static bool formatByURI(const std::string& uri, int * format);
+  static std::string contentType(int format);
+
   std::string GetPASink();
   void FreePASink();
-  void streamSink(handle * handle);
+  void streamSink(handle * handle, int format);
 
   void Reply503(handle * handle);
   void Reply400(handle * handle);
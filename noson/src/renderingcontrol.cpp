@@ -22,6 +22,11 @@
 #include "private/builtin.h"
 #include "private/cppdef.h"
 #include "private/debug.h"
+#include "private/os/threads/event.h"
+#include "private/os/threads/timeout.h"
+#include "private/eventsequence.h"
+
+#include <cstring>
 
 using namespace NSROOT;
 
@@ -36,9 +41,10 @@ RenderingControl::RenderingControl(const std::string& serviceHost, unsigned serv
 : Service(serviceHost, servicePort)
 , m_subscriptionPool()
 , m_subscription()
-, m_CBHandle(nullptr)
-, m_eventCB(nullptr)
+, m_eventTarget(EventTarget(nullptr, nullptr))
+, m_eventDone(new OS::CEvent)
 , m_msgCount(0)
+, m_sequence(new EventSequence())
 , m_property(RCSProperty())
 {
 }
@@ -47,9 +53,10 @@ RenderingControl::RenderingControl(const std::string& serviceHost, unsigned serv
 : Service(serviceHost, servicePort)
 , m_subscriptionPool(subscriptionPool)
 , m_subscription()
-, m_CBHandle(CBHandle)
-, m_eventCB(eventCB)
+, m_eventTarget(EventTarget(CBHandle, eventCB))
+, m_eventDone(new OS::CEvent)
 , m_msgCount(0)
+, m_sequence(new EventSequence())
 , m_property(RCSProperty())
 {
   unsigned subId = m_subscriptionPool->GetEventHandler().CreateSubscription(this);
@@ -65,6 +72,54 @@ RenderingControl::~RenderingControl()
     m_subscriptionPool->UnsubscribeEvent(m_subscription);
     m_subscriptionPool->GetEventHandler().RevokeAllSubscriptions(this);
   }
+  SAFE_DELETE(m_eventDone);
+  SAFE_DELETE(m_sequence);
+}
+
+void RenderingControl::SetEventCB(void* CBHandle, EventCB eventCB)
+{
+  unsigned generation;
+  {
+    // BEGIN CRITICAL SECTION
+    Locked<EventTarget>::pointer target = m_eventTarget.Get();
+    target->handle = CBHandle;
+    target->eventCB = eventCB;
+    generation = ++target->generation;
+    // END CRITICAL SECTION
+  }
+  WaitEventCall(generation);
+}
+
+void RenderingControl::RevokeEventCB(void* CBHandle)
+{
+  unsigned generation;
+  {
+    // BEGIN CRITICAL SECTION
+    Locked<EventTarget>::pointer target = m_eventTarget.Get();
+    if (target->handle != CBHandle)
+      return;
+    target->handle = nullptr;
+    target->eventCB = nullptr;
+    generation = ++target->generation;
+    // END CRITICAL SECTION
+  }
+  WaitEventCall(generation);
+}
+
+void RenderingControl::WaitEventCall(unsigned generation)
+{
+  // the callback runs out of the lock, so wait for a call made with an
+  // older target, unless the change is made by that call
+  for (;;)
+  {
+    {
+      Locked<EventTarget>::pointer target = m_eventTarget.Get();
+      if (target->calling == 0 || target->calling >= generation ||
+              target->caller == std::this_thread::get_id())
+        return;
+    }
+    m_eventDone->Wait(100);
+  }
 }
 
 bool RenderingControl::GetVolume(uint8_t* value, const char* channel)
@@ -92,7 +147,12 @@ bool RenderingControl::SetVolume(uint8_t value, const char* channel)
   args.push_back(ElementPtr(new Element("DesiredVolume", std::to_string(value))));
   ElementList vars = Request("SetVolume", args);
   if (!vars.empty() && vars[0]->compare("SetVolumeResponse") == 0)
+  {
+    // the next relative change is based on it, before the event confirms it
+    if (strcmp(channel, CH_MASTER) == 0)
+      m_property.Get()->VolumeMaster = value;
     return true;
+  }
   return false;
 }
 
@@ -348,6 +408,15 @@ bool RenderingControl::GetDecibelRange(int16_t *minimum, int16_t *maximum, const
   return false;
 }
 
+bool RenderingControl::GetCachedProperty(RCSProperty& property)
+{
+  Locked<RCSProperty>::pointer prop = m_property.Get();
+  if (!m_sequence->IsSynced() || prop->EventSID.empty() || prop->EventSID != m_subscription.GetSID())
+    return false;
+  property = *prop;
+  return true;
+}
+
 void RenderingControl::HandleEventMessage(EventMessagePtr msg)
 {
   if (!msg)
@@ -365,17 +434,11 @@ void RenderingControl::HandleEventMessage(EventMessagePtr msg)
         // check for higher sequence
         uint32_t seq = 0;
         string_to_uint32(msg->subject[1].c_str(), &seq);
-        if (msg->subject[0] != prop->EventSID)
-        {
-          prop->EventSID = msg->subject[0];
-        }
-        else if (seq < prop->EventSEQ)
-        {
-          DBG(DBG_DEBUG, "%s: %s SEQ=%u , discarding %u\n", __FUNCTION__, prop->EventSID.c_str(), prop->EventSEQ, seq);
+        if (!m_sequence->Check(prop->EventSID, prop->EventSEQ, msg->subject[0], seq))
           return;
-        }
-        // tracking serial of the event
-        prop->EventSEQ = seq;
+        // resync a stale state, with back-off
+        if (m_sequence->Resubscribe(OS::gettime_ms()))
+          m_subscription.AskResubscribe();
 
         std::vector<std::string>::const_iterator it = msg->subject.begin();
         while (it != msg->subject.end())
@@ -463,8 +526,26 @@ void RenderingControl::HandleEventMessage(EventMessagePtr msg)
       }
       // Signal
       ++m_msgCount;
-      if (m_eventCB)
-        m_eventCB(m_CBHandle);
+      void* handle;
+      EventCB eventCB;
+      {
+        // BEGIN CRITICAL SECTION
+        Locked<EventTarget>::pointer target = m_eventTarget.Get();
+        handle = target->handle;
+        eventCB = target->eventCB;
+        if (eventCB)
+        {
+          target->calling = target->generation;
+          target->caller = std::this_thread::get_id();
+        }
+        // END CRITICAL SECTION
+      }
+      if (eventCB)
+      {
+        eventCB(handle);
+        m_eventTarget.Get()->calling = 0;
+        m_eventDone->Broadcast();
+      }
     }
   }
 }
@@ -28,10 +28,17 @@
 #include "locked.h"
 
 #include <stdint.h>
+#include <thread>
 
 namespace NSROOT
 {
   class Subscription;
+  class EventSequence;
+
+  namespace OS
+  {
+    class CEvent;
+  }
 
   class RenderingControl : public Service, public EventSubscriber
   {
@@ -100,14 +107,46 @@ namespace NSROOT
 
     bool Empty() const { return m_msgCount == 0; }
 
+    /**
+     * Copy the state maintained by the events. It fails while the state
+     * could be stale: no event received for the current subscription, or a
+     * gap in the sequence of events.
+     */
+    bool GetCachedProperty(RCSProperty& property);
+
     Locked<RCSProperty>& GetRenderingProperty() { return m_property; }
 
+    /**
+     * Change the callback on event. Once returned, the previous one will no
+     * longer be called: a call in flight is waited for, unless this is called
+     * from that call.
+     */
+    void SetEventCB(void* CBHandle, EventCB eventCB);
+
+    /**
+     * Clear the callback on event if it still targets the given handle, so a
+     * late release can't clear the callback of the next owner.
+     */
+    void RevokeEventCB(void* CBHandle);
+
   private:
     SubscriptionPoolPtr m_subscriptionPool;
     Subscription m_subscription;
-    void* m_CBHandle;
-    EventCB m_eventCB;
+    struct EventTarget
+    {
+      void* handle;
+      EventCB eventCB;
+      unsigned generation;          // bumped on each change of the callback
+      unsigned calling;             // the generation of the call in flight, or 0
+      std::thread::id caller;
+      EventTarget(void* _handle, EventCB _eventCB)
+      : handle(_handle), eventCB(_eventCB), generation(1), calling(0) { }
+    };
+    Locked<EventTarget> m_eventTarget;
+    OS::CEvent* m_eventDone;        // signaled once a call returned
+    void WaitEventCall(unsigned generation);
     unsigned m_msgCount;
+    EventSequence* m_sequence;      // the events of the subscription
 
     Locked<RCSProperty> m_property;
   };
@@ -80,7 +80,7 @@ ElementList Service::Request(const std::string& action, const ElementList& args)
   content.append("<s:Body>");
   content.append("<u:").append(action).append(" xmlns:u=\"" NS_PREFIX).append(GetName()).append(NS_SUFFIX "\">");
   for (ElementList::const_iterator it = args.begin(); it != args.end(); ++it)
-    content.append((*it)->XML());
+    (*it)->XML(content);
   content.append("</u:").append(action).append(">");
   // end body
   content.append("</s:Body>");
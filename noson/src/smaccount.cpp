@@ -85,6 +85,7 @@ SMAccountList SMAccount::CreateAccounts(const std::string& type)
 ////
 SMOAKeyring::keyring empty_keyring;
 Locked<SMOAKeyring::keyring> SMOAKeyring::g_keyring(empty_keyring);
+unsigned SMOAKeyring::g_revision = 0;
 
 void SMOAKeyring::Store(const std::string& type, const std::string& serialNum, const std::string& key, const std::string& token, const std::string& username)
 {
@@ -94,6 +95,8 @@ void SMOAKeyring::Store(const std::string& type, const std::string& serialNum, c
   {
     if (it->type == type && it->serialNum == serialNum)
     {
+      if (it->key != key || it->token != token)
+        it->revision = ++g_revision;
       it->key.assign(key);
       it->token.assign(token);
       it->username.assign(username);
@@ -101,6 +104,7 @@ void SMOAKeyring::Store(const std::string& type, const std::string& serialNum, c
     }
   }
   p->push_back(Data(type, serialNum, key, token, username));
+  p->back().revision = ++g_revision;
 }
 
 void SMOAKeyring::Purge(const std::string& type, const std::string& serialNum)
@@ -121,3 +125,15 @@ void SMOAKeyring::Reset()
 {
   g_keyring.Store(empty_keyring);
 }
+
+unsigned SMOAKeyring::Revision(const std::string& type, const std::string& serialNum)
+{
+  // hold keyring lock until return
+  Locked<SMOAKeyring::keyring>::pointer p = g_keyring.Get();
+  for (keyring::const_iterator it = p->begin(); it != p->end(); ++it)
+  {
+    if (it->type == type && it->serialNum == serialNum)
+      return it->revision;
+  }
+  return 0;
+}
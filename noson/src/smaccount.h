@@ -63,6 +63,7 @@ namespace NSROOT
       std::string key;
       std::string token;
       std::string username;
+      unsigned revision;
     };
 
     const Credentials& GetCredentials() const;
@@ -101,24 +102,33 @@ namespace NSROOT
      */
     static void Reset();
 
+    /**
+     * Return the revision of the auth for the account. It changes each time
+     * the key or the token is renewed, or the auth is purged.
+     * @return the revision, 0 if the account is not registered
+     */
+    static unsigned Revision(const std::string& type, const std::string& serialNum);
+
     struct Data
     {
-      Data() { /* empty auth */ }
+      Data() : revision(0) { /* empty auth */ }
       Data(  const std::string& _type, const std::string& _sn,
               const std::string& _key, const std::string& _token,
              const std::string& _username)
-      : type(_type), serialNum(_sn), key(_key), token(_token), username(_username) { }
+      : type(_type), serialNum(_sn), key(_key), token(_token), username(_username), revision(0) { }
       std::string type;
       std::string serialNum;
       std::string key;
       std::string token;
       std::string username;
+      unsigned revision;
     };
 
     typedef std::vector<Data> keyring;
 
   private:
     static Locked<keyring> g_keyring;
+    static unsigned g_revision;
   };
 
 }
@@ -28,12 +28,18 @@
 #include "private/builtin.h"
 #include "private/cppdef.h"
 #include "private/urlencoder.h"
+#include "private/smapicache.h"
+#include "private/diskcache.h"
+#include "private/os/threads/threadpool.h"
 #include "sonossystem.h"
 
+#include <set>
+
 #define DEVICE_PROVIDER         "Sonos"
 #define SMAPI_NAMESPACE         "http://www.sonos.com/Services/1.1"
 #define SOAP_ENVELOPE_NAMESPACE "http://schemas.xmlsoap.org/soap/envelope/"
 #define SOAP_ENCODING_NAMESPACE "http://schemas.xmlsoap.org/soap/encoding/"
+#define SMAPI_PMAP_BUCKET       "pmap"
 
 using namespace NSROOT;
 
@@ -48,6 +54,8 @@ namespace NSROOT
   }
   static XMLDict SMAPIDict = __initSMAPIDict();
 
+  static SMAPICache SMAPIMetadataCache;
+
   void __traceSMAPIError(tinyxml2::XMLDocument& doc)
   {
     DBG(DBG_ERROR, "%s: invalid or not supported response\n", __FUNCTION__);
@@ -55,6 +63,104 @@ namespace NSROOT
     doc.Accept(&out);
     DBG(DBG_ERROR, "%s\n", out.CStr());
   }
+
+  /**
+   * Download the presentation map. The request is conditional when the entry
+   * holds validators.
+   * @return 200 when the entry has been filled, 304 when not modified, else 0
+   */
+  static int __fetchPresentationMap(const std::string& location, const std::string& agent, DiskCache::Entry& entry)
+  {
+    WSRequest request(location);
+    request.SetUserAgent(agent);
+    if (!entry.etag.empty())
+      request.SetHeader("If-None-Match", entry.etag);
+    if (!entry.lastModified.empty())
+      request.SetHeader("If-Modified-Since", entry.lastModified);
+    WSResponse* response = new WSResponse(request);
+    switch (response->GetStatusCode())
+    {
+    // allow the redirection
+    case 301:
+    case 302:
+      {
+        WSRequest redir(response->Redirection());
+        if (!entry.etag.empty())
+          redir.SetHeader("If-None-Match", entry.etag);
+        if (!entry.lastModified.empty())
+          redir.SetHeader("If-Modified-Since", entry.lastModified);
+        delete response;
+        response = new WSResponse(redir);
+      }
+      break;
+    default:
+      break;
+    }
+    int status = response->GetStatusCode();
+    if (response->IsSuccessful())
+    {
+      // receive content data
+      size_t l = 0;
+      char buffer[4096];
+      entry.data.clear();
+      while ((l = response->ReadContent(buffer, sizeof(buffer))))
+        entry.data.append(buffer, l);
+      if (!response->GetHeaderValue("ETAG", entry.etag))
+        entry.etag.clear();
+      if (!response->GetHeaderValue("LAST-MODIFIED", entry.lastModified))
+        entry.lastModified.clear();
+      status = 200;
+    }
+    else if (status != 304)
+      status = 0;
+    delete response;
+    return status;
+  }
+
+  /**
+   * Revalidate the presentation map stored in the disk cache. A newer map is
+   * stored for the next initialization.
+   */
+  class RevalidateMap : public OS::CWorker
+  {
+  public:
+    RevalidateMap(const std::string& location, const std::string& agent, const DiskCache::Entry& entry)
+    : m_location(location), m_agent(agent), m_entry(entry) { }
+
+    void Process()
+    {
+      switch (__fetchPresentationMap(m_location, m_agent, m_entry))
+      {
+      case 200:
+        DBG(DBG_DEBUG, "%s: presentation map has changed (%s)\n", __FUNCTION__, m_location.c_str());
+        DiskCache::Store(SMAPI_PMAP_BUCKET, m_entry);
+        break;
+      case 304:
+        DBG(DBG_DEBUG, "%s: presentation map is up to date (%s)\n", __FUNCTION__, m_location.c_str());
+        break;
+      default:
+        DBG(DBG_WARN, "%s: revalidation failed (%s)\n", __FUNCTION__, m_location.c_str());
+        break;
+      }
+    }
+
+  private:
+    std::string m_location;
+    std::string m_agent;
+    DiskCache::Entry m_entry;
+  };
+
+  static Locked<std::set<std::string> > RevalidatedMaps((std::set<std::string>()));
+
+  static void __revalidatePresentationMap(const std::string& location, const std::string& agent, const DiskCache::Entry& entry)
+  {
+    // once per process and map
+    if (!RevalidatedMaps.Get()->insert(entry.key).second)
+      return;
+    RevalidateMap* worker = new RevalidateMap(location, agent, entry);
+    if (!SMAPIMetadataCache.Enqueue(worker))
+      delete worker;
+  }
 }
 
 SMAPI::SMAPI(const System& system)
@@ -101,47 +207,32 @@ bool SMAPI::Init(const SMServicePtr& smsvc, const std::string& locale)
   }
   else
   {
-    // load presentation map from given uri
-    URIParser uri(m_service->GetPresentationMap()->GetAttribut("Uri"));
-    WSRequest request(uri);
-    request.SetUserAgent(m_service->GetAgent());
-    WSResponse* response = new WSResponse(request);
-    switch (response->GetStatusCode())
+    // load presentation map from the disk cache, else from given uri
+    const std::string& location = m_service->GetPresentationMap()->GetAttribut("Uri");
+    DiskCache::Entry entry;
+    entry.key.assign(m_service->GetId()).append(" ").append(m_service->GetVersion()).append(" ").append(location);
+    if (DiskCache::Load(SMAPI_PMAP_BUCKET, entry.key, entry) && parsePresentationMap(entry.data))
     {
-    // allow the redirection
-    case 301:
-    case 302:
-      {
-        WSRequest redir(response->Redirection());
-        delete response;
-        response = new WSResponse(redir);
-      }
-      break;
-    default:
-      break;
+      // revalidate the cached map in background for the next use
+      if (!entry.etag.empty() || !entry.lastModified.empty())
+        __revalidatePresentationMap(location, m_service->GetAgent(), entry);
     }
-    if (response->IsSuccessful())
+    else
     {
-      // receive content data
-      size_t len = 0, l = 0;
-      std::string data;
-      char buffer[4096];
-      while ((l = response->ReadContent(buffer, sizeof(buffer))))
+      entry.etag.clear();
+      entry.lastModified.clear();
+      if (__fetchPresentationMap(location, m_service->GetAgent(), entry) == 200)
       {
-        data.append(buffer, l);
-        len += l;
+        if (!parsePresentationMap(entry.data))
+          return false;
+        DiskCache::Store(SMAPI_PMAP_BUCKET, entry);
+      }
+      else
+      {
+        DBG(DBG_ERROR, "%s: the presentation map is invalid\n", __FUNCTION__);
+        m_presentation.clear();
+        m_searchCategories.clear();
       }
-      delete response;
-      response = nullptr;
-      if (!parsePresentationMap(data))
-        return false;
-    }
-    else
-    {
-      DBG(DBG_ERROR, "%s: the presentation map is invalid\n", __FUNCTION__);
-      delete response;
-      m_presentation.clear();
-      m_searchCategories.clear();
     }
   }
 
@@ -219,8 +310,7 @@ bool SMAPI::GetMetadata(const std::string& id, int index, int count, bool recurs
   args.push_back(ElementPtr(new Element("count", std::to_string(count))));
   args.push_back(ElementPtr(new Element("recursive", recursive ? "true" : "false")));
 
-  metadata.Reset(m_service, Request("getMetadata", args).GetValue("getMetadataResult"), id);
-  return metadata.IsValid();
+  return CachedRequest("getMetadata", args, id, metadata);
 }
 
 bool SMAPI::GetMediaMetadata(const std::string& id, SMAPIMetadata& metadata)
@@ -228,8 +318,7 @@ bool SMAPI::GetMediaMetadata(const std::string& id, SMAPIMetadata& metadata)
   ElementList args;
   args.push_back(ElementPtr(new Element("id", urldecode(id)))); // id is url encoded
 
-  metadata.Reset(m_service, Request("getMediaMetadata", args).GetValue("getMediaMetadataResult"), id);
-  return metadata.IsValid();
+  return CachedRequest("getMediaMetadata", args, id, metadata);
 }
 
 bool SMAPI::Search(const std::string& searchId, const std::string& term, int index, int count, SMAPIMetadata& metadata)
@@ -247,6 +336,156 @@ bool SMAPI::Search(const std::string& searchId, const std::string& term, int ind
   return metadata.IsValid();
 }
 
+void SMAPI::SetCacheTTL(unsigned ttl, unsigned stale)
+{
+  SMAPIMetadataCache.SetTTL(ttl, stale);
+}
+
+void SMAPI::SetCacheSize(size_t bytes)
+{
+  SMAPIMetadataCache.SetMaxSize(bytes);
+}
+
+void SMAPI::ClearCache()
+{
+  SMAPIMetadataCache.Clear();
+}
+
+/**
+ * Revalidate a cached response. The worker holds a copy of the endpoint and
+ * the auth policy, so it can run after the SMAPI instance has gone. The
+ * header is built with the credentials of the account at run time, and a
+ * token refresh is handled as for the requests of the instance.
+ */
+class SMAPI::Revalidate : public OS::CWorker
+{
+public:
+  Revalidate(const SMAPI& smapi, const std::string& action, const ElementList& args, const std::string& root,
+             const std::string& partition, const std::string& key, unsigned revision)
+  : m_service(smapi.m_service)
+  , m_uri(smapi.m_service->GetSecureUri().empty() ? smapi.m_service->GetUri() : smapi.m_service->GetSecureUri())
+  , m_agent(smapi.m_service->GetAgent())
+  , m_language(smapi.m_language)
+  , m_policyAuth(smapi.m_policyAuth)
+  , m_deviceSerialNumber(smapi.m_deviceSerialNumber)
+  , m_deviceHouseholdID(smapi.m_deviceHouseholdID)
+  , m_action(action)
+  , m_args(args)
+  , m_root(root)
+  , m_partition(partition)
+  , m_key(key)
+  , m_revision(revision) { }
+
+  void Process()
+  {
+    URIParser uri(m_uri);
+    SMAccountPtr account = m_service->GetAccount();
+    unsigned revision = SMOAKeyring::Revision(account->GetType(), account->GetSerialNum());
+    ElementList vars;
+    // the partition of the entry is dropped when the credentials have changed
+    if (revision == m_revision)
+    {
+      SMAccount::Credentials auth = account->GetCredentials();
+      vars = SMAPI::DoCall(uri, m_agent, m_language,
+                           SMAPI::SoapHeader(m_policyAuth, m_deviceSerialNumber, m_deviceHouseholdID, &auth),
+                           m_action, m_args);
+      if (SMAPI::CheckAuthFault(vars, m_service) == SMAPI::Fault_TokenRefreshed)
+      {
+        // retry with the fresh token
+        auth = account->GetCredentials();
+        revision = SMOAKeyring::Revision(account->GetType(), account->GetSerialNum());
+        vars = SMAPI::DoCall(uri, m_agent, m_language,
+                             SMAPI::SoapHeader(m_policyAuth, m_deviceSerialNumber, m_deviceHouseholdID, &auth),
+                             m_action, m_args);
+      }
+    }
+    SMAPIMetadata metadata;
+    const std::string& xml = vars.GetValue(m_action + "Result");
+    if (!xml.empty())
+      metadata.Reset(m_service, xml, m_root);
+    // a response made with outdated credentials is dropped
+    if (metadata.IsValid() && SMOAKeyring::Revision(account->GetType(), account->GetSerialNum()) == revision)
+      SMAPIMetadataCache.Put(m_partition, revision, m_key, metadata, xml.size());
+    else
+    {
+      DBG(DBG_DEBUG, "%s: revalidation failed (%s)\n", __FUNCTION__, m_action.c_str());
+      SMAPIMetadataCache.Abort(m_key);
+    }
+  }
+
+private:
+  SMServicePtr m_service;
+  std::string m_uri;
+  std::string m_agent;
+  std::string m_language;
+  Auth_t m_policyAuth;
+  std::string m_deviceSerialNumber;
+  std::string m_deviceHouseholdID;
+  std::string m_action;
+  ElementList m_args;
+  std::string m_root;
+  std::string m_partition;
+  std::string m_key;
+  unsigned m_revision;
+};
+
+std::string SMAPI::CachePartition() const
+{
+  std::string partition(m_service->GetId());
+  SMAccountPtr account = m_service->GetAccount();
+  partition.append("\n").append(account->GetType()).append("\n").append(account->GetSerialNum());
+  partition.append("\n").append(m_language);
+  return partition;
+}
+
+bool SMAPI::CachedRequest(const std::string& action, const ElementList& args, const std::string& root, SMAPIMetadata& metadata)
+{
+  // the failure of the call must be reported while the token is expired
+  if (m_authTokenExpired || !m_service)
+  {
+    metadata.Reset(m_service, "", root);
+    return false;
+  }
+  SMAccountPtr account = m_service->GetAccount();
+  std::string partition = CachePartition();
+  std::string key(partition);
+  key.append("\n").append(action);
+  for (ElementList::const_iterator it = args.begin(); it != args.end(); ++it)
+    key.append("\n").append((*it)->GetKey()).append("=").append(**it);
+
+  bool refresh;
+  unsigned revision = SMOAKeyring::Revision(account->GetType(), account->GetSerialNum());
+  switch (SMAPIMetadataCache.Get(partition, revision, key, metadata, refresh))
+  {
+  case SMAPICache::Fresh:
+    return true;
+  case SMAPICache::Stale:
+    if (refresh)
+    {
+      Revalidate* worker = new Revalidate(*this, action, args, root, partition, key, revision);
+      if (!SMAPIMetadataCache.Enqueue(worker))
+      {
+        delete worker;
+        SMAPIMetadataCache.Abort(key);
+      }
+    }
+    return true;
+  default:
+    break;
+  }
+
+  ElementList vars = Request(action, args);
+  const std::string& xml = vars.GetValue(action + "Result");
+  metadata.Reset(m_service, xml, root);
+  if (metadata.IsValid())
+  {
+    // the request could have renewed the credentials
+    revision = SMOAKeyring::Revision(account->GetType(), account->GetSerialNum());
+    SMAPIMetadataCache.Put(partition, revision, key, metadata, xml.size());
+  }
+  return metadata.IsValid();
+}
+
 const std::string& SMAPI::GetUsername()
 {
   if (m_policyAuth == Auth_UserId)
@@ -565,45 +804,92 @@ bool SMAPI::parsePresentationMap(const std::string& xml)
 
 bool SMAPI::makeSoapHeader()
 {
-  m_soapHeader.assign("<credentials xmlns=\"" SMAPI_NAMESPACE "\">");
+  SMAccount::Credentials auth = m_service->GetAccount()->GetCredentials();
+  m_soapHeader = SoapHeader(m_policyAuth, m_deviceSerialNumber, m_deviceHouseholdID, (m_authTokenExpired ? nullptr : &auth));
+  return true;
+}
 
-  switch (m_policyAuth)
+std::string SMAPI::SoapHeader(Auth_t policy, const std::string& deviceSerialNumber,
+                              const std::string& householdID, const SMAccount::Credentials* auth)
+{
+  std::string header("<credentials xmlns=\"" SMAPI_NAMESPACE "\">");
+
+  switch (policy)
   {
   case Auth_Anonymous:
-    m_soapHeader.append("<deviceId>").append(m_deviceSerialNumber).append("</deviceId>");
-    m_soapHeader.append("<deviceProvider>" DEVICE_PROVIDER "</deviceProvider>");
+    header.append("<deviceId>").append(deviceSerialNumber).append("</deviceId>");
+    header.append("<deviceProvider>" DEVICE_PROVIDER "</deviceProvider>");
     break;
   case Auth_UserId:
-    m_soapHeader.append("<deviceId>").append(m_deviceSerialNumber).append("</deviceId>");
-    m_soapHeader.append("<deviceProvider>" DEVICE_PROVIDER "</deviceProvider>");
-    if (!m_authTokenExpired)
-    {
-      SMAccount::Credentials auth = m_service->GetAccount()->GetCredentials();
-      m_soapHeader.append("<sessionId>").append(auth.token).append("</sessionId>");
-    }
+    header.append("<deviceId>").append(deviceSerialNumber).append("</deviceId>");
+    header.append("<deviceProvider>" DEVICE_PROVIDER "</deviceProvider>");
+    if (auth)
+      header.append("<sessionId>").append(auth->token).append("</sessionId>");
     break;
   case Auth_AppLink:
   case Auth_DeviceLink:
-    m_soapHeader.append("<deviceId>").append(m_deviceSerialNumber).append("</deviceId>");
-    m_soapHeader.append("<deviceProvider>" DEVICE_PROVIDER "</deviceProvider>");
-    if (!m_authTokenExpired)
+    header.append("<deviceId>").append(deviceSerialNumber).append("</deviceId>");
+    header.append("<deviceProvider>" DEVICE_PROVIDER "</deviceProvider>");
+    if (auth)
     {
-      SMAccount::Credentials auth = m_service->GetAccount()->GetCredentials();
-      m_soapHeader.append("<loginToken>");
-      m_soapHeader.append("<token>").append(auth.token.empty() ? auth.devId : auth.token).append("</token>");
-      if (!auth.key.empty())
-        m_soapHeader.append("<key>").append(auth.key).append("</key>");
-      m_soapHeader.append("<householdId>").append(m_deviceHouseholdID).append("</householdId>");
-      m_soapHeader.append("</loginToken>");
+      header.append("<loginToken>");
+      header.append("<token>").append(auth->token.empty() ? auth->devId : auth->token).append("</token>");
+      if (!auth->key.empty())
+        header.append("<key>").append(auth->key).append("</key>");
+      header.append("<householdId>").append(householdID).append("</householdId>");
+      header.append("</loginToken>");
     }
     break;
   }
 
-  m_soapHeader.append("</credentials>");
-  return true;
+  header.append("</credentials>");
+  return header;
+}
+
+SMAPI::AuthFault_t SMAPI::CheckAuthFault(const ElementList& vars, const SMServicePtr& service)
+{
+  if (vars.GetValue("TAG") != "Fault")
+    return Fault_None;
+  const std::string& str = vars.GetValue("faultcode");
+  if (XMLNS::NameEqual(str.c_str(), "Client.TokenRefreshRequired"))
+  {
+    /*
+     <s:Fault>
+     <faultcode>s:Client.TokenRefreshRequired</faultcode>
+     <faultstring>TokenRefreshRequired</faultstring>
+     <detail>
+     <ns:refreshAuthTokenResult>
+     <ns:authToken>NEW_TOKEN</ns:authToken>
+     <ns:privateKey>REFRESH_TOKEN</ns:privateKey>
+     </ns:refreshAuthTokenResult>
+     </detail>
+     </s:Fault>
+    */
+    SMAccount::Credentials cr = service->GetAccount()->GetCredentials();
+    cr.token = vars.GetValue("authToken");
+    cr.key = vars.GetValue("privateKey");
+    service->GetAccount()->SetCredentials(cr);
+    return Fault_TokenRefreshed;
+  }
+  if (XMLNS::NameEqual(str.c_str(), "Client.AuthTokenExpired") ||
+          XMLNS::NameEqual(str.c_str(), "Client.LoginDisabled") ||
+          XMLNS::NameEqual(str.c_str(), "Client.LoginInvalid") ||
+          XMLNS::NameEqual(str.c_str(), "Client.LoginUnauthorized") ||
+          XMLNS::NameEqual(str.c_str(), "Client.SessionIdInvalid"))
+    return Fault_TokenExpired;
+  return Fault_None;
 }
 
 ElementList SMAPI::DoCall(const std::string& action, const ElementList& args)
+{
+  ElementList vars = DoCall(*m_uri, m_service->GetAgent(), m_language, m_soapHeader, action, args);
+  if (vars.empty() || vars.GetValue("TAG") == "Fault")
+    SetFault(vars);
+  return vars;
+}
+
+ElementList SMAPI::DoCall(const URIParser& uri, const std::string& agent, const std::string& language,
+                          const std::string& soapHeader, const std::string& action, const ElementList& args)
 {
   ElementList vars;
 
@@ -615,22 +901,22 @@ ElementList SMAPI::DoCall(const std::string& action, const ElementList& args)
   // start envelope
   content.append("<s:Envelope xmlns:s=\"" SOAP_ENVELOPE_NAMESPACE "\" s:encodingStyle=\"" SOAP_ENCODING_NAMESPACE "\">");
   // fill the header
-  content.append("<s:Header>").append(m_soapHeader).append("</s:Header>");
+  content.append("<s:Header>").append(soapHeader).append("</s:Header>");
   // start body
   content.append("<s:Body>");
   content.append("<ns:").append(action).append(" xmlns:ns=\"" SMAPI_NAMESPACE "\">");
   for (ElementList::const_iterator it = args.begin(); it != args.end(); ++it)
-    content.append((*it)->XML("ns"));
+    (*it)->XML("ns", content);
   content.append("</ns:").append(action).append(">");
   // end body
   content.append("</s:Body>");
   // end envelope
   content.append("</s:Envelope>");
 
-  WSRequest request(*m_uri, HRM_POST);
-  request.SetUserAgent(m_service->GetAgent());
+  WSRequest request(uri, HRM_POST);
+  request.SetUserAgent(agent);
   request.SetHeader("X-Sonos-SWGen", "1");
-  request.SetHeader("Accept-Language", m_language);
+  request.SetHeader("Accept-Language", language);
   request.SetHeader("SOAPAction", soapaction);
   request.SetContentCustom(CT_XML, content.c_str());
   WSResponse response(request);
@@ -653,7 +939,6 @@ ElementList SMAPI::DoCall(const std::string& action, const ElementList& args)
   if (rootdoc.Parse(data.c_str(), len) != tinyxml2::XML_SUCCESS)
   {
     DBG(DBG_ERROR, "%s: parse xml failed\n", __FUNCTION__);
-    SetFault(vars);
     return vars;
   }
   const tinyxml2::XMLElement* elem; // an element
@@ -662,7 +947,6 @@ ElementList SMAPI::DoCall(const std::string& action, const ElementList& args)
   if (!(elem = rootdoc.RootElement()) || !XMLNS::NameEqual(elem->Name(), "Envelope"))
   {
     __traceSMAPIError(rootdoc);
-    SetFault(vars);
     return vars;
   }
   // learn declared namespaces in the element Envelope for translations
@@ -677,7 +961,6 @@ ElementList SMAPI::DoCall(const std::string& action, const ElementList& args)
   if (!elem || !(elem = elem->FirstChildElement()))
   {
     __traceSMAPIError(rootdoc);
-    SetFault(vars);
     return vars;
   }
   vars.push_back(ElementPtr(new Element("TAG", XMLNS::LocalName(elem->Name()))));
@@ -709,7 +992,6 @@ ElementList SMAPI::DoCall(const std::string& action, const ElementList& args)
       }
       felem = felem->NextSiblingElement(NULL);
     }
-    SetFault(vars);
   }
   else
   {
@@ -755,44 +1037,23 @@ ElementList SMAPI::Request(const std::string& action, const ElementList& args)
 
   vars = DoCall(action, args);
 
-  // Rebuild the soap header using fresh token which is filled in fault
-  if (vars.GetValue("TAG") == "Fault")
+  switch (CheckAuthFault(vars, m_service))
   {
-    const std::string& str = vars.GetValue("faultcode");
-    if (XMLNS::NameEqual(str.c_str(), "Client.TokenRefreshRequired"))
-    {
-      /*
-       <s:Fault>
-       <faultcode>s:Client.TokenRefreshRequired</faultcode>
-       <faultstring>TokenRefreshRequired</faultstring>
-       <detail>
-       <ns:refreshAuthTokenResult>
-       <ns:authToken>NEW_TOKEN</ns:authToken>
-       <ns:privateKey>REFRESH_TOKEN</ns:privateKey>
-       </ns:refreshAuthTokenResult>
-       </detail>
-       </s:Fault>
-      */
-      SMAccount::Credentials cr = m_service->GetAccount()->GetCredentials();
-      cr.token = vars.GetValue("authToken");
-      cr.key = vars.GetValue("privateKey");
-      m_service->GetAccount()->SetCredentials(cr);
-      makeSoapHeader();
-      // Retry the request
-      vars = DoCall(action, args);
-    }
-    else if (!m_authTokenExpired)
+  case Fault_TokenRefreshed:
+    // rebuild the soap header using the fresh token filled in the fault,
+    // then retry the request
+    makeSoapHeader();
+    vars = DoCall(action, args);
+    break;
+  case Fault_TokenExpired:
+    if (!m_authTokenExpired)
     {
-      if (XMLNS::NameEqual(str.c_str(), "Client.AuthTokenExpired") ||
-              XMLNS::NameEqual(str.c_str(), "Client.LoginDisabled") ||
-              XMLNS::NameEqual(str.c_str(), "Client.LoginInvalid") ||
-              XMLNS::NameEqual(str.c_str(), "Client.LoginUnauthorized") ||
-              XMLNS::NameEqual(str.c_str(), "Client.SessionIdInvalid"))
-      {
-        m_authTokenExpired = true;
-        makeSoapHeader(); // refresh hearder
-      }
+      m_authTokenExpired = true;
+      makeSoapHeader(); // refresh hearder
     }
+    break;
+  default:
+    break;
   }
   return vars;
 }
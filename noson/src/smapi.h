@@ -127,6 +127,23 @@ namespace NSROOT
      */
     const std::string& GetFaultString() const;
 
+    /**
+     * Configure the cache of metadata shared by all instances. A cached
+     * response is served during the TTL, then it is served stale while it is
+     * revalidated in background.
+     * @param ttl The seconds a response is fresh
+     * @param stale The seconds an expired response can still be served
+     */
+    static void SetCacheTTL(unsigned ttl, unsigned stale);
+
+    /**
+     * Bound the memory of the cache of metadata.
+     * @param bytes The maximum size of the cached responses, 0 disables the cache
+     */
+    static void SetCacheSize(size_t bytes);
+
+    static void ClearCache();
+
   private:
     OS::CMutex* m_mutex;
     std::string m_language;
@@ -152,8 +169,31 @@ namespace NSROOT
 
     bool makeSoapHeader();
 
+    // build the credentials header, without the token when auth is null
+    static std::string SoapHeader(Auth_t policy, const std::string& deviceSerialNumber,
+                                  const std::string& householdID, const SMAccount::Credentials* auth);
+
+    typedef enum
+    {
+      Fault_None,
+      Fault_TokenRefreshed,
+      Fault_TokenExpired,
+    } AuthFault_t;
+
+    // check the response for an auth fault, and store the refreshed token
+    static AuthFault_t CheckAuthFault(const ElementList& vars, const SMServicePtr& service);
+
     ElementList DoCall(const std::string& action, const ElementList& args);
 
+    static ElementList DoCall(const URIParser& uri, const std::string& agent, const std::string& language,
+                              const std::string& soapHeader, const std::string& action, const ElementList& args);
+
+    class Revalidate;
+
+    bool CachedRequest(const std::string& action, const ElementList& args, const std::string& root, SMAPIMetadata& metadata);
+
+    std::string CachePartition() const;
+
     ElementList m_fault;
 
     void SetFault(const ElementList& vars);
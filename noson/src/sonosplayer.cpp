@@ -30,10 +30,14 @@
 #include "private/tokenizer.h"
 #include "private/urlencoder.h"
 #include "private/socket.h"
+#include "private/coalescer.h"
+#include "private/groupbalance.h"
+#include "private/os/threads/thread.h"
 #include "didlparser.h"
 #include "sonossystem.h"
 #include "filestreamer.h"
 #include "imageservice.h"
+#include "lpcmencoder.h"
 #ifdef HAVE_PULSEAUDIO
 #include "pulsestreamer.h"
 #endif
@@ -42,6 +46,176 @@
 
 using namespace NSROOT;
 
+namespace NSROOT
+{
+  /**
+   * Construct a subscribed service in a thread, so that the services of a
+   * player are set up at once.
+   */
+  template <class T>
+  class ServiceLauncher : private OS::CThread
+  {
+  public:
+    ServiceLauncher(const std::string& host, unsigned port, SubscriptionPoolPtr& pool, void* CBHandle, EventCB eventCB)
+    : m_host(host), m_port(port), m_pool(pool), m_CBHandle(CBHandle), m_eventCB(eventCB), m_service(nullptr) { }
+
+    void Launch()
+    {
+      if (!StartThread())
+        Process();
+    }
+
+    T* Join()
+    {
+      StopThread(true);
+      return m_service;
+    }
+
+  private:
+    std::string m_host;
+    unsigned m_port;
+    SubscriptionPoolPtr m_pool;
+    void* m_CBHandle;
+    EventCB m_eventCB;
+    T* m_service;
+
+    void* Process() override
+    {
+      m_service = new T(m_host, m_port, m_pool, m_CBHandle, m_eventCB);
+      return nullptr;
+    }
+  };
+
+  /**
+   * Run a request on the rendering control of a group member. The requests
+   * to the members are run together on the pool of the coalescer, so a group
+   * change is applied by all speakers at once.
+   */
+  class RenderingRequest : public Coalescer::Command
+  {
+  public:
+    typedef enum
+    {
+      GetVolume,
+      SetVolume,
+      SetMute,
+      SetBass,
+      SetTreble,
+      SetLoudness,
+    } Action_t;
+
+    RenderingRequest(const RenderingControlPtr& rc, Action_t action)
+    : m_rc(rc), m_action(action), m_volume(0) { }
+
+    int Volume() const { return m_volume; }
+
+    bool Execute(int value) override
+    {
+      switch (m_action)
+      {
+      case GetVolume:
+      {
+        uint8_t v = 0;
+        bool ret = m_rc->GetVolume(&v);
+        m_volume = v;
+        return ret;
+      }
+      case SetVolume:
+        return m_rc->SetVolume((uint8_t)value);
+      case SetMute:
+        return m_rc->SetMute((uint8_t)value);
+      case SetBass:
+        return m_rc->SetBass((int8_t)value);
+      case SetTreble:
+        return m_rc->SetTreble((int8_t)value);
+      case SetLoudness:
+        return m_rc->SetLoudness((uint8_t)value);
+      }
+      return false;
+    }
+
+  private:
+    RenderingControlPtr m_rc;
+    Action_t m_action;
+    int m_volume;
+  };
+
+  class VolumeCommand : public Coalescer::Command
+  {
+  public:
+    VolumeCommand(const RenderingControlPtr& rc) : m_rc(rc) { }
+    bool Execute(int value) override { return m_rc->SetVolume((uint8_t)value); }
+    const RenderingControl* Target() const { return m_rc.get(); }
+  private:
+    RenderingControlPtr m_rc;
+  };
+
+  class SeekTimeCommand : public Coalescer::Command
+  {
+  public:
+    SeekTimeCommand(AVTransport* avt) : m_avt(avt) { }
+    bool Execute(int value) override { return m_avt->SeekTime((uint16_t)value); }
+  private:
+    AVTransport* m_avt;
+  };
+
+  /**
+   * Submit the volume of a member. The command of the key is reused while it
+   * targets the same service.
+   */
+  static bool __submitVolume(Coalescer& coalescer, const std::string& uuid, const RenderingControlPtr& rc, int value)
+  {
+    std::string key("volume:");
+    key.append(uuid);
+    Coalescer::CommandPtr command = coalescer.LastCommand(key);
+    if (!command || static_cast<VolumeCommand*>(command.get())->Target() != rc.get())
+      command.reset(new VolumeCommand(rc));
+    return coalescer.Submit(key, command, value);
+  }
+
+  /**
+   * Request the same change on all members of the group.
+   */
+  static bool __setGroupValue(Coalescer& coalescer, const std::vector<RenderingControlPtr>& table, RenderingRequest::Action_t action, int value)
+  {
+    Coalescer::Batch batch;
+    batch.reserve(table.size());
+    for (std::vector<RenderingControlPtr>::const_iterator it = table.begin(); it != table.end(); ++it)
+      batch.push_back(std::make_pair(Coalescer::CommandPtr(new RenderingRequest(*it, action)), value));
+    return coalescer.RunAll(batch);
+  }
+
+  /**
+   * Fetch the volume of all members, from the last event when available.
+   */
+  static bool __getGroupVolumes(Coalescer& coalescer, const std::vector<RenderingControlPtr>& table, std::vector<int>& volumes)
+  {
+    Coalescer::Batch batch;
+    std::vector<RenderingRequest*> requests;  // owned by the batch
+    std::vector<size_t> missing;
+    volumes.assign(table.size(), 0);
+    for (size_t i = 0; i < table.size(); ++i)
+    {
+      const RenderingControlPtr& rc = table[i];
+      RCSProperty prop;
+      if (rc->GetCachedProperty(prop))
+        volumes[i] = prop.VolumeMaster;
+      else
+      {
+        requests.push_back(new RenderingRequest(rc, RenderingRequest::GetVolume));
+        batch.push_back(std::make_pair(Coalescer::CommandPtr(requests.back()), 0));
+        missing.push_back(i);
+      }
+    }
+    if (batch.empty())
+      return !table.empty();
+    bool ret = coalescer.RunAll(batch);
+    for (size_t i = 0; i < missing.size(); ++i)
+      volumes[missing[i]] = requests[i]->Volume();
+    return ret;
+  }
+}
+
 Player::Player(const ZonePtr& zone, System* system, void* CBHandle, EventCB eventCB)
 : m_valid(false)
 , m_zone(zone)
@@ -56,14 +230,20 @@ Player::Player(const ZonePtr& zone, System* system, void* CBHandle, EventCB even
 , m_deviceProperties(nullptr)
 , m_AVTransport(nullptr)
 , m_contentDirectory(nullptr)
+, m_coalescer(new Coalescer())
+, m_cacheFirst(false)
+, m_cacheHits(0)
+, m_cacheMisses(0)
 , m_subscriptionPool()
+, m_RCTable(RCTable())
+, m_groupBalance(new GroupBalance())
 {
   m_valid = Init(system);
 }
 
 Player::Player(const ZonePlayerPtr& zonePlayer)
 : m_valid(false)
-, m_zone()
+, m_zone(ZonePtr())
 , m_eventHandler()
 , m_uuid()
 , m_deviceHost()
@@ -75,7 +255,13 @@ Player::Player(const ZonePlayerPtr& zonePlayer)
 , m_deviceProperties(nullptr)
 , m_AVTransport(nullptr)
 , m_contentDirectory(nullptr)
+, m_coalescer(new Coalescer())
+, m_cacheFirst(false)
+, m_cacheHits(0)
+, m_cacheMisses(0)
 , m_subscriptionPool()
+, m_RCTable(RCTable())
+, m_groupBalance(new GroupBalance())
 {
   if (zonePlayer && zonePlayer->IsValid())
   {
@@ -87,10 +273,9 @@ Player::Player(const ZonePlayerPtr& zonePlayer)
     SubordinateRC rc;
     rc.uuid = m_uuid;
     rc.name = zonePlayer->data();
-    rc.renderingControl = new RenderingControl(m_deviceHost, m_devicePort);
-    m_RCTable.push_back(rc);
+    rc.renderingControl.reset(new RenderingControl(m_deviceHost, m_devicePort));
+    m_RCTable.Get()->push_back(rc);
 
-    m_deviceProperties = new DeviceProperties(m_deviceHost, m_devicePort);
     m_AVTransport = new AVTransport(m_deviceHost, m_devicePort);
     m_contentDirectory= new ContentDirectory(m_deviceHost, m_devicePort);
 
@@ -102,11 +287,13 @@ Player::Player(const ZonePlayerPtr& zonePlayer)
 
 Player::~Player()
 {
+  // wait for the requests in flight
+  SAFE_DELETE(m_coalescer);
+  SAFE_DELETE(m_groupBalance);
   SAFE_DELETE(m_contentDirectory);
   SAFE_DELETE(m_AVTransport);
-  SAFE_DELETE(m_deviceProperties);
-  for (RCTable::iterator it = m_RCTable.begin(); it != m_RCTable.end(); ++it)
-    SAFE_DELETE(it->renderingControl);
+  DeviceProperties* deviceProperties = m_deviceProperties.Load();
+  SAFE_DELETE(deviceProperties);
 }
 
 void Player::SubordinateRC::FillSRProperty(SRProperty& srp) const
@@ -120,15 +307,16 @@ void Player::SubordinateRC::FillSRProperty(SRProperty& srp) const
 bool Player::Init(System* system)
 {
   assert(system);
-  if (!m_zone)
+  ZonePtr zone = m_zone.Load();
+  if (!zone)
   {
     DBG(DBG_ERROR, "%s: invalid zone\n", __FUNCTION__);
     return false;
   }
-  ZonePlayerPtr cinfo = m_zone->GetCoordinator();
+  ZonePlayerPtr cinfo = zone->GetCoordinator();
   if (!cinfo || !cinfo->IsValid())
   {
-    DBG(DBG_ERROR, "%s: invalid coordinator for zone '%s' (%s)\n", __FUNCTION__, m_zone->GetZoneName().c_str(), cinfo->GetLocation().c_str());
+    DBG(DBG_ERROR, "%s: invalid coordinator for zone '%s' (%s)\n", __FUNCTION__, zone->GetZoneName().c_str(), cinfo->GetLocation().c_str());
     return false;
   }
   DBG(DBG_DEBUG, "%s: initialize player '%s' as coordinator (%s:%u)\n", __FUNCTION__, cinfo->c_str(), cinfo->GetHost().c_str(), cinfo->GetPort());
@@ -142,34 +330,141 @@ bool Player::Init(System* system)
     .append(":").append(std::to_string(m_eventHandler.GetPort()));
   m_subscriptionPool = system->m_subscriptionPool;
 
-  TcpSocket sock;
-  sock.Connect(m_deviceHost.c_str(), m_devicePort, 0);
   m_controllerName = TcpSocket::GetMyHostName();
-  m_controllerHost = sock.GetHostAddrInfo();
-  sock.Disconnect();
+  m_controllerHost = TcpSocket::GetMyHostAddrInfoTo(m_deviceHost, m_devicePort);
   m_controllerUri.assign(ProtocolTable[Protocol_http])
       .append("://").append(m_controllerHost)
       .append(":").append(std::to_string(m_eventHandler.GetPort()));
 
-  // initialize subordinates
-  for (Zone::const_iterator it = m_zone->begin(); it != m_zone->end(); ++it)
+  // set up the services and their subscriptions at once
+  ServiceLauncher<AVTransport> avt(m_deviceHost, m_devicePort, m_subscriptionPool, this, CB_AVTransport);
+  avt.Launch();
+  ServiceLauncher<ContentDirectory> cd(m_deviceHost, m_devicePort, m_subscriptionPool, this, CB_ContentDirectory);
+  cd.Launch();
+  AssignRenderingControls(zone, system->m_renderingControls);
+  m_AVTransport = avt.Join();
+  m_contentDirectory = cd.Join();
+  // the device properties are requested on demand
+
+  return true;
+}
+
+void Player::AssignRenderingControls(const ZonePtr& zone, Locked<RCPool>& pool)
+{
+  RCTable current = m_RCTable.Load();
+  RCTable table;
+  std::vector<std::pair<size_t, ServiceLauncher<RenderingControl>*> > rcs;
+  std::vector<RenderingControlPtr> reused;
+  for (Zone::const_iterator it = zone->begin(); it != zone->end(); ++it)
   {
-    if ((*it)->IsValid())
+    if (!(*it)->IsValid())
     {
-      SubordinateRC rc;
-      rc.uuid = (*it)->GetUUID();
-      rc.name = (*it)->data();
-      rc.renderingControl = new RenderingControl((*it)->GetHost(), (*it)->GetPort(), m_subscriptionPool, this, CB_RenderingControl);
-      m_RCTable.push_back(rc);
-    }
-    else
       DBG(DBG_ERROR, "%s: invalid location for player '%s'\n", __FUNCTION__, (*it)->c_str());
+      continue;
+    }
+    SubordinateRC rc;
+    rc.uuid = (*it)->GetUUID();
+    rc.name = (*it)->data();
+    // keep the service of a member staying in the group
+    for (RCTable::iterator itc = current.begin(); itc != current.end(); ++itc)
+    {
+      if (itc->uuid == rc.uuid)
+      {
+        rc.renderingControl = itc->renderingControl;
+        current.erase(itc);
+        break;
+      }
+    }
+    // else take the service released by another player
+    if (!rc.renderingControl)
+    {
+      // BEGIN CRITICAL SECTION
+      Locked<RCPool>::pointer _pool = pool.Get();
+      RCPool::iterator itp = _pool->find(rc.uuid);
+      if (itp != _pool->end())
+      {
+        DBG(DBG_DEBUG, "%s: reuse rendering control of '%s'\n", __FUNCTION__, rc.name.c_str());
+        rc.renderingControl = itp->second;
+        reused.push_back(rc.renderingControl);
+        _pool->erase(itp);
+      }
+      // END CRITICAL SECTION
+    }
+    if (!rc.renderingControl)
+    {
+      rcs.push_back(std::make_pair(table.size(), new ServiceLauncher<RenderingControl>((*it)->GetHost(), (*it)->GetPort(), m_subscriptionPool, this, CB_RenderingControl)));
+      rcs.back().second->Launch();
+    }
+    table.push_back(rc);
+  }
+  for (size_t i = 0; i < reused.size(); ++i)
+    reused[i]->SetEventCB(this, CB_RenderingControl);
+  for (size_t i = 0; i < rcs.size(); ++i)
+  {
+    table[rcs[i].first].renderingControl.reset(rcs[i].second->Join());
+    delete rcs[i].second;
   }
+  m_RCTable.Store(table);
+  // release the services of the members gone
+  for (RCTable::iterator itc = current.begin(); itc != current.end(); ++itc)
+    ReleaseRenderingControl(*itc, pool);
+}
 
-  m_deviceProperties = new DeviceProperties(m_deviceHost, m_devicePort);
-  m_AVTransport = new AVTransport(m_deviceHost, m_devicePort, m_subscriptionPool, this, CB_AVTransport);
-  m_contentDirectory = new ContentDirectory(m_deviceHost, m_devicePort, m_subscriptionPool, this, CB_ContentDirectory);
+void Player::ReleaseRenderingControls(const ZonePtr& zone, Locked<RCPool>& pool)
+{
+  RCTable released;
+  {
+    // BEGIN CRITICAL SECTION
+    Locked<RCTable>::pointer table = m_RCTable.Get();
+    RCTable::iterator it = table->begin();
+    while (it != table->end())
+    {
+      bool stay = false;
+      if (zone)
+      {
+        for (Zone::const_iterator itz = zone->begin(); !stay && itz != zone->end(); ++itz)
+          stay = ((*itz)->GetUUID() == it->uuid);
+      }
+      if (stay)
+        ++it;
+      else
+      {
+        released.push_back(*it);
+        it = table->erase(it);
+      }
+    }
+    // END CRITICAL SECTION
+  }
+  for (RCTable::iterator it = released.begin(); it != released.end(); ++it)
+    ReleaseRenderingControl(*it, pool);
+}
 
+void Player::ReleaseRenderingControl(const SubordinateRC& rc, Locked<RCPool>& pool)
+{
+  // detaching waits for a call in flight, so it is done out of the locks
+  rc.renderingControl->RevokeEventCB(this);
+  m_coalescer->ForgetCommand(std::string("volume:").append(rc.uuid));
+  RenderingControlPtr replaced;
+  {
+    // BEGIN CRITICAL SECTION
+    Locked<RCPool>::pointer _pool = pool.Get();
+    RenderingControlPtr& entry = (*_pool)[rc.uuid];
+    replaced = entry;
+    entry = rc.renderingControl;
+    // END CRITICAL SECTION
+  }
+  // a replaced service is destroyed out of the lock
+}
+
+bool Player::Retarget(const ZonePtr& zone, Locked<RCPool>& pool)
+{
+  ZonePlayerPtr cinfo = zone->GetCoordinator();
+  if (!m_valid || !cinfo || cinfo->GetUUID() != m_uuid)
+    return false;
+  DBG(DBG_DEBUG, "%s: retarget player '%s' to zone '%s'\n", __FUNCTION__, cinfo->c_str(), zone->GetZoneName().c_str());
+  AssignRenderingControls(zone, pool);
+  m_zone.Store(zone);
+  CB_RenderingControl(this);
   return true;
 }
 
@@ -230,7 +525,8 @@ unsigned char Player::LastEvents()
 
 bool Player::RenderingPropertyEmpty()
 {
-  for (RCTable::const_iterator it = m_RCTable.begin(); it != m_RCTable.end(); ++it)
+  RCTable table = m_RCTable.Load();
+  for (RCTable::const_iterator it = table.begin(); it != table.end(); ++it)
   {
     if (it->renderingControl->Empty())
       return true;
@@ -241,10 +537,15 @@ bool Player::RenderingPropertyEmpty()
 SRPList Player::GetRenderingProperty()
 {
   SRPList list;
-  for (RCTable::const_iterator it = m_RCTable.begin(); it != m_RCTable.end(); ++it)
+  RCTable table = m_RCTable.Load();
+  for (RCTable::const_iterator it = table.begin(); it != table.end(); ++it)
   {
     list.push_back(SRProperty());
     it->FillSRProperty(list.back());
+    // report the volume expected once the coalesced requests are done
+    uint8_t v;
+    if (GetPendingVolume(it->uuid, &v))
+      list.back().property.VolumeMaster = v;
   }
   return list;
 }
@@ -259,23 +560,42 @@ AVTProperty Player::GetTransportProperty()
   return *(m_AVTransport->GetAVTProperty().Get());
 }
 
+DeviceProperties* Player::GetDeviceProperties()
+{
+  Locked<DeviceProperties*>::pointer deviceProperties = m_deviceProperties.Get();
+  if (!*deviceProperties)
+    *deviceProperties = new DeviceProperties(m_deviceHost, m_devicePort);
+  return *deviceProperties;
+}
+
 bool Player::GetZoneInfo(ElementList& vars)
 {
-  return m_deviceProperties->GetZoneInfo(vars);
+  return GetDeviceProperties()->GetZoneInfo(vars);
 }
 
 bool Player::GetZoneAttributes(ElementList& vars)
 {
-  return m_deviceProperties->GetZoneAttributes(vars);
+  return GetDeviceProperties()->GetZoneAttributes(vars);
 }
 
 bool Player::GetHouseholdID(ElementList& vars)
 {
-  return m_deviceProperties->GetHouseholdID(vars);
+  return GetDeviceProperties()->GetHouseholdID(vars);
 }
 
 bool Player::GetTransportInfo(ElementList& vars)
 {
+  AVTProperty prop;
+  // the speed is evented with the whole state, else the device is requested
+  if (CachedTransportProperty(prop) && !prop.TransportPlaySpeed.empty())
+  {
+    vars.clear();
+    vars.push_back(ElementPtr(new Element("TAG", "GetTransportInfoResponse")));
+    vars.push_back(ElementPtr(new Element("CurrentTransportState", prop.TransportState)));
+    vars.push_back(ElementPtr(new Element("CurrentTransportStatus", prop.TransportStatus)));
+    vars.push_back(ElementPtr(new Element("CurrentSpeed", prop.TransportPlaySpeed)));
+    return true;
+  }
   return m_AVTransport->GetTransportInfo(vars);
 }
 
@@ -298,17 +618,27 @@ bool Player::GetRemainingSleepTimerDuration(ElementList& vars)
 
 bool Player::GetVolume(const std::string& uuid, uint8_t* value)
 {
-  for (RCTable::const_iterator it = m_RCTable.begin(); it != m_RCTable.end(); ++it)
+  RCTable table = m_RCTable.Load();
+  for (RCTable::const_iterator it = table.begin(); it != table.end(); ++it)
   {
     if (it->uuid == uuid)
+    {
+      RCSProperty prop;
+      if (CachedRenderingProperty(it->renderingControl, prop))
+      {
+        *value = (uint8_t)prop.VolumeMaster;
+        return true;
+      }
       return it->renderingControl->GetVolume(value);
+    }
   }
   return false;
 }
 
 bool Player::SetVolume(const std::string& uuid, uint8_t value)
 {
-  for (RCTable::const_iterator it = m_RCTable.begin(); it != m_RCTable.end(); ++it)
+  RCTable table = m_RCTable.Load();
+  for (RCTable::const_iterator it = table.begin(); it != table.end(); ++it)
   {
     if (it->uuid == uuid)
       return it->renderingControl->SetVolume(value);
@@ -316,9 +646,217 @@ bool Player::SetVolume(const std::string& uuid, uint8_t value)
   return false;
 }
 
+void Player::GetCacheStats(unsigned* hits, unsigned* misses) const
+{
+  *hits = m_cacheHits.load();
+  *misses = m_cacheMisses.load();
+}
+
+bool Player::CachedRenderingProperty(const RenderingControlPtr& rc, RCSProperty& prop)
+{
+  if (!m_cacheFirst)
+    return false;
+  if (rc->GetCachedProperty(prop))
+  {
+    ++m_cacheHits;
+    return true;
+  }
+  ++m_cacheMisses;
+  return false;
+}
+
+bool Player::CachedTransportProperty(AVTProperty& prop)
+{
+  if (!m_cacheFirst || !m_AVTransport)
+    return false;
+  if (m_AVTransport->GetCachedProperty(prop))
+  {
+    ++m_cacheHits;
+    return true;
+  }
+  ++m_cacheMisses;
+  return false;
+}
+
+std::vector<RenderingControlPtr> Player::GetRenderingControls()
+{
+  return GetRenderingControls(m_RCTable.Load());
+}
+
+std::vector<RenderingControlPtr> Player::GetRenderingControls(const RCTable& table)
+{
+  std::vector<RenderingControlPtr> rcs;
+  rcs.reserve(table.size());
+  for (RCTable::const_iterator it = table.begin(); it != table.end(); ++it)
+    rcs.push_back(it->renderingControl);
+  return rcs;
+}
+
+bool Player::GetGroupVolume(uint8_t* value)
+{
+  std::vector<RenderingControlPtr> table = GetRenderingControls();
+  std::vector<int> volumes;
+  if (!__getGroupVolumes(*m_coalescer, table, volumes))
+    return false;
+  int sum = 0;
+  for (std::vector<int>::const_iterator it = volumes.begin(); it != volumes.end(); ++it)
+    sum += *it;
+  *value = (uint8_t)((sum + (int)volumes.size() / 2) / (int)volumes.size());
+  return true;
+}
+
+void Player::SaveGroupBalance(const RCTable& table, const std::vector<int>& volumes)
+{
+  std::vector<std::string> members;
+  for (RCTable::const_iterator it = table.begin(); it != table.end(); ++it)
+    members.push_back(it->uuid);
+  m_groupBalance->Save(members, volumes);
+}
+
+int Player::LoadGroupBalance(const RCTable& table, std::vector<int>& volumes)
+{
+  std::vector<std::string> members;
+  for (RCTable::const_iterator it = table.begin(); it != table.end(); ++it)
+    members.push_back(it->uuid);
+  return m_groupBalance->Load(members, volumes);
+}
+
+bool Player::SetGroupVolume(uint8_t value)
+{
+  RCTable members = m_RCTable.Load();
+  std::vector<RenderingControlPtr> table = GetRenderingControls(members);
+  std::vector<int> volumes;
+  if (!__getGroupVolumes(*m_coalescer, table, volumes))
+    return false;
+  int sum = 0;
+  for (std::vector<int>::const_iterator it = volumes.begin(); it != volumes.end(); ++it)
+    sum += *it;
+  int target = (value > 100 ? 100 : value);
+  // the balance is kept when the group is silenced, to be restored from it
+  if (sum == 0)
+    sum = LoadGroupBalance(members, volumes);
+  else if (target == 0)
+    SaveGroupBalance(members, volumes);
+  Coalescer::Batch batch;
+  batch.reserve(table.size());
+  for (size_t i = 0; i < table.size(); ++i)
+  {
+    int v = GroupBalance::ScaleVolume(volumes[i], sum, volumes.size(), target);
+    batch.push_back(std::make_pair(Coalescer::CommandPtr(new RenderingRequest(table[i], RenderingRequest::SetVolume)), v));
+  }
+  return m_coalescer->RunAll(batch);
+}
+
+bool Player::SetRelativeGroupVolume(int delta, uint8_t* value)
+{
+  RCTable members = m_RCTable.Load();
+  std::vector<RenderingControlPtr> table = GetRenderingControls(members);
+  std::vector<int> volumes;
+  if (!__getGroupVolumes(*m_coalescer, table, volumes))
+    return false;
+  int before = 0;
+  for (std::vector<int>::const_iterator it = volumes.begin(); it != volumes.end(); ++it)
+    before += *it;
+  // from silence, the balance kept is restored at the level of the delta
+  int balance = (before == 0 && delta > 0 ? LoadGroupBalance(members, volumes) : 0);
+  int sum = 0;
+  Coalescer::Batch batch;
+  batch.reserve(table.size());
+  for (size_t i = 0; i < table.size(); ++i)
+  {
+    int v = (balance > 0 ? GroupBalance::ScaleVolume(volumes[i], balance, volumes.size(), delta) : volumes[i] + delta);
+    v = (v < 0 ? 0 : v > 100 ? 100 : v);
+    sum += v;
+    batch.push_back(std::make_pair(Coalescer::CommandPtr(new RenderingRequest(table[i], RenderingRequest::SetVolume)), v));
+  }
+  if (sum == 0 && before > 0)
+    SaveGroupBalance(members, volumes);
+  bool ret = m_coalescer->RunAll(batch);
+  if (ret && value)
+    *value = (uint8_t)((sum + (int)batch.size() / 2) / (int)batch.size());
+  return ret;
+}
+
+bool Player::SetGroupMute(uint8_t value)
+{
+  return __setGroupValue(*m_coalescer, GetRenderingControls(), RenderingRequest::SetMute, value);
+}
+
+bool Player::SetGroupLoudness(uint8_t value)
+{
+  return __setGroupValue(*m_coalescer, GetRenderingControls(), RenderingRequest::SetLoudness, value);
+}
+
+bool Player::SetGroupBass(int8_t value)
+{
+  return __setGroupValue(*m_coalescer, GetRenderingControls(), RenderingRequest::SetBass, value);
+}
+
+bool Player::SetGroupTreble(int8_t value)
+{
+  return __setGroupValue(*m_coalescer, GetRenderingControls(), RenderingRequest::SetTreble, value);
+}
+
+bool Player::SetVolumeCoalesced(const std::string& uuid, uint8_t value)
+{
+  RCTable table = m_RCTable.Load();
+  for (RCTable::const_iterator it = table.begin(); it != table.end(); ++it)
+  {
+    if (it->uuid == uuid)
+    {
+      return __submitVolume(*m_coalescer, uuid, it->renderingControl, value);
+    }
+  }
+  return false;
+}
+
+bool Player::SetGroupVolumeCoalesced(uint8_t value)
+{
+  RCTable table = m_RCTable.Load();
+  std::vector<int> volumes;
+  for (RCTable::const_iterator it = table.begin(); it != table.end(); ++it)
+  {
+    uint8_t v;
+    RCSProperty prop;
+    if (GetPendingVolume(it->uuid, &v))
+      volumes.push_back(v);
+    else if (it->renderingControl->GetCachedProperty(prop))
+      volumes.push_back(prop.VolumeMaster);
+    else
+      return SetGroupVolume(value);
+  }
+  if (volumes.empty())
+    return false;
+  int sum = 0;
+  for (std::vector<int>::const_iterator it = volumes.begin(); it != volumes.end(); ++it)
+    sum += *it;
+  int target = (value > 100 ? 100 : value);
+  if (sum == 0)
+    sum = LoadGroupBalance(table, volumes);
+  else if (target == 0)
+    SaveGroupBalance(table, volumes);
+  bool ret = true;
+  for (size_t i = 0; i < table.size(); ++i)
+  {
+    int v = GroupBalance::ScaleVolume(volumes[i], sum, volumes.size(), target);
+    ret = __submitVolume(*m_coalescer, table[i].uuid, table[i].renderingControl, v) && ret;
+  }
+  return ret;
+}
+
+bool Player::GetPendingVolume(const std::string& uuid, uint8_t* value)
+{
+  int v;
+  if (!m_coalescer->Pending(std::string("volume:").append(uuid), &v))
+    return false;
+  *value = (uint8_t)v;
+  return true;
+}
+
 bool Player::GetVolumeDecibel(const std::string &uuid, int16_t *value)
 {
-  for (RCTable::const_iterator it = m_RCTable.begin(); it != m_RCTable.end(); ++it)
+  RCTable table = m_RCTable.Load();
+  for (RCTable::const_iterator it = table.begin(); it != table.end(); ++it)
   {
     if (it->uuid == uuid)
       return it->renderingControl->GetVolumeDecibel(value);
@@ -328,7 +866,8 @@ bool Player::GetVolumeDecibel(const std::string &uuid, int16_t *value)
 
 bool Player::SetVolumeDecibel(const std::string &uuid, int16_t value)
 {
-  for (RCTable::const_iterator it = m_RCTable.begin(); it != m_RCTable.end(); ++it)
+  RCTable table = m_RCTable.Load();
+  for (RCTable::const_iterator it = table.begin(); it != table.end(); ++it)
   {
     if (it->uuid == uuid)
       return it->renderingControl->SetVolumeDecibel(value);
@@ -338,7 +877,8 @@ bool Player::SetVolumeDecibel(const std::string &uuid, int16_t value)
 
 bool Player::GetDecibelRange(const std::string &uuid, int16_t *minimum, int16_t *maximum)
 {
-  for (RCTable::const_iterator it = m_RCTable.begin(); it != m_RCTable.end(); ++it)
+  RCTable table = m_RCTable.Load();
+  for (RCTable::const_iterator it = table.begin(); it != table.end(); ++it)
   {
     if (it->uuid == uuid)
       return it->renderingControl->GetDecibelRange(minimum, maximum);
@@ -348,17 +888,27 @@ bool Player::GetDecibelRange(const std::string &uuid, int16_t *minimum, int16_t
 
 bool Player::GetMute(const std::string& uuid, uint8_t* value)
 {
-  for (RCTable::const_iterator it = m_RCTable.begin(); it != m_RCTable.end(); ++it)
+  RCTable table = m_RCTable.Load();
+  for (RCTable::const_iterator it = table.begin(); it != table.end(); ++it)
   {
     if (it->uuid == uuid)
+    {
+      RCSProperty prop;
+      if (CachedRenderingProperty(it->renderingControl, prop))
+      {
+        *value = (uint8_t)prop.MuteMaster;
+        return true;
+      }
       return it->renderingControl->GetMute(value);
+    }
   }
   return false;
 }
 
 bool Player::SetMute(const std::string& uuid, uint8_t value)
 {
-  for (RCTable::const_iterator it = m_RCTable.begin(); it != m_RCTable.end(); ++it)
+  RCTable table = m_RCTable.Load();
+  for (RCTable::const_iterator it = table.begin(); it != table.end(); ++it)
   {
     if (it->uuid == uuid)
       return it->renderingControl->SetMute(value);
@@ -368,17 +918,27 @@ bool Player::SetMute(const std::string& uuid, uint8_t value)
 
 bool Player::GetNightmode(const std::string &uuid, int16_t *value)
 {
-  for (RCTable::const_iterator it = m_RCTable.begin(); it != m_RCTable.end(); ++it)
+  RCTable table = m_RCTable.Load();
+  for (RCTable::const_iterator it = table.begin(); it != table.end(); ++it)
   {
     if (it->uuid == uuid)
+    {
+      RCSProperty prop;
+      if (CachedRenderingProperty(it->renderingControl, prop))
+      {
+        *value = (int16_t)prop.NightMode;
+        return true;
+      }
       return it->renderingControl->GetNightmode(value);
+    }
   }
   return false;
 }
 
 bool Player::SetNightmode(const std::string &uuid, int16_t value)
 {
-  for (RCTable::const_iterator it = m_RCTable.begin(); it != m_RCTable.end(); ++it)
+  RCTable table = m_RCTable.Load();
+  for (RCTable::const_iterator it = table.begin(); it != table.end(); ++it)
   {
     if (it->uuid == uuid)
       return it->renderingControl->SetNightmode(value);
@@ -388,17 +948,27 @@ bool Player::SetNightmode(const std::string &uuid, int16_t value)
 
 bool Player::GetLoudness(const std::string &uuid, uint8_t *value)
 {
-  for (RCTable::const_iterator it = m_RCTable.begin(); it != m_RCTable.end(); ++it)
+  RCTable table = m_RCTable.Load();
+  for (RCTable::const_iterator it = table.begin(); it != table.end(); ++it)
   {
     if (it->uuid == uuid)
+    {
+      RCSProperty prop;
+      if (CachedRenderingProperty(it->renderingControl, prop))
+      {
+        *value = (uint8_t)prop.LoudnessMaster;
+        return true;
+      }
       return it->renderingControl->GetLoudness(value);
+    }
   }
   return false;
 }
 
 bool Player::SetLoudness(const std::string &uuid, uint8_t value)
 {
-  for (RCTable::const_iterator it = m_RCTable.begin(); it != m_RCTable.end(); ++it)
+  RCTable table = m_RCTable.Load();
+  for (RCTable::const_iterator it = table.begin(); it != table.end(); ++it)
   {
     if (it->uuid == uuid)
       return it->renderingControl->SetLoudness(value);
@@ -408,17 +978,27 @@ bool Player::SetLoudness(const std::string &uuid, uint8_t value)
 
 bool Player::GetSubGain(const std::string &uuid, int16_t *value)
 {
-  for (RCTable::const_iterator it = m_RCTable.begin(); it != m_RCTable.end(); ++it)
+  RCTable table = m_RCTable.Load();
+  for (RCTable::const_iterator it = table.begin(); it != table.end(); ++it)
   {
     if (it->uuid == uuid)
+    {
+      RCSProperty prop;
+      if (CachedRenderingProperty(it->renderingControl, prop))
+      {
+        *value = (int16_t)prop.SubGain;
+        return true;
+      }
       return it->renderingControl->GetSubGain(value);
+    }
   }
   return false;
 }
 
 bool Player::SetSubGain(const std::string &uuid, int16_t value)
 {
-  for (RCTable::const_iterator it = m_RCTable.begin(); it != m_RCTable.end(); ++it)
+  RCTable table = m_RCTable.Load();
+  for (RCTable::const_iterator it = table.begin(); it != table.end(); ++it)
   {
     if (it->uuid == uuid)
       return it->renderingControl->SetSubGain(value);
@@ -428,17 +1008,27 @@ bool Player::SetSubGain(const std::string &uuid, int16_t value)
 
 bool Player::GetBass(const std::string &uuid, int8_t* value)
 {
-  for (RCTable::const_iterator it = m_RCTable.begin(); it != m_RCTable.end(); ++it)
+  RCTable table = m_RCTable.Load();
+  for (RCTable::const_iterator it = table.begin(); it != table.end(); ++it)
   {
     if (it->uuid == uuid)
+    {
+      RCSProperty prop;
+      if (CachedRenderingProperty(it->renderingControl, prop))
+      {
+        *value = (int8_t)prop.Bass;
+        return true;
+      }
       return it->renderingControl->GetBass(value);
+    }
   }
   return false;
 }
 
 bool Player::SetBass(const std::string &uuid, int8_t value)
 {
-  for (RCTable::const_iterator it = m_RCTable.begin(); it != m_RCTable.end(); ++it)
+  RCTable table = m_RCTable.Load();
+  for (RCTable::const_iterator it = table.begin(); it != table.end(); ++it)
   {
     if (it->uuid == uuid)
       return it->renderingControl->SetBass(value);
@@ -448,17 +1038,27 @@ bool Player::SetBass(const std::string &uuid, int8_t value)
 
 bool Player::GetTreble(const std::string &uuid, int8_t* value)
 {
-  for (RCTable::const_iterator it = m_RCTable.begin(); it != m_RCTable.end(); ++it)
+  RCTable table = m_RCTable.Load();
+  for (RCTable::const_iterator it = table.begin(); it != table.end(); ++it)
   {
     if (it->uuid == uuid)
+    {
+      RCSProperty prop;
+      if (CachedRenderingProperty(it->renderingControl, prop))
+      {
+        *value = (int8_t)prop.Treble;
+        return true;
+      }
       return it->renderingControl->GetTreble(value);
+    }
   }
   return false;
 }
 
 bool Player::SetTreble(const std::string &uuid, int8_t value)
 {
-  for (RCTable::const_iterator it = m_RCTable.begin(); it != m_RCTable.end(); ++it)
+  RCTable table = m_RCTable.Load();
+  for (RCTable::const_iterator it = table.begin(); it != table.end(); ++it)
   {
     if (it->uuid == uuid)
       return it->renderingControl->SetTreble(value);
@@ -468,7 +1068,8 @@ bool Player::SetTreble(const std::string &uuid, int8_t value)
 
 bool Player::GetSupportsOutputFixed(const std::string &uuid, uint8_t* value)
 {
-  for (RCTable::const_iterator it = m_RCTable.begin(); it != m_RCTable.end(); ++it)
+  RCTable table = m_RCTable.Load();
+  for (RCTable::const_iterator it = table.begin(); it != table.end(); ++it)
   {
     if (it->uuid == uuid)
       return it->renderingControl->GetSupportsOutputFixed(value);
@@ -478,17 +1079,27 @@ bool Player::GetSupportsOutputFixed(const std::string &uuid, uint8_t* value)
 
 bool Player::GetOutputFixed(const std::string &uuid, uint8_t* value)
 {
-  for (RCTable::const_iterator it = m_RCTable.begin(); it != m_RCTable.end(); ++it)
+  RCTable table = m_RCTable.Load();
+  for (RCTable::const_iterator it = table.begin(); it != table.end(); ++it)
   {
     if (it->uuid == uuid)
+    {
+      RCSProperty prop;
+      if (CachedRenderingProperty(it->renderingControl, prop))
+      {
+        *value = (uint8_t)prop.OutputFixed;
+        return true;
+      }
       return it->renderingControl->GetOutputFixed(value);
+    }
   }
   return false;
 }
 
 bool Player::SetOutputFixed(const std::string &uuid, uint8_t value)
 {
-  for (RCTable::const_iterator it = m_RCTable.begin(); it != m_RCTable.end(); ++it)
+  RCTable table = m_RCTable.Load();
+  for (RCTable::const_iterator it = table.begin(); it != table.end(); ++it)
   {
     if (it->uuid == uuid)
       return it->renderingControl->SetOutputFixed(value);
@@ -503,13 +1114,16 @@ bool Player::SetCurrentURI(const DigitalItemPtr& item)
   return m_AVTransport->SetCurrentURI(item->GetValue("res"), item->DIDL());
 }
 
-bool Player::PlayPulse()
+bool Player::PlayPulse(const std::string& profile, const std::string& format)
 {
   RequestBroker::ResourcePtr res(nullptr);
 #ifdef HAVE_PULSEAUDIO
   RequestBrokerPtr rb = m_eventHandler.GetRequestBroker(PULSESTREAMER_CNAME);
+  // the resource of each format has the matching extension and content type
   if (rb)
-    res = rb->GetResource(PULSESTREAMER_CNAME);
+    res = rb->GetResource(format.empty() || format == "flac" ? std::string(PULSESTREAMER_CNAME) : std::string(PULSESTREAMER_CNAME ".").append(format));
+#else
+  (void)format;
 #endif
   if (res)
   {
@@ -519,6 +1133,8 @@ bool Player::PlayPulse()
     streamURL.assign(m_controllerUri).append(res->uri)
         .append(hasParam ? "&" : "?")
         .append("acr=").append(m_controllerName).append(":").append(std::to_string(m_eventHandler.GetPort()));
+    if (!profile.empty())
+      streamURL.append("&profile=").append(profile);
     // define the icon URL for the local handler
     std::string iconURL;
     iconURL.assign(m_controllerUri).append(res->iconUri);
@@ -526,7 +1142,7 @@ bool Player::PlayPulse()
     // write my formatted name
     std::string _title = res->description;
     _title.replace(res->description.find("%s"), 2, m_controllerName);
-    return PlayStream(streamURL, _title, iconURL);
+    return PlayStream(streamURL, _title, iconURL, res->contentType);
   }
   DBG(DBG_ERROR, "%s: service unavaible\n", __FUNCTION__);
   return false;
@@ -564,24 +1180,15 @@ bool Player::PlayStream(const std::string& streamURL, const std::string& title,
     if (file.find('.') != std::string::npos)
       mime = file.substr(file.find_last_of('.'));
     /*
-     * Configure an audio FLAC transfer for any resource with the corresponding extension
+     * Configure an audio FLAC or PCM transfer for any resource with the corresponding extension
      */
     if (mime == ".flac")
-    {
-      std::string protocolInfo;
-      protocolInfo.assign(ProtocolTable[Protocol_xRinconMP3Radio]).append(":*:audio/flac:*");
-      // Setup the digital item
-      DigitalItemPtr item(new DigitalItem(DigitalItem::Type_item, DigitalItem::SubType_audioItem));
-      item->SetProperty(DIDL_QNAME_DC "title", title);
-      item->SetProperty(DIDL_QNAME_RINC "streamContent", "");
-      if (!iconURL.empty())
-        item->SetProperty(DIDL_QNAME_UPNP "albumArtURI", iconURL);
-      ElementPtr res(new Element("res", streamURL));
-      res->SetAttribut("protocolInfo", protocolInfo);
-      item->SetProperty(res);
-      DBG(DBG_DEBUG, "%s: %s\n%s\n", __FUNCTION__, item->GetValue("res").c_str(), item->DIDL().c_str());
-      return SetCurrentURI(item) && m_AVTransport->Play();
-    }
+      return PlayStream(streamURL, title, iconURL, "audio/flac");
+    if (mime == ".wav")
+      return PlayStream(streamURL, title, iconURL, "audio/wav");
+    // the raw PCM carries no header, so its type tells the rate and channels
+    if (mime == ".l16")
+      return PlayStream(streamURL, title, iconURL, LPCMEncoder::mediaType(LPCMEncoder::L16, AudioFormat::CDLPCM()));
     /*
      * Else configure as MP3Radio
      */
@@ -612,6 +1219,23 @@ bool Player::PlayStream(const std::string& streamURL, const std::string& title)
   return PlayStream(streamURL, title, "");
 }
 
+bool Player::PlayStream(const std::string& streamURL, const std::string& title, const std::string& iconURL, const std::string& contentType)
+{
+  std::string protocolInfo;
+  protocolInfo.assign(ProtocolTable[Protocol_xRinconMP3Radio]).append(":*:").append(contentType).append(":*");
+  // Setup the digital item
+  DigitalItemPtr item(new DigitalItem(DigitalItem::Type_item, DigitalItem::SubType_audioItem));
+  item->SetProperty(DIDL_QNAME_DC "title", title);
+  item->SetProperty(DIDL_QNAME_RINC "streamContent", "");
+  if (!iconURL.empty())
+    item->SetProperty(DIDL_QNAME_UPNP "albumArtURI", iconURL);
+  ElementPtr res(new Element("res", streamURL));
+  res->SetAttribut("protocolInfo", protocolInfo);
+  item->SetProperty(res);
+  DBG(DBG_DEBUG, "%s: %s\n%s\n", __FUNCTION__, item->GetValue("res").c_str(), item->DIDL().c_str());
+  return SetCurrentURI(item) && m_AVTransport->Play();
+}
+
 bool Player::PlayQueue(bool start)
 {
   std::string uri;
@@ -635,21 +1259,35 @@ unsigned Player::AddURIToQueue(const DigitalItemPtr& item, unsigned position)
 unsigned Player::AddMultipleURIsToQueue(const std::vector<DigitalItemPtr>& items)
 {
   unsigned tno = 0;
-  std::vector<std::string> uris;
-  std::vector<std::string> metadatas;
+  // the metadata of each item is written into the same buffer, reused for
+  // each batch of 16 items
+  std::string uris;
+  std::string metadatas;
+  std::string res;
+  metadatas.reserve(16 * 1024);
   std::vector<DigitalItemPtr>::const_iterator it = items.begin();
   while (it != items.end())
   {
-    while (uris.size() < 16 && it != items.end())
+    unsigned count = 0;
+    while (count < 16 && it != items.end())
     {
       if (*it)
       {
-        uris.push_back((*it)->GetValue("res"));
-        metadatas.push_back((*it)->DIDL());
+        if (count++ > 0)
+        {
+          uris.append(" ");
+          metadatas.append(" ");
+        }
+        // read the resource without building the elements of the item
+        if ((*it)->FindValue("res", res))
+          uris.append(res);
+        (*it)->DIDL(metadatas);
       }
       ++it;
     }
-    unsigned r = m_AVTransport->AddMultipleURIsToQueue(uris, metadatas);
+    if (!count)
+      break;
+    unsigned r = m_AVTransport->AddMultipleURIsToQueue(count, uris, metadatas);
     if (!r)
       break;
     if (!tno) // save first track number
@@ -722,6 +1360,25 @@ bool Player::SeekTime(uint16_t reltime)
   return m_AVTransport->SeekTime(reltime);
 }
 
+bool Player::SeekTimeCoalesced(uint16_t reltime)
+{
+  if (!m_AVTransport)
+    return false;
+  Coalescer::CommandPtr command = m_coalescer->LastCommand("seektime");
+  if (!command)
+    command.reset(new SeekTimeCommand(m_AVTransport));
+  return m_coalescer->Submit("seektime", command, reltime);
+}
+
+bool Player::GetPendingSeekTime(uint16_t* reltime)
+{
+  int v;
+  if (!m_coalescer->Pending("seektime", &v))
+    return false;
+  *reltime = (uint16_t)v;
+  return true;
+}
+
 bool Player::SeekTrack(unsigned tracknr)
 {
   return m_AVTransport->SeekTrack(tracknr);
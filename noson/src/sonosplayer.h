@@ -27,12 +27,14 @@
 #include "sonoszone.h"
 #include "eventhandler.h"
 #include "subscriptionpool.h"
+#include "renderingcontrol.h"
 #include "element.h"
 #include "locked.h"
 
 #include <string>
 #include <vector>
 #include <map>
+#include <atomic>
 
 namespace NSROOT
 {
@@ -40,12 +42,15 @@ namespace NSROOT
   class DeviceProperties;
   class RenderingControl;
   class ContentDirectory;
+  class Coalescer;
+  class GroupBalance;
   class System;
   
   class Player;
 
   typedef SHARED_PTR<Player> PlayerPtr;
   typedef std::vector<SRProperty> SRPList;
+  typedef SHARED_PTR<RenderingControl> RenderingControlPtr;
 
   class Player
   {
@@ -74,9 +79,10 @@ namespace NSROOT
     Player& operator=(const Player&) = delete;
 
     bool IsValid() const { return m_valid; }
+    const std::string& GetUUID() const { return m_uuid; }
     const std::string& GetHost() const { return m_deviceHost; }
     unsigned GetPort() const { return m_devicePort; }
-    ZonePtr GetZone() const { return m_zone; }
+    ZonePtr GetZone() const { return m_zone.Load(); }
 
     unsigned char LastEvents();
     bool RenderingPropertyEmpty();
@@ -100,6 +106,42 @@ namespace NSROOT
     bool GetMute(const std::string& uuid, uint8_t* value);
     bool SetMute(const std::string& uuid, uint8_t value);
 
+    /**
+     * The group level changes are requested to all members at once.
+     * The volume of the group is the mean of the members.
+     */
+    bool GetGroupVolume(uint8_t* value);
+
+    /**
+     * Set the volume of the group, keeping the balance between members. The
+     * balance is kept when the group is silenced, and restored from silence.
+     */
+    bool SetGroupVolume(uint8_t value);
+
+    /**
+     * Change the volume of all members by the same amount.
+     * @param delta The step, positive or negative
+     * @param value (out) If not null, the new volume of the group
+     */
+    bool SetRelativeGroupVolume(int delta, uint8_t* value = nullptr);
+    bool SetGroupMute(uint8_t value);
+    bool SetGroupLoudness(uint8_t value);
+    bool SetGroupBass(int8_t value);
+    bool SetGroupTreble(int8_t value);
+
+    /**
+     * Coalesced setters, for high rate changes as from a slider. The call
+     * returns at once: while a request of the same kind is in flight, only
+     * the newest value is kept and it is sent once the previous one has
+     * completed. Until then, the pending value is reported by
+     * GetRenderingProperty, or GetPendingSeekTime.
+     */
+    bool SetVolumeCoalesced(const std::string& uuid, uint8_t value);
+    bool SetGroupVolumeCoalesced(uint8_t value);
+    bool SeekTimeCoalesced(uint16_t reltime);
+    bool GetPendingVolume(const std::string& uuid, uint8_t* value);
+    bool GetPendingSeekTime(uint16_t* reltime);
+
     bool GetNightmode(const std::string& uuid, int16_t* value);
     bool SetNightmode(const std::string& uuid, int16_t value);
     bool GetLoudness(const std::string& uuid, uint8_t* value);
@@ -117,12 +159,32 @@ namespace NSROOT
     bool GetOutputFixed(const std::string& uuid, uint8_t* value);
     bool SetOutputFixed(const std::string& uuid, uint8_t value);
 
+    /**
+     * Answer the getters of the rendering properties and the transport info
+     * from the state maintained by the events, as long as the subscription
+     * is up to date. Otherwise the device is requested. It is disabled by
+     * default.
+     */
+    void SetCacheFirst(bool enabled) { m_cacheFirst = enabled; }
+    void GetCacheStats(unsigned* hits, unsigned* misses) const;
+
     bool SetCurrentURI(const DigitalItemPtr& item);
-    bool PlayPulse();
+    /**
+     * Play the audio of the local PulseAudio sink.
+     * @param profile The profile of the FLAC encoder: lowlatency, balanced
+     * or archival. Empty for the default.
+     * @param format The format of the stream: flac, or wav and l16 for the
+     * uncompressed PCM. Empty for the default.
+     */
+    bool PlayPulse(const std::string& profile = "", const std::string& format = "");
     bool IsPulseStream(const std::string& streamURL);
     bool IsMyStream(const std::string& streamURL);
     bool PlayStream(const std::string& streamURL, const std::string& title, const std::string& iconURL);
     bool PlayStream(const std::string& streamURL, const std::string& title);
+    /**
+     * Play the stream as a transfer of the given content type.
+     */
+    bool PlayStream(const std::string& streamURL, const std::string& title, const std::string& iconURL, const std::string& contentType);
     bool PlayQueue(bool start);
     unsigned AddURIToQueue(const DigitalItemPtr& item, unsigned position);
     unsigned AddMultipleURIsToQueue(const std::vector<DigitalItemPtr>& items);
@@ -165,8 +227,10 @@ namespace NSROOT
     ContentProperty GetContentProperty();
 
   private:
+    friend class System;
+
     bool m_valid;
-    ZonePtr m_zone;
+    mutable Locked<ZonePtr> m_zone;
     EventHandler m_eventHandler;
     std::string m_uuid;
     std::string m_deviceHost;
@@ -176,9 +240,13 @@ namespace NSROOT
     Locked<bool> m_eventSignaled;           // cleared by calling LastEvents()
     Locked<unsigned char> m_eventMask;      // cleared by calling LastEvents()
     // Services API
-    DeviceProperties*   m_deviceProperties;
+    Locked<DeviceProperties*> m_deviceProperties; // built on first use
     AVTransport*        m_AVTransport;
     ContentDirectory*   m_contentDirectory;
+    Coalescer*          m_coalescer;          // coalesced requests
+    std::atomic<bool>   m_cacheFirst;         // getters answered from the events
+    std::atomic<unsigned> m_cacheHits;
+    std::atomic<unsigned> m_cacheMisses;
 
     // The name and address of this controller
     std::string m_controllerLocalUri;
@@ -194,16 +262,48 @@ namespace NSROOT
     public:
       std::string uuid;
       std::string name;
-      RenderingControl* renderingControl;
+      RenderingControlPtr renderingControl;
       void FillSRProperty(SRProperty& srp) const;
     };
 
     typedef std::vector<SubordinateRC> RCTable;
-    RCTable m_RCTable;
+    Locked<RCTable> m_RCTable;
+    std::vector<RenderingControlPtr> GetRenderingControls();
+    static std::vector<RenderingControlPtr> GetRenderingControls(const RCTable& table);
+
+    // the volumes of the members, by UUID, when the group was silenced
+    GroupBalance* m_groupBalance;
+    void SaveGroupBalance(const RCTable& table, const std::vector<int>& volumes);
+    int LoadGroupBalance(const RCTable& table, std::vector<int>& volumes);
+    bool CachedRenderingProperty(const RenderingControlPtr& rc, RCSProperty& prop);
+    bool CachedTransportProperty(AVTProperty& prop);
 
     // cold startup
     bool Init(System* system);
 
+    // the rendering controls released by the players, by device UUID
+    typedef std::map<std::string, RenderingControlPtr> RCPool;
+
+    /**
+     * Move the player to another state of its zone, with the same coordinator.
+     * The services of the members staying are kept, the others are taken from
+     * or released to the pool. The pool is locked for its lookups only, so
+     * the services are created and detached out of the lock, and the caller
+     * serializes the changes of a player.
+     * @return false if the coordinator differs
+     */
+    bool Retarget(const ZonePtr& zone, Locked<RCPool>& pool);
+
+    /**
+     * Release to the pool the services of the members not in the given zone.
+     * @param zone The zone, or null to release all
+     */
+    void ReleaseRenderingControls(const ZonePtr& zone, Locked<RCPool>& pool);
+    void AssignRenderingControls(const ZonePtr& zone, Locked<RCPool>& pool);
+    void ReleaseRenderingControl(const SubordinateRC& rc, Locked<RCPool>& pool);
+
+    DeviceProperties* GetDeviceProperties();
+
     // event callback
     static void CB_AVTransport(void* handle);
     static void CB_RenderingControl(void* handle);
@@ -33,6 +33,7 @@
 #include "private/builtin.h"
 #include "private/uriparser.h"
 #include "private/tokenizer.h"
+#include "private/diskcache.h"
 #include "private/tinyxml2.h"
 #include "private/os/threads/mutex.h"
 #include "private/os/threads/event.h"
@@ -45,6 +46,8 @@
 #define CB_TIMEOUT    3000
 #define PATH_TOPOLOGY "/status/topology"
 #define URI_MSLOGO    "http://update-services.sonos.com/services/mslogo.xml"
+#define SMSERVICES_RETRY_MIN 10000  // first delay before reloading a failed version
+#define SMSERVICES_RETRY_MAX 600000
 
 using namespace SONOS;
 
@@ -64,9 +67,16 @@ System::System(void* CBHandle, EventCB eventCB)
 , m_deviceProperties(nullptr)
 , m_alarmClock(nullptr)
 , m_contentDirectory(nullptr)
-, m_musicServices(nullptr)
+, m_musicServices()
 , m_players(PlayerMap())
+, m_renderingControls(Player::RCPool())
+, m_retargetMutex(new OS::CMutex)
 , m_subscriptionPool()
+, m_smservicesLoading(false)
+, m_smservicesFailed()
+, m_smservicesRetry(new OS::CTimeout)
+, m_smservicesBackoff(0)
+, m_zoneChanges(ZoneChanges())
 {
   m_subId = m_eventHandler.CreateSubscription(this);
   m_eventHandler.SubscribeForEvent(m_subId, EVENT_HANDLER_STATUS);
@@ -84,13 +94,15 @@ System::System(void* CBHandle, EventCB eventCB)
 System::~System()
 {
   m_mutex->Lock();
-  SAFE_DELETE(m_musicServices);
+  m_musicServices.reset();
   SAFE_DELETE(m_contentDirectory);
   SAFE_DELETE(m_alarmClock);
   SAFE_DELETE(m_deviceProperties);
   SAFE_DELETE(m_groupTopology);
   SAFE_DELETE(m_cbzgt);
+  SAFE_DELETE(m_smservicesRetry);
   m_eventHandler.RevokeAllSubscriptions(this);
+  SAFE_DELETE(m_retargetMutex);
   SAFE_DELETE(m_mutex);
 }
 
@@ -120,7 +132,7 @@ bool System::Discover(const std::string& url)
   m_devicePort = uri.Port();
 
   // close all subscriptions
-  SAFE_DELETE(m_musicServices);
+  m_musicServices.reset();
   SAFE_DELETE(m_contentDirectory);
   SAFE_DELETE(m_alarmClock);
   SAFE_DELETE(m_deviceProperties);
@@ -152,9 +164,13 @@ bool System::Discover(const std::string& url)
   m_serialNumber = vars.GetValue("SerialNumber");
   m_softwareVersion = vars.GetValue("SoftwareVersion");
 
-  // music services
-  m_musicServices = new MusicServices(uri.Host(), uri.Port());
-  m_smservices = m_musicServices->GetAvailableServices();
+  // music services: the catalogue stored for the household is valid until
+  // the device announces a new version of the list
+  m_musicServices.reset(new MusicServices(uri.Host(), uri.Port(), m_subscriptionPool));
+  if (!m_musicServices->LoadAvailableServices(m_householdID, m_smservices))
+    m_smservices = m_musicServices->GetAvailableServices(m_householdID);
+  m_smservicesFailed.clear();
+  m_smservicesBackoff = 0;
 
   // subscribe to AlarmClock events
   m_alarmClock = new AlarmClock(uri.Host(), uri.Port(), m_subscriptionPool, this, CB_AlarmClock);
@@ -208,25 +224,43 @@ ZonePlayerList System::GetZonePlayerList() const
 
 PlayerPtr System::GetPlayer(const ZonePtr& zone, void* CBHandle, EventCB eventCB)
 {
+  // Check requirements
+  if (!zone || !zone->GetCoordinator())
+    return PlayerPtr();
   DBG(DBG_DEBUG, "%s: %s\n", __FUNCTION__, zone->GetZoneName().c_str());
-  Locked<PlayerMap>::pointer players = m_players.Get();
-  PlayerMap::iterator pit = players->find(zone->GetGroup());
-  // The group ID is that of its coordinator. Therefore it is necessary to
-  // compare the names to avoid confusion.
-  if (pit != players->end() && pit->second->GetZone()->GetZoneName() == zone->GetZoneName())
-    return pit->second;
+  // The services are created out of the lock of the players
+  OS::CLockGuard guard(*m_retargetMutex);
+  // The players are pooled by the UUID of their coordinator
+  const std::string& uuid = zone->GetCoordinator()->GetUUID();
+  PlayerPtr player;
+  size_t count;
+  {
+    // BEGIN CRITICAL SECTION
+    Locked<PlayerMap>::pointer players = m_players.Get();
+    PlayerMap::iterator pit = players->find(uuid);
+    if (pit != players->end())
+      player = pit->second;
+    count = players->size();
+    // END CRITICAL SECTION
+  }
+  if (player)
+  {
+    if (player->GetZone()->GetZoneName() == zone->GetZoneName())
+      return player;
+    if (player->Retarget(zone, m_renderingControls))
+      return player;
+    m_players.Get()->erase(uuid);
+    player.reset();
+  }
 
   // Check listener
   if (!m_eventHandler.IsRunning() && !m_eventHandler.Start())
     return PlayerPtr();
-  // Check requirements
-  if (!zone)
-    return PlayerPtr();
-  DBG(DBG_DEBUG, "%s: connect zone [%u] '%s'\n", __FUNCTION__, players->size(), zone->GetZoneName().c_str());
-  PlayerPtr player(new Player(zone, this, CBHandle, eventCB));
+  DBG(DBG_DEBUG, "%s: connect zone [%u] '%s'\n", __FUNCTION__, (unsigned)count, zone->GetZoneName().c_str());
+  player.reset(new Player(zone, this, CBHandle, eventCB));
   if (player->IsValid())
   {
-    players->insert(std::make_pair(zone->GetGroup(), player));
+    m_players.Get()->insert(std::make_pair(uuid, player));
     return player;
   }
   return PlayerPtr();
@@ -444,10 +478,58 @@ bool System::ExtractObjectFromFavorite(const DigitalItemPtr& favorite, DigitalIt
   return true;
 }
 
+SMServiceList System::GetServices()
+{
+  SHARED_PTR<MusicServices> musicServices;
+  std::string version;
+  std::string householdID;
+  {
+    OS::CLockGuard lock(*m_mutex);
+    if (!m_musicServices || m_smservicesLoading)
+      return m_smservices;
+    version = m_musicServices->GetAnnouncedVersion();
+    if (version.empty() || version == m_musicServices->GetVersion().Load())
+      return m_smservices;
+    // the failed version is retried after a delay, doubled on each failure
+    if (version == m_smservicesFailed && m_smservicesRetry->TimeLeft() > 0)
+      return m_smservices;
+    m_smservicesLoading = true;
+    musicServices = m_musicServices;
+    householdID = m_householdID;
+  }
+  // the request could take a while: the lock must not be held meanwhile
+  DBG(DBG_INFO, "%s: reload services for version (%s)\n", __FUNCTION__, version.c_str());
+  SMServiceList list = musicServices->GetAvailableServices(householdID);
+  OS::CLockGuard lock(*m_mutex);
+  m_smservicesLoading = false;
+  // the device could have been changed meanwhile
+  if (musicServices == m_musicServices)
+  {
+    if (!list.empty())
+    {
+      m_smservices.swap(list);
+      m_smservicesFailed.clear();
+      m_smservicesBackoff = 0;
+    }
+    else
+    {
+      if (version != m_smservicesFailed)
+        m_smservicesBackoff = 0;
+      m_smservicesFailed.assign(version);
+      m_smservicesBackoff = (m_smservicesBackoff == 0 ? SMSERVICES_RETRY_MIN :
+              (m_smservicesBackoff < SMSERVICES_RETRY_MAX / 2 ? 2 * m_smservicesBackoff : SMSERVICES_RETRY_MAX));
+      m_smservicesRetry->Set(m_smservicesBackoff);
+      DBG(DBG_WARN, "%s: retry version (%s) in %u ms\n", __FUNCTION__, version.c_str(), m_smservicesBackoff);
+    }
+  }
+  return m_smservices;
+}
+
 SMServiceList System::GetEnabledServices()
 {
   SMServiceList list;
-  for (SMServiceList::iterator it = m_smservices.begin(); it != m_smservices.end(); ++it)
+  SMServiceList services = GetServices();
+  for (SMServiceList::iterator it = services.begin(); it != services.end(); ++it)
   {
     const std::string& auth = (*it)->GetPolicy()->GetAttribut("Auth");
     if ((*it)->GetContainerType() != "MService")
@@ -478,7 +560,8 @@ SMServiceList System::GetEnabledServices()
 SMServiceList System::GetAvailableServices()
 {
   SMServiceList list;
-  for (SMServiceList::iterator it = m_smservices.begin(); it != m_smservices.end(); ++it)
+  SMServiceList services = GetServices();
+  for (SMServiceList::iterator it = services.begin(); it != services.end(); ++it)
   {
     const std::string& auth = (*it)->GetPolicy()->GetAttribut("Auth");
     if ((*it)->GetContainerType() != "MService")
@@ -527,7 +610,8 @@ SMServicePtr System::GetServiceForMedia(const std::string& mediaUri)
         sn.assign("0"); // trying fake account
 
       // loop in services: no longer check the serial since commit 7a91d3ade3a428d69fe6eb97a98fc6f670f16351
-      for (SMServiceList::iterator its = m_smservices.begin(); its != m_smservices.end(); ++its)
+      SMServiceList services = GetServices();
+      for (SMServiceList::iterator its = services.begin(); its != services.end(); ++its)
         if ((*its)->GetId() == sid /*&& (*its)->GetAccount()->GetSerialNum() == sn*/)
           return *its;
 
@@ -621,6 +705,11 @@ void System::DeleteServiceOAuth(const std::string& type, const std::string& sn)
   SMOAKeyring::Purge(type, sn);
 }
 
+void System::SetCacheDirectory(const std::string& path)
+{
+  DiskCache::SetDirectory(path);
+}
+
 bool System::HavePulseAudio()
 {
 #ifdef HAVE_PULSEAUDIO
@@ -787,32 +876,110 @@ bool System::FindDeviceDescription(std::string& url)
   return ret;
 }
 
-void System::RevokePlayers()
+void System::UpdatePlayers(const ZoneChanges& changes)
 {
+  if (changes.empty())
+    return;
   ZoneList zones = GetZoneList();
-  Locked<PlayerMap>::pointer players = m_players.Get();
-  std::list<PlayerMap::iterator> revoked;
-  for (PlayerMap::iterator it = players->begin(); it != players->end(); ++it)
+  ZonePlayerList zonePlayers = GetZonePlayerList();
+  std::map<std::string, ZonePtr> coordinated;
+  for (ZoneList::const_iterator it = zones.begin(); it != zones.end(); ++it)
+    coordinated.insert(std::make_pair(it->second->GetCoordinator()->GetUUID(), it->second));
+  std::set<std::string> devices;
+  for (ZonePlayerList::const_iterator it = zonePlayers.begin(); it != zonePlayers.end(); ++it)
+    devices.insert(it->second->GetUUID());
+
+  // The diff is computed under the lock of the players, then the services
+  // are created, detached and destroyed out of it
+  OS::CLockGuard guard(*m_retargetMutex);
+  std::list<std::pair<PlayerPtr, ZonePtr> > retargeted;
+  std::list<PlayerPtr> released;
+  std::list<PlayerPtr> revoked;           // destroyed out of the locks
   {
-    // The group ID is that of its coordinator. Therefore it is necessary to
-    // compare the names to avoid confusion.
-    ZoneList::iterator zit = zones.find(it->first);
-    if (zit == zones.end() || zit->second->GetZoneName() != it->second->GetZone()->GetZoneName())
-      revoked.push_back(it);
+    // BEGIN CRITICAL SECTION
+    Locked<PlayerMap>::pointer players = m_players.Get();
+    PlayerMap::iterator it = players->begin();
+    while (it != players->end())
+    {
+      std::map<std::string, ZonePtr>::const_iterator itc = coordinated.find(it->first);
+      if (itc != coordinated.end())
+      {
+        if (itc->second.get() != it->second->GetZone().get())
+          retargeted.push_back(std::make_pair(it->second, itc->second));
+        ++it;
+      }
+      else
+      {
+        // The device is no longer a coordinator: the player is kept for when
+        // it will be again, unless the device is gone
+        released.push_back(it->second);
+        if (devices.find(it->first) == devices.end())
+        {
+          DBG(DBG_INFO, "%s: %s\n", __FUNCTION__, it->first.c_str());
+          revoked.push_back(it->second);
+          players->erase(it++);
+        }
+        else
+          ++it;
+      }
+    }
+    // END CRITICAL SECTION
+  }
+  // First release the services of the members leaving, so that they can be
+  // taken by the player of the zone they join
+  for (std::list<std::pair<PlayerPtr, ZonePtr> >::iterator it = retargeted.begin(); it != retargeted.end(); ++it)
+    it->first->ReleaseRenderingControls(it->second, m_renderingControls);
+  for (std::list<PlayerPtr>::iterator it = released.begin(); it != released.end(); ++it)
+    (*it)->ReleaseRenderingControls(ZonePtr(), m_renderingControls);
+  for (std::list<std::pair<PlayerPtr, ZonePtr> >::iterator it = retargeted.begin(); it != retargeted.end(); ++it)
+  {
+    if (!it->first->Retarget(it->second, m_renderingControls))
+    {
+      m_players.Get()->erase(it->first->GetUUID());
+      revoked.push_back(it->first);
+    }
   }
-  for (std::list<PlayerMap::iterator>::iterator it = revoked.begin(); it != revoked.end(); ++it)
+  // Drop the services of the devices gone
+  std::vector<RenderingControlPtr> dropped;
   {
-    DBG(DBG_INFO, "%s: %s\n", __FUNCTION__, (*it)->first.c_str());
-    players->erase(*it);
+    // BEGIN CRITICAL SECTION
+    Locked<Player::RCPool>::pointer pool = m_renderingControls.Get();
+    Player::RCPool::iterator itp = pool->begin();
+    while (itp != pool->end())
+    {
+      if (devices.find(itp->first) == devices.end())
+      {
+        dropped.push_back(itp->second);
+        pool->erase(itp++);
+      }
+      else
+        ++itp;
+    }
+    // END CRITICAL SECTION
   }
 }
 
+ZoneChanges System::TakeZoneChanges()
+{
+  Locked<ZoneChanges>::pointer changes = m_zoneChanges.Get();
+  ZoneChanges list;
+  std::swap(list, *changes);
+  return list;
+}
+
 void System::CB_ZGTopology(void* handle)
 {
   System* _handle = static_cast<System*>(handle);
   assert(_handle);
 
-  _handle->RevokePlayers();
+  ZoneChanges changes;
+  {
+    OS::CLockGuard lock(*_handle->m_mutex);
+    if (_handle->m_groupTopology)
+      changes = _handle->m_groupTopology->TakeChanges();
+  }
+  _handle->UpdatePlayers(changes);
+  _handle->m_zoneChanges.Get()->Merge(changes);
 
   {
     // BEGIN CRITICAL SECTION
@@ -40,6 +40,7 @@ namespace NSROOT
   {
     class CMutex;
     class CEvent;
+    class CTimeout;
   }
 
   class ZoneGroupTopology;
@@ -71,6 +72,12 @@ namespace NSROOT
 
     ZonePlayerList GetZonePlayerList() const;
 
+    /**
+     * Returns the changes of the topology since the last call, so that the
+     * zones not listed can be kept as they are.
+     */
+    ZoneChanges TakeZoneChanges();
+
     PlayerPtr GetPlayer(const ZonePtr& zone, void* CBHandle = 0, EventCB eventCB = 0);
 
     PlayerPtr GetPlayer(const ZonePlayerPtr& zonePlayer, void* CBHandle = 0, EventCB eventCB = 0);
@@ -152,6 +159,13 @@ namespace NSROOT
      */
     static void DeleteServiceOAuth(const std::string& type, const std::string& sn);
 
+    /**
+     * Set the directory where the data fetched from the network are kept
+     * between sessions, as the presentation maps of the music services.
+     * @param path The existing directory, or empty to disable the persistence
+     */
+    static void SetCacheDirectory(const std::string& path);
+
     /**
      * Check the PulseAudio feature.
      * @return true if the feature is enabled
@@ -181,10 +195,12 @@ namespace NSROOT
     DeviceProperties*   m_deviceProperties;
     AlarmClock*         m_alarmClock;
     ContentDirectory*   m_contentDirectory;
-    MusicServices*      m_musicServices;
+    SHARED_PTR<MusicServices> m_musicServices;
 
     typedef std::map<std::string, PlayerPtr> PlayerMap;
-    Locked<PlayerMap> m_players;
+    Locked<PlayerMap> m_players;            // by UUID of the coordinator
+    Locked<Player::RCPool> m_renderingControls; // released by the players
+    OS::CMutex* m_retargetMutex;            // serializes the changes of the players
 
     // Service subscriptions
     SubscriptionPoolPtr m_subscriptionPool;
@@ -198,10 +214,16 @@ namespace NSROOT
     std::string m_softwareVersion;
 
     SMServiceList m_smservices;
+    bool m_smservicesLoading;               // a refresh is running
+    std::string m_smservicesFailed;         // the version failed to load
+    OS::CTimeout* m_smservicesRetry;        // no retry of the failed version before
+    unsigned m_smservicesBackoff;
+    SMServiceList GetServices();
 
     static bool DeviceMatches(const char * serverString);
     static bool FindDeviceDescription(std::string& url);
-    void RevokePlayers();
+    Locked<ZoneChanges> m_zoneChanges;      // cleared by calling TakeZoneChanges()
+    void UpdatePlayers(const ZoneChanges& changes);
 
     static void CB_ZGTopology(void* handle);
     static void CB_AlarmClock(void* handle);
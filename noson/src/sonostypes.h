@@ -136,6 +136,7 @@ namespace NSROOT
     std::string r_CurrentValidPlayModes;       // SHUFFLE,REPEAT,CROSSFADE
     std::string r_MuseSessions;
     std::string TransportStatus;               // OK
+    std::string TransportPlaySpeed;            // 1
     std::string r_SleepTimerGeneration;        // 0
     std::string r_AlarmRunning;                // 0
     std::string r_AlarmIDRunning;
@@ -146,7 +147,6 @@ namespace NSROOT
     std::string PossiblePlaybackStorageMedia;  // NONE, NETWORK
 
     // NOT IMPLEMENTED
-    //std::string TransportPlaySpeed
     //std::string CurrentMediaDuration
     //std::string RecordStorageMedium
     //std::string PossibleRecordStorageMedia
@@ -131,3 +131,61 @@ void Zone::Revamp()
       this->push_back(*it);
   }
 }
+
+bool ZoneChanges::empty() const
+{
+  return added.empty() && removed.empty() && regrouped.empty() && renamed.empty() && updated.empty();
+}
+
+void ZoneChanges::clear()
+{
+  added.clear();
+  removed.clear();
+  regrouped.clear();
+  renamed.clear();
+  updated.clear();
+}
+
+void ZoneChanges::Merge(const ZoneChanges& next)
+{
+  std::set<std::string>::const_iterator it;
+  for (it = next.removed.begin(); it != next.removed.end(); ++it)
+  {
+    regrouped.erase(*it);
+    renamed.erase(*it);
+    updated.erase(*it);
+    // a zone added then removed never existed
+    if (added.erase(*it) == 0)
+      removed.insert(*it);
+  }
+  for (it = next.added.begin(); it != next.added.end(); ++it)
+  {
+    // a zone removed then added is another one
+    if (removed.erase(*it) > 0)
+      regrouped.insert(*it);
+    else
+      added.insert(*it);
+  }
+  for (it = next.regrouped.begin(); it != next.regrouped.end(); ++it)
+  {
+    if (added.find(*it) == added.end())
+    {
+      renamed.erase(*it);
+      updated.erase(*it);
+      regrouped.insert(*it);
+    }
+  }
+  for (it = next.renamed.begin(); it != next.renamed.end(); ++it)
+  {
+    if (added.find(*it) == added.end() && regrouped.find(*it) == regrouped.end())
+    {
+      updated.erase(*it);
+      renamed.insert(*it);
+    }
+  }
+  for (it = next.updated.begin(); it != next.updated.end(); ++it)
+  {
+    if (added.find(*it) == added.end() && regrouped.find(*it) == regrouped.end() && renamed.find(*it) == renamed.end())
+      updated.insert(*it);
+  }
+}
@@ -26,6 +26,7 @@
 #include "element.h"
 
 #include <map>
+#include <set>
 #include <vector>
 
 #define ZP_UUID         "uuid"
@@ -100,6 +101,29 @@ namespace NSROOT
       return first->compare(*last) < 0 ? true : false;
     }
   };
+
+  /**
+   * The changes of the topology between two states, by group ID. A zone not
+   * listed is unchanged, and it is held by the same object in both states.
+   */
+  struct ZoneChanges
+  {
+    std::set<std::string> added;      ///< The new zones
+    std::set<std::string> removed;    ///< The zones no longer existing
+    std::set<std::string> regrouped;  ///< The zones with other members or coordinator
+    std::set<std::string> renamed;    ///< The zones with a renamed member
+    std::set<std::string> updated;    ///< The zones with a member otherwise changed
+
+    bool empty() const;
+
+    void clear();
+
+    /**
+     * Append the changes that followed, so that the result leads from the
+     * first state to the last one.
+     */
+    void Merge(const ZoneChanges& next);
+  };
 }
 
 #endif	/* SONOSZONE_H */
@@ -58,6 +58,7 @@ namespace NSROOT
     , m_ttl(SUBSCRIPTION_TIMEOUT_MAX)
     , m_configured(false)
     , m_renewable(false)
+    , m_resubscribe(false)
     {
       m_ttl = (ttl < SUBSCRIPTION_TIMEOUT_MIN ? SUBSCRIPTION_TIMEOUT_MIN :
               (ttl > SUBSCRIPTION_TIMEOUT_MAX ? SUBSCRIPTION_TIMEOUT_MAX : ttl));
@@ -98,6 +99,16 @@ namespace NSROOT
       }
     }
 
+    virtual void AskResubscribe()
+    {
+      if (IsRunning())
+      {
+        m_resubscribe = true;
+        m_timeout.Clear();
+        m_event.Signal();
+      }
+    }
+
     virtual const std::string& GetSID() { return m_SID; }
 
     virtual const std::string& GetHost() { return m_host; }
@@ -117,6 +128,7 @@ namespace NSROOT
     unsigned m_ttl;
     bool m_configured;
     bool m_renewable;
+    volatile bool m_resubscribe;
     std::string m_myIP;
     OS::CTimeout m_timeout;
     OS::CEvent m_event;
@@ -134,6 +146,13 @@ void* SubscriptionThreadImpl::Process()
   unsigned retry = TIMEOUT_FIRST_RETRY;
   while (!IsStopped())
   {
+    if (m_resubscribe)
+    {
+      m_resubscribe = false;
+      if (success)
+        UnSubscribeForEvent();
+      success = false;
+    }
     // Reconfigure: IP may be leased for a time
     if (Configure() && (success = SubscribeForEvent(success)))
     {
@@ -154,10 +173,7 @@ void* SubscriptionThreadImpl::Process()
 
 bool SubscriptionThreadImpl::Configure()
 {
-  TcpSocket sock;
-  sock.Connect(m_host.c_str(), m_port, 0);
-  std::string myIP = sock.GetHostAddrInfo();
-  sock.Disconnect();
+  std::string myIP = TcpSocket::GetMyHostAddrInfoTo(m_host, m_port);
   if (!myIP.empty())
   {
     if (myIP == m_myIP)
@@ -257,6 +273,12 @@ void Subscription::AskRenewal()
     m_imp->AskRenewal();
 }
 
+void Subscription::AskResubscribe()
+{
+  if (m_imp)
+    m_imp->AskResubscribe();
+}
+
 const std::string& Subscription::GetSID()
 {
   static std::string nil;
@@ -59,6 +59,10 @@ namespace NSROOT
 
     void AskRenewal();
 
+    // drop the current subscription and subscribe again: the first event of
+    // the new subscription carries the whole state
+    void AskResubscribe();
+
     class SubscriptionThread
     {
     public:
@@ -69,6 +73,7 @@ namespace NSROOT
       virtual void Stop() = 0;
       virtual bool IsRunning() = 0;
       virtual void AskRenewal() = 0;
+      virtual void AskResubscribe() = 0;
       virtual const std::string& GetSID() = 0;
       virtual const std::string& GetHost() = 0;
       virtual unsigned GetPort() = 0;
@@ -59,6 +59,7 @@ ZoneGroupTopology::ZoneGroupTopology(const std::string& serviceHost, unsigned se
 , m_eventSEQ(0)
 , m_zones(ZoneList())
 , m_zonePlayers(ZonePlayerList())
+, m_changes(ZoneChanges())
 {
 }
 
@@ -73,6 +74,7 @@ ZoneGroupTopology::ZoneGroupTopology(const std::string& serviceHost, unsigned se
 , m_eventSEQ(0)
 , m_zones(ZoneList())
 , m_zonePlayers(ZonePlayerList())
+, m_changes(ZoneChanges())
 {
   unsigned subId = m_subscriptionPool->GetEventHandler().CreateSubscription(this);
   m_subscriptionPool->GetEventHandler().SubscribeForEvent(subId, EVENT_UPNP_PROPCHANGE);
@@ -124,20 +126,20 @@ void ZoneGroupTopology::HandleEventMessage(EventMessagePtr msg)
       m_eventSEQ = seq;
 
       std::vector<std::string>::const_iterator it = msg->subject.begin();
-      unsigned _oldKey = m_topologyKey;
+      bool changed = false;
       while (it != msg->subject.end())
       {
         if (*it == "ZoneGroupState")
         {
           // BEGIN CRITICAL SECTION
-          ParseZoneGroupState(*++it);
+          ParseZoneGroupState(*++it, &changed);
           // END CRITICAL SECTION
           break;
         }
         ++it;
       }
       // Event is signaled only on first or any change
-      if (m_msgCount && _oldKey == m_topologyKey)
+      if (m_msgCount && !changed)
         return;
       // Signal
       ++m_msgCount;
@@ -147,7 +149,7 @@ void ZoneGroupTopology::HandleEventMessage(EventMessagePtr msg)
   }
 }
 
-bool ZoneGroupTopology::ParseZoneGroupState(const std::string& xml)
+bool ZoneGroupTopology::ParseZoneGroupState(const std::string& xml, bool* changed)
 {
   tinyxml2::XMLDocument rootdoc;
   // Parse xml content
@@ -173,10 +175,8 @@ bool ZoneGroupTopology::ParseZoneGroupState(const std::string& xml)
     return false;
   }
 
-  Locked<ZoneList>::pointer zones = m_zones.Get();
-  Locked<ZonePlayerList>::pointer zonePlayers = m_zonePlayers.Get();
-  zones->clear();
-  zonePlayers->clear();
+  ZoneList newZones;
+  ZonePlayerList newZonePlayers;
 
   while (elem)
   {
@@ -196,7 +196,7 @@ bool ZoneGroupTopology::ParseZoneGroupState(const std::string& xml)
         }
         ZonePtr zone(new Zone(zoneGroup.GetAttribut("ID")));
         const std::string& cuuid = zoneGroup.GetAttribut("Coordinator");
-        DBG(DBG_INFO, "%s: new group '%s' with coordinator '%s'\n", __FUNCTION__, zone->GetGroup().c_str(), cuuid.c_str());
+        DBG(DBG_DEBUG, "%s: group '%s' with coordinator '%s'\n", __FUNCTION__, zone->GetGroup().c_str(), cuuid.c_str());
         // browse childs
         const tinyxml2::XMLElement* child = gelem->FirstChildElement();
         while (child)
@@ -214,7 +214,7 @@ bool ZoneGroupTopology::ParseZoneGroupState(const std::string& xml)
             {
               const std::string& mname = zoneGroupMember.GetAttribut("ZoneName");
               const std::string& muuid = zoneGroupMember.GetAttribut("UUID");
-              DBG(DBG_INFO, "%s: discard invisible group member '%s' (%s)\n", __FUNCTION__, muuid.c_str(), mname.c_str());
+              DBG(DBG_DEBUG, "%s: discard invisible group member '%s' (%s)\n", __FUNCTION__, muuid.c_str(), mname.c_str());
             }
             else
             {
@@ -230,8 +230,6 @@ bool ZoneGroupTopology::ParseZoneGroupState(const std::string& xml)
               zp->SetAttribut(ZP_VERSION, zoneGroupMember.GetAttribut("SoftwareVersion"));
               zp->SetAttribut(ZP_MCVERSION, zoneGroupMember.GetAttribut("MinCompatibleVersion"));
               zp->SetAttribut(ZP_LCVERSION, zoneGroupMember.GetAttribut("LegacyCompatibleVersion"));
-              DBG(DBG_INFO, "%s: new group member '%s' (%s)\n", __FUNCTION__, muuid.c_str(), zp->c_str());
-              zonePlayers->insert(std::make_pair(*zp, zp));
               zone->push_back(zp);
             }
           }
@@ -240,13 +238,92 @@ bool ZoneGroupTopology::ParseZoneGroupState(const std::string& xml)
         if (!zone->empty())
         {
           zone->Revamp();
-          zones->insert(std::make_pair(zone->GetGroup(), zone));
+          newZones.insert(std::make_pair(zone->GetGroup(), zone));
         }
         gelem = gelem->NextSiblingElement(NULL);
       }
     }
     elem = elem->NextSiblingElement(NULL);
   }
+
+  Locked<ZoneList>::pointer zones = m_zones.Get();
+  Locked<ZonePlayerList>::pointer zonePlayers = m_zonePlayers.Get();
+  ZoneChanges changes;
+
+  // index the current members by UUID
+  std::map<std::string, ZonePlayerPtr> members;
+  for (ZonePlayerList::const_iterator it = zonePlayers->begin(); it != zonePlayers->end(); ++it)
+    members.insert(std::make_pair(it->second->GetUUID(), it->second));
+
+  for (ZoneList::iterator it = newZones.begin(); it != newZones.end(); ++it)
+  {
+    Zone& zone = *(it->second);
+    ZoneList::const_iterator oit = zones->find(it->first);
+    bool renamed = false;
+    bool updated = false;
+    // reuse the unchanged members
+    for (Zone::iterator zit = zone.begin(); zit != zone.end(); ++zit)
+    {
+      std::map<std::string, ZonePlayerPtr>::const_iterator mit = members.find((*zit)->GetUUID());
+      if (mit == members.end())
+        continue;
+      if (SameMember(*(mit->second), **zit))
+        *zit = mit->second;
+      else if (mit->second->compare(**zit) != 0)
+        renamed = true;
+      else
+        updated = true;
+    }
+    for (Zone::const_iterator zit = zone.begin(); zit != zone.end(); ++zit)
+      newZonePlayers.insert(std::make_pair(**zit, *zit));
+
+    if (oit == zones->end())
+    {
+      DBG(DBG_INFO, "%s: new group '%s' (%s)\n", __FUNCTION__, it->first.c_str(), zone.GetZoneName().c_str());
+      changes.added.insert(it->first);
+      continue;
+    }
+    const Zone& old = *(oit->second);
+    bool same = (old.size() == zone.size());
+    for (size_t i = 0; same && i < zone.size(); ++i)
+      same = (old[i]->GetUUID() == zone[i]->GetUUID() &&
+              old[i]->GetAttribut(ZP_COORDINATOR) == zone[i]->GetAttribut(ZP_COORDINATOR));
+    if (!same)
+    {
+      DBG(DBG_INFO, "%s: regrouped '%s' (%s)\n", __FUNCTION__, it->first.c_str(), zone.GetZoneName().c_str());
+      changes.regrouped.insert(it->first);
+    }
+    else if (renamed)
+    {
+      DBG(DBG_INFO, "%s: renamed '%s' (%s)\n", __FUNCTION__, it->first.c_str(), zone.GetZoneName().c_str());
+      changes.renamed.insert(it->first);
+    }
+    else if (updated)
+    {
+      DBG(DBG_INFO, "%s: updated '%s' (%s)\n", __FUNCTION__, it->first.c_str(), zone.GetZoneName().c_str());
+      changes.updated.insert(it->first);
+    }
+    else
+    {
+      // the members are the same objects
+      it->second = oit->second;
+    }
+  }
+  for (ZoneList::const_iterator it = zones->begin(); it != zones->end(); ++it)
+  {
+    if (newZones.find(it->first) == newZones.end())
+    {
+      DBG(DBG_INFO, "%s: removed group '%s'\n", __FUNCTION__, it->first.c_str());
+      changes.removed.insert(it->first);
+    }
+  }
+
+  zones->swap(newZones);
+  zonePlayers->swap(newZonePlayers);
+  if (changed)
+    *changed = !changes.empty();
+  m_changes.Get()->Merge(changes);
+
   // compute a key for this state
   std::string keyStr;
   keyStr.reserve(zones->size() << 5);
@@ -256,3 +333,24 @@ bool ZoneGroupTopology::ParseZoneGroupState(const std::string& xml)
   DBG(DBG_INFO, "%s: topology key %u\n", __FUNCTION__, m_topologyKey);
   return (!zones->empty());
 }
+
+ZoneChanges ZoneGroupTopology::TakeChanges()
+{
+  Locked<ZoneChanges>::pointer p = m_changes.Get();
+  ZoneChanges changes;
+  std::swap(changes, *p);
+  return changes;
+}
+
+bool ZoneGroupTopology::SameMember(ZonePlayer& a, ZonePlayer& b)
+{
+  static const char* attrs[] = {
+    ZP_UUID, ZP_COORDINATOR, ZP_LOCATION, ZP_ICON, ZP_VERSION, ZP_MCVERSION, ZP_LCVERSION,
+  };
+  if (a.compare(b) != 0)
+    return false;
+  for (unsigned i = 0; i < sizeof(attrs) / sizeof(const char*); ++i)
+    if (a.GetAttribut(attrs[i]) != b.GetAttribut(attrs[i]))
+      return false;
+  return true;
+}
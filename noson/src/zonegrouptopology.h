@@ -59,6 +59,18 @@ namespace NSROOT
 
     Locked<ZonePlayerList>& GetZonePlayerList() { return m_zonePlayers; }
 
+    /**
+     * Returns the changes made by the states received since the last call,
+     * and clears them.
+     */
+    ZoneChanges TakeChanges();
+
+    /**
+     * Check both members are the same device in the same state, so that the
+     * current object can be kept.
+     */
+    static bool SameMember(ZonePlayer& a, ZonePlayer& b);
+
     // Implements EventSubscriber
     void HandleEventMessage(EventMessagePtr msg) override;
 
@@ -74,8 +86,9 @@ namespace NSROOT
 
     Locked<ZoneList> m_zones;
     Locked<ZonePlayerList> m_zonePlayers;
+    Locked<ZoneChanges> m_changes;  // merged until taken
 
-    bool ParseZoneGroupState(const std::string& xml);
+    bool ParseZoneGroupState(const std::string& xml, bool* changed = nullptr);
 
   };
 }
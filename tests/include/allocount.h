@@ -0,0 +1,61 @@
+#ifndef ALLOCOUNT_H
+#define ALLOCOUNT_H
+
+/*
+ * Replace the global operators new and delete, to count all the heap
+ * allocations made by the program. It must be included by one source only.
+ */
+
+#include <atomic>
+#include <cstdlib>
+#include <new>
+
+static std::atomic<unsigned> _allocount(0);
+static std::atomic<size_t> _allocbytes(0);
+
+static inline unsigned AllocCount()
+{
+  return _allocount.load();
+}
+
+static inline size_t AllocBytes()
+{
+  return _allocbytes.load();
+}
+
+void * operator new(std::size_t size)
+{
+  _allocount.fetch_add(1);
+  _allocbytes.fetch_add(size);
+  void * p = std::malloc(size == 0 ? 1 : size);
+  if (!p)
+    throw std::bad_alloc();
+  return p;
+}
+
+void * operator new[](std::size_t size)
+{
+  return operator new(size);
+}
+
+void operator delete(void * p) noexcept
+{
+  std::free(p);
+}
+
+void operator delete[](void * p) noexcept
+{
+  std::free(p);
+}
+
+void operator delete(void * p, std::size_t) noexcept
+{
+  std::free(p);
+}
+
+void operator delete[](void * p, std::size_t) noexcept
+{
+  std::free(p);
+}
+
+#endif /* ALLOCOUNT_H */
@@ -0,0 +1,94 @@
+#include <iostream>
+
+#include "include/testmain.h"
+#include "include/allocount.h"
+
+#include <noson/audiosource.h>
+
+#include <cstring>
+#include <string>
+
+class TestSource : public SONOS::AudioSource
+{
+public:
+  TestSource() : SONOS::AudioSource(8) { }
+  std::string getName() const override { return "test"; }
+  std::string getDescription() const override { return "test"; }
+  SONOS::AudioFormat getFormat() const override { return SONOS::AudioFormat::CDLPCM(); }
+  char * reserve(int len) { return reserveData(len); }
+  int commit() { return commitData(); }
+};
+
+class TestSink : public SONOS::IODevice
+{
+public:
+  const char * received = nullptr;
+  int size = 0;
+  bool isSequential() const override { return true; }
+  int bytesAvailable() const override { return 0; }
+protected:
+  int readData(char *, int) override { return 0; }
+  int writeData(const char * data, int len) override
+  {
+    received = data;
+    size = len;
+    return len;
+  }
+};
+
+TEST_CASE("Recording in place into the buffer")
+{
+  TestSource source;
+  source.open(SONOS::IODevice::ReadWrite);
+  source.startRecording();
+  char buf[1024];
+  unsigned allocs = 0;
+  bool intact = true;
+  for (int i = 0; i < 1000; ++i)
+  {
+    if (i == 100)
+      allocs = AllocCount();
+    int len = 1 + (i * 37) % (int)sizeof(buf);
+    char * data = source.reserve(len);
+    memset(data, (char)i, len);
+    if (source.commit() != len)
+      intact = false;
+    if (source.bytesAvailable() != len || source.read(buf, sizeof(buf), 0) != len ||
+            buf[0] != (char)i || buf[len - 1] != (char)i)
+      intact = false;
+  }
+  REQUIRE(AllocCount() == allocs);
+  REQUIRE(intact == true);
+}
+
+TEST_CASE("Recording in place into the connected output")
+{
+  TestSource source;
+  TestSink sink;
+  sink.open(SONOS::IODevice::WriteOnly);
+  source.connectOutput(&sink);
+  source.open(SONOS::IODevice::ReadOnly);
+
+  // the data is discarded until recording
+  source.reserve(16);
+  REQUIRE(source.commit() == 16);
+  REQUIRE(sink.received == nullptr);
+
+  source.startRecording();
+  unsigned allocs = 0;
+  bool inplace = true;
+  for (int i = 0; i < 1000; ++i)
+  {
+    if (i == 100)
+      allocs = AllocCount();
+    int len = (i % 7 == 3 ? 1024 : 1 + (i * 37) % 1024);
+    char * data = source.reserve(len);
+    memset(data, (char)i, len);
+    // the output receives the reserved space, not a copy
+    if (source.commit() != len || sink.received != data || sink.size != len)
+      inplace = false;
+  }
+  REQUIRE(AllocCount() == allocs);
+  REQUIRE(inplace == true);
+  REQUIRE(source.bytesAvailable() == 0);
+}
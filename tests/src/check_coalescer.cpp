@@ -0,0 +1,196 @@
+#include <iostream>
+
+#include "include/testmain.h"
+
+#include <private/coalescer.h>
+
+#include <atomic>
+#include <chrono>
+#include <thread>
+#include <vector>
+
+class FakeCommand : public SONOS::Coalescer::Command
+{
+public:
+  FakeCommand() : m_hold(false), m_running(false), m_delay(0) { }
+
+  bool Execute(int value) override
+  {
+    {
+      SONOS::OS::CLockGuard lock(m_mutex);
+      m_values.push_back(value);
+    }
+    m_running = true;
+    if (m_delay)
+      std::this_thread::sleep_for(std::chrono::milliseconds(m_delay));
+    while (m_hold)
+      std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    m_running = false;
+    return value >= 0;
+  }
+
+  std::vector<int> Values()
+  {
+    SONOS::OS::CLockGuard lock(m_mutex);
+    return m_values;
+  }
+
+  std::atomic<bool> m_hold;
+  std::atomic<bool> m_running;
+  std::atomic<int> m_delay;   // round-trip of the request in ms
+
+private:
+  SONOS::OS::CMutex m_mutex;
+  std::vector<int> m_values;
+};
+
+static bool WaitIdle(SONOS::Coalescer& coalescer, const std::string& key)
+{
+  int v;
+  for (int i = 0; i < 2000; ++i)
+  {
+    if (!coalescer.Pending(key, &v))
+      return true;
+    std::this_thread::sleep_for(std::chrono::milliseconds(1));
+  }
+  return false;
+}
+
+TEST_CASE("Sending the last value submitted while in flight")
+{
+  SONOS::Coalescer coalescer;
+  FakeCommand* fake = new FakeCommand();
+  SONOS::Coalescer::CommandPtr command(fake);
+  fake->m_hold = true;
+  REQUIRE(coalescer.Submit("volume", command, 1));
+  while (!fake->m_running)
+    std::this_thread::sleep_for(std::chrono::milliseconds(1));
+
+  // the values in between are dropped
+  int v = 0;
+  REQUIRE(coalescer.Submit("volume", command, 2));
+  REQUIRE(coalescer.Submit("volume", command, 3));
+  REQUIRE(coalescer.Submit("volume", command, 4));
+  REQUIRE(coalescer.Pending("volume", &v));
+  REQUIRE(v == 4);
+  REQUIRE(!coalescer.Pending("other", &v));
+
+  fake->m_hold = false;
+  REQUIRE(WaitIdle(coalescer, "volume"));
+  std::vector<int> values = fake->Values();
+  REQUIRE(values.size() == 2);
+  REQUIRE(values[0] == 1);
+  REQUIRE(values[1] == 4);
+
+  // the command is kept for the key
+  REQUIRE(coalescer.LastCommand("volume").get() == fake);
+  REQUIRE(coalescer.Submit("volume", coalescer.LastCommand("volume"), 5));
+  REQUIRE(WaitIdle(coalescer, "volume"));
+  REQUIRE(fake->Values().back() == 5);
+  coalescer.ForgetCommand("volume");
+  REQUIRE(!coalescer.LastCommand("volume"));
+}
+
+TEST_CASE("Running a batch of commands at once")
+{
+  SONOS::Coalescer coalescer;
+  std::vector<FakeCommand*> fakes;
+  SONOS::Coalescer::Batch batch;
+  for (int i = 0; i < 6; ++i)
+  {
+    fakes.push_back(new FakeCommand());
+    batch.push_back(std::make_pair(SONOS::Coalescer::CommandPtr(fakes.back()), i));
+  }
+  REQUIRE(coalescer.RunAll(batch));
+  for (int i = 0; i < 6; ++i)
+  {
+    REQUIRE(fakes[i]->Values().size() == 1);
+    REQUIRE(fakes[i]->Values()[0] == i);
+  }
+
+  // a failure is reported
+  batch[3].second = -1;
+  REQUIRE(!coalescer.RunAll(batch));
+}
+
+class BarrierCommand : public SONOS::Coalescer::Command
+{
+public:
+  BarrierCommand(std::atomic<int>& count, int size) : m_count(count), m_size(size) { }
+
+  bool Execute(int value) override
+  {
+    (void)value;
+    // block until all the commands of the batch are running
+    ++m_count;
+    for (int i = 0; i < 2000; ++i)
+    {
+      if (m_count >= m_size)
+        return true;
+      std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    }
+    return false;
+  }
+
+private:
+  std::atomic<int>& m_count;
+  int m_size;
+};
+
+TEST_CASE("Running a large batch concurrently")
+{
+  SONOS::Coalescer coalescer;
+  std::atomic<int> count(0);
+  SONOS::Coalescer::Batch batch;
+  for (int i = 0; i < 6; ++i)
+    batch.push_back(std::make_pair(SONOS::Coalescer::CommandPtr(new BarrierCommand(count, 6)), i));
+  REQUIRE(coalescer.RunAll(batch));
+  REQUIRE(count == 6);
+}
+
+TEST_CASE("Taking turns between more keys than threads")
+{
+  SONOS::Coalescer coalescer;
+  std::atomic<bool> dragging(true);
+  std::vector<std::thread> drags;
+  std::vector<SONOS::Coalescer::CommandPtr> commands;
+  for (int k = 0; k < COALESCER_THREADS + 1; ++k)
+  {
+    FakeCommand* fake = new FakeCommand();
+    fake->m_delay = 5;
+    commands.push_back(SONOS::Coalescer::CommandPtr(fake));
+    std::string key = "volume" + std::to_string(k);
+    SONOS::Coalescer::CommandPtr command = commands.back();
+    drags.push_back(std::thread([&coalescer, &dragging, key, command]() {
+      for (int v = 0; dragging; ++v)
+      {
+        coalescer.Submit(key, command, v);
+        std::this_thread::sleep_for(std::chrono::microseconds(100));
+      }
+    }));
+  }
+
+  // a key submitted once is sent while all the others are dragging
+  FakeCommand* seek = new FakeCommand();
+  SONOS::Coalescer::CommandPtr command(seek);
+  REQUIRE(coalescer.Submit("seektime", command, 42));
+  bool sent = false;
+  for (int i = 0; i < 2000 && !sent; ++i)
+  {
+    sent = !seek->Values().empty();
+    if (!sent)
+      std::this_thread::sleep_for(std::chrono::milliseconds(1));
+  }
+  bool stillDragging = dragging;
+  dragging = false;
+  for (std::thread& t : drags)
+    t.join();
+  REQUIRE(sent);
+  REQUIRE(stillDragging);
+  REQUIRE(seek->Values()[0] == 42);
+  for (int k = 0; k < COALESCER_THREADS + 1; ++k)
+  {
+    REQUIRE(WaitIdle(coalescer, "volume" + std::to_string(k)));
+    REQUIRE(!static_cast<FakeCommand*>(commands[k].get())->Values().empty());
+  }
+}
@@ -0,0 +1,112 @@
+#include <iostream>
+
+#include "include/testmain.h"
+
+#include <noson/contentdirectory.h>
+#include <noson/didlparser.h>
+#include <private/browsecache.h>
+
+TEST_CASE("Adapting the size of the prefetched bulks")
+{
+  // fast: doubled up to the max
+  REQUIRE(SONOS::ContentList::AdaptBulkSize(25, 100, 100) == 50);
+  REQUIRE(SONOS::ContentList::AdaptBulkSize(50, 100, 100) == 100);
+  REQUIRE(SONOS::ContentList::AdaptBulkSize(80, 100, 100) == 100);
+  REQUIRE(SONOS::ContentList::AdaptBulkSize(100, 100, 100) == 100);
+  // slow: halved down to the min
+  REQUIRE(SONOS::ContentList::AdaptBulkSize(100, 2000, 100) == 50);
+  REQUIRE(SONOS::ContentList::AdaptBulkSize(40, 2000, 100) == BROWSE_MINCOUNT);
+  REQUIRE(SONOS::ContentList::AdaptBulkSize(BROWSE_MINCOUNT, 2000, 100) == BROWSE_MINCOUNT);
+  // otherwise kept
+  REQUIRE(SONOS::ContentList::AdaptBulkSize(50, 500, 100) == 50);
+
+  // a slow peer converges to the min, then recovers to the max
+  unsigned size = 100;
+  for (int i = 0; i < 10; ++i)
+    size = SONOS::ContentList::AdaptBulkSize(size, 1500, 100);
+  REQUIRE(size == BROWSE_MINCOUNT);
+  for (int i = 0; i < 10; ++i)
+    size = SONOS::ContentList::AdaptBulkSize(size, 50, 100);
+  REQUIRE(size == 100);
+}
+
+static SONOS::BrowseCache::Table _page(unsigned count)
+{
+  SONOS::BrowseCache::Table table;
+  for (unsigned i = 0; i < count; ++i)
+    table.push_back(SONOS::DigitalItemPtr(new SONOS::DigitalItem(SONOS::DigitalItem::Type_item)));
+  return table;
+}
+
+TEST_CASE("Evicting the least recently used pages")
+{
+  SONOS::BrowseCache::Table table = _page(10);
+  size_t pageSize = 0;
+  for (const SONOS::DigitalItemPtr& item : table)
+    pageSize += item->Footprint();
+  REQUIRE(pageSize > 0);
+
+  // room for 3 pages
+  SONOS::BrowseCache cache(10, 3 * pageSize);
+  cache.Store(0, table.begin(), table.end());
+  cache.Store(10, table.begin(), table.end());
+  cache.Store(20, table.begin(), table.end());
+  REQUIRE(cache.PageCount() == 3);
+  REQUIRE(cache.Size() == 3 * pageSize);
+  REQUIRE(cache.Find(10)->size() == 10);
+  REQUIRE(cache.Find(5) == nullptr);
+
+  // the first page is used again, then the second is the oldest
+  REQUIRE(cache.Touch(0) == true);
+  REQUIRE(cache.Touch(30) == false);
+  cache.Store(30, table.begin(), table.end());
+  cache.Shrink();
+  REQUIRE(cache.PageCount() == 3);
+  REQUIRE(cache.Find(10) == nullptr);
+  REQUIRE(cache.Find(0) != nullptr);
+  REQUIRE(cache.Find(20) != nullptr);
+  REQUIRE(cache.Find(30) != nullptr);
+
+  // storing a page again replaces it
+  cache.Store(20, table.begin(), table.begin() + 5);
+  REQUIRE(cache.Find(20)->size() == 5);
+  REQUIRE(cache.Size() == 2 * pageSize + pageSize / 2);
+
+  // the budget is bytes: shrinking to one page keeps the most recent
+  cache.SetMaxSize(pageSize);
+  REQUIRE(cache.PageCount() == 1);
+  REQUIRE(cache.Find(20) != nullptr);
+
+  // 0 disables the cache
+  cache.SetMaxSize(0);
+  REQUIRE(cache.PageCount() == 0);
+  REQUIRE(cache.Size() == 0);
+}
+
+TEST_CASE("Bounding the cache by the memory held")
+{
+  // the items holding more data take more room
+  SONOS::BrowseCache::Table small = _page(10);
+  SONOS::BrowseCache::Table large = _page(10);
+  for (const SONOS::DigitalItemPtr& item : large)
+    item->SetProperty(DIDL_QNAME_DC "title", std::string(1000, 't'));
+  size_t smallSize = 0, largeSize = 0;
+  for (unsigned i = 0; i < 10; ++i)
+  {
+    smallSize += small[i]->Footprint();
+    largeSize += large[i]->Footprint();
+  }
+  REQUIRE(largeSize > smallSize + 10000);
+
+  SONOS::BrowseCache cache(10, largeSize + smallSize);
+  cache.Store(0, large.begin(), large.end());
+  cache.Store(10, small.begin(), small.end());
+  cache.Shrink();
+  REQUIRE(cache.PageCount() == 2);
+  cache.Store(20, small.begin(), small.end());
+  cache.Shrink();
+  // the large page is evicted, not one page by count
+  REQUIRE(cache.Find(0) == nullptr);
+  REQUIRE(cache.PageCount() == 2);
+  REQUIRE(cache.Size() == 2 * smallSize);
+}
@@ -0,0 +1,76 @@
+#include <iostream>
+
+#include "include/testmain.h"
+
+#include <noson/contentindex.h>
+#include <noson/didlparser.h>
+
+static SONOS::DigitalItemPtr _track(const char * title, const char * creator, const char * album)
+{
+  SONOS::DigitalItemPtr item(new SONOS::DigitalItem(SONOS::DigitalItem::Type_item, SONOS::DigitalItem::SubType_audioItem));
+  item->SetProperty(DIDL_QNAME_DC "title", title);
+  item->SetProperty(DIDL_QNAME_DC "creator", creator);
+  item->SetProperty(DIDL_QNAME_UPNP "album", album);
+  return item;
+}
+
+TEST_CASE("Splitting the words to index")
+{
+  std::vector<std::string> tokens;
+  SONOS::ContentIndex::Tokenize("Don't Stop Me Now (2011 Remaster)", tokens);
+  REQUIRE(tokens.size() == 7);
+  REQUIRE(tokens[0] == "don");
+  REQUIRE(tokens[1] == "t");
+  REQUIRE(tokens[2] == "stop");
+  REQUIRE(tokens[5] == "2011");
+  REQUIRE(tokens[6] == "remaster");
+
+  // the multibyte sequences are kept, the separators are dropped
+  tokens.clear();
+  SONOS::ContentIndex::Tokenize("  Bj\xc3\xb6rk -- Hom\xc3\xb3gen  ", tokens);
+  REQUIRE(tokens.size() == 2);
+  REQUIRE(tokens[0] == "bj\xc3\xb6rk");
+  REQUIRE(tokens[1] == "hom\xc3\xb3gen");
+
+  tokens.clear();
+  SONOS::ContentIndex::Tokenize(" ,;- ", tokens);
+  REQUIRE(tokens.empty());
+}
+
+TEST_CASE("Searching the words by prefix")
+{
+  SONOS::ContentDirectory service("127.0.0.1", 1400);
+  SONOS::ContentIndex index(service);
+  SONOS::DigitalItemList items;
+  items.push_back(_track("Bohemian Rhapsody", "Queen", "A Night at the Opera"));
+  items.push_back(_track("Love of My Life", "Queen", "A Night at the Opera"));
+  items.push_back(_track("Rhapsody in Blue", "George Gershwin", "Rhapsody"));
+  items.push_back(_track("Under Pressure", "Queen & David Bowie", "Hot Space"));
+  index.Assign(SONOS::SearchTrack, items);
+  REQUIRE(index.size() == 4);
+
+  // a word matches any word starting with it, in the order of the library
+  SONOS::DigitalItemList list = index.Search(SONOS::SearchTrack, "rhap");
+  REQUIRE(list.size() == 2);
+  REQUIRE(list[0] == items[0]);
+  REQUIRE(list[1] == items[2]);
+
+  // all the words must match, in any property and regardless of the case
+  list = index.Search(SONOS::SearchTrack, "QUEEN opera");
+  REQUIRE(list.size() == 2);
+  REQUIRE(list[0] == items[0]);
+  REQUIRE(list[1] == items[1]);
+  list = index.Search(SONOS::SearchTrack, "queen bow");
+  REQUIRE(list.size() == 1);
+  REQUIRE(list[0] == items[3]);
+  REQUIRE(index.Search(SONOS::SearchTrack, "queen blue").empty());
+
+  // the limit keeps the first matches
+  list = index.Search(SONOS::SearchTrack, "q", 2);
+  REQUIRE(list.size() == 2);
+  REQUIRE(list[1] == items[1]);
+
+  // nothing for empty queries, or roots not indexed
+  REQUIRE(index.Search(SONOS::SearchTrack, " - ").empty());
+  REQUIRE(index.Search(SONOS::SearchAlbum, "queen").empty());
+}
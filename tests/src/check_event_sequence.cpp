@@ -0,0 +1,105 @@
+#include <iostream>
+
+#include "include/testmain.h"
+
+#include <private/eventsequence.h>
+#include <noson/sonosplayer.h>
+
+#include <string>
+
+TEST_CASE("Tracking the sequence of the events")
+{
+  SONOS::EventSequence sequence;
+  std::string sid;
+  unsigned seq = 0;
+  REQUIRE(!sequence.IsSynced());
+
+  // the first event of a subscription syncs the state
+  REQUIRE(sequence.Check(sid, seq, "uuid:1", 0));
+  REQUIRE(sid == "uuid:1");
+  REQUIRE(sequence.IsSynced());
+  REQUIRE(!sequence.Resubscribe(0));
+  REQUIRE(sequence.Check(sid, seq, "uuid:1", 1));
+  REQUIRE(sequence.Check(sid, seq, "uuid:1", 2));
+  REQUIRE(seq == 2);
+  REQUIRE(sequence.IsSynced());
+
+  // an outdated event is discarded
+  REQUIRE(!sequence.Check(sid, seq, "uuid:1", 1));
+  REQUIRE(seq == 2);
+  REQUIRE(sequence.IsSynced());
+
+  // a gap leaves the state stale
+  REQUIRE(sequence.Check(sid, seq, "uuid:1", 5));
+  REQUIRE(seq == 5);
+  REQUIRE(!sequence.IsSynced());
+  REQUIRE(sequence.Check(sid, seq, "uuid:1", 6));
+  REQUIRE(!sequence.IsSynced());
+
+  // a new subscription syncs it again
+  REQUIRE(sequence.Check(sid, seq, "uuid:2", 0));
+  REQUIRE(sid == "uuid:2");
+  REQUIRE(seq == 0);
+  REQUIRE(sequence.IsSynced());
+}
+
+TEST_CASE("Resubscribing with back-off when the first event is missed")
+{
+  SONOS::EventSequence sequence;
+  std::string sid;
+  unsigned seq = 0;
+
+  // the first event seen for the subscription is past its first one
+  REQUIRE(sequence.Check(sid, seq, "uuid:1", 1));
+  REQUIRE(!sequence.IsSynced());
+  int64_t now = 100000;
+  REQUIRE(sequence.Resubscribe(now));
+  REQUIRE(!sequence.Resubscribe(now + 1));
+
+  // the next one is missed again: asked once per doubled delay
+  REQUIRE(sequence.Check(sid, seq, "uuid:2", 1));
+  REQUIRE(!sequence.Resubscribe(now + EVENTSEQUENCE_RESYNC_DELAY - 1));
+  REQUIRE(sequence.Resubscribe(now + EVENTSEQUENCE_RESYNC_DELAY));
+  now += EVENTSEQUENCE_RESYNC_DELAY;
+  REQUIRE(!sequence.Resubscribe(now + 2 * EVENTSEQUENCE_RESYNC_DELAY - 1));
+  REQUIRE(sequence.Resubscribe(now + 2 * EVENTSEQUENCE_RESYNC_DELAY));
+
+  // once synced the delay is reset
+  REQUIRE(sequence.Check(sid, seq, "uuid:3", 0));
+  REQUIRE(!sequence.Resubscribe(now));
+  REQUIRE(sequence.Check(sid, seq, "uuid:3", 3));
+  REQUIRE(sequence.Resubscribe(now + 1000000));
+  REQUIRE(!sequence.Resubscribe(now + 1000000 + EVENTSEQUENCE_RESYNC_DELAY - 1));
+  REQUIRE(sequence.Resubscribe(now + 1000000 + EVENTSEQUENCE_RESYNC_DELAY));
+}
+
+TEST_CASE("Counting the hits and misses of the evented state")
+{
+  SONOS::ZonePlayerPtr zp(new SONOS::ZonePlayer("test"));
+  zp->SetAttribut(ZP_UUID, "RINCON_TEST");
+  zp->SetAttribut(ZP_LOCATION, "http://127.0.0.1:1/xml/device_description.xml");
+  SONOS::Player player(zp);
+  REQUIRE(player.IsValid());
+  unsigned hits = 0, misses = 0;
+  uint8_t volume;
+
+  // not counted while disabled
+  player.GetVolume("RINCON_TEST", &volume);
+  player.GetCacheStats(&hits, &misses);
+  REQUIRE(hits == 0);
+  REQUIRE(misses == 0);
+
+  // without any event the device is requested
+  player.SetCacheFirst(true);
+  player.GetVolume("RINCON_TEST", &volume);
+  SONOS::ElementList vars;
+  player.GetTransportInfo(vars);
+  player.GetCacheStats(&hits, &misses);
+  REQUIRE(hits == 0);
+  REQUIRE(misses == 2);
+
+  // an unknown member is not looked up
+  REQUIRE(!player.GetVolume("RINCON_OTHER", &volume));
+  player.GetCacheStats(&hits, &misses);
+  REQUIRE(misses == 2);
+}
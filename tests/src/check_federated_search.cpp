@@ -0,0 +1,126 @@
+#include <iostream>
+
+#include "include/testmain.h"
+
+#include <private/federatedstate.h>
+#include <private/os/threads/threadpool.h>
+
+#include <atomic>
+#include <chrono>
+#include <thread>
+
+typedef SHARED_PTR<SONOS::FederatedSearch::State> StatePtr;
+
+class FakeSource : public SONOS::OS::CWorker
+{
+public:
+  FakeSource(const StatePtr& state, unsigned index, unsigned delay, std::atomic<int>* started = nullptr)
+  : m_state(state), m_index(index), m_delay(delay), m_started(started) { }
+
+  void Process() override
+  {
+    if (!m_state->Begin(m_index))
+      return;
+    if (m_started)
+      m_started->fetch_add(1);
+    std::this_thread::sleep_for(std::chrono::milliseconds(m_delay));
+    SONOS::FederatedResult result;
+    result.status = SONOS::FederatedResult::Succeeded;
+    result.category.assign("tracks");
+    result.totalCount = m_index;
+    m_state->Push(m_index, result);
+    m_state->Finish(m_index);
+  }
+
+private:
+  StatePtr m_state;
+  unsigned m_index;
+  unsigned m_delay;
+  std::atomic<int>* m_started;
+};
+
+TEST_CASE("Delivering the results of the sources")
+{
+  SONOS::FederatedSearchPool pool(2, 1);
+  StatePtr state(new SONOS::FederatedSearch::State(pool));
+  state->AddSource("a", SONOS::SMServicePtr(), 5000);
+  state->AddSource("b", SONOS::SMServicePtr(), 5000);
+  REQUIRE(pool.Enqueue(new FakeSource(state, 0, 10)));
+  REQUIRE(pool.Enqueue(new FakeSource(state, 1, 10)));
+
+  SONOS::FederatedResult result;
+  unsigned found = 0;
+  while (state->Next(result, 2000))
+  {
+    REQUIRE(result.status == SONOS::FederatedResult::Succeeded);
+    found |= 1 << result.totalCount;
+  }
+  REQUIRE(found == 3);
+  REQUIRE(state->IsComplete());
+}
+
+TEST_CASE("Expiring the sources queued past their deadline")
+{
+  // one thread: the second source is queued behind the first
+  SONOS::FederatedSearchPool pool(1, 1);
+  StatePtr state(new SONOS::FederatedSearch::State(pool));
+  std::atomic<int> started(0);
+  state->AddSource("a", SONOS::SMServicePtr(), 5000);
+  state->AddSource("b", SONOS::SMServicePtr(), 100);
+  REQUIRE(pool.Enqueue(new FakeSource(state, 0, 400, &started)));
+  REQUIRE(pool.Enqueue(new FakeSource(state, 1, 0, &started)));
+
+  auto start = std::chrono::steady_clock::now();
+  SONOS::FederatedResult result;
+  REQUIRE(state->Next(result, 2000));
+  auto elapsed = std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now() - start).count();
+  REQUIRE(result.status == SONOS::FederatedResult::TimedOut);
+  REQUIRE(elapsed < 400);
+  REQUIRE(state->Next(result, 2000));
+  REQUIRE(result.status == SONOS::FederatedResult::Succeeded);
+  REQUIRE(result.totalCount == 0);
+  REQUIRE(!state->Next(result, 100));
+  // the work of the expired source is dropped when dequeued
+  std::this_thread::sleep_for(std::chrono::milliseconds(100));
+  REQUIRE(started.load() == 1);
+}
+
+TEST_CASE("Bounding the threads held by a source")
+{
+  SONOS::FederatedSearchPool pool(4, 1);
+  std::atomic<int> started(0);
+  // a previous search still runs the source x
+  StatePtr previous(new SONOS::FederatedSearch::State(pool));
+  previous->AddSource("x", SONOS::SMServicePtr(), 100);
+  REQUIRE(pool.Enqueue(new FakeSource(previous, 0, 500, &started)));
+  while (started.load() == 0)
+    std::this_thread::sleep_for(std::chrono::milliseconds(1));
+  previous->Abort();
+
+  StatePtr state(new SONOS::FederatedSearch::State(pool));
+  state->AddSource("x", SONOS::SMServicePtr(), 5000);
+  state->AddSource("y", SONOS::SMServicePtr(), 5000);
+  REQUIRE(pool.Enqueue(new FakeSource(state, 0, 0, &started)));
+  REQUIRE(pool.Enqueue(new FakeSource(state, 1, 0, &started)));
+
+  auto start = std::chrono::steady_clock::now();
+  SONOS::FederatedResult result;
+  unsigned failed = 0, succeeded = 0;
+  while (state->Next(result, 2000))
+  {
+    if (result.status == SONOS::FederatedResult::Failed)
+      ++failed;
+    else if (result.status == SONOS::FederatedResult::Succeeded && result.totalCount == 1)
+      ++succeeded;
+  }
+  auto elapsed = std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now() - start).count();
+  // x is reported busy at once, without waiting for the previous search
+  REQUIRE(failed == 1);
+  REQUIRE(succeeded == 1);
+  REQUIRE(elapsed < 400);
+
+  // once released, the source runs again
+  std::this_thread::sleep_for(std::chrono::milliseconds(500));
+  REQUIRE(pool.Acquire("x"));
+  pool.Release("x");
+}
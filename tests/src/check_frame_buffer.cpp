@@ -0,0 +1,139 @@
+#include <iostream>
+
+#include "include/testmain.h"
+#include "include/allocount.h"
+
+#include <noson/framebuffer.h>
+#include <private/os/threads/threadpool.h>
+
+#include <cstring>
+#include <string>
+#include <atomic>
+
+static std::string _read(SONOS::FrameBuffer& buffer)
+{
+  SONOS::FramePacket * p = buffer.read();
+  if (!p)
+    return std::string();
+  std::string s(p->data, p->size);
+  buffer.freePacket(p);
+  return s;
+}
+
+TEST_CASE("Reading the packets in order")
+{
+  SONOS::FrameBuffer buffer(4);
+  REQUIRE(buffer.bytesUnread() == 0);
+  REQUIRE(buffer.bytesAvailable() == 0);
+  REQUIRE(buffer.write("one", 3) == 3);
+  REQUIRE(buffer.write("three", 5) == 5);
+  REQUIRE(buffer.bytesUnread() == 8);
+  REQUIRE(buffer.bytesAvailable() == 3);
+  REQUIRE(buffer.bytesUnread() == 8);
+  REQUIRE(_read(buffer) == "one");
+  REQUIRE(buffer.bytesAvailable() == 5);
+  REQUIRE(_read(buffer) == "three");
+  REQUIRE(_read(buffer).empty());
+  REQUIRE(buffer.bytesUnread() == 0);
+}
+
+TEST_CASE("Overwriting the oldest packets")
+{
+  SONOS::FrameBuffer buffer(4);
+  for (int i = 0; i < 4; ++i)
+    buffer.write(std::to_string(i).c_str(), 1);
+  REQUIRE(buffer.full() == true);
+  buffer.write("45", 2);
+  buffer.write("67", 2);
+  REQUIRE(buffer.full() == true);
+  REQUIRE(buffer.bytesUnread() == 6);
+  REQUIRE(_read(buffer) == "2");
+  REQUIRE(buffer.full() == false);
+  REQUIRE(_read(buffer) == "3");
+  REQUIRE(_read(buffer) == "45");
+  REQUIRE(_read(buffer) == "67");
+  REQUIRE(buffer.bytesUnread() == 0);
+  buffer.write("8", 1);
+  buffer.clear();
+  REQUIRE(buffer.bytesUnread() == 0);
+  REQUIRE(_read(buffer).empty());
+}
+
+namespace
+{
+  class Producer : public SONOS::OS::CWorker
+  {
+  public:
+    Producer(SONOS::FrameBuffer& buffer, unsigned count, std::atomic<bool>& done)
+    : m_buffer(buffer), m_count(count), m_done(done) { }
+    void Process() override
+    {
+      for (unsigned i = 0; i < m_count; ++i)
+      {
+        char data[64];
+        int len = 4 + (i % 60);
+        memset(data, (char)i, len);
+        memcpy(data, &i, sizeof(i));
+        m_buffer.write(data, len);
+      }
+      m_done = true;
+    }
+  private:
+    SONOS::FrameBuffer& m_buffer;
+    unsigned m_count;
+    std::atomic<bool>& m_done;
+  };
+}
+
+TEST_CASE("Sharing the buffer between two threads")
+{
+  const unsigned count = 200000;
+  SONOS::FrameBuffer buffer(16);
+  std::atomic<bool> done(false);
+  SONOS::OS::CThreadPool pool(1);
+  REQUIRE(pool.Enqueue(new Producer(buffer, count, done)) == true);
+  unsigned last = 0, received = 0;
+  bool ordered = true, intact = true;
+  for (;;)
+  {
+    SONOS::FramePacket * p = buffer.read();
+    if (!p)
+    {
+      if (done && buffer.bytesUnread() == 0)
+        break;
+      continue;
+    }
+    unsigned i;
+    memcpy(&i, p->data, sizeof(i));
+    if (received && i <= last)
+      ordered = false;
+    if (p->size != 4 + (int)(i % 60) || (p->size > 4 && p->data[p->size - 1] != (char)i))
+      intact = false;
+    last = i;
+    ++received;
+    buffer.freePacket(p);
+  }
+  REQUIRE(ordered == true);
+  REQUIRE(intact == true);
+  REQUIRE(last == count - 1);
+  REQUIRE(buffer.bytesUnread() == 0);
+}
+
+TEST_CASE("Streaming without allocation after warm-up")
+{
+  SONOS::FrameBuffer buffer(8);
+  char data[512];
+  memset(data, 0, sizeof(data));
+  unsigned allocs = 0;
+  for (int i = 0; i < 1000; ++i)
+  {
+    if (i == 100)
+      allocs = AllocCount();
+    // variable sizes, overwriting when the reader is late
+    buffer.write(data, (i % 7 == 3 ? (int)sizeof(data) : 1 + (i * 37) % (int)sizeof(data)));
+    SONOS::FramePacket * p;
+    if (i % 3 && (p = buffer.read()))
+      buffer.freePacket(p);
+  }
+  REQUIRE(AllocCount() == allocs);
+}
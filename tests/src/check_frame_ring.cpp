@@ -0,0 +1,197 @@
+#include <iostream>
+
+#include "include/testmain.h"
+#include "include/allocount.h"
+
+#include <noson/framering.h>
+#include <private/os/threads/threadpool.h>
+
+#include <cstring>
+#include <string>
+#include <atomic>
+#include <thread>
+#include <chrono>
+
+class TestRing : public SONOS::FrameRing
+{
+public:
+  TestRing(int frames) : SONOS::FrameRing(frames) { }
+  int push(const std::string& frame) { return write(frame.c_str(), (int)frame.size()); }
+protected:
+  // the header is tagged with 'H'
+  bool isHeader(const char * data, int len) const override { return len > 0 && data[0] == 'H'; }
+};
+
+static std::string _read(SONOS::FrameRing& ring, SONOS::FrameRing::Cursor& cursor, int maxlen)
+{
+  char buf[64];
+  int r = ring.read(cursor, buf, maxlen, 0);
+  return (r > 0 ? std::string(buf, r) : std::string());
+}
+
+TEST_CASE("Sharing the frames between readers")
+{
+  TestRing ring(4);
+  REQUIRE(ring.open(SONOS::IODevice::WriteOnly) == true);
+  SONOS::FrameRing::Cursor a, b;
+  ring.attach(a);
+  REQUIRE(ring.push("H1") == 2);
+  REQUIRE(ring.push("H2") == 2);
+  // no frame yet
+  REQUIRE(_read(ring, a, 64).empty());
+  REQUIRE(ring.push("f1") == 2);
+  ring.attach(b);
+  REQUIRE(ring.push("f2") == 2);
+
+  // the header first, then the frames from the attachment
+  REQUIRE(_read(ring, a, 64) == "H1H2");
+  REQUIRE(_read(ring, a, 64) == "f1");
+  REQUIRE(_read(ring, a, 64) == "f2");
+  REQUIRE(_read(ring, a, 64).empty());
+  REQUIRE(_read(ring, b, 3) == "H1H");
+  REQUIRE(_read(ring, b, 3) == "2");
+  REQUIRE(_read(ring, b, 64) == "f2");
+  REQUIRE(ring.bytesAvailable() == 4);
+  ring.close();
+  char buf[8];
+  REQUIRE(ring.read(a, buf, sizeof(buf), 0) == -1);
+}
+
+TEST_CASE("Skipping the frames lost by a slow reader")
+{
+  TestRing ring(4);
+  ring.open(SONOS::IODevice::WriteOnly);
+  SONOS::FrameRing::Cursor slow, fast;
+  ring.attach(slow);
+  ring.attach(fast);
+  ring.push("H");
+  for (int i = 0; i < 10; ++i)
+  {
+    ring.push(std::string("frame") + std::to_string(i));
+    // the fast reader reads part of each frame, then the rest
+    REQUIRE(_read(ring, fast, 64) == (i == 0 ? "H" : std::string("frame") + std::to_string(i)));
+    if (i == 0)
+      REQUIRE(_read(ring, fast, 3) == "fra");
+    if (i == 0)
+      REQUIRE(_read(ring, fast, 64) == "me0");
+  }
+  REQUIRE(fast.dropped == 0);
+  // the slow reader lost the 6 frames overwritten
+  REQUIRE(_read(ring, slow, 64) == "H");
+  REQUIRE(_read(ring, slow, 64) == "frame6");
+  REQUIRE(slow.dropped == 6);
+  REQUIRE(_read(ring, slow, 64) == "frame7");
+  REQUIRE(ring.bytesAvailable() == 24);
+}
+
+TEST_CASE("Filling the frame lost in progress by a slow reader")
+{
+  TestRing ring(2);
+  ring.open(SONOS::IODevice::WriteOnly);
+  SONOS::FrameRing::Cursor slow;
+  ring.attach(slow);
+  ring.push("frame0");
+  REQUIRE(_read(ring, slow, 2) == "fr");
+  ring.push("frame1");
+  ring.push("frame2");
+  ring.push("frame3");
+  // the rest of the overwritten frame is zeros, then the next frame is whole
+  REQUIRE(_read(ring, slow, 3) == std::string(3, '\0'));
+  REQUIRE(_read(ring, slow, 64) == std::string(1, '\0'));
+  REQUIRE(_read(ring, slow, 64) == "frame2");
+  REQUIRE(slow.dropped == 2);
+}
+
+namespace
+{
+  class Reader : public SONOS::OS::CWorker
+  {
+  public:
+    Reader(SONOS::FrameRing& ring, unsigned count, std::atomic<unsigned>& served, std::atomic<unsigned>& finished)
+    : m_ring(ring), m_count(count), m_served(served), m_finished(finished)
+    {
+      m_ring.attach(m_cursor);
+    }
+    void Process() override
+    {
+      unsigned received = 0;
+      char buf[64];
+      while (received < m_count && m_ring.read(m_cursor, buf, sizeof(buf), 5000) > 0)
+        ++received;
+      if (received == m_count)
+        ++m_served;
+      ++m_finished;
+    }
+  private:
+    SONOS::FrameRing& m_ring;
+    SONOS::FrameRing::Cursor m_cursor;
+    unsigned m_count;
+    std::atomic<unsigned>& m_served;
+    std::atomic<unsigned>& m_finished;
+  };
+}
+
+TEST_CASE("Waking up all the waiting readers")
+{
+  const unsigned readers = 8;
+  const unsigned count = 50;
+  TestRing ring(64);
+  ring.open(SONOS::IODevice::WriteOnly);
+  std::atomic<unsigned> served(0), finished(0);
+  SONOS::OS::CThreadPool pool(readers);
+  for (unsigned i = 0; i < readers; ++i)
+    REQUIRE(pool.Enqueue(new Reader(ring, count, served, finished)) == true);
+  for (unsigned i = 0; i < count; ++i)
+  {
+    std::this_thread::sleep_for(std::chrono::milliseconds(10));
+    ring.push(std::string("frame") + std::to_string(i));
+  }
+  // every reader gets the last frame before the closing
+  for (int i = 0; i < 100 && finished < readers; ++i)
+    std::this_thread::sleep_for(std::chrono::milliseconds(10));
+  ring.close();
+  while (finished < readers)
+    std::this_thread::sleep_for(std::chrono::milliseconds(10));
+  REQUIRE(served == readers);
+}
+
+TEST_CASE("Starting a late reader with the backlog")
+{
+  TestRing ring(4);
+  ring.open(SONOS::IODevice::WriteOnly);
+  ring.push("H");
+  for (int i = 0; i < 6; ++i)
+    ring.push(std::string("frame") + std::to_string(i));
+
+  SONOS::FrameRing::Cursor live, late;
+  ring.attach(live, 0);
+  REQUIRE(_read(ring, live, 64) == "H");
+  REQUIRE(_read(ring, live, 64).empty());
+  // the backlog is bounded by the frames kept in the ring
+  ring.attach(late, 60000);
+  REQUIRE(_read(ring, late, 64) == "H");
+  REQUIRE(_read(ring, late, 64) == "frame2");
+  REQUIRE(_read(ring, late, 64) == "frame3");
+  REQUIRE(late.dropped == 0);
+}
+
+TEST_CASE("Streaming without allocation after warm-up")
+{
+  TestRing ring(8);
+  ring.open(SONOS::IODevice::WriteOnly);
+  SONOS::FrameRing::Cursor cursor;
+  ring.attach(cursor);
+  ring.push("H");
+  std::string frame(512, 'f');
+  unsigned allocs = 0;
+  for (int i = 0; i < 1000; ++i)
+  {
+    if (i == 100)
+      allocs = AllocCount();
+    // the largest frame comes first, then the slots grow once
+    ring.write(frame.c_str(), (i % 7 == 3 ? (int)frame.size() : 1 + (i * 37) % (int)frame.size()));
+    char buf[1024];
+    ring.read(cursor, buf, sizeof(buf), 0);
+  }
+  REQUIRE(AllocCount() == allocs);
+}
@@ -0,0 +1,63 @@
+#include <iostream>
+
+#include "include/testmain.h"
+
+#include <private/groupbalance.h>
+
+#include <string>
+#include <vector>
+
+TEST_CASE("Scaling the volumes of a group")
+{
+  // the balance is kept
+  REQUIRE(SONOS::GroupBalance::ScaleVolume(20, 60, 2, 30) == 20);
+  REQUIRE(SONOS::GroupBalance::ScaleVolume(40, 60, 2, 30) == 40);
+  REQUIRE(SONOS::GroupBalance::ScaleVolume(20, 60, 2, 60) == 40);
+  REQUIRE(SONOS::GroupBalance::ScaleVolume(40, 60, 2, 60) == 80);
+  // rounded to the nearest
+  REQUIRE(SONOS::GroupBalance::ScaleVolume(10, 30, 3, 11) == 11);
+  REQUIRE(SONOS::GroupBalance::ScaleVolume(1, 3, 2, 1) == 1);
+  // clamped to the maximum
+  REQUIRE(SONOS::GroupBalance::ScaleVolume(90, 100, 2, 80) == 100);
+  // silenced
+  REQUIRE(SONOS::GroupBalance::ScaleVolume(20, 60, 2, 0) == 0);
+  // from silence all members join the same level
+  REQUIRE(SONOS::GroupBalance::ScaleVolume(0, 0, 2, 25) == 25);
+}
+
+TEST_CASE("Restoring the balance of a silenced group")
+{
+  SONOS::GroupBalance balance;
+  std::vector<std::string> members;
+  members.push_back("RINCON_A");
+  members.push_back("RINCON_B");
+  std::vector<int> volumes;
+  volumes.push_back(20);
+  volumes.push_back(40);
+
+  // nothing saved
+  std::vector<int> loaded(2, 0);
+  REQUIRE(balance.Load(members, loaded) == 0);
+  REQUIRE(loaded[0] == 0);
+
+  balance.Save(members, volumes);
+  REQUIRE(balance.Load(members, loaded) == 60);
+  REQUIRE(loaded[0] == 20);
+  REQUIRE(loaded[1] == 40);
+  // the saved balance is restored at the new level
+  REQUIRE(SONOS::GroupBalance::ScaleVolume(loaded[0], 60, loaded.size(), 15) == 10);
+  REQUIRE(SONOS::GroupBalance::ScaleVolume(loaded[1], 60, loaded.size(), 15) == 20);
+
+  // the group has changed since
+  members.push_back("RINCON_C");
+  std::vector<int> current(3, 0);
+  REQUIRE(balance.Load(members, current) == 0);
+  REQUIRE(current[2] == 0);
+
+  // saved silent
+  members.pop_back();
+  volumes.assign(2, 0);
+  balance.Save(members, volumes);
+  REQUIRE(balance.Load(members, loaded) == 0);
+  REQUIRE(loaded[1] == 40);
+}
@@ -0,0 +1,152 @@
+#include <iostream>
+
+#include "include/testmain.h"
+#include "include/sample_pcm_s16le.c"
+
+#include <noson/audioformat.h>
+#include <noson/lpcmencoder.h>
+#include <private/pcmconvert.h>
+
+#include <cstdlib>
+#include <cstring>
+#include <vector>
+#include <algorithm>
+
+static void _flush_encoded_data(SONOS::AudioEncoder * encoder, std::vector<char>& out)
+{
+  char buf[1024];
+  int w = 0;
+  // check for available encoded data and flush out
+  while ((w = encoder->bytesAvailable()) > 0)
+  {
+    if ((w = encoder->read(buf, sizeof(buf), 0/*forever*/)) > 0)
+      out.insert(out.end(), buf, buf + w);
+  }
+}
+
+static std::vector<char> _encode(SONOS::LPCMEncoder * encoder, const char * data, size_t len, size_t chunk)
+{
+  std::vector<char> out;
+  REQUIRE(encoder->open() == true);
+  REQUIRE(encoder->open() == false);
+  const char * p = data;
+  const char * e = data + len;
+  while (p < e)
+  {
+    size_t s = chunk;
+    if ((p + s) > e)
+      s = e - p;
+    int r = encoder->write(p, s);
+    if (r <= 0)
+      break;
+    p += r;
+    _flush_encoded_data(encoder, out);
+  }
+  REQUIRE(p == e);
+  encoder->close();
+  _flush_encoded_data(encoder, out);
+  return out;
+}
+
+TEST_CASE("Framing PCM s16le as WAV")
+{
+  SONOS::LPCMEncoder * encoder = new SONOS::LPCMEncoder(256);
+  encoder->setAudioFormat(SONOS::AudioFormat::CDLPCM());
+  encoder->setBlockSize(576);
+  REQUIRE(encoder->mediaType() == "audio/wav");
+
+  // the length of the sample is a multiple of the frame size
+  size_t len = pcm_s16le_raw_len - (pcm_s16le_raw_len % 4);
+  std::vector<char> out = _encode(encoder, (const char*)pcm_s16le_raw, len, 1000);
+
+  REQUIRE(out.size() == len + 44);
+  REQUIRE(memcmp(out.data(), "RIFF\xff\xff\xff\xffWAVEfmt ", 16) == 0);
+  // PCM, 2 channels, 44100 Hz, 176400 bytes/s, 4 bytes/frame, 16 bits
+  REQUIRE(memcmp(out.data() + 20, "\x01\x00\x02\x00\x44\xac\x00\x00\x10\xb1\x02\x00\x04\x00\x10\x00", 16) == 0);
+  REQUIRE(memcmp(out.data() + 36, "data\xff\xff\xff\xff", 8) == 0);
+  REQUIRE(memcmp(out.data() + 44, pcm_s16le_raw, len) == 0);
+
+  // reopening starts a new stream
+  out = _encode(encoder, (const char*)pcm_s16le_raw, 4096, 4096);
+  REQUIRE(out.size() == 4096 + 44);
+
+  delete encoder;
+}
+
+TEST_CASE("Framing PCM s16le as L16")
+{
+  SONOS::LPCMEncoder::Framing framing = SONOS::LPCMEncoder::WAV;
+  REQUIRE(SONOS::LPCMEncoder::framingByName("l16", &framing) == true);
+  REQUIRE(framing == SONOS::LPCMEncoder::L16);
+  REQUIRE(SONOS::LPCMEncoder::framingByName("mp3", &framing) == false);
+
+  SONOS::LPCMEncoder * encoder = new SONOS::LPCMEncoder(256);
+  encoder->setAudioFormat(SONOS::AudioFormat::CDLPCM());
+  encoder->setFraming(framing);
+  REQUIRE(encoder->mediaType() == "audio/L16;rate=44100;channels=2");
+
+  size_t len = pcm_s16le_raw_len - (pcm_s16le_raw_len % 4);
+  std::vector<char> out = _encode(encoder, (const char*)pcm_s16le_raw, len, 1000);
+
+  // no header, and the samples are big-endian
+  REQUIRE(out.size() == len);
+  for (size_t i = 0; i < len; i += 2)
+  {
+    REQUIRE(out[i] == (char)pcm_s16le_raw[i + 1]);
+    REQUIRE(out[i + 1] == (char)pcm_s16le_raw[i]);
+  }
+
+  // unsigned 8 bits cannot be framed as L16
+  SONOS::AudioFormat format = SONOS::AudioFormat::CDLPCM();
+  format.sampleSize = 8;
+  format.sampleType = SONOS::AudioFormat::UnSignedInt;
+  encoder->setAudioFormat(format);
+  REQUIRE(encoder->open() == false);
+
+  delete encoder;
+}
+
+TEST_CASE("Swapping the byte order of PCM")
+{
+  static const int sizes[] = { 16, 24, 32 };
+  static const char * kernels[] = { "sse2", "avx2", "neon" };
+  const int count = 4099; // not a multiple of the vector size
+  std::vector<char> data(count * 4 + 1);
+  srand(1234);
+  for (size_t i = 0; i < data.size(); ++i)
+    data[i] = (char)(rand() & 0xff);
+
+  for (int size : sizes)
+  {
+    const int bytes = size / 8;
+    std::vector<char> expected(count * bytes);
+    std::vector<char> out(count * bytes);
+    // from an unaligned address
+    const char * p = &data[1];
+    switch (size)
+    {
+    case 16: SONOS::PCMByteSwapScalar<16>(p, expected.data(), count); break;
+    case 24: SONOS::PCMByteSwapScalar<24>(p, expected.data(), count); break;
+    case 32: SONOS::PCMByteSwapScalar<32>(p, expected.data(), count); break;
+    }
+    REQUIRE(expected[0] == p[bytes - 1]);
+    REQUIRE(expected[bytes - 1] == p[0]);
+    REQUIRE(SONOS::SelectPCMByteSwap(size) != nullptr);
+    for (const char * name : kernels)
+    {
+      SONOS::PCMByteSwap swap = SONOS::GetPCMByteSwap(size, name);
+      if (!swap)
+        continue;
+      // all lengths of the tail
+      for (int n = count - 33; n <= count; ++n)
+      {
+        std::fill(out.begin(), out.end(), (char)0x5a);
+        swap(p, out.data(), n);
+        REQUIRE(std::equal(out.begin(), out.begin() + n * bytes, expected.begin()));
+        // nothing written past the end
+        if (n < count)
+          REQUIRE(out[n * bytes] == (char)0x5a);
+      }
+    }
+  }
+}
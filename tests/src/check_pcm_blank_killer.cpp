@@ -0,0 +1,102 @@
+#include <iostream>
+
+#include "include/testmain.h"
+
+#include <private/pcmblankkiller.h>
+
+#include <cstdint>
+#include <cstring>
+#include <vector>
+
+static std::vector<char> _silence(uint32_t zero, int size, bool bigEndian, int len)
+{
+  std::vector<char> buf(len);
+  for (int i = 0; i < len; ++i)
+  {
+    int b = (bigEndian ? size - 1 - (i % size) : (i % size));
+    buf[i] = (char)((zero >> (8 * b)) & 0xff);
+  }
+  return buf;
+}
+
+TEST_CASE("Detecting the silence")
+{
+  static const char * kernels[] = { "sse2", "avx2", "neon" };
+  static const struct { uint32_t zero; int size; bool bigEndian; } formats[] = {
+    { 0, 1, false }, { 0x80, 1, false }, { 0x8000, 2, false }, { 0x8000, 2, true },
+    { 0x800000, 3, false }, { 0x800000, 3, true }, { 0x80000000, 4, false }, { 0x80000000, 4, true },
+  };
+  REQUIRE(SONOS::SelectPCMIsBlank() != nullptr);
+  REQUIRE(SONOS::GetPCMIsBlank("scalar") == SONOS::PCMIsBlankScalar);
+
+  for (const auto& f : formats)
+  {
+    std::vector<char> pattern = _silence(f.zero, f.size, f.bigEndian, PCMBLANK_PATTERN);
+    for (const char * name : kernels)
+    {
+      SONOS::PCMIsBlank isBlank = SONOS::GetPCMIsBlank(name);
+      if (!isBlank)
+        continue;
+      // all lengths of the tail, and a noise at each position
+      for (int len = 0; len <= 2 * PCMBLANK_PATTERN + 1; ++len)
+      {
+        // from an unaligned address
+        std::vector<char> buf(1, (char)0x5a);
+        std::vector<char> silence = _silence(f.zero, f.size, f.bigEndian, len);
+        buf.insert(buf.end(), silence.begin(), silence.end());
+        REQUIRE(isBlank(buf.data() + 1, len, pattern.data()) == true);
+        for (int i = 0; i < len; ++i)
+        {
+          buf[1 + i] ^= 0x01;
+          REQUIRE(isBlank(buf.data() + 1, len, pattern.data()) == false);
+          REQUIRE(SONOS::PCMIsBlankScalar(buf.data() + 1, len, pattern.data()) == false);
+          buf[1 + i] ^= 0x01;
+        }
+      }
+    }
+  }
+}
+
+TEST_CASE("Killing the blank of each format")
+{
+  static const struct { SONOS::PCMBlankKiller killer; uint32_t zero; int size; bool bigEndian; } formats[] = {
+    { SONOS::PCMBlankKillerU8, 0x80, 1, false },
+    { SONOS::PCMBlankKillerS16LE, 0, 2, false },
+    { SONOS::PCMBlankKillerU16LE, 0x8000, 2, false },
+    { SONOS::PCMBlankKillerS24LE, 0, 3, false },
+    { SONOS::PCMBlankKillerU24LE, 0x800000, 3, false },
+    { SONOS::PCMBlankKillerS32LE, 0, 4, false },
+    { SONOS::PCMBlankKillerU32LE, 0x80000000, 4, false },
+    { SONOS::PCMBlankKillerS16BE, 0, 2, true },
+    { SONOS::PCMBlankKillerU16BE, 0x8000, 2, true },
+    { SONOS::PCMBlankKillerS24BE, 0, 3, true },
+    { SONOS::PCMBlankKillerU24BE, 0x800000, 3, true },
+    { SONOS::PCMBlankKillerS32BE, 0, 4, true },
+    { SONOS::PCMBlankKillerU32BE, 0x80000000, 4, true },
+  };
+  const int channels = 2;
+  const int frames = 256;
+
+  for (const auto& f : formats)
+  {
+    const int len = f.size * channels * frames;
+    const int head = 2 * f.size * channels;
+    const std::vector<char> silence = _silence(f.zero, f.size, f.bigEndian, len);
+
+    // the silence is replaced by a small noise in the first frames
+    std::vector<char> buf(silence);
+    f.killer(buf.data(), channels, frames);
+    REQUIRE(memcmp(buf.data(), silence.data(), head) != 0);
+    REQUIRE(memcmp(buf.data() + head, silence.data() + head, len - head) == 0);
+
+    // a sound is not changed, wherever it is
+    for (int i : { 0, len / 2, len - 1 })
+    {
+      buf = silence;
+      buf[i] ^= 0x01;
+      std::vector<char> sound(buf);
+      f.killer(buf.data(), channels, frames);
+      REQUIRE(buf == sound);
+    }
+  }
+}
@@ -0,0 +1,57 @@
+#include <iostream>
+
+#include "include/testmain.h"
+
+#include <private/pcmconvert.h>
+
+#include <cstdlib>
+#include <vector>
+#include <algorithm>
+
+TEST_CASE("Converting PCM to int32")
+{
+  static const int sizes[] = { 8, 16, 24, 32 };
+  static const char * kernels[] = { "sse2", "avx2", "neon" };
+  const int count = 4099; // not a multiple of the vector size
+  std::vector<char> data(count * 4 + 1);
+  srand(1234);
+  for (size_t i = 0; i < data.size(); ++i)
+    data[i] = (char)(rand() & 0xff);
+  // the extreme values of each format
+  data[1] = data[4] = data[7] = data[10] = (char)0x00;
+  data[2] = data[5] = data[8] = data[11] = (char)0x80;
+  data[13] = data[16] = data[19] = data[22] = (char)0xff;
+  data[14] = data[17] = data[20] = data[23] = (char)0x7f;
+
+  for (int size : sizes)
+  {
+    std::vector<int32_t> expected(count);
+    std::vector<int32_t> pcm(count);
+    // from an unaligned address
+    const char * p = &data[1];
+    switch (size)
+    {
+    case 8: SONOS::PCMToInt32Scalar<8>(p, expected.data(), count); break;
+    case 16: SONOS::PCMToInt32Scalar<16>(p, expected.data(), count); break;
+    case 24: SONOS::PCMToInt32Scalar<24>(p, expected.data(), count); break;
+    case 32: SONOS::PCMToInt32Scalar<32>(p, expected.data(), count); break;
+    }
+    REQUIRE(SONOS::SelectPCMToInt32(size) != nullptr);
+    for (const char * name : kernels)
+    {
+      SONOS::PCMToInt32 convert = SONOS::GetPCMToInt32(size, name);
+      if (!convert)
+        continue;
+      // all lengths of the tail
+      for (int n = count - 33; n <= count; ++n)
+      {
+        std::fill(pcm.begin(), pcm.end(), 0x5a5a5a5a);
+        convert(p, pcm.data(), n);
+        REQUIRE(std::equal(pcm.begin(), pcm.begin() + n, expected.begin()));
+        // nothing written past the end
+        if (n < count)
+          REQUIRE(pcm[n] == 0x5a5a5a5a);
+      }
+    }
+  }
+}
@@ -0,0 +1,101 @@
+#include <iostream>
+
+#include "include/testmain.h"
+
+#include <private/positioncache.h>
+#include <noson/avtransport.h>
+
+#include <string>
+
+static SONOS::ElementList PositionInfo(const char * relTime, const char * duration)
+{
+  SONOS::ElementList vars;
+  vars.push_back(SONOS::ElementPtr(new SONOS::Element("TAG", "GetPositionInfoResponse")));
+  vars.push_back(SONOS::ElementPtr(new SONOS::Element("Track", "1")));
+  vars.push_back(SONOS::ElementPtr(new SONOS::Element("TrackDuration", duration)));
+  vars.push_back(SONOS::ElementPtr(new SONOS::Element("RelTime", relTime)));
+  return vars;
+}
+
+static std::string RelTime(const SONOS::ElementList& vars)
+{
+  SONOS::ElementList::const_iterator it = vars.FindKey("RelTime");
+  return (it != vars.end() ? std::string(**it) : std::string());
+}
+
+TEST_CASE("Parsing and formatting the time")
+{
+  unsigned s = 0;
+  REQUIRE(SONOS::PositionCache::ParseTime("0:00:00", &s));
+  REQUIRE(s == 0);
+  REQUIRE(SONOS::PositionCache::ParseTime("0:03:25", &s));
+  REQUIRE(s == 205);
+  REQUIRE(SONOS::PositionCache::ParseTime("2:01:05", &s));
+  REQUIRE(s == 7265);
+  REQUIRE(!SONOS::PositionCache::ParseTime("NOT_IMPLEMENTED", &s));
+  REQUIRE(!SONOS::PositionCache::ParseTime("", &s));
+  REQUIRE(s == 7265);
+
+  REQUIRE(SONOS::PositionCache::FormatTime(0) == "0:00:00");
+  REQUIRE(SONOS::PositionCache::FormatTime(205) == "0:03:25");
+  REQUIRE(SONOS::PositionCache::FormatTime(7265) == "2:01:05");
+}
+
+TEST_CASE("Extrapolating the elapsed time")
+{
+  SONOS::PositionCache cache;
+  SONOS::ElementList vars;
+  int64_t now = 1000000;
+  REQUIRE(!cache.Load(vars, now));
+
+  // anchored halfway the request
+  REQUIRE(cache.Store(PositionInfo("0:01:00", "0:03:00"), cache.Generation(), now - 200, now, true, true));
+  REQUIRE(cache.Load(vars, now));
+  REQUIRE(RelTime(vars) == "0:01:00");
+  REQUIRE(vars.size() == 4);
+  REQUIRE(cache.Load(vars, now + 10100));
+  REQUIRE(RelTime(vars) == "0:01:10");
+  // until the next resync
+  REQUIRE(!cache.Load(vars, now + AVTRANSPORT_POSITION_RESYNC));
+
+  // clamped at the end of the track, within the overrun
+  REQUIRE(cache.Store(PositionInfo("0:02:50", "0:03:00"), cache.Generation(), now - 200, now, true, true));
+  REQUIRE(cache.Load(vars, now + 11100));
+  REQUIRE(RelTime(vars) == "0:03:00");
+  REQUIRE(cache.Load(vars, now + (10 + AVTRANSPORT_POSITION_OVERRUN) * 1000 + 100));
+  REQUIRE(RelTime(vars) == "0:03:00");
+  // past the overrun the next track should have been signaled
+  REQUIRE(!cache.Load(vars, now + (11 + AVTRANSPORT_POSITION_OVERRUN) * 1000 + 100));
+
+  // paused, or not signaled: the reply as is, not for long
+  REQUIRE(cache.Store(PositionInfo("0:01:00", "0:03:00"), cache.Generation(), now, now, false, true));
+  REQUIRE(cache.Load(vars, now + 900));
+  REQUIRE(RelTime(vars) == "0:01:00");
+  REQUIRE(cache.Store(PositionInfo("0:01:00", "0:03:00"), cache.Generation(), now, now, true, false));
+  REQUIRE(cache.Load(vars, now + 900));
+  REQUIRE(RelTime(vars) == "0:01:00");
+  REQUIRE(!cache.Load(vars, now + 1000));
+
+  // a stream without duration is not clamped
+  REQUIRE(cache.Store(PositionInfo("0:01:00", "0:00:00"), cache.Generation(), now, now, true, true));
+  REQUIRE(cache.Load(vars, now + 20000));
+  REQUIRE(RelTime(vars) == "0:01:20");
+  REQUIRE(!cache.Load(vars, now + AVTRANSPORT_POSITION_RESYNC));
+}
+
+TEST_CASE("Dropping the position on a change of the transport")
+{
+  SONOS::PositionCache cache;
+  SONOS::ElementList vars;
+  int64_t now = 1000000;
+  REQUIRE(cache.Store(PositionInfo("0:01:00", "0:03:00"), cache.Generation(), now, now, true, true));
+  REQUIRE(cache.Load(vars, now));
+  cache.Reset();
+  REQUIRE(!cache.Load(vars, now));
+
+  // the reply of a request made before the change is not stored
+  unsigned generation = cache.Generation();
+  cache.Reset();
+  REQUIRE(!cache.Store(PositionInfo("0:01:00", "0:03:00"), generation, now, now, true, true));
+  REQUIRE(!cache.Load(vars, now));
+}
@@ -0,0 +1,85 @@
+#include <iostream>
+
+#include "include/testmain.h"
+
+#include <private/smapicache.h>
+
+TEST_CASE("Serving the fresh and stale entries")
+{
+  SONOS::SMAPICache cache;
+  SONOS::SMAPIMetadata metadata;
+  bool refresh = true;
+  REQUIRE(cache.Get("p", 1, "k", metadata, refresh) == SONOS::SMAPICache::Miss);
+  REQUIRE(refresh == false);
+
+  cache.Put("p", 1, "k", metadata, 100);
+  REQUIRE(cache.Get("p", 1, "k", metadata, refresh) == SONOS::SMAPICache::Fresh);
+  REQUIRE(refresh == false);
+
+  // expired: served stale, and only the first caller revalidates
+  cache.SetTTL(0, 600);
+  cache.Put("p", 1, "k", metadata, 100);
+  REQUIRE(cache.Get("p", 1, "k", metadata, refresh) == SONOS::SMAPICache::Stale);
+  REQUIRE(refresh == true);
+  REQUIRE(cache.Get("p", 1, "k", metadata, refresh) == SONOS::SMAPICache::Stale);
+  REQUIRE(refresh == false);
+  // a failed revalidation is released for the next caller
+  cache.Abort("k");
+  REQUIRE(cache.Get("p", 1, "k", metadata, refresh) == SONOS::SMAPICache::Stale);
+  REQUIRE(refresh == true);
+  // a revalidated entry is fresh again
+  cache.SetTTL(60, 600);
+  cache.Put("p", 1, "k", metadata, 100);
+  REQUIRE(cache.Get("p", 1, "k", metadata, refresh) == SONOS::SMAPICache::Fresh);
+
+  // beyond the stale period the entry is dropped
+  cache.SetTTL(0, 0);
+  cache.Put("p", 1, "k", metadata, 100);
+  REQUIRE(cache.Get("p", 1, "k", metadata, refresh) == SONOS::SMAPICache::Miss);
+  REQUIRE(cache.Get("p", 1, "k", metadata, refresh) == SONOS::SMAPICache::Miss);
+}
+
+TEST_CASE("Dropping the partition when the auth revision changes")
+{
+  SONOS::SMAPICache cache;
+  SONOS::SMAPIMetadata metadata;
+  bool refresh;
+  cache.Put("p", 1, "k1", metadata, 100);
+  cache.Put("p", 1, "k2", metadata, 100);
+  cache.Put("q", 1, "k3", metadata, 100);
+  // an entry stored with the new revision is kept
+  cache.Put("p", 2, "k4", metadata, 100);
+
+  REQUIRE(cache.Get("p", 2, "k1", metadata, refresh) == SONOS::SMAPICache::Miss);
+  REQUIRE(cache.Get("p", 2, "k2", metadata, refresh) == SONOS::SMAPICache::Miss);
+  REQUIRE(cache.Get("p", 2, "k4", metadata, refresh) == SONOS::SMAPICache::Fresh);
+  REQUIRE(cache.Get("q", 1, "k3", metadata, refresh) == SONOS::SMAPICache::Fresh);
+}
+
+TEST_CASE("Evicting the least recently used entries")
+{
+  SONOS::SMAPICache cache;
+  SONOS::SMAPIMetadata metadata;
+  bool refresh;
+  cache.SetMaxSize(300);
+  cache.Put("p", 1, "k1", metadata, 100);
+  cache.Put("p", 1, "k2", metadata, 100);
+  cache.Put("p", 1, "k3", metadata, 100);
+  // k1 is used again, then k2 is the oldest
+  REQUIRE(cache.Get("p", 1, "k1", metadata, refresh) == SONOS::SMAPICache::Fresh);
+  cache.Put("p", 1, "k4", metadata, 100);
+  REQUIRE(cache.Get("p", 1, "k2", metadata, refresh) == SONOS::SMAPICache::Miss);
+  REQUIRE(cache.Get("p", 1, "k1", metadata, refresh) == SONOS::SMAPICache::Fresh);
+  REQUIRE(cache.Get("p", 1, "k3", metadata, refresh) == SONOS::SMAPICache::Fresh);
+  REQUIRE(cache.Get("p", 1, "k4", metadata, refresh) == SONOS::SMAPICache::Fresh);
+
+  // too large to be stored
+  cache.Put("p", 1, "k5", metadata, 400);
+  REQUIRE(cache.Get("p", 1, "k5", metadata, refresh) == SONOS::SMAPICache::Miss);
+
+  // shrinking evicts the oldest: k1 then k3
+  cache.SetMaxSize(100);
+  REQUIRE(cache.Get("p", 1, "k1", metadata, refresh) == SONOS::SMAPICache::Miss);
+  REQUIRE(cache.Get("p", 1, "k3", metadata, refresh) == SONOS::SMAPICache::Miss);
+  REQUIRE(cache.Get("p", 1, "k4", metadata, refresh) == SONOS::SMAPICache::Fresh);
+}
@@ -7,6 +7,7 @@
 
 #include <noson/element.h>
 #include <noson/didlparser.h>
+#include <noson/musicservices.h>
 #include <private/tinyxml2.h>
 #include <private/xmldict.h>
 
@@ -103,3 +104,135 @@ TEST_CASE("Parse SOAP response 1")
   SONOS::DIDLParser didl2(item->DIDL().c_str());
   REQUIRE(didl2.IsValid() == true);
 }
+
+static std::string _browse_result(const std::string& data)
+{
+  tinyxml2::XMLDocument rootdoc;
+  if (rootdoc.Parse(data.c_str(), data.size()) != tinyxml2::XML_SUCCESS)
+    return std::string();
+  const tinyxml2::XMLElement* elem = rootdoc.RootElement();
+  while (elem && !SONOS::XMLNS::NameEqual(elem->Name(), "Result"))
+  {
+    if (elem->FirstChildElement())
+      elem = elem->FirstChildElement();
+    else
+      elem = elem->NextSiblingElement();
+  }
+  return (elem && elem->GetText() ? elem->GetText() : "");
+}
+
+TEST_CASE("Compact storage of DIDL items")
+{
+  const std::string data((const char*)soap_response_1_html, soap_response_1_html_len);
+  const std::string result = _browse_result(data);
+  REQUIRE(result.substr(0, 10) == "<DIDL-Lite");
+
+  SONOS::DIDLParser didl(result.c_str());
+  REQUIRE(didl.IsValid() == true);
+  REQUIRE(didl.GetItems().size() == 24);
+
+  SONOS::DigitalItemPtr item = didl.GetItems()[21];
+  REQUIRE(item->IsItem() == true);
+  REQUIRE(item->subType() == SONOS::DigitalItem::SubType_audioItem);
+  REQUIRE(item->GetObjectID() == "Q:0/22");
+
+  // read values from the compact storage
+  std::string value;
+  REQUIRE(item->FindValue("dc:title", value) == true);
+  REQUIRE(value == "Embryons desséchés : De Podophthalma");
+  REQUIRE(item->FindValue("upnp:originalTrackNumber", value) == true);
+  REQUIRE(value == "22");
+  REQUIRE(item->FindValue("dc:date", value) == false);
+
+  // the elements read are built on first access, and kept with the item
+  SONOS::ElementPtr res = item->GetProperty("res");
+  REQUIRE(res);
+  REQUIRE(res->GetAttribut("protocolInfo") == "x-file-cifs:*:audio/flac:*");
+  REQUIRE(item->GetProperty("res").get() == res.get());
+  const std::string& title = item->GetValue("dc:title");
+  REQUIRE(title == "Embryons desséchés : De Podophthalma");
+  REQUIRE(&item->GetValue("dc:title") == &title);
+  REQUIRE(item->GetValue("dc:date").empty());
+  REQUIRE(item->GetCollection("dc:creator").size() == 1);
+  REQUIRE(item->GetElements().size() == 7);
+  REQUIRE(item->GetElements()[0].get() == res.get());
+
+  // a change builds the other elements
+  item->SetProperty("dc:title", "Embryons desséchés");
+  REQUIRE(item->FindValue("dc:title", value) == true);
+  REQUIRE(value == "Embryons desséchés");
+  REQUIRE(item->GetValue("dc:title") == "Embryons desséchés");
+  REQUIRE(item->GetProperty("res").get() == res.get());
+  REQUIRE(item->GetElements().size() == 7);
+
+  SONOS::DigitalItem clone;
+  didl.GetItems()[0]->Clone(clone);
+  REQUIRE(clone.GetObjectID() == didl.GetItems()[0]->GetObjectID());
+  REQUIRE(clone.DIDL() == didl.GetItems()[0]->DIDL());
+}
+
+TEST_CASE("XML encoding")
+{
+  // hits at every position of the vector blocks and the tail
+  for (unsigned len = 0; len < 48; ++len)
+  {
+    for (unsigned pos = 0; pos < len; ++pos)
+    {
+      std::string str(len, 'a');
+      std::string expected(len, 'a');
+      str[pos] = '&';
+      expected.replace(pos, 1, "&amp;");
+      REQUIRE(SONOS::Element("k", str).XMLEncoded() == expected);
+    }
+  }
+  REQUIRE(SONOS::Element("k", "<a href=\"x\">Tom & Jerry</a>").XMLEncoded() ==
+          "&lt;a href=&quot;x&quot;&gt;Tom &amp; Jerry&lt;/a&gt;");
+  REQUIRE(SONOS::Element("k", "Embryons desséchés").XMLEncoded() == "Embryons desséchés");
+
+  SONOS::Element elem("dc:title", "A & B");
+  elem.SetAttribut("id", "\"1\"");
+  REQUIRE(elem.XML() == "<dc:title id=\"&quot;1&quot;\">A &amp; B</dc:title>");
+  std::string buf("<x>");
+  elem.XML(buf);
+  REQUIRE(buf == "<x><dc:title id=\"&quot;1&quot;\">A &amp; B</dc:title>");
+
+  // the DIDL written from the compact storage is the same as from the elements
+  const std::string data((const char*)soap_response_1_html, soap_response_1_html_len);
+  const std::string result = _browse_result(data);
+  SONOS::DIDLParser didl1(result.c_str());
+  SONOS::DIDLParser didl2(result.c_str());
+  REQUIRE(didl1.GetItems().size() == didl2.GetItems().size());
+  for (size_t i = 0; i < didl1.GetItems().size(); ++i)
+  {
+    didl2.GetItems()[i]->RemoveProperty("dc:date");
+    REQUIRE(didl1.GetItems()[i]->DIDL() == didl2.GetItems()[i]->DIDL());
+  }
+}
+
+TEST_CASE("Splitting the list of music services")
+{
+  const std::string xml =
+      "<?xml version=\"1.0\"?>"
+      "<Services SchemaVersion=\"1\">"
+      "<Service Capabilities=\"513\" Id = \"254\" Name=\"TuneIn\" Version=\"1.1\">"
+      "<Policy Auth=\"Anonymous\" PollInterval=\"30\"/>"
+      "</Service>"
+      "<Service Name=\"Deezer &amp; co\"\n  Id\n=\n'&#50;&#x35;9' Version=\"1.1\"/>"
+      "<ServiceX Id=\"1\"/>"
+      "<Service Name=\"Spotify\" Id=\"12\"></Service>"
+      "</Services>";
+  std::vector<std::pair<std::string, std::string> > data;
+  REQUIRE(SONOS::MusicServices::SplitAvailableServices(xml, data));
+  REQUIRE(data.size() == 3);
+  REQUIRE(data[0].first == "254");
+  REQUIRE(data[0].second.substr(0, 9) == "<Service ");
+  REQUIRE(data[0].second.substr(data[0].second.size() - 10) == "</Service>");
+  REQUIRE(data[1].first == "259");
+  REQUIRE(data[1].second.substr(data[1].second.size() - 2) == "/>");
+  REQUIRE(data[2].first == "12");
+
+  // the descriptor is parsed as a whole document
+  tinyxml2::XMLDocument doc;
+  REQUIRE(doc.Parse(data[1].second.c_str(), data[1].second.size()) == tinyxml2::XML_SUCCESS);
+  REQUIRE(std::string(doc.RootElement()->Attribute("Name")) == "Deezer & co");
+}
@@ -0,0 +1,108 @@
+#include <iostream>
+
+#include "include/testmain.h"
+
+#include <noson/sonoszone.h>
+#include <noson/zonegrouptopology.h>
+
+TEST_CASE("Merging the changes of the topology")
+{
+  SONOS::ZoneChanges changes;
+  REQUIRE(changes.empty());
+
+  SONOS::ZoneChanges next;
+  next.added.insert("A");
+  next.removed.insert("B");
+  next.renamed.insert("C");
+  next.updated.insert("D");
+  changes.Merge(next);
+  REQUIRE(changes.added.count("A") == 1);
+  REQUIRE(changes.removed.count("B") == 1);
+  REQUIRE(changes.renamed.count("C") == 1);
+  REQUIRE(changes.updated.count("D") == 1);
+
+  // a zone added then removed never existed
+  next.clear();
+  next.removed.insert("A");
+  changes.Merge(next);
+  REQUIRE(changes.added.count("A") == 0);
+  REQUIRE(changes.removed.count("A") == 0);
+
+  // a zone removed then added is another one
+  next.clear();
+  next.added.insert("B");
+  changes.Merge(next);
+  REQUIRE(changes.removed.count("B") == 0);
+  REQUIRE(changes.added.count("B") == 0);
+  REQUIRE(changes.regrouped.count("B") == 1);
+
+  // the stronger change prevails: regrouped, then renamed, then updated
+  next.clear();
+  next.regrouped.insert("C");
+  next.renamed.insert("D");
+  changes.Merge(next);
+  REQUIRE(changes.regrouped.count("C") == 1);
+  REQUIRE(changes.renamed.count("C") == 0);
+  REQUIRE(changes.renamed.count("D") == 1);
+  REQUIRE(changes.updated.count("D") == 0);
+  next.clear();
+  next.updated.insert("C");
+  next.updated.insert("D");
+  changes.Merge(next);
+  REQUIRE(changes.updated.empty());
+
+  // a removed zone drops its other changes
+  next.clear();
+  next.removed.insert("C");
+  changes.Merge(next);
+  REQUIRE(changes.regrouped.count("C") == 0);
+  REQUIRE(changes.removed.count("C") == 1);
+
+  // the changes of a new zone are in its addition
+  next.clear();
+  next.added.insert("E");
+  changes.Merge(next);
+  next.clear();
+  next.regrouped.insert("E");
+  next.updated.insert("E");
+  changes.Merge(next);
+  REQUIRE(changes.added.count("E") == 1);
+  REQUIRE(changes.regrouped.count("E") == 0);
+  REQUIRE(changes.updated.count("E") == 0);
+
+  changes.clear();
+  REQUIRE(changes.empty());
+}
+
+static SONOS::ZonePlayer _member(const char * name, const char * uuid)
+{
+  SONOS::ZonePlayer player(name);
+  player.SetAttribut(ZP_UUID, uuid);
+  player.SetAttribut(ZP_LOCATION, "http://192.168.0.10:1400/xml/device_description.xml");
+  player.SetAttribut(ZP_COORDINATOR, "true");
+  player.SetAttribut(ZP_VERSION, "78.1-51030");
+  return player;
+}
+
+TEST_CASE("Comparing the members of the zones")
+{
+  SONOS::ZonePlayer a = _member("Kitchen", "RINCON_1");
+  SONOS::ZonePlayer b = _member("Kitchen", "RINCON_1");
+  REQUIRE(SONOS::ZoneGroupTopology::SameMember(a, b));
+
+  // renamed
+  SONOS::ZonePlayer c = _member("Living Room", "RINCON_1");
+  REQUIRE(!SONOS::ZoneGroupTopology::SameMember(a, c));
+
+  // otherwise changed
+  b.SetAttribut(ZP_VERSION, "79.0-52080");
+  REQUIRE(!SONOS::ZoneGroupTopology::SameMember(a, b));
+  b = _member("Kitchen", "RINCON_1");
+  b.SetAttribut(ZP_COORDINATOR, "false");
+  REQUIRE(!SONOS::ZoneGroupTopology::SameMember(a, b));
+
+  // the attributes not compared are ignored
+  b = _member("Kitchen", "RINCON_1");
+  b.SetAttribut("bootseq", "42");
+  REQUIRE(SONOS::ZoneGroupTopology::SameMember(a, b));
+}
@@ -0,0 +1,176 @@
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+#include <chrono>
+
+#include "include/soap_response_1.c"
+#include "include/allocount.h"
+
+#include <noson/didlparser.h>
+#include <private/tinyxml2.h>
+#include <private/xmldict.h>
+
+static std::string browse_result(const std::string& data)
+{
+  tinyxml2::XMLDocument rootdoc;
+  if (rootdoc.Parse(data.c_str(), data.size()) != tinyxml2::XML_SUCCESS)
+    return std::string();
+  const tinyxml2::XMLElement* elem = rootdoc.RootElement();
+  while (elem && !SONOS::XMLNS::NameEqual(elem->Name(), "Result"))
+  {
+    if (elem->FirstChildElement())
+      elem = elem->FirstChildElement();
+    else
+      elem = elem->NextSiblingElement();
+  }
+  return (elem && elem->GetText() ? elem->GetText() : "");
+}
+
+static SONOS::XMLDict _initDIDLDict()
+{
+  SONOS::XMLDict dict;
+  dict.DefineNS(DIDL_QNAME_DIDL, DIDL_XMLNS_DIDL);
+  dict.DefineNS(DIDL_QNAME_RINC, DIDL_XMLNS_RINC);
+  dict.DefineNS(DIDL_QNAME_DC, DIDL_XMLNS_DC);
+  dict.DefineNS(DIDL_QNAME_UPNP, DIDL_XMLNS_UPNP);
+  return dict;
+}
+
+// the former parsing, building the elements of each item from the DOM
+static size_t parse_baseline(const char* document)
+{
+  static SONOS::XMLDict dict = _initDIDLDict();
+  SONOS::DigitalItemList items;
+  tinyxml2::XMLDocument doc;
+  if (doc.Parse(document) != tinyxml2::XML_SUCCESS)
+    return 0;
+  const tinyxml2::XMLElement* elem = doc.RootElement();
+  if (!elem || !SONOS::XMLNS::NameEqual(elem->Name(), "DIDL-Lite"))
+    return 0;
+  SONOS::XMLNames xmlnames;
+  xmlnames.AddXMLNS(elem);
+  for (elem = elem->FirstChildElement(); elem; elem = elem->NextSiblingElement())
+  {
+    if (!SONOS::XMLNS::NameEqual(elem->Name(), "item") && !SONOS::XMLNS::NameEqual(elem->Name(), "container"))
+      continue;
+    const char* id = elem->Attribute("id");
+    const char* parentID = elem->Attribute("parentID");
+    const char* restricted = elem->Attribute("restricted");
+    SONOS::ElementList vars;
+    for (const tinyxml2::XMLElement* velem = elem->FirstChildElement(); velem; velem = velem->NextSiblingElement())
+    {
+      if (!velem->Name() || !velem->GetText())
+        continue;
+      SONOS::ElementPtr var(new SONOS::Element(dict.TranslateQName(xmlnames, velem->Name()), velem->GetText()));
+      for (const tinyxml2::XMLAttribute* vattr = velem->FirstAttribute(); vattr && vattr->Name() && vattr->Value(); vattr = vattr->Next())
+        var->SetAttribut(vattr->Name(), vattr->Value());
+      vars.push_back(var);
+    }
+    items.push_back(SONOS::DigitalItemPtr(new SONOS::DigitalItem(id ? id : "-1", parentID ? parentID : "-1",
+            (restricted && strncmp(restricted, "true", 4) == 0), vars)));
+  }
+  return items.size();
+}
+
+static void run(const char* label, const std::string& didl, int loops, bool baseline)
+{
+  size_t allocs = 0, bytes = 0, items = 0;
+  auto start = std::chrono::steady_clock::now();
+  for (int i = 0; i < loops; ++i)
+  {
+    size_t a = AllocCount(), b = AllocBytes();
+    if (baseline)
+      items += parse_baseline(didl.c_str());
+    else
+    {
+      SONOS::DIDLParser parser(didl.c_str());
+      items += parser.GetItems().size();
+    }
+    allocs += AllocCount() - a;
+    bytes += AllocBytes() - b;
+  }
+  auto us = std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - start).count();
+  printf("%-10s: %6.1f us/page, %7.1f allocs/page, %8.0f bytes/page, %5.1f allocs/item\n", label,
+         (double)us / loops, (double)allocs / loops, (double)bytes / loops, (double)allocs / items);
+}
+
+// the former char by char encoding
+static std::string encode_bytewise(const std::string& str)
+{
+  std::string ret;
+  ret.reserve(str.size());
+  for (std::string::const_iterator it = str.begin(); it != str.end(); ++it)
+  {
+    if (*it == '&')
+      ret.append("&amp;");
+    else if (*it == '<')
+      ret.append("&lt;");
+    else if (*it == '>')
+      ret.append("&gt;");
+    else if (*it == '"')
+      ret.append("&quot;");
+    else
+      ret.push_back(*it);
+  }
+  return ret;
+}
+
+static void run_encode(const std::string& didl, int loops)
+{
+  // the metadata of the items are encoded twice when sent with the SOAP request
+  SONOS::DIDLParser parser(didl.c_str());
+  size_t bytes = 0;
+  auto start = std::chrono::steady_clock::now();
+  for (int i = 0; i < loops; ++i)
+  {
+    std::string metadata;
+    for (auto& item : parser.GetItems())
+      item->DIDL(metadata);
+    std::string content;
+    SONOS::Element("EnqueuedURIsMetaData", metadata).XML(content);
+    bytes += content.size();
+  }
+  auto us = std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - start).count();
+  printf("%-10s: %6.1f us/page, %7.1f MB/s\n", "serialize", (double)us / loops, (double)bytes / us);
+  std::string metadata;
+  for (auto& item : parser.GetItems())
+    metadata.append(item->DIDL());
+  start = std::chrono::steady_clock::now();
+  bytes = 0;
+  for (int i = 0; i < loops; ++i)
+    bytes += SONOS::Element("", metadata).XMLEncoded().size();
+  us = std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - start).count();
+  printf("%-10s: %6.1f us/page, %7.1f MB/s\n", "encode", (double)us / loops, (double)bytes / us);
+  start = std::chrono::steady_clock::now();
+  bytes = 0;
+  for (int i = 0; i < loops; ++i)
+    bytes += encode_bytewise(metadata).size();
+  us = std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - start).count();
+  printf("%-10s: %6.1f us/page, %7.1f MB/s\n", "bytewise", (double)us / loops, (double)bytes / us);
+}
+
+int main(int argc, char** argv)
+{
+  int loops = 2000;
+  if (argc > 1)
+    loops = atoi(argv[1]);
+  const std::string didl = browse_result(std::string((const char*)soap_response_1_html, soap_response_1_html_len));
+  if (didl.empty())
+    return EXIT_FAILURE;
+  run("compact", didl, loops, false);
+  run("baseline", didl, loops, true);
+  // a page of 96 tracks
+  size_t b = didl.find("<item"), e = didl.rfind("</DIDL-Lite>");
+  if (b == std::string::npos || e == std::string::npos)
+    return EXIT_FAILURE;
+  std::string items = didl.substr(b, e - b);
+  std::string large = didl.substr(0, b);
+  for (int i = 0; i < 4; ++i)
+    large.append(items);
+  large.append(didl.substr(e));
+  run("compact96", large, loops / 4, false);
+  run("baseline96", large, loops / 4, true);
+  run_encode(large, loops / 4);
+  return EXIT_SUCCESS;
+}
@@ -0,0 +1,88 @@
+#include <cstdio>
+#include <cstdlib>
+#include <ctime>
+#include <chrono>
+
+#include "include/sample_pcm_s16le.c"
+
+#include <noson/audioformat.h>
+#include <noson/flacencoder.h>
+
+/**
+ * Compare the profiles of the FLAC encoder: CPU time, bitrate, the delay of
+ * audio buffered before the first frame is out, and the wall time spent in
+ * the write that outputs the first frame and in the slowest write. The time
+ * to first byte of a listener is the buffered delay plus the first write.
+ */
+#define SLICE 1764 // 10 ms of CD audio
+
+static size_t flush(SONOS::AudioEncoder * encoder, char * buf, int bufsize)
+{
+  size_t n = 0;
+  int r;
+  while (encoder->bytesAvailable() > 0 && (r = encoder->read(buf, bufsize, 0)) > 0)
+    n += r;
+  return n;
+}
+
+static void run(SONOS::FLACEncoder::Profile profile, int loops)
+{
+  char buf[4096];
+  SONOS::FLACEncoder encoder(4096);
+  encoder.setAudioFormat(SONOS::AudioFormat::CDLPCM());
+  encoder.setProfile(profile);
+  size_t bytes = 0, pcm = 0;
+  double firstFrameMs = 0, firstWriteUs = 0, slowestWriteUs = 0;
+  clock_t start = clock();
+  for (int l = 0; l < loops; ++l)
+  {
+    if (!encoder.open())
+      return;
+    // the stream header is written on opening
+    size_t header = flush(&encoder, buf, sizeof(buf));
+    size_t fed = 0;
+    bool first = true;
+    unsigned char * p = pcm_s16le_raw;
+    unsigned char * e = pcm_s16le_raw + pcm_s16le_raw_len;
+    while (p < e)
+    {
+      int s = (e - p < SLICE ? (int)(e - p) : SLICE);
+      auto t = std::chrono::steady_clock::now();
+      int r = encoder.write((char*)p, s);
+      double us = (double)std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - t).count();
+      if (r <= 0)
+        break;
+      if (us > slowestWriteUs)
+        slowestWriteUs = us;
+      p += r;
+      fed += r;
+      size_t n = flush(&encoder, buf, sizeof(buf));
+      if (first && n > 0)
+      {
+        firstFrameMs += fed * 10.0 / SLICE;
+        firstWriteUs += us;
+        first = false;
+      }
+      bytes += n;
+    }
+    encoder.close();
+    bytes += flush(&encoder, buf, sizeof(buf)) + header;
+    pcm += pcm_s16le_raw_len;
+  }
+  double cpu = (double)(clock() - start) / CLOCKS_PER_SEC;
+  double seconds = (double)pcm / (SLICE * 100);
+  printf("%-10s: %6.2f%% CPU, %7.1f kbit/s, %5.1f ms to first frame (+%.0f us), slowest write %.0f us\n",
+         SONOS::FLACEncoder::profileName(profile), 100.0 * cpu / seconds,
+         bytes * 8.0 / seconds / 1000.0, firstFrameMs / loops, firstWriteUs / loops, slowestWriteUs);
+}
+
+int main(int argc, char** argv)
+{
+  int loops = 20;
+  if (argc > 1)
+    loops = atoi(argv[1]);
+  run(SONOS::FLACEncoder::LowLatency, loops);
+  run(SONOS::FLACEncoder::Balanced, loops);
+  run(SONOS::FLACEncoder::Archival, loops);
+  return EXIT_SUCCESS;
+}
@@ -0,0 +1,336 @@
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <cassert>
+#include <vector>
+#include <list>
+#include <chrono>
+#include <atomic>
+
+#include <noson/framebuffer.h>
+#include <private/os/threads/threadpool.h>
+#include <private/os/threads/mutex.h>
+
+using namespace SONOS;
+
+/**
+ * The previous implementation of the buffer, guarded by mutexes
+ */
+class LockedFrameBuffer
+{
+public:
+  LockedFrameBuffer(int capacity);
+  virtual ~LockedFrameBuffer();
+  LockedFrameBuffer(const LockedFrameBuffer& other) = delete;
+  LockedFrameBuffer& operator=(const LockedFrameBuffer& other) = delete;
+
+  int capacity() const;
+
+  int bytesAvailable() const;
+
+  unsigned bytesUnread() const;
+
+  bool full() const;
+
+  void clear();
+
+  int write(const char * data, int len);
+
+  FramePacket * newPacket(int len);
+
+  void writePacket(FramePacket * packet);
+
+  /**
+   * Returned pointer MUST BE freed by caller
+   * @see freePacket(FramePacket *)
+   * @return new FramePacket or nullptr
+   */
+  FramePacket * read();
+
+  void freePacket(FramePacket * p);
+
+private:
+  struct Lockable;
+  mutable Lockable * m_ringlock;
+  mutable Lockable * m_poollock;
+  const int m_capacity;           /// buffer size
+  unsigned m_count;               /// total count of processed frame
+  unsigned m_unread;              /// total size of unread data in the buffer
+
+  struct Frame
+  {
+    Frame() : packet(nullptr), next(nullptr) { }
+    ~Frame() { if (packet) delete packet; }
+    FramePacket * packet;
+    Frame * next;
+  };
+
+  std::vector<Frame*> m_buffer;   /// buffer of frames
+  Frame * m_read;                 /// frame to read
+  Frame * m_write;                /// frame to write
+
+  void init();
+
+  std::list<FramePacket*> m_pool;
+  FramePacket * needPacket(int size);
+};
+
+
+struct LockedFrameBuffer::Lockable
+{
+  OS::CMutex mutex;
+};
+
+LockedFrameBuffer::LockedFrameBuffer(int capacity)
+: m_ringlock(new Lockable())
+, m_poollock(new Lockable())
+, m_capacity(capacity)
+, m_count(0)
+, m_unread(0)
+, m_buffer()
+, m_read(nullptr)
+, m_write(nullptr)
+, m_pool()
+{
+  assert(capacity > 0);
+  m_buffer.resize(capacity);
+  init();
+}
+
+LockedFrameBuffer::~LockedFrameBuffer()
+{
+  m_ringlock->mutex.Lock();
+  for (std::vector<Frame*>::iterator it = m_buffer.begin(); it != m_buffer.end(); ++it)
+    delete *it;
+  m_ringlock->mutex.Unlock();
+  m_poollock->mutex.Lock();
+  while (!m_pool.empty())
+  {
+    delete m_pool.front();
+    m_pool.pop_front();
+  }
+  m_poollock->mutex.Unlock();
+  delete m_poollock;
+  delete m_ringlock;
+}
+
+void LockedFrameBuffer::init()
+{
+  Frame * previous = nullptr;
+  for (std::vector<Frame*>::iterator it = m_buffer.begin(); it != m_buffer.end(); ++it)
+  {
+    *it = new Frame();
+    if (previous)
+      previous->next = *it;
+    previous = *it;
+  }
+  if (m_buffer.begin() != m_buffer.end())
+    previous->next = *(m_buffer.begin());
+  m_write = *(m_buffer.begin());
+  m_read = m_write;
+}
+
+int LockedFrameBuffer::capacity() const
+{
+  return m_capacity;
+}
+
+int LockedFrameBuffer::bytesAvailable() const
+{
+  OS::CLockGuard g(m_ringlock->mutex);
+  return (m_unread ? m_read->packet->size : 0);
+}
+
+unsigned LockedFrameBuffer::bytesUnread() const
+{
+  OS::CLockGuard g(m_ringlock->mutex);
+  return m_unread;
+}
+
+bool LockedFrameBuffer::full() const
+{
+  OS::CLockGuard g(m_ringlock->mutex);
+  return (m_unread && m_read == m_write);
+}
+
+void LockedFrameBuffer::clear()
+{
+  OS::CLockGuard g(m_ringlock->mutex);
+  // reset of unread implies the reset of packet size
+  // so clean all frames in the buffer
+  for (std::vector<Frame*>::iterator it = m_buffer.begin(); it != m_buffer.end(); ++it)
+  {
+    if ((*it)->packet)
+      freePacket((*it)->packet);
+    (*it)->packet = nullptr;
+  }
+  m_count = m_unread = 0;
+  m_read = m_write;
+}
+
+int LockedFrameBuffer::write(const char * data, int len)
+{
+  if (len > 0)
+  {
+    FramePacket * _packet = needPacket(len);
+    _packet->size = len;
+    memcpy(_packet->data, data, len);
+    {
+      OS::CLockGuard g(m_ringlock->mutex);
+      if (m_write->packet)
+      {
+        // overwriting a packet implies to update unread because the data will be destroyed,
+        // and no longer available for reading.
+        m_unread -= m_write->packet->size;
+        freePacket(m_write->packet);
+      }
+      m_write->packet = _packet;
+      m_write->packet->id = ++m_count;
+      m_write = m_write->next;
+      m_unread += _packet->size;
+    }
+  }
+  return len;
+}
+
+FramePacket* LockedFrameBuffer::newPacket(int len)
+{
+  FramePacket * _packet = needPacket(len);
+  _packet->size = 0;
+  return _packet;
+}
+
+void LockedFrameBuffer::writePacket(FramePacket* packet)
+{
+  if (packet)
+  {
+    OS::CLockGuard g(m_ringlock->mutex);
+    if (m_write->packet)
+    {
+      // overwriting a packet implies to update unread because the data will be destroyed,
+      // and no longer available for reading.
+      m_unread -= m_write->packet->size;
+      freePacket(m_write->packet);
+    }
+    m_write->packet = packet;
+    m_write->packet->id = ++m_count;
+    m_write = m_write->next;
+    m_unread += packet->size;
+  }
+}
+
+FramePacket * LockedFrameBuffer::read()
+{
+  FramePacket * p = nullptr;
+  {
+    OS::CLockGuard g(m_ringlock->mutex);
+    if (m_unread)
+    {
+      p = m_read->packet;
+      m_read->packet = nullptr;
+      m_read = m_read->next;
+      m_unread -= p->size;
+    }
+  }
+  return p;
+}
+
+void LockedFrameBuffer::freePacket(FramePacket * p)
+{
+  m_poollock->mutex.Lock();
+  m_pool.push_back(p);
+  m_poollock->mutex.Unlock();
+}
+
+FramePacket * LockedFrameBuffer::needPacket(int size)
+{
+  FramePacket * p = nullptr;
+  m_poollock->mutex.Lock();
+  if (!m_pool.empty())
+  {
+    p = m_pool.front();
+    m_pool.pop_front();
+    m_poollock->mutex.Unlock();
+    if (p->capacity >= size)
+    {
+      p->id = 0;
+      return p;
+    }
+    //DBG(DBG_DEBUG, "%s: freed packet from buffer (%d)\n", __FUNCTION__, p->capacity);
+    delete p;
+  }
+  else
+  {
+    m_poollock->mutex.Unlock();
+  }
+  p = new FramePacket(size);
+  //DBG(DBG_DEBUG, "%s: allocated packet to buffer (%d)\n", __FUNCTION__, p->capacity);
+  return p;
+
+}
+
+/**
+ * The contention of the audio path: a producer writing packets as fast as
+ * possible, and a consumer reading them concurrently.
+ */
+template <class BUFFER>
+class Producer : public OS::CWorker
+{
+public:
+  Producer(BUFFER& buffer, int count, int size, std::atomic<bool>& done)
+  : m_buffer(buffer), m_count(count), m_size(size), m_done(done) { }
+  void Process() override
+  {
+    std::vector<char> data(m_size, 'x');
+    for (int i = 0; i < m_count; ++i)
+      m_buffer.write(data.data(), m_size);
+    m_done = true;
+  }
+private:
+  BUFFER& m_buffer;
+  int m_count;
+  int m_size;
+  std::atomic<bool>& m_done;
+};
+
+template <class BUFFER>
+static void run(const char * name, int capacity, int count, int size)
+{
+  BUFFER buffer(capacity);
+  std::atomic<bool> done(false);
+  OS::CThreadPool pool(1);
+  long received = 0;
+  auto start = std::chrono::steady_clock::now();
+  pool.Enqueue(new Producer<BUFFER>(buffer, count, size, done));
+  for (;;)
+  {
+    FramePacket * p = buffer.read();
+    if (p)
+    {
+      ++received;
+      buffer.freePacket(p);
+    }
+    else if (done && buffer.bytesUnread() == 0)
+      break;
+  }
+  auto us = std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - start).count();
+  if (us == 0)
+    us = 1;
+  printf("%-8s %5d bytes: %8.2f Mpackets/s, %6.1f%% received\n", name, size,
+         (double)count / us, 100.0 * received / count);
+}
+
+int main(int argc, char** argv)
+{
+  int count = 2000000;
+  if (argc > 1)
+    count = atoi(argv[1]);
+  // the reads of PulseAudio (256 stereo frames), and the frames of the encoder
+  static const int sizes[] = { 1024, 4096, 16384 };
+  for (int size : sizes)
+  {
+    run<LockedFrameBuffer>("locked", 256, count / (size / 1024), size);
+    run<FrameBuffer>("lockfree", 256, count / (size / 1024), size);
+  }
+  return 0;
+}
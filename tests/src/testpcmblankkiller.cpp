@@ -0,0 +1,89 @@
+#include <cstdio>
+#include <cstdlib>
+#include <cstdint>
+#include <cstring>
+#include <vector>
+#include <chrono>
+
+#include <private/pcmblankkiller.h>
+
+/**
+ * The throughput of the silence detection of the blank killer, for each
+ * format on a blank buffer, i.e the worst case scanning the whole buffer
+ */
+static std::vector<char> silence(uint32_t zero, int size, bool bigEndian, int len)
+{
+  std::vector<char> buf(len);
+  for (int i = 0; i < len; ++i)
+  {
+    int b = (bigEndian ? size - 1 - (i % size) : (i % size));
+    buf[i] = (char)((zero >> (8 * b)) & 0xff);
+  }
+  return buf;
+}
+
+static double elapsed(std::chrono::steady_clock::time_point start)
+{
+  auto us = std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - start).count();
+  return (us == 0 ? 1.0 : (double)us);
+}
+
+int main(int argc, char** argv)
+{
+  int loops = 200000;
+  if (argc > 1)
+    loops = atoi(argv[1]);
+  static const struct { const char * name; SONOS::PCMBlankKiller killer; uint32_t zero; int size; bool bigEndian; } formats[] = {
+    { "U8",    SONOS::PCMBlankKillerU8, 0x80, 1, false },
+    { "S16LE", SONOS::PCMBlankKillerS16LE, 0, 2, false },
+    { "U16LE", SONOS::PCMBlankKillerU16LE, 0x8000, 2, false },
+    { "S24LE", SONOS::PCMBlankKillerS24LE, 0, 3, false },
+    { "U24LE", SONOS::PCMBlankKillerU24LE, 0x800000, 3, false },
+    { "S32LE", SONOS::PCMBlankKillerS32LE, 0, 4, false },
+    { "U32LE", SONOS::PCMBlankKillerU32LE, 0x80000000, 4, false },
+    { "S16BE", SONOS::PCMBlankKillerS16BE, 0, 2, true },
+    { "U16BE", SONOS::PCMBlankKillerU16BE, 0x8000, 2, true },
+    { "S24BE", SONOS::PCMBlankKillerS24BE, 0, 3, true },
+    { "U24BE", SONOS::PCMBlankKillerU24BE, 0x800000, 3, true },
+    { "S32BE", SONOS::PCMBlankKillerS32BE, 0, 4, true },
+    { "U32BE", SONOS::PCMBlankKillerU32BE, 0x80000000, 4, true },
+  };
+  static const char * kernels[] = { "scalar", "sse2", "avx2", "neon" };
+  // the read of the pulse source: 256 stereo frames
+  const int channels = 2;
+  const int frames = 256;
+  const char * selected = "";
+  SONOS::SelectPCMIsBlank(&selected);
+
+  for (const auto& f : formats)
+  {
+    const int len = f.size * channels * frames;
+    std::vector<char> pattern = silence(f.zero, f.size, f.bigEndian, PCMBLANK_PATTERN);
+    std::vector<char> data = silence(f.zero, f.size, f.bigEndian, len);
+    for (const char * name : kernels)
+    {
+      SONOS::PCMIsBlank isBlank = SONOS::GetPCMIsBlank(name);
+      if (!isBlank)
+        continue;
+      int blank = 0;
+      auto start = std::chrono::steady_clock::now();
+      for (int i = 0; i < loops; ++i)
+        blank += isBlank(data.data(), len, pattern.data());
+      double us = elapsed(start);
+      printf("%-5s %-7s: %8.1f MB/s%s\n", f.name, name, (double)len * loops / us,
+             blank == loops ? "" : " (failed)");
+    }
+    // the killer writes a noise in the first frames, that is reset
+    std::vector<char> buf(data);
+    auto start = std::chrono::steady_clock::now();
+    for (int i = 0; i < loops; ++i)
+    {
+      f.killer(buf.data(), channels, frames);
+      memcpy(buf.data(), data.data(), 2 * f.size * channels + 1);
+    }
+    double us = elapsed(start);
+    printf("%-5s killer : %8.1f MB/s\n", f.name, (double)len * loops / us);
+  }
+  printf("selected: %s\n", selected);
+  return EXIT_SUCCESS;
+}
@@ -0,0 +1,79 @@
+#include <cstdio>
+#include <cstdlib>
+#include <vector>
+#include <chrono>
+
+#include <private/pcmconvert.h>
+
+/**
+ * The throughput of the PCM conversion kernels of the FLAC encoder, and of
+ * the byte swap kernels of the LPCM encoder
+ */
+static void run(int size, const char * name, const std::vector<char>& data, std::vector<int32_t>& pcm, int loops)
+{
+  SONOS::PCMToInt32 convert = SONOS::GetPCMToInt32(size, name);
+  if (!convert)
+    return;
+  int count = (int)pcm.size();
+  auto start = std::chrono::steady_clock::now();
+  for (int i = 0; i < loops; ++i)
+    convert(data.data(), pcm.data(), count);
+  auto us = std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - start).count();
+  if (us == 0)
+    us = 1;
+  printf("%2d bits %-7s: %8.1f Msamples/s, %7.1f MB/s\n", size, name,
+         (double)count * loops / us, (double)count * loops * (size / 8) / us);
+}
+
+static void runSwap(int size, const char * name, const std::vector<char>& data, std::vector<char>& out, int loops)
+{
+  SONOS::PCMByteSwap swap = SONOS::GetPCMByteSwap(size, name);
+  if (!swap)
+    return;
+  int count = (int)out.size() / (size / 8);
+  auto start = std::chrono::steady_clock::now();
+  for (int i = 0; i < loops; ++i)
+    swap(data.data(), out.data(), count);
+  auto us = std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - start).count();
+  if (us == 0)
+    us = 1;
+  printf("%2d bits swap %-7s: %8.1f Msamples/s, %7.1f MB/s\n", size, name,
+         (double)count * loops / us, (double)count * loops * (size / 8) / us);
+}
+
+int main(int argc, char** argv)
+{
+  int loops = 20000;
+  if (argc > 1)
+    loops = atoi(argv[1]);
+  // the buffer of the encoder: 1024 stereo frames
+  std::vector<int32_t> pcm(2048);
+  std::vector<char> data(pcm.size() * 4);
+  for (size_t i = 0; i < data.size(); ++i)
+    data[i] = (char)(rand() & 0xff);
+  static const int sizes[] = { 8, 16, 24 };
+  static const char * kernels[] = { "scalar", "sse2", "avx2", "neon" };
+  for (int size : sizes)
+  {
+    const char * selected = "";
+    SONOS::SelectPCMToInt32(size, &selected);
+    for (const char * name : kernels)
+      run(size, name, data, pcm, loops);
+    printf("%2d bits selected: %s\n", size, selected);
+  }
+  // the block of the encoder: 4096 stereo frames
+  std::vector<char> raw(4096 * 2 * 4);
+  for (size_t i = 0; i < raw.size(); ++i)
+    raw[i] = (char)(rand() & 0xff);
+  static const int swapSizes[] = { 16, 24, 32 };
+  for (int size : swapSizes)
+  {
+    const char * selected = "";
+    SONOS::SelectPCMByteSwap(size, &selected);
+    std::vector<char> out(4096 * 2 * (size / 8));
+    for (const char * name : kernels)
+      runSwap(size, name, raw, out, loops);
+    printf("%2d bits swap selected: %s\n", size, selected);
+  }
+  return EXIT_SUCCESS;
+}